@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Latency of the camera service calls made when an app opens a camera: fetching the static
+// characteristics and connecting/disconnecting a camera2 device. One benchmark is registered
+// per camera ID that supports API2.
+//
+// adb shell /data/benchmarktest64/camera_service_benchmark/camera_service_benchmark
+
+#define LOG_TAG "CameraServiceBenchmark"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <android/hardware/ICameraService.h>
+#include <android/hardware/camera2/BnCameraDeviceCallbacks.h>
+#include <android/hardware/camera2/ICameraDeviceUser.h>
+#include <binder/IServiceManager.h>
+#include <binder/ProcessState.h>
+#include <camera/CameraMetadata.h>
+#include <camera/CaptureResult.h>
+#include <utils/Log.h>
+#include <utils/String8.h>
+#include <utils/String16.h>
+
+using namespace android;
+using namespace android::hardware;
+
+using hardware::camera2::impl::CameraMetadataNative;
+using hardware::camera2::impl::CaptureResultExtras;
+using hardware::camera2::impl::PhysicalCaptureResultInfo;
+
+namespace {
+
+class NoopDeviceCallbacks : public camera2::BnCameraDeviceCallbacks {
+public:
+    binder::Status onDeviceError(int errorCode,
+            const CaptureResultExtras& /*resultExtras*/) override {
+        ALOGE("%s: onDeviceError occurred with: %d", __FUNCTION__, errorCode);
+        return binder::Status::ok();
+    }
+    binder::Status onDeviceIdle() override { return binder::Status::ok(); }
+    binder::Status onCaptureStarted(const CaptureResultExtras& /*resultExtras*/,
+            int64_t /*timestamp*/) override {
+        return binder::Status::ok();
+    }
+    binder::Status onResultReceived(const CameraMetadataNative& /*metadata*/,
+            const CaptureResultExtras& /*resultExtras*/,
+            const std::vector<PhysicalCaptureResultInfo>& /*physicalResultInfos*/) override {
+        return binder::Status::ok();
+    }
+    binder::Status onPrepared(int /*streamId*/) override { return binder::Status::ok(); }
+    binder::Status onRepeatingRequestError(int64_t /*lastFrameNumber*/,
+            int32_t /*stoppedSequenceId*/) override {
+        return binder::Status::ok();
+    }
+    binder::Status onRequestQueueEmpty() override { return binder::Status::ok(); }
+};
+
+void BM_GetCameraCharacteristics(benchmark::State& state, sp<ICameraService> service,
+        String16 cameraId) {
+    CameraMetadata characteristics;
+    for (auto _ : state) {
+        binder::Status res = service->getCameraCharacteristics(cameraId, &characteristics);
+        if (!res.isOk()) {
+            state.SkipWithError(res.toString8().string());
+            break;
+        }
+    }
+    state.counters["entries"] = characteristics.entryCount();
+}
+
+// Times connectDevice() only; the disconnect needed before the next open is excluded.
+void BM_OpenCamera(benchmark::State& state, sp<ICameraService> service, String16 cameraId) {
+    sp<NoopDeviceCallbacks> callbacks = new NoopDeviceCallbacks();
+    for (auto _ : state) {
+        sp<camera2::ICameraDeviceUser> device;
+        auto start = std::chrono::steady_clock::now();
+        binder::Status res = service->connectDevice(callbacks, cameraId,
+                String16(LOG_TAG), std::unique_ptr<String16>(),
+                ICameraService::USE_CALLING_UID, /*out*/&device);
+        auto end = std::chrono::steady_clock::now();
+        if (!res.isOk() || device == nullptr) {
+            state.SkipWithError(res.toString8().string());
+            break;
+        }
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+        device->disconnect();
+    }
+}
+
+std::vector<String16> getApi2CameraIds(const sp<ICameraService>& service) {
+    std::vector<String16> cameraIds;
+    int32_t numCameras = 0;
+    if (!service->getNumberOfCameras(ICameraService::CAMERA_TYPE_ALL, &numCameras).isOk()) {
+        return cameraIds;
+    }
+    for (int32_t i = 0; i < numCameras; i++) {
+        String16 cameraId(String8::format("%d", i));
+        bool isSupported = false;
+        if (service->supportsCameraApi(cameraId, ICameraService::API_VERSION_2,
+                &isSupported).isOk() && isSupported) {
+            cameraIds.push_back(cameraId);
+        }
+    }
+    return cameraIds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ProcessState::self()->startThreadPool();
+    sp<IBinder> binder = defaultServiceManager()->getService(String16("media.camera"));
+    sp<ICameraService> service = interface_cast<ICameraService>(binder);
+    if (service == nullptr) {
+        fprintf(stderr, "Camera service is not available\n");
+        return 1;
+    }
+
+    for (const auto& cameraId : getApi2CameraIds(service)) {
+        std::string id(String8(cameraId).string());
+        benchmark::RegisterBenchmark(("BM_GetCameraCharacteristics/" + id).c_str(),
+                BM_GetCameraCharacteristics, service, cameraId);
+        benchmark::RegisterBenchmark(("BM_OpenCamera/" + id).c_str(),
+                BM_OpenCamera, service, cameraId)
+                ->UseManualTime()
+                ->Unit(benchmark::kMillisecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
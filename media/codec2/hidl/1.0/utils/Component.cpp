@@ -30,6 +30,7 @@
 #include <C2PlatformSupport.h>
 
 #include <chrono>
+#include <mutex>
 #include <thread>
 
 namespace android {
@@ -104,12 +105,15 @@ struct Component::Listener : public C2Component::Listener {
 
         sp<IComponentListener> listener = mListener.promote();
         if (listener) {
+            // workBundle refers to mArena until onWorkDone() returns.
+            std::lock_guard<std::mutex> lock(mArenaMutex);
             WorkBundle workBundle;
 
             sp<Component> strongComponent = mComponent.promote();
             beginTransferBufferQueueBlocks(c2workItems, true);
             if (!objcpy(&workBundle, c2workItems, strongComponent ?
-                    &strongComponent->mBufferPoolSender : nullptr)) {
+                    &strongComponent->mBufferPoolSender : nullptr,
+                    &mArena)) {
                 LOG(ERROR) << "Component::Listener::onWorkDone_nb -- "
                            << "received corrupted work items.";
                 endTransferBufferQueueBlocks(c2workItems, false, true);
@@ -129,6 +133,10 @@ struct Component::Listener : public C2Component::Listener {
 protected:
     wp<Component> mComponent;
     wp<IComponentListener> mListener;
+
+    // Marshalling memory reused by onWorkDone_nb().
+    std::mutex mArenaMutex;
+    WorkBundleArena mArena;
 };
 
 // Component::Sink
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Codec2-types_benchmark"
+
+#include <list>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include <codec2/hidl/1.0/types.h>
+
+#include <C2Buffer.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <C2Work.h>
+#include <mediautils/AllocationCounter.h>
+
+using namespace android;
+using namespace ::android::hardware::media::c2::V1_0;
+using namespace ::android::hardware::media::c2::V1_0::utils;
+
+namespace {
+
+constexpr uint32_t kBlockSize = 4096;
+
+std::shared_ptr<C2Buffer> makeBuffer(const std::shared_ptr<C2BlockPool>& pool) {
+    std::shared_ptr<C2LinearBlock> block;
+    if (pool->fetchLinearBlock(
+            kBlockSize, { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE }, &block) != C2_OK) {
+        return nullptr;
+    }
+    std::shared_ptr<C2Buffer> buffer =
+            C2Buffer::CreateLinearBuffer(block->share(0, 1024, C2Fence()));
+    buffer->setInfo(std::make_shared<C2StreamPictureSizeInfo::output>(0u, 1920, 1080));
+    return buffer;
+}
+
+// Builds works shaped like the ones a video decoder returns: an input buffer, a config update
+// and one worklet with a tuning and an output buffer.
+bool makeWorks(size_t count, std::list<std::unique_ptr<C2Work>>* works) {
+    std::shared_ptr<C2BlockPool> pool;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != C2_OK) {
+        return false;
+    }
+    works->clear();
+    for (size_t i = 0; i < count; ++i) {
+        std::unique_ptr<C2Work> work = std::make_unique<C2Work>();
+        work->input.flags = C2FrameData::FLAG_CODEC_CONFIG;
+        work->input.ordinal.timestamp = i * 33333;
+        work->input.ordinal.frameIndex = i;
+        work->input.buffers.push_back(makeBuffer(pool));
+        work->input.configUpdate.push_back(
+                std::make_unique<C2StreamBitrateInfo::input>(0u, 4000000));
+
+        std::unique_ptr<C2Worklet> worklet = std::make_unique<C2Worklet>();
+        worklet->tunings.push_back(std::make_unique<C2StreamRequestSyncFrameTuning::output>(
+                0u, C2_TRUE));
+        worklet->output.ordinal = work->input.ordinal;
+        worklet->output.buffers.push_back(makeBuffer(pool));
+        work->worklets.push_back(std::move(worklet));
+        work->workletsProcessed = 1;
+        work->result = C2_OK;
+        if (!work->input.buffers.back() || !work->worklets.front()->output.buffers.back()) {
+            return false;
+        }
+        works->push_back(std::move(work));
+    }
+    return true;
+}
+
+void BM_Encode(benchmark::State& state) {
+    std::list<std::unique_ptr<C2Work>> works;
+    if (!makeWorks(state.range(0), &works)) {
+        state.SkipWithError("cannot create works");
+        return;
+    }
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        WorkBundle bundle;
+        if (!objcpy(&bundle, works)) {
+            state.SkipWithError("objcpy failed");
+            return;
+        }
+        benchmark::DoNotOptimize(bundle);
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_Encode)->Arg(1)->Arg(4)->Arg(16);
+
+void BM_EncodeArena(benchmark::State& state) {
+    std::list<std::unique_ptr<C2Work>> works;
+    if (!makeWorks(state.range(0), &works)) {
+        state.SkipWithError("cannot create works");
+        return;
+    }
+
+    WorkBundleArena arena;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        WorkBundle bundle;
+        if (!objcpy(&bundle, works, nullptr, &arena)) {
+            state.SkipWithError("objcpy failed");
+            return;
+        }
+        benchmark::DoNotOptimize(bundle);
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_EncodeArena)->Arg(1)->Arg(4)->Arg(16);
+
+void BM_Decode(benchmark::State& state) {
+    std::list<std::unique_ptr<C2Work>> works;
+    WorkBundle bundle;
+    if (!makeWorks(state.range(0), &works) || !objcpy(&bundle, works)) {
+        state.SkipWithError("cannot create a work bundle");
+        return;
+    }
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        std::list<std::unique_ptr<C2Work>> decoded;
+        if (!objcpy(&decoded, bundle)) {
+            state.SkipWithError("objcpy failed");
+            return;
+        }
+        benchmark::DoNotOptimize(decoded);
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_Decode)->Arg(1)->Arg(4)->Arg(16);
+
+// Encodes with an arena, then decodes, as a listener callback and the receiving process would.
+void BM_RoundTrip(benchmark::State& state) {
+    std::list<std::unique_ptr<C2Work>> works;
+    if (!makeWorks(state.range(0), &works)) {
+        state.SkipWithError("cannot create works");
+        return;
+    }
+
+    WorkBundleArena arena;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        WorkBundle bundle;
+        std::list<std::unique_ptr<C2Work>> decoded;
+        if (!objcpy(&bundle, works, nullptr, &arena) || !objcpy(&decoded, bundle)) {
+            state.SkipWithError("objcpy failed");
+            return;
+        }
+        if (decoded.size() != works.size()) {
+            state.SkipWithError("round trip lost works");
+            return;
+        }
+        benchmark::DoNotOptimize(decoded);
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_RoundTrip)->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+
+BENCHMARK_MAIN();
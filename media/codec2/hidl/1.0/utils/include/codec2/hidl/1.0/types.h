@@ -31,6 +31,8 @@
 #include <util/C2Debug-base.h>
 
 #include <chrono>
+#include <memory>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -225,6 +227,80 @@ private:
     std::map<int64_t, Connection> mConnections;
 };
 
+// Scratch memory reused across calls to
+// objcpy(std::list<std::unique_ptr<C2Work>> -> WorkBundle).
+//
+// Without an arena, every params blob (block metadata, buffer info, tunings and
+// config updates) and every array of a WorkBundle is a separate allocation, as
+// are the nodes of the table that deduplicates base blocks. With an arena, all
+// of them are laid out in memory owned by the arena, which is recycled by the
+// next conversion. A connection that sends work at a steady rate therefore
+// stops allocating for marshalling after a few bundles.
+//
+// A WorkBundle converted with an arena refers to the arena's memory. It is
+// only valid until the arena is used for another conversion or destroyed,
+// which is long enough to make the HIDL call that sends it. An arena is not
+// thread-safe: each connection should own one and serialize its use.
+struct WorkBundleArena {
+    WorkBundleArena() = default;
+    WorkBundleArena(const WorkBundleArena&) = delete;
+    WorkBundleArena& operator=(const WorkBundleArena&) = delete;
+
+    // Recycles the memory of the previous conversion. WorkBundles converted
+    // with this arena become invalid.
+    void reset();
+
+    // Returns size zeroed bytes, aligned to 8 bytes.
+    uint8_t* allocateBytes(size_t size);
+
+    // Returns count default-valued objects of type T (Work, Worklet, Buffer or
+    // Block).
+    template <typename T>
+    T* allocate(size_t count);
+
+    // Deduplication table of the base blocks of a WorkBundle. Blocks are
+    // identified by their native handle or their BufferPoolData.
+    struct BaseBlockTable {
+        std::vector<BaseBlock> blocks;
+        std::vector<const void*> keys; // parallel to blocks
+
+        // Returns the index of the base block with the given key, or
+        // blocks.size() if there is none.
+        uint32_t find(const void* key) const;
+        void clear();
+    };
+    BaseBlockTable baseBlocks;
+
+private:
+    // Memory is handed out from the last chunk. reset() merges the chunks into
+    // a single one large enough for the previous conversion.
+    template <typename T>
+    struct Pool {
+        std::vector<std::unique_ptr<T[]>> chunks;
+        std::vector<size_t> chunkSizes;
+        size_t used = 0; // in the last chunk
+        size_t total = 0; // handed out since the last reset()
+
+        T* allocate(size_t count);
+        void reset();
+    };
+
+    Pool<uint64_t> mBytes;
+    Pool<Work> mWorks;
+    Pool<Worklet> mWorklets;
+    Pool<Buffer> mBuffers;
+    Pool<Block> mBlocks;
+};
+
+template <>
+Work* WorkBundleArena::allocate<Work>(size_t count);
+template <>
+Worklet* WorkBundleArena::allocate<Worklet>(size_t count);
+template <>
+Buffer* WorkBundleArena::allocate<Buffer>(size_t count);
+template <>
+Block* WorkBundleArena::allocate<Block>(size_t count);
+
 // std::list<std::unique_ptr<C2Work>> -> WorkBundle
 // Note: If bufferpool will be used, bpSender must not be null.
 bool objcpy(
@@ -232,6 +308,15 @@ bool objcpy(
         const std::list<std::unique_ptr<C2Work>>& s,
         BufferPoolSender* bpSender = nullptr);
 
+// std::list<std::unique_ptr<C2Work>> -> WorkBundle
+// Same as above, but d is laid out in arena, which is reset first. d is valid
+// until arena is reset again.
+bool objcpy(
+        WorkBundle* d,
+        const std::list<std::unique_ptr<C2Work>>& s,
+        BufferPoolSender* bpSender,
+        WorkBundleArena* arena);
+
 // WorkBundle -> std::list<std::unique_ptr<C2Work>>
 bool objcpy(
         std::list<std::unique_ptr<C2Work>>* d,
@@ -284,10 +369,10 @@ bool createParamsBlob(
  */
 bool copyParamsFromBlob(
         std::vector<std::unique_ptr<C2Param>>* params,
-        Params blob);
+        const Params& blob);
 bool copyParamsFromBlob(
         std::vector<std::unique_ptr<C2Tuning>>* params,
-        Params blob);
+        const Params& blob);
 
 /**
  * Parses a params blob and applies updates to params.
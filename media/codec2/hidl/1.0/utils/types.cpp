@@ -33,6 +33,7 @@
 #include <util/C2ParamUtils.h>
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <iomanip>
 #include <unordered_map>
@@ -641,27 +642,60 @@ bool objcpy(std::unique_ptr<C2StructDescriptor> *d, const StructDescriptor &s) {
 
 namespace /* unnamed */ {
 
-// Find or add a hidl BaseBlock object from a given C2Handle* to a list and an
-// associated map.
+// State shared by the conversions that make up a single WorkBundle.
+struct EncodeContext {
+    BufferPoolSender* bufferPoolSender;
+    // Base blocks referred to by the Blocks of the bundle.
+    WorkBundleArena::BaseBlockTable* baseBlocks;
+    // Memory of the bundle's arrays and params blobs. If null, the bundle owns
+    // its memory.
+    WorkBundleArena* arena;
+};
+
+// Sets the size of a hidl_vec of Work, Worklet, Buffer or Block. The elements
+// are default-valued.
+template <typename T>
+void resizeVec(hidl_vec<T>* d, size_t size, WorkBundleArena* arena) {
+    if (arena) {
+        d->setToExternal(arena->allocate<T>(size), size);
+    } else {
+        d->resize(size);
+    }
+}
+
+// Sets the size of a hidl_vec whose type has no pool in WorkBundleArena. Only
+// empty vectors can be laid out in the arena. They are by far the common case.
+template <typename T>
+void resizeUnpooledVec(hidl_vec<T>* d, size_t size, WorkBundleArena* arena) {
+    if (arena && size == 0) {
+        d->setToExternal(nullptr, 0);
+    } else {
+        d->resize(size);
+    }
+}
+
+// Concatenates params into a blob. If arena is not null, the blob is laid out
+// in the arena. Defined with _createParamsBlob() below.
+template <typename T>
+bool createParamsBlob(
+        hidl_vec<uint8_t> *blob, const T &params, WorkBundleArena* arena);
+
+// Find or add a hidl BaseBlock object from a given C2Handle* to a table.
 // Note: The handle is not cloned.
 bool _addBaseBlock(
         uint32_t* index,
         const C2Handle* handle,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        WorkBundleArena::BaseBlockTable* baseBlocks) {
     if (!handle) {
         LOG(ERROR) << "addBaseBlock called on a null C2Handle.";
         return false;
     }
-    auto it = baseBlockIndices->find(handle);
-    if (it != baseBlockIndices->end()) {
-        *index = it->second;
-    } else {
-        *index = baseBlocks->size();
-        baseBlockIndices->emplace(handle, *index);
-        baseBlocks->emplace_back();
+    *index = baseBlocks->find(handle);
+    if (*index == baseBlocks->blocks.size()) {
+        baseBlocks->keys.emplace_back(handle);
+        baseBlocks->blocks.emplace_back();
 
-        BaseBlock &dBaseBlock = baseBlocks->back();
+        BaseBlock &dBaseBlock = baseBlocks->blocks.back();
         // This does not clone the handle.
         dBaseBlock.nativeBlock(
                 reinterpret_cast<const native_handle_t*>(handle));
@@ -670,27 +704,22 @@ bool _addBaseBlock(
     return true;
 }
 
-// Find or add a hidl BaseBlock object from a given BufferPoolData to a list and
-// an associated map.
+// Find or add a hidl BaseBlock object from a given BufferPoolData to a table.
 bool _addBaseBlock(
         uint32_t* index,
         const std::shared_ptr<BufferPoolData> bpData,
         BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        WorkBundleArena::BaseBlockTable* baseBlocks) {
     if (!bpData) {
         LOG(ERROR) << "addBaseBlock called on a null BufferPoolData.";
         return false;
     }
-    auto it = baseBlockIndices->find(bpData.get());
-    if (it != baseBlockIndices->end()) {
-        *index = it->second;
-    } else {
-        *index = baseBlocks->size();
-        baseBlockIndices->emplace(bpData.get(), *index);
-        baseBlocks->emplace_back();
+    *index = baseBlocks->find(bpData.get());
+    if (*index == baseBlocks->blocks.size()) {
+        baseBlocks->keys.emplace_back(bpData.get());
+        baseBlocks->blocks.emplace_back();
 
-        BaseBlock &dBaseBlock = baseBlocks->back();
+        BaseBlock &dBaseBlock = baseBlocks->blocks.back();
 
         if (bufferPoolSender) {
             BufferStatusMessage pooledBlock;
@@ -714,14 +743,12 @@ bool addBaseBlock(
         uint32_t* index,
         const C2Handle* handle,
         const std::shared_ptr<const _C2BlockPoolData>& blockPoolData,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        EncodeContext* ctx) {
     if (!blockPoolData) {
         // No BufferPoolData ==> NATIVE block.
         return _addBaseBlock(
                 index, handle,
-                baseBlocks, baseBlockIndices);
+                ctx->baseBlocks);
     }
     switch (blockPoolData->getType()) {
     case _C2BlockPoolData::TYPE_BUFFERPOOL: {
@@ -734,7 +761,7 @@ bool addBaseBlock(
             }
             return _addBaseBlock(
                     index, bpData,
-                    bufferPoolSender, baseBlocks, baseBlockIndices);
+                    ctx->bufferPoolSender, ctx->baseBlocks);
         }
     case _C2BlockPoolData::TYPE_BUFFERQUEUE:
         uint32_t gen;
@@ -748,7 +775,7 @@ bool addBaseBlock(
         }
         return _addBaseBlock(
                 index, handle,
-                baseBlocks, baseBlockIndices);
+                ctx->baseBlocks);
     default:
         LOG(ERROR) << "Unknown C2BlockPoolData type.";
         return false;
@@ -778,13 +805,10 @@ bool objcpy(hidl_handle* d, const C2Fence& s) {
 // Note: Native handles are not duplicated. The original handles must not be
 // closed before the transaction is complete.
 bool objcpy(Block* d, const C2ConstLinearBlock& s,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        EncodeContext* ctx) {
     std::shared_ptr<const _C2BlockPoolData> bpData =
             _C2BlockFactory::GetLinearBlockPoolData(s);
-    if (!addBaseBlock(&d->index, s.handle(), bpData,
-            bufferPoolSender, baseBlocks, baseBlockIndices)) {
+    if (!addBaseBlock(&d->index, s.handle(), bpData, ctx)) {
         LOG(ERROR) << "Invalid block data in C2ConstLinearBlock.";
         return false;
     }
@@ -793,7 +817,8 @@ bool objcpy(Block* d, const C2ConstLinearBlock& s,
     C2Hidl_RangeInfo dRangeInfo;
     dRangeInfo.offset = static_cast<uint32_t>(s.offset());
     dRangeInfo.length = static_cast<uint32_t>(s.size());
-    if (!createParamsBlob(&d->meta, std::vector<C2Param*>{ &dRangeInfo })) {
+    if (!createParamsBlob(&d->meta, std::array<C2Param*, 1>{ &dRangeInfo },
+            ctx->arena)) {
         LOG(ERROR) << "Invalid range info in C2ConstLinearBlock.";
         return false;
     }
@@ -810,13 +835,10 @@ bool objcpy(Block* d, const C2ConstLinearBlock& s,
 // Note: Native handles are not duplicated. The original handles must not be
 // closed before the transaction is complete.
 bool objcpy(Block* d, const C2ConstGraphicBlock& s,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        EncodeContext* ctx) {
     std::shared_ptr<const _C2BlockPoolData> bpData =
             _C2BlockFactory::GetGraphicBlockPoolData(s);
-    if (!addBaseBlock(&d->index, s.handle(), bpData,
-            bufferPoolSender, baseBlocks, baseBlockIndices)) {
+    if (!addBaseBlock(&d->index, s.handle(), bpData, ctx)) {
         LOG(ERROR) << "Invalid block data in C2ConstGraphicBlock.";
         return false;
     }
@@ -828,7 +850,8 @@ bool objcpy(Block* d, const C2ConstGraphicBlock& s,
     dRectInfo.top = static_cast<uint32_t>(sRect.top);
     dRectInfo.width = static_cast<uint32_t>(sRect.width);
     dRectInfo.height = static_cast<uint32_t>(sRect.height);
-    if (!createParamsBlob(&d->meta, std::vector<C2Param*>{ &dRectInfo })) {
+    if (!createParamsBlob(&d->meta, std::array<C2Param*, 1>{ &dRectInfo },
+            ctx->arena)) {
         LOG(ERROR) << "Invalid rect info in C2ConstGraphicBlock.";
         return false;
     }
@@ -844,18 +867,15 @@ bool objcpy(Block* d, const C2ConstGraphicBlock& s,
 // C2BufferData -> Buffer
 // This function only fills in d->blocks.
 bool objcpy(Buffer* d, const C2BufferData& s,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
-    d->blocks.resize(
-            s.linearBlocks().size() +
-            s.graphicBlocks().size());
+        EncodeContext* ctx) {
+    resizeVec(&d->blocks,
+              s.linearBlocks().size() +
+              s.graphicBlocks().size(),
+              ctx->arena);
     size_t i = 0;
     for (const C2ConstLinearBlock& linearBlock : s.linearBlocks()) {
         Block& dBlock = d->blocks[i++];
-        if (!objcpy(
-                &dBlock, linearBlock,
-                bufferPoolSender, baseBlocks, baseBlockIndices)) {
+        if (!objcpy(&dBlock, linearBlock, ctx)) {
             LOG(ERROR) << "Invalid C2BufferData::linearBlocks. "
                        << "(Destination index = " << i - 1 << ".)";
             return false;
@@ -863,9 +883,7 @@ bool objcpy(Buffer* d, const C2BufferData& s,
     }
     for (const C2ConstGraphicBlock& graphicBlock : s.graphicBlocks()) {
         Block& dBlock = d->blocks[i++];
-        if (!objcpy(
-                &dBlock, graphicBlock,
-                bufferPoolSender, baseBlocks, baseBlockIndices)) {
+        if (!objcpy(&dBlock, graphicBlock, ctx)) {
             LOG(ERROR) << "Invalid C2BufferData::graphicBlocks. "
                        << "(Destination index = " << i - 1 << ".)";
             return false;
@@ -876,14 +894,12 @@ bool objcpy(Buffer* d, const C2BufferData& s,
 
 // C2Buffer -> Buffer
 bool objcpy(Buffer* d, const C2Buffer& s,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
-    if (!createParamsBlob(&d->info, s.info())) {
+        EncodeContext* ctx) {
+    if (!createParamsBlob(&d->info, s.info(), ctx->arena)) {
         LOG(ERROR) << "Invalid C2Buffer::info.";
         return false;
     }
-    if (!objcpy(d, s.data(), bufferPoolSender, baseBlocks, baseBlockIndices)) {
+    if (!objcpy(d, s.data(), ctx)) {
         LOG(ERROR) << "Invalid C2Buffer::data.";
         return false;
     }
@@ -892,56 +908,48 @@ bool objcpy(Buffer* d, const C2Buffer& s,
 
 // C2InfoBuffer -> InfoBuffer
 bool objcpy(InfoBuffer* d, const C2InfoBuffer& s,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        EncodeContext* ctx) {
     // TODO: C2InfoBuffer is not implemented.
     (void)d;
     (void)s;
-    (void)bufferPoolSender;
-    (void)baseBlocks;
-    (void)baseBlockIndices;
+    (void)ctx;
     LOG(INFO) << "InfoBuffer not implemented.";
     return true;
 }
 
 // C2FrameData -> FrameData
 bool objcpy(FrameData* d, const C2FrameData& s,
-        BufferPoolSender* bufferPoolSender,
-        std::list<BaseBlock>* baseBlocks,
-        std::map<const void*, uint32_t>* baseBlockIndices) {
+        EncodeContext* ctx) {
     d->flags = static_cast<hidl_bitfield<FrameData::Flags>>(s.flags);
     if (!objcpy(&d->ordinal, s.ordinal)) {
         LOG(ERROR) << "Invalid C2FrameData::ordinal.";
         return false;
     }
 
-    d->buffers.resize(s.buffers.size());
+    resizeVec(&d->buffers, s.buffers.size(), ctx->arena);
     size_t i = 0;
     for (const std::shared_ptr<C2Buffer>& sBuffer : s.buffers) {
         Buffer& dBuffer = d->buffers[i++];
         if (!sBuffer) {
             // A null (pointer to) C2Buffer corresponds to a Buffer with empty
             // info and blocks.
-            dBuffer.info.resize(0);
-            dBuffer.blocks.resize(0);
+            resizeUnpooledVec(&dBuffer.info, 0, ctx->arena);
+            resizeVec(&dBuffer.blocks, 0, ctx->arena);
             continue;
         }
-        if (!objcpy(
-                &dBuffer, *sBuffer,
-                bufferPoolSender, baseBlocks, baseBlockIndices)) {
+        if (!objcpy(&dBuffer, *sBuffer, ctx)) {
             LOG(ERROR) << "Invalid C2FrameData::buffers["
                        << i - 1 << "].";
             return false;
         }
     }
 
-    if (!createParamsBlob(&d->configUpdate, s.configUpdate)) {
+    if (!createParamsBlob(&d->configUpdate, s.configUpdate, ctx->arena)) {
         LOG(ERROR) << "Invalid C2FrameData::configUpdate.";
         return false;
     }
 
-    d->infoBuffers.resize(s.infoBuffers.size());
+    resizeUnpooledVec(&d->infoBuffers, s.infoBuffers.size(), ctx->arena);
     i = 0;
     for (const std::shared_ptr<C2InfoBuffer>& sInfoBuffer : s.infoBuffers) {
         InfoBuffer& dInfoBuffer = d->infoBuffers[i++];
@@ -950,8 +958,7 @@ bool objcpy(FrameData* d, const C2FrameData& s,
                        << i - 1 << "].";
             return false;
         }
-        if (!objcpy(&dInfoBuffer, *sInfoBuffer,
-                bufferPoolSender, baseBlocks, baseBlockIndices)) {
+        if (!objcpy(&dInfoBuffer, *sInfoBuffer, ctx)) {
             LOG(ERROR) << "Invalid C2FrameData::infoBuffers["
                        << i - 1 << "].";
             return false;
@@ -1061,26 +1068,16 @@ ResultStatus DefaultBufferPoolSender::send(
     return rs;
 }
 
+namespace /* unnamed */ {
+
 // std::list<std::unique_ptr<C2Work>> -> WorkBundle
-bool objcpy(
+// This function fills in everything but d->baseBlocks, which are collected in
+// ctx->baseBlocks.
+bool _objcpy(
         WorkBundle* d,
         const std::list<std::unique_ptr<C2Work>>& s,
-        BufferPoolSender* bufferPoolSender) {
-    // baseBlocks holds a list of BaseBlock objects that Blocks can refer to.
-    std::list<BaseBlock> baseBlocks;
-
-    // baseBlockIndices maps a raw pointer to native_handle_t or BufferPoolData
-    // inside baseBlocks to the corresponding index into baseBlocks. The keys
-    // (pointers) are used to identify blocks that have the same "base block" in
-    // s, a list of C2Work objects. Because baseBlocks will be copied into a
-    // hidl_vec eventually, the values of baseBlockIndices are zero-based
-    // integer indices instead of list iterators.
-    //
-    // Note that the pointers can be raw because baseBlockIndices has a shorter
-    // lifespan than all of base blocks.
-    std::map<const void*, uint32_t> baseBlockIndices;
-
-    d->works.resize(s.size());
+        EncodeContext* ctx) {
+    resizeVec(&d->works, s.size(), ctx->arena);
     size_t i = 0;
     for (const std::unique_ptr<C2Work>& sWork : s) {
         Work &dWork = d->works[i++];
@@ -1092,8 +1089,7 @@ bool objcpy(
         // chain info is not in use currently.
 
         // input
-        if (!objcpy(&dWork.input, sWork->input,
-                bufferPoolSender, &baseBlocks, &baseBlockIndices)) {
+        if (!objcpy(&dWork.input, sWork->input, ctx)) {
             LOG(ERROR) << "Invalid C2Work::input.";
             return false;
         }
@@ -1104,7 +1100,7 @@ bool objcpy(
         } else {
             // Parcel the worklets.
             hidl_vec<Worklet> &dWorklets = dWork.worklets;
-            dWorklets.resize(sWork->worklets.size());
+            resizeVec(&dWorklets, sWork->worklets.size(), ctx->arena);
             size_t j = 0;
             for (const std::unique_ptr<C2Worklet>& sWorklet : sWork->worklets)
             {
@@ -1120,14 +1116,16 @@ bool objcpy(
                         sWorklet->component);
 
                 // tunings
-                if (!createParamsBlob(&dWorklet.tunings, sWorklet->tunings)) {
+                if (!createParamsBlob(&dWorklet.tunings, sWorklet->tunings,
+                        ctx->arena)) {
                     LOG(ERROR) << "Invalid C2Work::worklets["
                                << j - 1 << "]->tunings.";
                     return false;
                 }
 
                 // failures
-                dWorklet.failures.resize(sWorklet->failures.size());
+                resizeUnpooledVec(&dWorklet.failures,
+                                  sWorklet->failures.size(), ctx->arena);
                 size_t k = 0;
                 for (const std::unique_ptr<C2SettingResult>& sFailure :
                         sWorklet->failures) {
@@ -1146,8 +1144,7 @@ bool objcpy(
                 }
 
                 // output
-                if (!objcpy(&dWorklet.output, sWorklet->output,
-                        bufferPoolSender, &baseBlocks, &baseBlockIndices)) {
+                if (!objcpy(&dWorklet.output, sWorklet->output, ctx)) {
                     LOG(ERROR) << "Invalid C2Work::worklets["
                                << j - 1 << "]->output.";
                     return false;
@@ -1162,18 +1159,137 @@ bool objcpy(
         dWork.result = static_cast<Status>(sWork->result);
     }
 
-    // Copy std::list<BaseBlock> to hidl_vec<BaseBlock>.
-    {
-        d->baseBlocks.resize(baseBlocks.size());
-        size_t i = 0;
-        for (const BaseBlock& baseBlock : baseBlocks) {
-            d->baseBlocks[i++] = baseBlock;
-        }
+    return true;
+}
+
+} // unnamed namespace
+
+// std::list<std::unique_ptr<C2Work>> -> WorkBundle
+bool objcpy(
+        WorkBundle* d,
+        const std::list<std::unique_ptr<C2Work>>& s,
+        BufferPoolSender* bufferPoolSender) {
+    // baseBlocks holds the BaseBlock objects that Blocks can refer to. Blocks
+    // that have the same "base block" in s, a list of C2Work objects, are
+    // identified by the raw pointer to their native_handle_t or BufferPoolData.
+    // The pointers can be raw because baseBlocks has a shorter lifespan than
+    // all of base blocks.
+    WorkBundleArena::BaseBlockTable baseBlocks;
+    EncodeContext ctx{bufferPoolSender, &baseBlocks, nullptr};
+    if (!_objcpy(d, s, &ctx)) {
+        return false;
     }
 
+    // Copy std::vector<BaseBlock> to hidl_vec<BaseBlock>.
+    d->baseBlocks = baseBlocks.blocks;
+    return true;
+}
+
+// std::list<std::unique_ptr<C2Work>> -> WorkBundle
+bool objcpy(
+        WorkBundle* d,
+        const std::list<std::unique_ptr<C2Work>>& s,
+        BufferPoolSender* bufferPoolSender,
+        WorkBundleArena* arena) {
+    if (!arena) {
+        return objcpy(d, s, bufferPoolSender);
+    }
+    arena->reset();
+    EncodeContext ctx{bufferPoolSender, &arena->baseBlocks, arena};
+    if (!_objcpy(d, s, &ctx)) {
+        return false;
+    }
+    d->baseBlocks.setToExternal(
+            arena->baseBlocks.blocks.data(), arena->baseBlocks.blocks.size());
     return true;
 }
 
+// WorkBundleArena's implementation
+
+void WorkBundleArena::reset() {
+    baseBlocks.clear();
+    mBytes.reset();
+    mWorks.reset();
+    mWorklets.reset();
+    mBuffers.reset();
+    mBlocks.reset();
+}
+
+uint8_t* WorkBundleArena::allocateBytes(size_t size) {
+    // mBytes hands out uint64_t so that params blobs stay 8-byte aligned.
+    return reinterpret_cast<uint8_t*>(
+            mBytes.allocate(align(size, sizeof(uint64_t)) / sizeof(uint64_t)));
+}
+
+template <typename T>
+T* WorkBundleArena::Pool<T>::allocate(size_t count) {
+    // Small chunks would only be merged away by the next reset().
+    constexpr size_t kMinChunkSize = 16;
+    if (count == 0) {
+        return nullptr;
+    }
+    total += count;
+    if (chunks.empty() || count > chunkSizes.back() - used) {
+        size_t size = std::max(count, chunks.empty() ?
+                kMinChunkSize : chunkSizes.back() * 2);
+        chunks.emplace_back(new T[size]);
+        chunkSizes.emplace_back(size);
+        used = 0;
+    }
+    T* p = chunks.back().get() + used;
+    used += count;
+    // Elements may hold values of a previous conversion. This also zeroes the
+    // padding of params blobs.
+    for (size_t i = 0; i < count; ++i) {
+        p[i] = T();
+    }
+    return p;
+}
+
+template <typename T>
+void WorkBundleArena::Pool<T>::reset() {
+    if (chunks.size() > 1) {
+        chunks.clear();
+        chunkSizes.clear();
+        chunks.emplace_back(new T[total]);
+        chunkSizes.emplace_back(total);
+    }
+    used = 0;
+    total = 0;
+}
+
+template <>
+Work* WorkBundleArena::allocate<Work>(size_t count) {
+    return mWorks.allocate(count);
+}
+
+template <>
+Worklet* WorkBundleArena::allocate<Worklet>(size_t count) {
+    return mWorklets.allocate(count);
+}
+
+template <>
+Buffer* WorkBundleArena::allocate<Buffer>(size_t count) {
+    return mBuffers.allocate(count);
+}
+
+template <>
+Block* WorkBundleArena::allocate<Block>(size_t count) {
+    return mBlocks.allocate(count);
+}
+
+uint32_t WorkBundleArena::BaseBlockTable::find(const void* key) const {
+    // A bundle refers to a handful of base blocks, so a linear search is
+    // cheaper than maintaining an index.
+    return static_cast<uint32_t>(
+            std::find(keys.begin(), keys.end(), key) - keys.begin());
+}
+
+void WorkBundleArena::BaseBlockTable::clear() {
+    blocks.clear();
+    keys.clear();
+}
+
 namespace /* unnamed */ {
 
 struct C2BaseBlock {
@@ -1578,7 +1694,9 @@ namespace /* unnamed */ {
  *         happens if the parameters were not const)
  */
 template <typename T>
-bool _createParamsBlob(hidl_vec<uint8_t> *blob, const T &params) {
+bool _createParamsBlob(
+        hidl_vec<uint8_t> *blob, const T &params,
+        WorkBundleArena* arena = nullptr) {
     // assuming the parameter values are const
     size_t size = 0;
     for (const auto &p : params) {
@@ -1588,7 +1706,11 @@ bool _createParamsBlob(hidl_vec<uint8_t> *blob, const T &params) {
         size += p->size();
         size = align(size, PARAMS_ALIGNMENT);
     }
-    blob->resize(size);
+    if (arena) {
+        blob->setToExternal(arena->allocateBytes(size), size);
+    } else {
+        blob->resize(size);
+    }
     size_t ix = 0;
     for (const auto &p : params) {
         if (!p) {
@@ -1603,14 +1725,20 @@ bool _createParamsBlob(hidl_vec<uint8_t> *blob, const T &params) {
         ix += paramSize;
         ix = align(ix, PARAMS_ALIGNMENT);
     }
-    blob->resize(ix);
     if (ix != size) {
+        blob->resize(ix);
         LOG(ERROR) << "createParamsBlob -- inconsistent sizes.";
         return false;
     }
     return true;
 }
 
+template <typename T>
+bool createParamsBlob(
+        hidl_vec<uint8_t> *blob, const T &params, WorkBundleArena* arena) {
+    return _createParamsBlob(blob, params, arena);
+}
+
 /**
  * Parses a params blob and create a vector of new T objects that contain copies
  * of the params in the blob. T is C2Param or its compatible derived class.
@@ -1623,7 +1751,7 @@ bool _createParamsBlob(hidl_vec<uint8_t> *blob, const T &params) {
 template <typename T>
 bool _copyParamsFromBlob(
         std::vector<std::unique_ptr<T>>* params,
-        Params blob) {
+        const Params& blob) {
 
     std::vector<C2Param*> paramPointers;
     if (!parseParamsBlob(&paramPointers, blob)) {
@@ -1684,14 +1812,14 @@ bool createParamsBlob(
 // Params -> std::vector<std::unique_ptr<C2Param>>
 bool copyParamsFromBlob(
         std::vector<std::unique_ptr<C2Param>>* params,
-        Params blob) {
+        const Params& blob) {
     return _copyParamsFromBlob(params, blob);
 }
 
 // Params -> std::vector<std::unique_ptr<C2Tuning>>
 bool copyParamsFromBlob(
         std::vector<std::unique_ptr<C2Tuning>>* params,
-        Params blob) {
+        const Params& blob) {
     return _copyParamsFromBlob(params, blob);
 }
 
@@ -83,6 +83,7 @@ using ::android::hardware::media::c2::V1_0::utils::updateParamsFromBlob;
 
 using ::android::hardware::media::c2::V1_0::utils::BufferPoolSender;
 using ::android::hardware::media::c2::V1_0::utils::DefaultBufferPoolSender;
+using ::android::hardware::media::c2::V1_0::utils::WorkBundleArena;
 
 using ::android::hardware::media::c2::V1_0::utils::beginTransferBufferQueueBlock;
 using ::android::hardware::media::c2::V1_0::utils::beginTransferBufferQueueBlocks;
@@ -591,6 +591,11 @@ struct Codec2Client::Component::BufferPoolSender :
     }
 };
 
+// Codec2Client::Component::WorkBundleArena
+struct Codec2Client::Component::WorkBundleArena :
+        hardware::media::c2::V1_1::utils::WorkBundleArena {
+};
+
 // Codec2Client::Component::OutputBufferQueue
 struct Codec2Client::Component::OutputBufferQueue :
         hardware::media::c2::V1_1::utils::OutputBufferQueue {
@@ -1206,6 +1211,7 @@ Codec2Client::Component::Component(const sp<Base>& base)
         mBase1_0{base},
         mBase1_1{Base1_1::castFrom(base)},
         mBufferPoolSender{std::make_unique<BufferPoolSender>()},
+        mWorkBundleArena{std::make_unique<WorkBundleArena>()},
         mOutputBufferQueue{std::make_unique<OutputBufferQueue>()} {
 }
 
@@ -1228,6 +1234,7 @@ Codec2Client::Component::Component(const sp<Base1_1>& base)
         mBase1_0{base},
         mBase1_1{base},
         mBufferPoolSender{std::make_unique<BufferPoolSender>()},
+        mWorkBundleArena{std::make_unique<WorkBundleArena>()},
         mOutputBufferQueue{std::make_unique<OutputBufferQueue>()} {
 }
 
@@ -1281,8 +1288,11 @@ void Codec2Client::Component::handleOnWorkDone(
 
 c2_status_t Codec2Client::Component::queue(
         std::list<std::unique_ptr<C2Work>>* const items) {
+    // workBundle refers to mWorkBundleArena until queue() returns.
+    std::lock_guard<std::mutex> lock(mWorkBundleArenaMutex);
     WorkBundle workBundle;
-    if (!objcpy(&workBundle, *items, mBufferPoolSender.get())) {
+    if (!objcpy(&workBundle, *items, mBufferPoolSender.get(),
+                mWorkBundleArena.get())) {
         LOG(ERROR) << "queue -- bad input.";
         return C2_TRANSACTION_FAILED;
     }
@@ -422,6 +422,11 @@ protected:
     struct BufferPoolSender;
     std::unique_ptr<BufferPoolSender> mBufferPoolSender;
 
+    // Marshalling memory reused by queue().
+    struct WorkBundleArena;
+    std::mutex mWorkBundleArenaMutex;
+    std::unique_ptr<WorkBundleArena> mWorkBundleArena;
+
     struct OutputBufferQueue;
     std::unique_ptr<OutputBufferQueue> mOutputBufferQueue;
 
@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+#include <list>
+
 #include <gtest/gtest.h>
 
 #include <C2AllocatorIon.h>
 #include <C2AllocatorGralloc.h>
+#include <C2AllocatorMemfd.h>
 #include <C2Buffer.h>
 #include <C2BufferPriv.h>
 #include <C2ParamDef.h>
@@ -765,4 +768,129 @@ TEST_F(C2BufferTest, MultipleLinearMapTest) {
     }
 }
 
+class C2RecyclingLinearBlockPoolTest : public ::testing::Test {
+public:
+    C2RecyclingLinearBlockPoolTest()
+        : mAllocator(std::make_shared<C2AllocatorMemfd>('m')) {
+    }
+
+    // Fetches, writes and releases |count| blocks of |capacity| bytes, |inFlight| at a time,
+    // the way a software audio component produces its output.
+    void produce(const std::shared_ptr<C2BlockPool> &pool,
+                 uint32_t capacity, int count, int inFlight) {
+        std::list<std::shared_ptr<C2LinearBlock>> blocks;
+        for (int i = 0; i < count; ++i) {
+            std::shared_ptr<C2LinearBlock> block;
+            ASSERT_EQ(C2_OK, pool->fetchLinearBlock(
+                    capacity,
+                    { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE },
+                    &block));
+            ASSERT_TRUE(block);
+            ASSERT_EQ(capacity, block->size());
+            C2WriteView view = block->map().get();
+            ASSERT_EQ(C2_OK, view.error());
+            memset(view.data(), i & 0xFF, view.capacity());
+
+            C2ReadView readView = block->share(0, capacity, C2Fence()).map().get();
+            ASSERT_EQ(C2_OK, readView.error());
+            ASSERT_EQ(i & 0xFF, readView.data()[capacity - 1]);
+
+            blocks.push_back(block);
+            if (blocks.size() > size_t(inFlight)) {
+                blocks.pop_front();
+            }
+        }
+    }
+
+protected:
+    // The pool is not served by GetCodec2BlockPool(), its owner picks the local id.
+    static constexpr C2BlockPool::local_id_t kLocalId = C2BlockPool::PLATFORM_START + 1;
+
+    std::shared_ptr<C2AllocatorMemfd> mAllocator;
+};
+
+TEST_F(C2RecyclingLinearBlockPoolTest, AllocationCounts) {
+    constexpr uint32_t kCapacity = 8192u;
+    constexpr int kCount = 1000;
+    constexpr int kInFlight = 4;
+
+    C2AllocatorMemfd::Stats before = mAllocator->getStats();
+    produce(std::make_shared<C2BasicLinearBlockPool>(mAllocator), kCapacity, kCount, kInFlight);
+    C2AllocatorMemfd::Stats basic = mAllocator->getStats();
+
+    std::shared_ptr<C2RecyclingLinearBlockPool> pool =
+        std::make_shared<C2RecyclingLinearBlockPool>(mAllocator, kLocalId);
+    produce(pool, kCapacity, kCount, kInFlight);
+    C2AllocatorMemfd::Stats recycling = mAllocator->getStats();
+
+    uint64_t basicAllocations = basic.allocations - before.allocations;
+    uint64_t basicMmaps = basic.mmaps - before.mmaps;
+    uint64_t recyclingAllocations = recycling.allocations - basic.allocations;
+    uint64_t recyclingMmaps = recycling.mmaps - basic.mmaps;
+    printf("%d blocks of %u bytes: basic pool %llu allocations %llu mmaps, "
+           "recycling pool %llu allocations %llu mmaps\n",
+           kCount, kCapacity,
+           (unsigned long long)basicAllocations, (unsigned long long)basicMmaps,
+           (unsigned long long)recyclingAllocations, (unsigned long long)recyclingMmaps);
+
+    EXPECT_EQ(uint64_t(kCount), basicAllocations);
+    EXPECT_EQ(uint64_t(2 * kCount), basicMmaps);
+    // one allocation, mapped once, per block in flight
+    EXPECT_EQ(uint64_t(kInFlight + 1), recyclingAllocations);
+    EXPECT_EQ(recyclingAllocations, recyclingMmaps);
+
+    C2RecyclingLinearBlockPool::Stats stats = pool->getStats();
+    EXPECT_EQ(uint64_t(kCount), stats.fetches);
+    EXPECT_EQ(uint64_t(kCount - kInFlight - 1), stats.recycled);
+    EXPECT_EQ(size_t(kInFlight + 1), stats.freeCount);
+}
+
+TEST_F(C2RecyclingLinearBlockPoolTest, SizeClassesAndTrim) {
+    std::shared_ptr<C2RecyclingLinearBlockPool> pool =
+        std::make_shared<C2RecyclingLinearBlockPool>(mAllocator, kLocalId);
+    const C2MemoryUsage usage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+
+    std::shared_ptr<C2LinearBlock> block;
+    ASSERT_EQ(C2_OK, pool->fetchLinearBlock(3000u, usage, &block));
+    const C2Handle *handle = block->handle();
+    block.reset();
+
+    // served by the same 4KiB size class
+    ASSERT_EQ(C2_OK, pool->fetchLinearBlock(4096u, usage, &block));
+    EXPECT_EQ(handle, block->handle());
+    EXPECT_EQ(4096u, block->size());
+    block.reset();
+
+    // another size class
+    ASSERT_EQ(C2_OK, pool->fetchLinearBlock(5000u, usage, &block));
+    EXPECT_NE(handle, block->handle());
+    block.reset();
+
+    // blocks over the largest size class are not pooled
+    ASSERT_EQ(C2_OK, pool->fetchLinearBlock(4u << 20, usage, &block));
+    block.reset();
+    EXPECT_EQ(2u, pool->getStats().freeCount);
+    EXPECT_EQ(4096u + 8192u, pool->getStats().freeBytes);
+
+    uint64_t munmaps = mAllocator->getStats().munmaps;
+    C2RecyclingLinearBlockPool::TrimAll();
+    EXPECT_EQ(0u, pool->getStats().freeCount);
+    EXPECT_EQ(0u, pool->getStats().freeBytes);
+    EXPECT_EQ(munmaps + 2, mAllocator->getStats().munmaps);
+
+    // blocks outliving their pool are released, not recycled
+    ASSERT_EQ(C2_OK, pool->fetchLinearBlock(4096u, usage, &block));
+    pool.reset();
+    munmaps = mAllocator->getStats().munmaps;
+    block.reset();
+    EXPECT_EQ(munmaps + 1, mAllocator->getStats().munmaps);
+}
+
+TEST_F(C2RecyclingLinearBlockPoolTest, LocalId) {
+    std::shared_ptr<C2RecyclingLinearBlockPool> pool =
+        std::make_shared<C2RecyclingLinearBlockPool>(mAllocator, kLocalId);
+    EXPECT_EQ(kLocalId, pool->getLocalId());
+    EXPECT_EQ(mAllocator->getId(), pool->getAllocatorId());
+}
+
 } // namespace android
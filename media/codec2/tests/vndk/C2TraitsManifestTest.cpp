@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <android-base/file.h>
+
+#include <C2TraitsManifest.h>
+
+namespace android {
+
+class C2TraitsManifestTest : public ::testing::Test {
+protected:
+    static constexpr const char *kFingerprint = "vendor/product/device:13/ABC/1:user/release-keys";
+    static constexpr const char *kLibDir = "/apex/com.android.media.swcodec/lib64";
+
+    std::string manifestPath() const {
+        return std::string(mDir.path) + "/codec2_traits64.manifest";
+    }
+
+    static std::map<C2String, C2TraitsManifest::Entry> makeEntries() {
+        std::shared_ptr<C2Component::Traits> traits = std::make_shared<C2Component::Traits>();
+        traits->name = "c2.android.aac.decoder";
+        traits->domain = C2Component::DOMAIN_AUDIO;
+        traits->kind = C2Component::KIND_DECODER;
+        traits->rank = 8;
+        traits->mediaType = "audio/mp4a-latm";
+        traits->aliases = { "OMX.google.aac.decoder" };
+
+        std::map<C2String, C2TraitsManifest::Entry> entries;
+        entries["libcodec2_soft_aacdec.so"] = { 123456, 1600000000123456789LL, traits };
+        // a library without component
+        entries["libcodec2_soft_rawdec.so"] = { 4096, 1600000000000000000LL, nullptr };
+        return entries;
+    }
+
+    TemporaryDir mDir;
+};
+
+TEST_F(C2TraitsManifestTest, WriteAndRead) {
+    C2TraitsManifest manifest(manifestPath(), kFingerprint, kLibDir);
+    std::map<C2String, C2TraitsManifest::Entry> entries;
+    EXPECT_FALSE(manifest.read(&entries)) << "no manifest yet";
+
+    ASSERT_TRUE(manifest.write(makeEntries()));
+    ASSERT_TRUE(manifest.read(&entries));
+
+    ASSERT_EQ(2u, entries.size());
+    const C2TraitsManifest::Entry &aac = entries["libcodec2_soft_aacdec.so"];
+    EXPECT_EQ(123456, aac.size);
+    EXPECT_EQ(1600000000123456789LL, aac.mtimeNs);
+    ASSERT_NE(nullptr, aac.traits);
+    EXPECT_EQ("c2.android.aac.decoder", aac.traits->name);
+    EXPECT_EQ(C2Component::DOMAIN_AUDIO, aac.traits->domain);
+    EXPECT_EQ(C2Component::KIND_DECODER, aac.traits->kind);
+    EXPECT_EQ(8u, aac.traits->rank);
+    EXPECT_EQ("audio/mp4a-latm", aac.traits->mediaType);
+    EXPECT_EQ(std::vector<C2String>{ "OMX.google.aac.decoder" }, aac.traits->aliases);
+
+    const C2TraitsManifest::Entry &raw = entries["libcodec2_soft_rawdec.so"];
+    EXPECT_EQ(4096, raw.size);
+    EXPECT_EQ(nullptr, raw.traits);
+}
+
+TEST_F(C2TraitsManifestTest, RejectsOtherBuild) {
+    ASSERT_TRUE(C2TraitsManifest(manifestPath(), kFingerprint, kLibDir).write(makeEntries()));
+
+    std::map<C2String, C2TraitsManifest::Entry> entries;
+    C2TraitsManifest updated(
+            manifestPath(), "vendor/product/device:13/ABC/2:user/release-keys", kLibDir);
+    EXPECT_FALSE(updated.read(&entries));
+    EXPECT_TRUE(entries.empty());
+}
+
+TEST_F(C2TraitsManifestTest, RejectsOtherLibDir) {
+    ASSERT_TRUE(C2TraitsManifest(manifestPath(), kFingerprint, kLibDir).write(makeEntries()));
+
+    std::map<C2String, C2TraitsManifest::Entry> entries;
+    C2TraitsManifest other(manifestPath(), kFingerprint, "/apex/com.android.media.swcodec/lib");
+    EXPECT_FALSE(other.read(&entries));
+    EXPECT_TRUE(entries.empty());
+}
+
+TEST_F(C2TraitsManifestTest, RejectsCorruptedManifest) {
+    C2TraitsManifest manifest(manifestPath(), kFingerprint, kLibDir);
+    ASSERT_TRUE(manifest.write(makeEntries()));
+    std::string contents;
+    ASSERT_TRUE(base::ReadFileToString(manifestPath(), &contents));
+    ASSERT_TRUE(base::WriteStringToFile(contents + "lib truncated\n", manifestPath()));
+
+    std::map<C2String, C2TraitsManifest::Entry> entries;
+    EXPECT_FALSE(manifest.read(&entries));
+    EXPECT_TRUE(entries.empty());
+}
+
+} // namespace android
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "C2AllocatorMemfd"
+#include <utils/Log.h>
+
+#include <list>
+#include <mutex>
+
+#include <linux/memfd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h> // close, ftruncate, getpagesize, syscall
+
+#include <C2AllocatorMemfd.h>
+#include <C2Buffer.h>
+#include <C2Debug.h>
+#include <C2ErrnoUtils.h>
+
+namespace android {
+
+/* ======================================= MEMFD HANDLE ====================================== */
+namespace {
+
+struct C2HandleMemfd : public C2Handle {
+    // memfd handle owns the buffer fd
+    C2HandleMemfd(int bufferFd, size_t size)
+        : C2Handle(cHeader),
+          mFds{ bufferFd },
+          mInts{ int(size & 0xFFFFFFFF), int((uint64_t(size) >> 32) & 0xFFFFFFFF), kMagic } { }
+
+    static bool isValid(const C2Handle * const o) {
+        if (!o || memcmp(o, &cHeader, sizeof(cHeader))) {
+            return false;
+        }
+        const C2HandleMemfd *other = static_cast<const C2HandleMemfd*>(o);
+        return other->mInts.mMagic == kMagic;
+    }
+
+    int bufferFd() const { return mFds.mBuffer; }
+    size_t size() const {
+        return size_t(unsigned(mInts.mSizeLo))
+                | size_t(uint64_t(unsigned(mInts.mSizeHi)) << 32);
+    }
+
+protected:
+    struct {
+        int mBuffer; // memfd
+    } mFds;
+    struct {
+        int mSizeLo; // low 32-bits of size
+        int mSizeHi; // high 32-bits of size
+        int mMagic;
+    } mInts;
+
+private:
+    enum {
+        kMagic = '\xc2mf\x00',
+        numFds = sizeof(mFds) / sizeof(int),
+        numInts = sizeof(mInts) / sizeof(int),
+        version = sizeof(C2Handle)
+    };
+    const static C2Handle cHeader;
+};
+
+const C2Handle C2HandleMemfd::cHeader = {
+    C2HandleMemfd::version,
+    C2HandleMemfd::numFds,
+    C2HandleMemfd::numInts,
+    {}
+};
+
+int createMemfd(size_t capacity, int *err) {
+    // bionic only exposes memfd_create() from API level 30
+    int fd = syscall(__NR_memfd_create, "C2AllocatorMemfd", MFD_CLOEXEC);
+    if (fd < 0) {
+        *err = errno;
+        return -1;
+    }
+    if (ftruncate(fd, capacity) != 0) {
+        *err = errno;
+        close(fd);
+        return -1;
+    }
+    *err = 0;
+    return fd;
+}
+
+} // namespace
+
+/* ===================================== MEMFD ALLOCATION ==================================== */
+class C2AllocationMemfd : public C2LinearAllocation {
+public:
+    /* Interface methods */
+    virtual c2_status_t map(
+        size_t offset, size_t size, C2MemoryUsage usage, C2Fence *fence,
+        void **addr /* nonnull */) override;
+    virtual c2_status_t unmap(void *addr, size_t size, C2Fence *fenceFd) override;
+    virtual ~C2AllocationMemfd() override;
+    virtual const C2Handle *handle() const override { return &mHandle; }
+    virtual id_t getAllocatorId() const override { return mId; }
+    virtual bool equals(const std::shared_ptr<C2LinearAllocation> &other) const override {
+        return other && other->handle() == handle();
+    }
+
+    // internal methods
+
+    /**
+     * Constructs a memfd allocation. Ownership of |bufferFd| is transferred to the allocation.
+     */
+    C2AllocationMemfd(size_t capacity, int bufferFd, C2Allocator::id_t id,
+                      const std::shared_ptr<C2AllocatorMemfd::Counters> &counters)
+        : C2LinearAllocation(capacity),
+          mHandle(bufferFd, capacity),
+          mId(id),
+          mCounters(counters) { }
+
+private:
+    C2HandleMemfd mHandle;
+    const C2Allocator::id_t mId;
+    const std::shared_ptr<C2AllocatorMemfd::Counters> mCounters;
+
+    struct Mapping {
+        void *addr;
+        size_t alignmentBytes;
+        size_t size;
+    };
+    std::list<Mapping> mMappings;
+    std::mutex mMutexMappings;
+
+    C2_DO_NOT_COPY(C2AllocationMemfd);
+};
+
+c2_status_t C2AllocationMemfd::map(
+        size_t offset, size_t size, C2MemoryUsage usage, C2Fence *fence, void **addr) {
+    (void)fence; // not using fences
+    *addr = nullptr;
+    if (size == 0 || offset > capacity() || size > capacity() - offset) {
+        return C2_BAD_VALUE;
+    }
+
+    int prot = PROT_NONE;
+    if (usage.expected & C2MemoryUsage::CPU_READ) {
+        prot |= PROT_READ;
+    }
+    if (usage.expected & C2MemoryUsage::CPU_WRITE) {
+        prot |= PROT_WRITE;
+    }
+
+    static const size_t kPageSize = ::getpagesize();
+    size_t alignmentBytes = offset % kPageSize;
+    size_t mapOffset = offset - alignmentBytes;
+    size_t mapSize = size + alignmentBytes;
+    void *base = mmap(nullptr, mapSize, prot, MAP_SHARED, mHandle.bufferFd(), mapOffset);
+    ALOGV("mmap(size = %zu, prot = %d, fd = %d, offset = %zu) returned (%d)",
+          mapSize, prot, mHandle.bufferFd(), mapOffset, errno);
+    if (base == MAP_FAILED) {
+        return c2_map_errno<EINVAL, ENOMEM>(errno);
+    }
+    mCounters->mmaps++;
+    *addr = (uint8_t *)base + alignmentBytes;
+    std::lock_guard<std::mutex> guard(mMutexMappings);
+    mMappings.push_back({ base, alignmentBytes, mapSize });
+    return C2_OK;
+}
+
+c2_status_t C2AllocationMemfd::unmap(void *addr, size_t size, C2Fence *fence) {
+    std::lock_guard<std::mutex> guard(mMutexMappings);
+    for (auto it = mMappings.begin(); it != mMappings.end(); ++it) {
+        if (addr != (uint8_t *)it->addr + it->alignmentBytes ||
+                size + it->alignmentBytes != it->size) {
+            continue;
+        }
+        if (munmap(it->addr, it->size) != 0) {
+            ALOGD("munmap failed");
+            return c2_map_errno<EINVAL>(errno);
+        }
+        mCounters->munmaps++;
+        if (fence) {
+            *fence = C2Fence(); // not using fences
+        }
+        (void)mMappings.erase(it);
+        return C2_OK;
+    }
+    ALOGD("unmap failed to find specified map");
+    return C2_BAD_VALUE;
+}
+
+C2AllocationMemfd::~C2AllocationMemfd() {
+    if (!mMappings.empty()) {
+        ALOGD("Dangling mappings!");
+        for (const Mapping &map : mMappings) {
+            (void)munmap(map.addr, map.size);
+            mCounters->munmaps++;
+        }
+    }
+    native_handle_close(&mHandle);
+}
+
+/* ===================================== MEMFD ALLOCATOR ===================================== */
+C2AllocatorMemfd::C2AllocatorMemfd(id_t id)
+    : mCounters(std::make_shared<Counters>()) {
+    C2MemoryUsage minUsage = { 0, 0 };
+    C2MemoryUsage maxUsage = { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE };
+    Traits traits = { "android.allocator.memfd", id, LINEAR, minUsage, maxUsage };
+    mTraits = std::make_shared<Traits>(traits);
+}
+
+C2Allocator::id_t C2AllocatorMemfd::getId() const {
+    return mTraits->id;
+}
+
+C2String C2AllocatorMemfd::getName() const {
+    return mTraits->name;
+}
+
+std::shared_ptr<const C2Allocator::Traits> C2AllocatorMemfd::getTraits() const {
+    return mTraits;
+}
+
+C2AllocatorMemfd::Stats C2AllocatorMemfd::getStats() const {
+    return { mCounters->allocations, mCounters->mmaps, mCounters->munmaps };
+}
+
+c2_status_t C2AllocatorMemfd::newLinearAllocation(
+        uint32_t capacity, C2MemoryUsage usage, std::shared_ptr<C2LinearAllocation> *allocation) {
+    (void)usage; // memfd buffers can be mapped for any CPU usage
+    if (allocation == nullptr) {
+        return C2_BAD_VALUE;
+    }
+    allocation->reset();
+    if (capacity == 0) {
+        return C2_BAD_VALUE;
+    }
+
+    int err = 0;
+    int fd = createMemfd(capacity, &err);
+    if (fd < 0) {
+        ALOGD("failed to create memfd of %u bytes: %d", capacity, err);
+        return c2_map_errno<ENOMEM>(err);
+    }
+    mCounters->allocations++;
+    *allocation = std::make_shared<C2AllocationMemfd>(capacity, fd, getId(), mCounters);
+    return C2_OK;
+}
+
+c2_status_t C2AllocatorMemfd::priorLinearAllocation(
+        const C2Handle *handle, std::shared_ptr<C2LinearAllocation> *allocation) {
+    *allocation = nullptr;
+    if (!C2HandleMemfd::isValid(handle)) {
+        return C2_BAD_VALUE;
+    }
+
+    const C2HandleMemfd *h = static_cast<const C2HandleMemfd*>(handle);
+    *allocation = std::make_shared<C2AllocationMemfd>(h->size(), h->bufferFd(), getId(), mCounters);
+    native_handle_delete(const_cast<native_handle_t*>(
+            reinterpret_cast<const native_handle_t*>(handle)));
+    return C2_OK;
+}
+
+bool C2AllocatorMemfd::isValid(const C2Handle* const o) {
+    return C2HandleMemfd::isValid(o);
+}
+
+} // namespace android
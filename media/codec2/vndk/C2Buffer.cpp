@@ -18,6 +18,7 @@
 #define LOG_TAG "C2Buffer"
 #include <utils/Log.h>
 
+#include <chrono>
 #include <list>
 #include <map>
 #include <mutex>
@@ -347,6 +348,320 @@ c2_status_t C2BasicLinearBlockPool::fetchLinearBlock(
     return C2_OK;
 }
 
+/**
+ * Recycling linear block pool implementation.
+ *
+ * Free allocations are kept per size class, most recently released first. Released allocations
+ * are unmapped outside of the pool lock.
+ */
+class C2RecyclingLinearBlockPool::Impl : public std::enable_shared_from_this<Impl> {
+public:
+    explicit Impl(const std::shared_ptr<C2Allocator> &allocator)
+        : mAllocator(allocator), mFreeBytes(0), mFetches(0), mRecycled(0), mAllocations(0) { }
+
+    c2_status_t fetchLinearBlock(
+            uint32_t capacity, C2MemoryUsage usage, std::shared_ptr<C2LinearBlock> *block);
+
+    void trim() {
+        std::list<std::shared_ptr<MappedAllocation>> released;
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (std::list<FreeAllocation> &freeList : mFree) {
+            for (FreeAllocation &entry : freeList) {
+                released.push_back(std::move(entry.allocation));
+            }
+            freeList.clear();
+        }
+        mFreeBytes = 0;
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        size_t freeCount = 0;
+        for (const std::list<FreeAllocation> &freeList : mFree) {
+            freeCount += freeList.size();
+        }
+        return { mFetches, mRecycled, mAllocations, freeCount, mFreeBytes };
+    }
+
+    static void Register(const std::shared_ptr<Impl> &impl) {
+        std::lock_guard<std::mutex> lock(PoolsMutex());
+        std::list<std::weak_ptr<Impl>> &pools = Pools();
+        pools.remove_if([](const std::weak_ptr<Impl> &pool) { return pool.expired(); });
+        pools.push_back(impl);
+    }
+
+    static void TrimAll() {
+        std::list<std::shared_ptr<Impl>> pools;
+        {
+            std::lock_guard<std::mutex> lock(PoolsMutex());
+            for (const std::weak_ptr<Impl> &weakPool : Pools()) {
+                std::shared_ptr<Impl> pool = weakPool.lock();
+                if (pool) {
+                    pools.push_back(pool);
+                }
+            }
+        }
+        for (const std::shared_ptr<Impl> &pool : pools) {
+            pool->trim();
+        }
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // Size classes are powers of two from 4KiB to 1MiB. Larger blocks are not recycled.
+    static constexpr size_t kMinSizeClassCapacity = 4096u;
+    static constexpr size_t kNumSizeClasses = 9;
+    // Budget of free allocations, which are released in LRU order beyond this
+    static constexpr size_t kMaxFreeBytes = 4u << 20;
+    static constexpr size_t kMaxFreePerSizeClass = 16;
+    // Free allocations unused for this long are released
+    static constexpr Clock::duration kIdleTimeout = std::chrono::seconds(5);
+
+    /**
+     * Allocation that stays mapped for CPU access for its whole lifetime, so that mapping and
+     * unmapping views of its blocks is free.
+     */
+    class MappedAllocation : public C2LinearAllocation {
+    public:
+        static std::shared_ptr<MappedAllocation> Create(
+                const std::shared_ptr<C2LinearAllocation> &allocation,
+                C2MemoryUsage usage, size_t sizeClass) {
+            void *base = nullptr;
+            c2_status_t err = allocation->map(
+                    0, allocation->capacity(),
+                    { C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE }, nullptr, &base);
+            if (err != C2_OK) {
+                ALOGD("failed to map recycled allocation: %d", err);
+                return nullptr;
+            }
+            return std::shared_ptr<MappedAllocation>(
+                    new MappedAllocation(allocation, usage, sizeClass, (uint8_t *)base));
+        }
+
+        virtual ~MappedAllocation() override {
+            (void)mAllocation->unmap(mBase, capacity(), nullptr);
+        }
+
+        virtual c2_status_t map(
+                size_t offset, size_t size, C2MemoryUsage usage, C2Fence *fence,
+                void **addr /* nonnull */) override {
+            (void)usage;
+            if (fence) {
+                *fence = C2Fence(); // not using fences
+            }
+            if (offset > capacity() || size > capacity() - offset) {
+                *addr = nullptr;
+                return C2_BAD_VALUE;
+            }
+            *addr = mBase + offset;
+            return C2_OK;
+        }
+
+        virtual c2_status_t unmap(void *addr, size_t size, C2Fence *fence) override {
+            (void)addr;
+            (void)size;
+            if (fence) {
+                *fence = C2Fence(); // not using fences
+            }
+            return C2_OK;
+        }
+
+        virtual const C2Handle *handle() const override {
+            return mAllocation->handle();
+        }
+
+        virtual id_t getAllocatorId() const override {
+            return mAllocation->getAllocatorId();
+        }
+
+        virtual bool equals(const std::shared_ptr<C2LinearAllocation> &other) const override {
+            return other && other->handle() == handle();
+        }
+
+        C2MemoryUsage usage() const { return mUsage; }
+        size_t sizeClass() const { return mSizeClass; }
+
+    private:
+        MappedAllocation(
+                const std::shared_ptr<C2LinearAllocation> &allocation, C2MemoryUsage usage,
+                size_t sizeClass, uint8_t *base)
+            : C2LinearAllocation(allocation->capacity()),
+              mAllocation(allocation),
+              mUsage(usage),
+              mSizeClass(sizeClass),
+              mBase(base) { }
+
+        const std::shared_ptr<C2LinearAllocation> mAllocation;
+        const C2MemoryUsage mUsage;
+        const size_t mSizeClass;
+        uint8_t *const mBase;
+    };
+
+    struct FreeAllocation {
+        std::shared_ptr<MappedAllocation> allocation;
+        Clock::time_point released;
+    };
+
+    static size_t SizeClass(uint32_t capacity) {
+        size_t sizeClass = 0;
+        while (sizeClass < kNumSizeClasses && (kMinSizeClassCapacity << sizeClass) < capacity) {
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+
+    static std::mutex &PoolsMutex() {
+        static std::mutex sMutex;
+        return sMutex;
+    }
+
+    static std::list<std::weak_ptr<Impl>> &Pools() {
+        static std::list<std::weak_ptr<Impl>> sPools;
+        return sPools;
+    }
+
+    // Called when the last reference to a block of |allocation| is released.
+    void recycle(const std::shared_ptr<MappedAllocation> &allocation) {
+        std::list<std::shared_ptr<MappedAllocation>> released;
+        std::lock_guard<std::mutex> lock(mMutex);
+        Clock::time_point now = Clock::now();
+        std::list<FreeAllocation> &freeList = mFree[allocation->sizeClass()];
+        freeList.push_front({ allocation, now });
+        mFreeBytes += kMinSizeClassCapacity << allocation->sizeClass();
+        if (freeList.size() > kMaxFreePerSizeClass) {
+            releaseOldestLocked(&freeList, &released);
+        }
+        expireLocked(now, &released);
+        while (mFreeBytes > kMaxFreeBytes) {
+            std::list<FreeAllocation> *oldest = nullptr;
+            for (std::list<FreeAllocation> &candidate : mFree) {
+                if (!candidate.empty() && (oldest == nullptr
+                        || candidate.back().released < oldest->back().released)) {
+                    oldest = &candidate;
+                }
+            }
+            releaseOldestLocked(oldest, &released);
+        }
+    }
+
+    void releaseOldestLocked(
+            std::list<FreeAllocation> *freeList,
+            std::list<std::shared_ptr<MappedAllocation>> *released) {
+        mFreeBytes -= kMinSizeClassCapacity << freeList->back().allocation->sizeClass();
+        released->push_back(std::move(freeList->back().allocation));
+        freeList->pop_back();
+    }
+
+    void expireLocked(
+            Clock::time_point now, std::list<std::shared_ptr<MappedAllocation>> *released) {
+        for (std::list<FreeAllocation> &freeList : mFree) {
+            while (!freeList.empty() && now - freeList.back().released > kIdleTimeout) {
+                releaseOldestLocked(&freeList, released);
+            }
+        }
+    }
+
+    const std::shared_ptr<C2Allocator> mAllocator;
+
+    mutable std::mutex mMutex;
+    std::list<FreeAllocation> mFree[kNumSizeClasses];
+    size_t mFreeBytes;
+    uint64_t mFetches;
+    uint64_t mRecycled;
+    uint64_t mAllocations;
+};
+
+c2_status_t C2RecyclingLinearBlockPool::Impl::fetchLinearBlock(
+        uint32_t capacity, C2MemoryUsage usage, std::shared_ptr<C2LinearBlock> *block) {
+    block->reset();
+
+    size_t sizeClass = SizeClass(capacity);
+    std::shared_ptr<MappedAllocation> allocation;
+    {
+        std::list<std::shared_ptr<MappedAllocation>> released;
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mFetches;
+        if (sizeClass < kNumSizeClasses) {
+            expireLocked(Clock::now(), &released);
+            std::list<FreeAllocation> &freeList = mFree[sizeClass];
+            for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+                if (it->allocation->usage().expected == usage.expected) {
+                    allocation = std::move(it->allocation);
+                    freeList.erase(it);
+                    mFreeBytes -= kMinSizeClassCapacity << sizeClass;
+                    ++mRecycled;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!allocation) {
+        std::shared_ptr<C2LinearAllocation> alloc;
+        uint32_t allocCapacity =
+                sizeClass < kNumSizeClasses ? kMinSizeClassCapacity << sizeClass : capacity;
+        c2_status_t err = mAllocator->newLinearAllocation(allocCapacity, usage, &alloc);
+        if (err != C2_OK) {
+            return err;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            ++mAllocations;
+        }
+        if (sizeClass < kNumSizeClasses) {
+            allocation = MappedAllocation::Create(alloc, usage, sizeClass);
+        }
+        if (!allocation) {
+            // too large or not mappable: not recycled
+            *block = _C2BlockFactory::CreateLinearBlock(alloc, nullptr, 0, capacity);
+            return *block ? C2_OK : C2_NO_MEMORY;
+        }
+    }
+
+    // The allocation returns to this pool (if still alive) once all blocks and views are gone.
+    std::weak_ptr<Impl> weakImpl = shared_from_this();
+    std::shared_ptr<C2LinearAllocation> recyclable(
+            allocation.get(), [weakImpl, allocation](C2LinearAllocation *) {
+                std::shared_ptr<Impl> impl = weakImpl.lock();
+                if (impl) {
+                    impl->recycle(allocation);
+                }
+            });
+    *block = _C2BlockFactory::CreateLinearBlock(recyclable, nullptr, 0, capacity);
+    return *block ? C2_OK : C2_NO_MEMORY;
+}
+
+C2RecyclingLinearBlockPool::C2RecyclingLinearBlockPool(
+        const std::shared_ptr<C2Allocator> &allocator, const local_id_t localId)
+    : mAllocator(allocator),
+      mLocalId(localId),
+      mImpl(std::make_shared<Impl>(allocator)) {
+    Impl::Register(mImpl);
+}
+
+C2RecyclingLinearBlockPool::~C2RecyclingLinearBlockPool() = default;
+
+c2_status_t C2RecyclingLinearBlockPool::fetchLinearBlock(
+        uint32_t capacity,
+        C2MemoryUsage usage,
+        std::shared_ptr<C2LinearBlock> *block /* nonnull */) {
+    return mImpl->fetchLinearBlock(capacity, usage, block);
+}
+
+void C2RecyclingLinearBlockPool::trim() {
+    mImpl->trim();
+}
+
+C2RecyclingLinearBlockPool::Stats C2RecyclingLinearBlockPool::getStats() const {
+    return mImpl->getStats();
+}
+
+// static
+void C2RecyclingLinearBlockPool::TrimAll() {
+    Impl::TrimAll();
+}
+
 struct C2_HIDE C2PooledBlockPoolData : _C2BlockPoolData {
 
     virtual type_t getType() const override {
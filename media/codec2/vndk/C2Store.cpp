@@ -27,12 +27,15 @@
 #include <C2Config.h>
 #include <C2PlatformStorePluginLoader.h>
 #include <C2PlatformSupport.h>
+#include <C2TraitsManifest.h>
 #include <cutils/properties.h>
 #include <util/C2InterfaceHelper.h>
 
 #include <dlfcn.h>
+#include <sys/stat.h>
 #include <unistd.h> // getpagesize
 
+#include <chrono>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -532,9 +535,6 @@ private:
 
     /**
      * An object encapsulating a loaded component module.
-     *
-     * \todo provide a way to add traits to known components here to avoid loading the .so-s
-     * for listComponents
      */
     struct ComponentModule : public C2ComponentFactory,
             public std::enable_shared_from_this<ComponentModule> {
@@ -720,11 +720,21 @@ private:
 
     /**
      * Loads each component module and discover its contents.
+     *
+     * Component modules whose traits are recorded in the traits manifest for the same library
+     * file are not loaded until one of their components or interfaces is created.
      */
     void visitComponents();
 
+    /**
+     * Retrieves the size and modification time of a component library.
+     */
+    bool statLibrary(const C2String &libPath, int64_t *size, int64_t *mtimeNs) const;
+
     std::mutex mMutex; ///< mutex guarding the component lists during construction
     bool mVisited; ///< component modules visited
+    std::unique_ptr<C2TraitsManifest> mManifest; ///< traits manifest, nullptr if not used
+    std::string mLibDir; ///< directory of the component libraries
     std::map<C2String, ComponentLoader> mComponents; ///< path -> component module
     std::map<C2String, C2String> mComponentNameToPath; ///< name -> path
     std::vector<std::shared_ptr<const C2Component::Traits>> mComponentList;
@@ -909,11 +919,42 @@ std::shared_ptr<const C2Component::Traits> C2PlatformComponentStore::ComponentMo
     return mTraits;
 }
 
+namespace {
+
+std::string getBuildFingerprint() {
+    char fingerprint[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", fingerprint, "");
+    return fingerprint;
+}
+
+} // namespace
+
 C2PlatformComponentStore::C2PlatformComponentStore()
     : mVisited(false),
       mReflector(std::make_shared<C2ReflectorHelper>()),
       mInterface(mReflector) {
 
+    // The component libraries are installed next to this library.
+    Dl_info info;
+    if (dladdr((void *)&GetCodec2PlatformComponentStore, &info) && info.dli_fname) {
+        std::string path(info.dli_fname);
+        size_t slash = path.rfind('/');
+        if (slash != std::string::npos) {
+            mLibDir = path.substr(0, slash);
+        }
+    }
+    char manifestDir[PROPERTY_VALUE_MAX];
+    if (!mLibDir.empty()
+            && property_get("debug.stagefright.c2-traits-manifest-dir", manifestDir, "") > 0) {
+#ifdef __LP64__
+        std::string manifestPath = std::string(manifestDir) + "/codec2_traits64.manifest";
+#else
+        std::string manifestPath = std::string(manifestDir) + "/codec2_traits.manifest";
+#endif
+        mManifest = std::make_unique<C2TraitsManifest>(
+                manifestPath, getBuildFingerprint(), mLibDir);
+    }
+
     auto emplace = [this](const char *libPath) {
         mComponents.emplace(libPath, libPath);
     };
@@ -972,27 +1013,74 @@ c2_status_t C2PlatformComponentStore::config_sm(
     return mInterface.config(params, C2_MAY_BLOCK, failures);
 }
 
+bool C2PlatformComponentStore::statLibrary(
+        const C2String &libPath, int64_t *size, int64_t *mtimeNs) const {
+    struct stat st;
+    if (mLibDir.empty() || stat((mLibDir + "/" + libPath).c_str(), &st) != 0) {
+        return false;
+    }
+    *size = st.st_size;
+    *mtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
 void C2PlatformComponentStore::visitComponents() {
     std::lock_guard<std::mutex> lock(mMutex);
     if (mVisited) {
         return;
     }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::map<C2String, C2TraitsManifest::Entry> manifest;
+    std::map<C2String, C2TraitsManifest::Entry> updatedManifest;
+    bool manifestChanged = false;
+    size_t numLoaded = 0;
+    if (mManifest) {
+        manifestChanged = !mManifest->read(&manifest);
+    }
     for (auto &pathAndLoader : mComponents) {
         const C2String &path = pathAndLoader.first;
         ComponentLoader &loader = pathAndLoader.second;
-        std::shared_ptr<ComponentModule> module;
-        if (loader.fetchModule(&module) == C2_OK) {
-            std::shared_ptr<const C2Component::Traits> traits = module->getTraits();
-            if (traits) {
-                mComponentList.push_back(traits);
-                mComponentNameToPath.emplace(traits->name, path);
-                for (const C2String &alias : traits->aliases) {
-                    mComponentNameToPath.emplace(alias, path);
-                }
+        C2TraitsManifest::Entry entry = { -1, -1, nullptr };
+        bool inManifest = false;
+        if (mManifest && statLibrary(path, &entry.size, &entry.mtimeNs)) {
+            auto it = manifest.find(path);
+            inManifest = it != manifest.end()
+                    && it->second.size == entry.size && it->second.mtimeNs == entry.mtimeNs;
+            if (inManifest) {
+                entry.traits = it->second.traits;
+            } else {
+                manifestChanged = true;
+            }
+            updatedManifest.emplace(path, entry);
+        }
+        if (!inManifest) {
+            std::shared_ptr<ComponentModule> module;
+            if (loader.fetchModule(&module) == C2_OK) {
+                entry.traits = module->getTraits();
+                ++numLoaded;
+            }
+            auto it = updatedManifest.find(path);
+            if (it != updatedManifest.end()) {
+                it->second.traits = entry.traits;
             }
         }
+        std::shared_ptr<const C2Component::Traits> traits = entry.traits;
+        if (traits) {
+            mComponentList.push_back(traits);
+            mComponentNameToPath.emplace(traits->name, path);
+            for (const C2String &alias : traits->aliases) {
+                mComponentNameToPath.emplace(alias, path);
+            }
+        }
+    }
+    if (mManifest && (manifestChanged || updatedManifest.size() != manifest.size())) {
+        mManifest->write(updatedManifest);
     }
     mVisited = true;
+    ALOGD("visited %zu component libraries (%zu loaded) in %lld us",
+            mComponents.size(), numLoaded,
+            (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count());
 }
 
 std::vector<std::shared_ptr<const C2Component::Traits>> C2PlatformComponentStore::listComponents() {
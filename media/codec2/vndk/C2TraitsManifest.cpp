@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "C2TraitsManifest"
+#include <utils/Log.h>
+
+#include <C2TraitsManifest.h>
+
+#include <android-base/file.h>
+#include <android-base/parseint.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+using namespace ::android;
+
+namespace {
+
+constexpr char kManifestMagic[] = "codec2-traits-manifest 1";
+
+} // namespace
+
+C2TraitsManifest::C2TraitsManifest(std::string path, std::string fingerprint, std::string libDir)
+    : mPath(std::move(path)),
+      mFingerprint(std::move(fingerprint)),
+      mLibDir(std::move(libDir)) {
+}
+
+bool C2TraitsManifest::read(std::map<C2String, Entry> *entries) const {
+    entries->clear();
+    std::string contents;
+    if (!base::ReadFileToString(mPath, &contents)) {
+        return false;
+    }
+    std::vector<std::string> lines = base::Split(contents, "\n");
+    if (lines.size() < 3 || lines[0] != kManifestMagic
+            || lines[1] != "fingerprint " + mFingerprint
+            || lines[2] != "libdir " + mLibDir) {
+        ALOGD("ignoring stale traits manifest %s", mPath.c_str());
+        return false;
+    }
+    // lib <path> <size> <mtime>
+    // traits <name> <domain> <kind> <rank> <media-type> [<alias>...]
+    Entry *entry = nullptr;
+    for (size_t i = 3; i < lines.size(); ++i) {
+        std::vector<std::string> fields = base::Split(lines[i], " ");
+        bool valid = false;
+        if (fields.size() == 4 && fields[0] == "lib") {
+            entry = &(*entries)[fields[1]];
+            entry->traits = nullptr;
+            valid = base::ParseInt(fields[2], &entry->size)
+                    && base::ParseInt(fields[3], &entry->mtimeNs);
+        } else if (fields.size() >= 6 && fields[0] == "traits" && entry && !entry->traits) {
+            std::shared_ptr<C2Component::Traits> traits = std::make_shared<C2Component::Traits>();
+            uint32_t domain = 0, kind = 0;
+            valid = base::ParseUint(fields[2], &domain) && base::ParseUint(fields[3], &kind)
+                    && base::ParseUint(fields[4], &traits->rank);
+            traits->name = fields[1];
+            traits->domain = (C2Component::domain_t)domain;
+            traits->kind = (C2Component::kind_t)kind;
+            traits->mediaType = fields[5];
+            traits->aliases.assign(fields.begin() + 6, fields.end());
+            entry->traits = traits;
+        } else {
+            valid = lines[i].empty();
+        }
+        if (!valid) {
+            ALOGW("ignoring corrupted traits manifest %s", mPath.c_str());
+            entries->clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool C2TraitsManifest::write(const std::map<C2String, Entry> &entries) const {
+    std::string contents = base::StringPrintf("%s\nfingerprint %s\nlibdir %s\n",
+            kManifestMagic, mFingerprint.c_str(), mLibDir.c_str());
+    for (const std::pair<const C2String, Entry> &pathAndEntry : entries) {
+        const Entry &entry = pathAndEntry.second;
+        contents += base::StringPrintf("lib %s %lld %lld\n", pathAndEntry.first.c_str(),
+                (long long)entry.size, (long long)entry.mtimeNs);
+        if (entry.traits) {
+            contents += base::StringPrintf("traits %s %u %u %u %s",
+                    entry.traits->name.c_str(), (unsigned)entry.traits->domain,
+                    (unsigned)entry.traits->kind, (unsigned)entry.traits->rank,
+                    entry.traits->mediaType.c_str());
+            for (const C2String &alias : entry.traits->aliases) {
+                contents += " " + alias;
+            }
+            contents += "\n";
+        }
+    }
+    std::string tmpPath = mPath + base::StringPrintf(".%d", getpid());
+    if (!base::WriteStringToFile(contents, tmpPath)
+            || rename(tmpPath.c_str(), mPath.c_str()) != 0) {
+        ALOGD("could not write traits manifest %s: %s", mPath.c_str(), strerror(errno));
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
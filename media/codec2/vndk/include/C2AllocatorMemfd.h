@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STAGEFRIGHT_CODEC2_ALLOCATOR_MEMFD_H_
+#define STAGEFRIGHT_CODEC2_ALLOCATOR_MEMFD_H_
+
+#include <atomic>
+#include <memory>
+
+#include <C2Buffer.h>
+
+namespace android {
+
+/**
+ * Linear allocator backed by anonymous memory files (memfd).
+ *
+ * This allocator does not need any device or HAL, so it is available on any Linux host. It is
+ * meant for tests and for process-local buffers; it is not registered in the platform allocator
+ * store.
+ */
+class C2AllocatorMemfd : public C2Allocator {
+public:
+    /**
+     * Number of operations performed by this allocator and its allocations.
+     */
+    struct Stats {
+        uint64_t allocations; // buffers created by newLinearAllocation()
+        uint64_t mmaps;       // successful map() calls
+        uint64_t munmaps;     // successful unmap() calls, including dangling mappings
+    };
+
+    virtual id_t getId() const override;
+
+    virtual C2String getName() const override;
+
+    virtual std::shared_ptr<const Traits> getTraits() const override;
+
+    virtual c2_status_t newLinearAllocation(
+            uint32_t capacity, C2MemoryUsage usage,
+            std::shared_ptr<C2LinearAllocation> *allocation) override;
+
+    virtual c2_status_t priorLinearAllocation(
+            const C2Handle *handle,
+            std::shared_ptr<C2LinearAllocation> *allocation) override;
+
+    C2AllocatorMemfd(id_t id);
+
+    virtual ~C2AllocatorMemfd() override = default;
+
+    Stats getStats() const;
+
+    static bool isValid(const C2Handle* const o);
+
+    struct Counters {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> mmaps{0};
+        std::atomic<uint64_t> munmaps{0};
+    };
+
+private:
+    std::shared_ptr<const Traits> mTraits;
+    // shared with the allocations, which may outlive the allocator
+    std::shared_ptr<Counters> mCounters;
+};
+
+} // namespace android
+
+#endif // STAGEFRIGHT_CODEC2_ALLOCATOR_MEMFD_H_
@@ -47,6 +47,69 @@ private:
     const std::shared_ptr<C2Allocator> mAllocator;
 };
 
+/**
+ * Linear block pool that recycles allocations within the process.
+ *
+ * Allocations are bucketed in power-of-two size classes and stay mapped while they are pooled,
+ * so a fetch served from a free allocation does not allocate, map or unmap. An allocation
+ * returns to the pool when the last reference to its blocks and views is released. Free
+ * allocations are released when they stay unused for a while, when the pool holds more than
+ * its budget, and on trim().
+ *
+ * Blocks are recycled as soon as they are released locally. This pool must therefore not be
+ * used for blocks that are shared with another process, which may still be reading them. For
+ * this reason GetCodec2BlockPool() does not serve it: in-process users create it directly and
+ * choose its local id.
+ */
+class C2RecyclingLinearBlockPool : public C2BlockPool {
+public:
+    struct Stats {
+        uint64_t fetches;
+        uint64_t recycled;    // fetches served from a free allocation
+        uint64_t allocations; // allocations requested from the allocator
+        size_t freeCount;     // allocations currently in the pool
+        size_t freeBytes;
+    };
+
+    C2RecyclingLinearBlockPool(
+            const std::shared_ptr<C2Allocator> &allocator, const local_id_t localId);
+
+    virtual ~C2RecyclingLinearBlockPool() override;
+
+    virtual C2Allocator::id_t getAllocatorId() const override {
+        return mAllocator->getId();
+    }
+
+    virtual local_id_t getLocalId() const override {
+        return mLocalId;
+    }
+
+    virtual c2_status_t fetchLinearBlock(
+            uint32_t capacity,
+            C2MemoryUsage usage,
+            std::shared_ptr<C2LinearBlock> *block /* nonnull */) override;
+
+    /**
+     * Releases all free allocations of this pool.
+     */
+    void trim();
+
+    Stats getStats() const;
+
+    /**
+     * Releases the free allocations of all recycling pools of this process, e.g. when the
+     * process is asked to reduce its memory usage.
+     */
+    static void TrimAll();
+
+private:
+    const std::shared_ptr<C2Allocator> mAllocator;
+    const local_id_t mLocalId;
+
+    class Impl;
+    std::shared_ptr<Impl> mImpl;
+};
+
 class C2BasicGraphicBlockPool : public C2BlockPool {
 public:
     explicit C2BasicGraphicBlockPool(const std::shared_ptr<C2Allocator> &allocator);
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_STAGEFRIGHT_C2TRAITS_MANIFEST_H_
+#define ANDROID_STAGEFRIGHT_C2TRAITS_MANIFEST_H_
+
+#include <C2Component.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * File recording the traits of the components in each component library, so that the
+ * platform component store can list components without loading their libraries.
+ *
+ * A manifest is only valid for the build and the library directory it was written for.
+ */
+class C2TraitsManifest {
+public:
+    /**
+     * Traits of the component in a library.
+     */
+    struct Entry {
+        int64_t size; ///< library file size
+        int64_t mtimeNs; ///< library modification time
+        std::shared_ptr<const C2Component::Traits> traits; ///< nullptr if the module has none
+    };
+
+    /**
+     * \param path          path of the manifest file
+     * \param fingerprint   build fingerprint of the running system
+     * \param libDir        directory of the component libraries
+     */
+    C2TraitsManifest(std::string path, std::string fingerprint, std::string libDir);
+
+    /**
+     * Reads the manifest.
+     *
+     * \param entries   library path -> entry, cleared if the manifest is not valid
+     *
+     * \return false if there is no manifest, or it was written for another build or library
+     *         directory, or it is corrupted.
+     */
+    bool read(std::map<C2String, Entry> *entries) const;
+
+    /**
+     * Replaces the manifest atomically, as other processes may be reading it.
+     *
+     * \return false if the manifest could not be written.
+     */
+    bool write(const std::map<C2String, Entry> &entries) const;
+
+    const std::string &path() const { return mPath; }
+
+private:
+    std::string mPath;
+    std::string mFingerprint;
+    std::string mLibDir;
+};
+
+#endif  // ANDROID_STAGEFRIGHT_C2TRAITS_MANIFEST_H_
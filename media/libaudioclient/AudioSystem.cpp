@@ -46,6 +46,7 @@ std::set<audio_error_callback> AudioSystem::gAudioErrorCallbacks;
 audio_session_callback AudioSystem::gAudioSessionCallback = NULL;
 dynamic_policy_callback AudioSystem::gDynPolicyCallback = NULL;
 record_config_callback AudioSystem::gRecordConfigCallback = NULL;
+AudioSystem::IoParametersCache AudioSystem::gIoParametersCache;
 
 // Required to be held while calling into gSoundTriggerCaptureStateListener.
 class CaptureStateListenerImpl;
@@ -112,6 +113,105 @@ sp<AudioIoDescriptor> AudioSystem::getIoDescriptor(audio_io_handle_t ioHandle)
     return desc;
 }
 
+// ---------------------------------------------------------------------------
+
+AudioSystem::IoParametersCache::IoParametersCache() : mGeneration(0)
+{
+    for (auto& entry : mEntries) {
+        entry.ioHandle.store(AUDIO_IO_HANDLE_NONE, std::memory_order_relaxed);
+    }
+}
+
+bool AudioSystem::IoParametersCache::get(audio_io_handle_t ioHandle,
+                                         Parameters *parameters) const
+{
+    if (ioHandle == AUDIO_IO_HANDLE_NONE) return false;
+    for (;;) {
+        const uint32_t generation = mGeneration.load(std::memory_order_acquire);
+        if (generation & 1) continue;  // update in progress
+        bool found = false;
+        for (const auto& entry : mEntries) {
+            if (entry.ioHandle.load(std::memory_order_relaxed) == ioHandle) {
+                parameters->samplingRate = entry.samplingRate.load(std::memory_order_relaxed);
+                parameters->frameCount = entry.frameCount.load(std::memory_order_relaxed);
+                parameters->frameCountHAL = entry.frameCountHAL.load(std::memory_order_relaxed);
+                parameters->latency = entry.latency.load(std::memory_order_relaxed);
+                found = true;
+                break;
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (mGeneration.load(std::memory_order_relaxed) == generation) {
+            return found;
+        }
+    }
+}
+
+void AudioSystem::IoParametersCache::beginWrite_l()
+{
+    mGeneration.store(mGeneration.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void AudioSystem::IoParametersCache::endWrite_l()
+{
+    mGeneration.store(mGeneration.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+}
+
+void AudioSystem::IoParametersCache::put(const sp<AudioIoDescriptor>& ioDesc)
+{
+    Mutex::Autolock _l(mLock);
+    Entry *slot = nullptr;
+    for (auto& entry : mEntries) {
+        const audio_io_handle_t ioHandle = entry.ioHandle.load(std::memory_order_relaxed);
+        if (ioHandle == ioDesc->mIoHandle) {
+            slot = &entry;
+            break;
+        }
+        if (ioHandle == AUDIO_IO_HANDLE_NONE && slot == nullptr) {
+            slot = &entry;
+        }
+    }
+    beginWrite_l();
+    if (slot != nullptr) {
+        slot->samplingRate.store(ioDesc->mSamplingRate, std::memory_order_relaxed);
+        slot->frameCount.store(ioDesc->mFrameCount, std::memory_order_relaxed);
+        slot->frameCountHAL.store(ioDesc->mFrameCountHAL, std::memory_order_relaxed);
+        slot->latency.store(ioDesc->mLatency, std::memory_order_relaxed);
+        slot->ioHandle.store(ioDesc->mIoHandle, std::memory_order_relaxed);
+    } else {
+        // Queries for this I/O fall back to the descriptors.
+        ALOGW("%s: no room to cache io %d", __func__, ioDesc->mIoHandle);
+    }
+    endWrite_l();
+}
+
+void AudioSystem::IoParametersCache::remove(audio_io_handle_t ioHandle)
+{
+    Mutex::Autolock _l(mLock);
+    beginWrite_l();
+    for (auto& entry : mEntries) {
+        if (entry.ioHandle.load(std::memory_order_relaxed) == ioHandle) {
+            entry.ioHandle.store(AUDIO_IO_HANDLE_NONE, std::memory_order_relaxed);
+        }
+    }
+    endWrite_l();
+}
+
+void AudioSystem::IoParametersCache::clear()
+{
+    Mutex::Autolock _l(mLock);
+    beginWrite_l();
+    for (auto& entry : mEntries) {
+        entry.ioHandle.store(AUDIO_IO_HANDLE_NONE, std::memory_order_relaxed);
+    }
+    endWrite_l();
+}
+
+// ---------------------------------------------------------------------------
+
 /* static */ status_t AudioSystem::checkAudioFlinger()
 {
     if (defaultServiceManager()->checkService(String16("media.audio_flinger")) != 0) {
@@ -310,6 +410,11 @@ status_t AudioSystem::getOutputSamplingRate(uint32_t* samplingRate, audio_stream
 status_t AudioSystem::getSamplingRate(audio_io_handle_t ioHandle,
                                       uint32_t* samplingRate)
 {
+    IoParametersCache::Parameters parameters;
+    if (gIoParametersCache.get(ioHandle, &parameters) && parameters.samplingRate != 0) {
+        *samplingRate = parameters.samplingRate;
+        return NO_ERROR;
+    }
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
@@ -347,6 +452,11 @@ status_t AudioSystem::getOutputFrameCount(size_t* frameCount, audio_stream_type_
 status_t AudioSystem::getFrameCount(audio_io_handle_t ioHandle,
                                     size_t* frameCount)
 {
+    IoParametersCache::Parameters parameters;
+    if (gIoParametersCache.get(ioHandle, &parameters) && parameters.frameCount != 0) {
+        *frameCount = parameters.frameCount;
+        return NO_ERROR;
+    }
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
@@ -384,6 +494,11 @@ status_t AudioSystem::getOutputLatency(uint32_t* latency, audio_stream_type_t st
 status_t AudioSystem::getLatency(audio_io_handle_t output,
                                  uint32_t* latency)
 {
+    IoParametersCache::Parameters parameters;
+    if (gIoParametersCache.get(output, &parameters)) {
+        *latency = parameters.latency;
+        return NO_ERROR;
+    }
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> outputDesc = getIoDescriptor(output);
@@ -476,6 +591,11 @@ status_t AudioSystem::systemReady()
 status_t AudioSystem::getFrameCountHAL(audio_io_handle_t ioHandle,
                                        size_t* frameCount)
 {
+    IoParametersCache::Parameters parameters;
+    if (gIoParametersCache.get(ioHandle, &parameters) && parameters.frameCountHAL != 0) {
+        *frameCount = parameters.frameCountHAL;
+        return NO_ERROR;
+    }
     const sp<IAudioFlinger>& af = AudioSystem::get_audio_flinger();
     if (af == 0) return PERMISSION_DENIED;
     sp<AudioIoDescriptor> desc = getIoDescriptor(ioHandle);
@@ -535,6 +655,7 @@ void AudioSystem::AudioFlingerClient::clearIoCache()
 {
     Mutex::Autolock _l(mLock);
     mIoDescriptors.clear();
+    gIoParametersCache.clear();
     mInBuffSize = 0;
     mInSamplingRate = 0;
     mInFormat = AUDIO_FORMAT_DEFAULT;
@@ -580,6 +701,7 @@ void AudioSystem::AudioFlingerClient::ioConfigChanged(audio_io_config_event even
                 deviceId = oldDesc->getDeviceId();
                 mIoDescriptors.replaceValueFor(ioDesc->mIoHandle, ioDesc);
             }
+            gIoParametersCache.put(ioDesc);
 
             if (ioDesc->getDeviceId() != AUDIO_PORT_HANDLE_NONE) {
                 deviceId = ioDesc->getDeviceId();
@@ -610,6 +732,7 @@ void AudioSystem::AudioFlingerClient::ioConfigChanged(audio_io_config_event even
                   event == AUDIO_OUTPUT_CLOSED ? "output" : "input", ioDesc->mIoHandle);
 
             mIoDescriptors.removeItem(ioDesc->mIoHandle);
+            gIoParametersCache.remove(ioDesc->mIoHandle);
             mAudioDeviceCallbacks.erase(ioDesc->mIoHandle);
             } break;
 
@@ -623,6 +746,7 @@ void AudioSystem::AudioFlingerClient::ioConfigChanged(audio_io_config_event even
 
             deviceId = oldDesc->getDeviceId();
             mIoDescriptors.replaceValueFor(ioDesc->mIoHandle, ioDesc);
+            gIoParametersCache.put(ioDesc);
 
             if (deviceId != ioDesc->getDeviceId()) {
                 deviceId = ioDesc->getDeviceId();
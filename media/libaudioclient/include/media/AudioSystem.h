@@ -27,6 +27,7 @@
 #include <media/IAudioFlingerClient.h>
 #include <media/IAudioPolicyServiceClient.h>
 #include <media/MicrophoneInfo.h>
+#include <atomic>
 #include <set>
 #include <system/audio.h>
 #include <system/audio_effect.h>
@@ -526,6 +527,49 @@ public:
 
 private:
 
+    // Parameters of the opened outputs and inputs, cached for queries that would otherwise
+    // need a binder call or gLock. Entries are published from ioConfigChanged() events.
+    // Readers do not lock: each update bumps a generation counter, and a reader retries if
+    // the generation changed while it was reading.
+    // The output selected for a stream type is not cached: routing changes are only
+    // reported to clients registered for audio port callbacks.
+    class IoParametersCache
+    {
+    public:
+        struct Parameters {
+            uint32_t samplingRate;
+            size_t   frameCount;
+            size_t   frameCountHAL;
+            uint32_t latency;
+        };
+
+        IoParametersCache();
+
+        bool get(audio_io_handle_t ioHandle, Parameters *parameters) const;
+        void put(const sp<AudioIoDescriptor>& ioDesc);
+        void remove(audio_io_handle_t ioHandle);
+        void clear();
+
+    private:
+        static constexpr size_t kMaxEntries = 32;
+
+        struct Entry {
+            std::atomic<audio_io_handle_t> ioHandle;
+            std::atomic<uint32_t> samplingRate;
+            std::atomic<size_t>   frameCount;
+            std::atomic<size_t>   frameCountHAL;
+            std::atomic<uint32_t> latency;
+        };
+
+        // Must be called with mLock held.
+        void beginWrite_l();
+        void endWrite_l();
+
+        Mutex                 mLock;        // serializes the writers
+        std::atomic<uint32_t> mGeneration;  // odd while an update is in progress
+        Entry                 mEntries[kMaxEntries];
+    };
+
     class AudioFlingerClient: public IBinder::DeathRecipient, public BnAudioFlingerClient
     {
     public:
@@ -621,6 +665,7 @@ private:
 
     static sp<AudioFlingerClient> gAudioFlingerClient;
     static sp<AudioPolicyServiceClient> gAudioPolicyServiceClient;
+    static IoParametersCache gIoParametersCache;
     friend class AudioFlingerClient;
     friend class AudioPolicyServiceClient;
 
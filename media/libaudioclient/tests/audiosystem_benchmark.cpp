@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "audiosystem_benchmark"
+
+#include <fstream>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <binder/ProcessState.h>
+#include <media/AudioSystem.h>
+#include <media/AudioTrack.h>
+
+using namespace android;
+
+namespace {
+
+// Returns the number of transactions sent by this process according to the binder driver
+// statistics, or -1 if they can not be read (this requires access to binderfs or debugfs).
+int64_t getBinderTransactionCount() {
+    static const char* const kStatsPaths[] = {
+        "/dev/binderfs/binder_logs/stats",
+        "/sys/kernel/debug/binder/stats",
+    };
+    const std::string procHeader = "proc " + std::to_string(getpid());
+    for (const char* path : kStatsPaths) {
+        std::ifstream stats(path);
+        if (!stats) continue;
+        std::string line;
+        bool inProc = false;
+        bool found = false;
+        int64_t count = 0;
+        while (std::getline(stats, line)) {
+            if (line.rfind("proc ", 0) == 0) {
+                inProc = line == procHeader;
+                continue;
+            }
+            if (!inProc) continue;
+            for (const char* key : { "BC_TRANSACTION:", "BC_TRANSACTION_SG:" }) {
+                const size_t pos = line.find(key);
+                if (pos != std::string::npos) {
+                    count += std::stoll(line.substr(pos + strlen(key)));
+                    found = true;
+                }
+            }
+        }
+        if (found) return count;
+    }
+    return -1;
+}
+
+class BinderTransactionCounter {
+public:
+    BinderTransactionCounter() : mStart(getBinderTransactionCount()) {}
+
+    bool isValid() const { return mStart >= 0; }
+
+    void report(benchmark::State& state) const {
+        state.counters["binder/op"] = benchmark::Counter(
+                getBinderTransactionCount() - mStart, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    const int64_t mStart;
+};
+
+void BM_AudioTrackSet(benchmark::State& state) {
+    // Warm up the connections to audioserver and the cached output parameters.
+    uint32_t latency;
+    if (AudioSystem::getOutputLatency(&latency, AUDIO_STREAM_MUSIC) != NO_ERROR) {
+        state.SkipWithError("audioserver not available");
+        return;
+    }
+
+    BinderTransactionCounter transactions;
+    if (!transactions.isValid()) {
+        state.SkipWithError("cannot read binder statistics");
+        return;
+    }
+    for (auto _ : state) {
+        sp<AudioTrack> track = new AudioTrack();
+        if (track->set(AUDIO_STREAM_MUSIC, 48000 /* sampleRate */, AUDIO_FORMAT_PCM_16_BIT,
+                AUDIO_CHANNEL_OUT_STEREO) != NO_ERROR) {
+            state.SkipWithError("AudioTrack::set() failed");
+            return;
+        }
+    }
+    transactions.report(state);
+}
+BENCHMARK(BM_AudioTrackSet);
+
+// The queries an application makes for A/V sync. Each query still asks audio policy for
+// the output of the stream, one binder transaction, then reads the output parameters from
+// the cached I/O descriptor. binder/op counts the transactions of the three queries.
+void BM_OutputParameters(benchmark::State& state) {
+    uint32_t latency;
+    if (AudioSystem::getOutputLatency(&latency, AUDIO_STREAM_MUSIC) != NO_ERROR) {
+        state.SkipWithError("audioserver not available");
+        return;
+    }
+
+    BinderTransactionCounter transactions;
+    if (!transactions.isValid()) {
+        state.SkipWithError("cannot read binder statistics");
+        return;
+    }
+    for (auto _ : state) {
+        uint32_t samplingRate;
+        size_t frameCount;
+        AudioSystem::getOutputSamplingRate(&samplingRate, AUDIO_STREAM_MUSIC);
+        AudioSystem::getOutputFrameCount(&frameCount, AUDIO_STREAM_MUSIC);
+        AudioSystem::getOutputLatency(&latency, AUDIO_STREAM_MUSIC);
+        benchmark::DoNotOptimize(samplingRate);
+        benchmark::DoNotOptimize(frameCount);
+        benchmark::DoNotOptimize(latency);
+    }
+    transactions.report(state);
+}
+BENCHMARK(BM_OutputParameters);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    ProcessState::self()->startThreadPool();
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
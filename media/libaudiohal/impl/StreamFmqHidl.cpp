@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "StreamHalHidl"
+//#define LOG_NDEBUG 0
+
+#include <utils/Log.h>
+
+#include "StreamFmqHidl.h"
+
+namespace android {
+namespace CPP_VERSION {
+
+using namespace ::android::hardware::audio::CPP_VERSION;
+
+void StreamFmqStats::onWake(size_t transfers) {
+    nsecs_t expected = 0;
+    mFirstWakeNs.compare_exchange_strong(expected, systemTime(), std::memory_order_relaxed);
+    mWakeups.fetch_add(1, std::memory_order_relaxed);
+    mTransfers.fetch_add(transfers, std::memory_order_relaxed);
+}
+
+void StreamFmqStats::onWait(nsecs_t waitNs) {
+    mWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    if (waitNs > mMaxWaitNs.load(std::memory_order_relaxed)) {
+        mMaxWaitNs.store(waitNs, std::memory_order_relaxed);
+    }
+}
+
+void StreamFmqStats::dump(int fd) const {
+    const uint64_t wakeups = mWakeups.load(std::memory_order_relaxed);
+    if (wakeups == 0) return;
+    const nsecs_t elapsedNs = systemTime() - mFirstWakeNs.load(std::memory_order_relaxed);
+    const nsecs_t waitNs = mWaitNs.load(std::memory_order_relaxed);
+    dprintf(fd, "  FMQ wakeups: %llu (%.1f/s), transfers per wakeup: %.2f\n",
+            (unsigned long long)wakeups,
+            elapsedNs > 0 ? wakeups * 1e9 / elapsedNs : 0.,
+            (double)mTransfers.load(std::memory_order_relaxed) / wakeups);
+    dprintf(fd, "  FMQ wait: total %.3f ms (%.2f%%), average %.3f ms, max %.3f ms\n",
+            waitNs * 1e-6, elapsedNs > 0 ? waitNs * 100. / elapsedNs : 0.,
+            waitNs * 1e-6 / wakeups, mMaxWaitNs.load(std::memory_order_relaxed) * 1e-6);
+}
+
+StreamOutWriteQueue::StreamOutWriteQueue(std::unique_ptr<CommandMQ> commandMQ,
+        std::unique_ptr<DataMQ> dataMQ,
+        std::unique_ptr<StatusMQ> statusMQ,
+        EventFlag* efGroup,
+        size_t writeBatchSize,
+        StreamFmqStats* stats)
+        : ConversionHelperHidl("StreamOutWriteQueue"),
+          mCommandMQ(std::move(commandMQ)),
+          mDataMQ(std::move(dataMQ)),
+          mStatusMQ(std::move(statusMQ)),
+          mEfGroup(efGroup),
+          mStats(stats),
+          mWriteBatchSize(writeBatchSize) {
+}
+
+StreamOutWriteQueue::~StreamOutWriteQueue() {
+    if (mEfGroup) {
+        EventFlag::deleteEventFlag(&mEfGroup);
+    }
+}
+
+status_t StreamOutWriteQueue::write(const uint8_t* data, size_t bytes, size_t* written) {
+    *written = 0;
+    if (mWriteBatchSize > 1) {
+        return writeBatched(data, bytes, written);
+    }
+    // Batching may just have been disabled with writes still queued, the HAL would
+    // otherwise report them as written by this command.
+    status_t status = flushQueuedWrites("write");
+    if (status != OK) return status;
+    return callWriterThread(
+            WriteCommand::WRITE, "write", data, bytes,
+            [&] (const WriteStatus& writeStatus) {
+                *written = writeStatus.reply.written;
+                // Diagnostics of the cause of b/35813113.
+                ALOGE_IF(*written > bytes,
+                        "hal reports more bytes written than asked for: %lld > %lld",
+                        (long long)*written, (long long)bytes);
+            });
+}
+
+status_t StreamOutWriteQueue::writeBatched(const uint8_t* data, size_t bytes, size_t* written) {
+    // The HAL may still be writing the previous batch, collect its status before touching
+    // the queues so that errors are reported to the caller.
+    status_t status = collectWriteStatus();
+    if (status != OK) return status;
+    if (mWriteBatchSize == 1) {
+        // The HAL did not write the whole batch.
+        return write(data, bytes, written);
+    }
+
+    if (bytes > mDataMQ->availableToWrite() && mQueuedWrites > 0) {
+        if ((status = flushQueuedWrites("write")) != OK) return status;
+    }
+    size_t availableToWrite = mDataMQ->availableToWrite();
+    if (bytes > availableToWrite) {
+        ALOGW("truncating write data from %lld to %lld due to insufficient data queue space",
+                (long long)bytes, (long long)availableToWrite);
+        bytes = availableToWrite;
+    }
+    if (!mDataMQ->write(data, bytes)) {
+        ALOGE("data message queue write failed for \"write\"");
+        return -EAGAIN;
+    }
+    mQueuedBytes += bytes;
+    *written = bytes;
+
+    if (++mQueuedWrites < mWriteBatchSize) return OK;
+    return sendQueuedWrites();
+}
+
+status_t StreamOutWriteQueue::sendQueuedWrites() {
+    // The HAL writes all the data available in the queue on a WRITE command.
+    const size_t queuedWrites = mQueuedWrites;
+    mInFlightBytes = mQueuedBytes;
+    mQueuedWrites = 0;
+    mQueuedBytes = 0;
+    status_t status = sendWriterCommand(WriteCommand::WRITE, "write", nullptr, 0);
+    if (status != OK) return status;
+    mStats->onWake(queuedWrites);
+    mWriteInFlight = true;
+    return OK;
+}
+
+status_t StreamOutWriteQueue::collectWriteStatus() {
+    if (!mWriteInFlight) return OK;
+    mWriteInFlight = false;
+    return waitWriterStatus("write",
+            [&](const WriteStatus& writeStatus) {
+                if (writeStatus.reply.written >= mInFlightBytes) return;
+                // The HAL has consumed the whole queue and what it did not write is lost,
+                // while the writes were already reported complete. Stop batching so that
+                // the HAL write result reaches the caller again.
+                ALOGW("hal wrote %lld of %lld batched bytes, disabling write batching",
+                        (long long)writeStatus.reply.written, (long long)mInFlightBytes);
+                mWriteBatchSize = 1;
+            });
+}
+
+status_t StreamOutWriteQueue::flushQueuedWrites(const char* reason) {
+    status_t status = collectWriteStatus();
+    if (status != OK || mQueuedWrites == 0) return status;
+    ALOGV("%s: writing %zu queued bytes before %s", __func__, mQueuedBytes, reason);
+    if ((status = sendQueuedWrites()) != OK) return status;
+    return collectWriteStatus();
+}
+
+status_t StreamOutWriteQueue::discardQueuedWrites() {
+    // A batch already sent can not be recalled, wait until the HAL has written it.
+    status_t status = collectWriteStatus();
+    // The HAL thread only reads the data queue on a WRITE command, and none is in flight.
+    const size_t queuedBytes = mDataMQ->availableToRead();
+    if (queuedBytes > 0) {
+        DataMQ::MemTransaction tx;
+        if (!mDataMQ->beginRead(queuedBytes, &tx) || !mDataMQ->commitRead(queuedBytes)) {
+            ALOGE("data message queue read failed for \"flush\"");
+            if (status == OK) status = -EAGAIN;
+        }
+    }
+    ALOGV_IF(mQueuedWrites > 0, "%s: dropped %zu queued writes, %zu bytes",
+            __func__, mQueuedWrites, queuedBytes);
+    mQueuedWrites = 0;
+    mQueuedBytes = 0;
+    return status;
+}
+
+status_t StreamOutWriteQueue::query(
+        WriteCommand cmd, const char* cmdName, WriterCallback callback) {
+    if (mWriteInFlight) return WOULD_BLOCK;
+    return callWriterThread(cmd, cmdName, nullptr, 0, callback);
+}
+
+status_t StreamOutWriteQueue::callWriterThread(
+        WriteCommand cmd, const char* cmdName,
+        const uint8_t* data, size_t dataSize, WriterCallback callback) {
+    // Only one command can be in flight, the status of a batched write must be collected
+    // first. Queued writes stay queued, they are accounted as latency by the caller.
+    status_t status = collectWriteStatus();
+    if (status != OK) return status;
+    if ((status = sendWriterCommand(cmd, cmdName, data, dataSize)) != OK) {
+        return status;
+    }
+    mStats->onWake(data != nullptr ? 1 : 0);
+    return waitWriterStatus(cmdName, callback);
+}
+
+status_t StreamOutWriteQueue::sendWriterCommand(
+        WriteCommand cmd, const char* cmdName, const uint8_t* data, size_t dataSize) {
+    if (!mCommandMQ->write(&cmd)) {
+        ALOGE("command message queue write failed for \"%s\"", cmdName);
+        return -EAGAIN;
+    }
+    if (data != nullptr) {
+        size_t availableToWrite = mDataMQ->availableToWrite();
+        if (dataSize > availableToWrite) {
+            ALOGW("truncating write data from %lld to %lld due to insufficient data queue space",
+                    (long long)dataSize, (long long)availableToWrite);
+            dataSize = availableToWrite;
+        }
+        if (!mDataMQ->write(data, dataSize)) {
+            ALOGE("data message queue write failed for \"%s\"", cmdName);
+        }
+    }
+    mEfGroup->wake(static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY));
+    return OK;
+}
+
+status_t StreamOutWriteQueue::waitWriterStatus(const char* cmdName, WriterCallback callback) {
+    // TODO: Remove manual event flag handling once blocking MQ is implemented. b/33815422
+    uint32_t efState = 0;
+    const nsecs_t waitStartNs = systemTime();
+retry:
+    status_t ret = mEfGroup->wait(static_cast<uint32_t>(MessageQueueFlagBits::NOT_FULL), &efState);
+    if (efState & static_cast<uint32_t>(MessageQueueFlagBits::NOT_FULL)) {
+        mStats->onWait(systemTime() - waitStartNs);
+        WriteStatus writeStatus;
+        writeStatus.retval = Result::NOT_INITIALIZED;
+        if (!mStatusMQ->read(&writeStatus)) {
+            ALOGE("status message read failed for \"%s\"", cmdName);
+        }
+        if (writeStatus.retval == Result::OK) {
+            ret = OK;
+            callback(writeStatus);
+        } else {
+            ret = processReturn(cmdName, writeStatus.retval);
+        }
+        return ret;
+    }
+    if (ret == -EAGAIN || ret == -EINTR) {
+        // Spurious wakeup. This normally retries no more than once.
+        goto retry;
+    }
+    return ret;
+}
+
+}  // namespace CPP_VERSION
+}  // namespace android
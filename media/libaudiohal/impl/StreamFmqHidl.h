@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_HARDWARE_STREAM_FMQ_HIDL_H
+#define ANDROID_HARDWARE_STREAM_FMQ_HIDL_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include PATH(android/hardware/audio/FILE_VERSION/IStreamOut.h)
+#include <fmq/EventFlag.h>
+#include <fmq/MessageQueue.h>
+#include <utils/Timers.h>
+
+#include "ConversionHelperHidl.h"
+
+using ::android::hardware::EventFlag;
+using ::android::hardware::MessageQueue;
+using WriteCommand = ::android::hardware::audio::CPP_VERSION::IStreamOut::WriteCommand;
+using WriteStatus = ::android::hardware::audio::CPP_VERSION::IStreamOut::WriteStatus;
+
+namespace android {
+namespace CPP_VERSION {
+
+// Counts the wakeups of the HAL thread serving a stream and the time the client
+// spends blocked waiting for its replies on the fast message queues.
+class StreamFmqStats {
+  public:
+    // Called when the HAL thread is woken up to handle 'transfers' reads or writes.
+    void onWake(size_t transfers);
+    // Called when a wait for the HAL thread reply has returned.
+    void onWait(nsecs_t waitNs);
+
+    void dump(int fd) const;
+
+  private:
+    std::atomic<nsecs_t> mFirstWakeNs{0};
+    std::atomic<uint64_t> mWakeups{0};
+    std::atomic<uint64_t> mTransfers{0};
+    std::atomic<nsecs_t> mWaitNs{0};
+    std::atomic<nsecs_t> mMaxWaitNs{0};
+};
+
+// Client side of the fast message queues of an output stream, only used by the writer thread.
+//
+// When the write batch size is more than 1, write() only appends data to the data queue, and
+// one WRITE command is sent for every 'writeBatchSize' writes. The status of that command is
+// collected before the next command is sent, so the writer is not blocked while the HAL
+// writes the batch.
+class StreamOutWriteQueue : public ConversionHelperHidl {
+  public:
+    typedef MessageQueue<WriteCommand, hardware::kSynchronizedReadWrite> CommandMQ;
+    typedef MessageQueue<uint8_t, hardware::kSynchronizedReadWrite> DataMQ;
+    typedef MessageQueue<WriteStatus, hardware::kSynchronizedReadWrite> StatusMQ;
+    using WriterCallback = std::function<void(const WriteStatus& writeStatus)>;
+
+    // Takes ownership of 'efGroup'. 'stats' must outlive the queue.
+    StreamOutWriteQueue(std::unique_ptr<CommandMQ> commandMQ,
+            std::unique_ptr<DataMQ> dataMQ,
+            std::unique_ptr<StatusMQ> statusMQ,
+            EventFlag* efGroup,
+            size_t writeBatchSize,
+            StreamFmqStats* stats);
+    ~StreamOutWriteQueue();
+
+    // Writes or queues 'bytes' bytes, '*written' is the number of bytes accepted.
+    status_t write(const uint8_t* data, size_t bytes, size_t* written);
+
+    // Sends a command that only returns a status, e.g. GET_LATENCY. Returns WOULD_BLOCK
+    // without sending it while a batched write is in flight, the caller must then use
+    // the HIDL method so that it does not wait for the HAL to write the batch.
+    status_t query(WriteCommand cmd, const char* cmdName, WriterCallback callback);
+
+    // Sends the writes queued in the data queue to the HAL and waits until they are written.
+    status_t flushQueuedWrites(const char* reason);
+
+    // Drops the writes queued in the data queue, the HAL never sees them.
+    status_t discardQueuedWrites();
+
+    // Bytes in the data queue that the HAL has not read yet.
+    size_t queuedBytes() const { return mDataMQ->availableToRead(); }
+
+    // 1 once batching is disabled.
+    size_t writeBatchSize() const { return mWriteBatchSize; }
+
+  private:
+    const std::unique_ptr<CommandMQ> mCommandMQ;
+    const std::unique_ptr<DataMQ> mDataMQ;
+    const std::unique_ptr<StatusMQ> mStatusMQ;
+    EventFlag* mEfGroup;
+    StreamFmqStats* const mStats;
+
+    size_t mWriteBatchSize;
+    size_t mQueuedWrites = 0;     // writes appended to mDataMQ since the last WRITE command
+    size_t mQueuedBytes = 0;
+    bool mWriteInFlight = false;  // a WRITE command was sent and its status is not collected
+    size_t mInFlightBytes = 0;
+
+    status_t writeBatched(const uint8_t* data, size_t bytes, size_t* written);
+    // Sends the queued writes to the HAL without waiting for their status.
+    status_t sendQueuedWrites();
+    // Collects the status of the WRITE command in flight, if any.
+    status_t collectWriteStatus();
+    status_t callWriterThread(
+            WriteCommand cmd, const char* cmdName,
+            const uint8_t* data, size_t dataSize, WriterCallback callback);
+    status_t sendWriterCommand(
+            WriteCommand cmd, const char* cmdName, const uint8_t* data, size_t dataSize);
+    status_t waitWriterStatus(const char* cmdName, WriterCallback callback);
+};
+
+}  // namespace CPP_VERSION
+}  // namespace android
+
+#endif  // ANDROID_HARDWARE_STREAM_FMQ_HIDL_H
@@ -17,7 +17,10 @@
 #define LOG_TAG "StreamHalHidl"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
+
 #include PATH(android/hardware/audio/FILE_VERSION/IStreamOutCallback.h)
+#include <cutils/properties.h>
 #include <hwbinder/IPCThreadState.h>
 #include <media/AudioParameter.h>
 #include <mediautils/SchedulingPolicyService.h>
@@ -41,6 +44,16 @@ using ReadCommand = ::android::hardware::audio::CPP_VERSION::IStreamIn::ReadComm
 using namespace ::android::hardware::audio::common::CPP_VERSION;
 using namespace ::android::hardware::audio::CPP_VERSION;
 
+namespace {
+
+// Number of writes of a PCM output stream that are queued before waking the HAL thread.
+// Each write then returns as soon as its data is queued, at the price of up to that many
+// buffers of additional latency. 1 disables batching.
+constexpr char kWriteBatchSizeProperty[] = "media.audiohal.write_batch";
+constexpr int32_t kMaxWriteBatchSize = 8;
+
+}  // namespace
+
 StreamHalHidl::StreamHalHidl(IStream *stream)
         : ConversionHelperHidl("Stream"),
           mStream(stream),
@@ -153,6 +166,7 @@ status_t StreamHalHidl::dump(int fd) {
     Return<void> ret = mStream->debug(hidlHandle, {} /* options */);
     native_handle_delete(hidlHandle);
     mStreamPowerLog.dump(fd);
+    mFmqStats.dump(fd);
     return processReturn("dump", ret);
 }
 
@@ -291,7 +305,8 @@ struct StreamOutCallback : public IStreamOutCallback {
 }  // namespace
 
 StreamOutHalHidl::StreamOutHalHidl(const sp<IStreamOut>& stream)
-        : StreamHalHidl(stream.get()), mStream(stream), mWriterClient(0), mEfGroup(nullptr) {
+        : StreamHalHidl(stream.get()), mStream(stream), mWriterClient(0), mFrameSize(0),
+          mSampleRate(0) {
 }
 
 StreamOutHalHidl::~StreamOutHalHidl() {
@@ -311,9 +326,6 @@ StreamOutHalHidl::~StreamOutHalHidl() {
     mCallback.clear();
     mEventCallback.clear();
     hardware::IPCThreadState::self()->flushCommands();
-    if (mEfGroup) {
-        EventFlag::deleteEventFlag(&mEfGroup);
-    }
 }
 
 status_t StreamOutHalHidl::getFrameSize(size_t *size) {
@@ -323,15 +335,23 @@ status_t StreamOutHalHidl::getFrameSize(size_t *size) {
 
 status_t StreamOutHalHidl::getLatency(uint32_t *latency) {
     if (mStream == 0) return NO_INIT;
-    if (mWriterClient == gettid() && mCommandMQ) {
-        return callWriterThread(
-                WriteCommand::GET_LATENCY, "getLatency", nullptr, 0,
+    status_t status = WOULD_BLOCK;
+    if (mWriterClient == gettid() && mWriteQueue) {
+        status = mWriteQueue->query(
+                WriteCommand::GET_LATENCY, "getLatency",
                 [&](const WriteStatus& writeStatus) {
                     *latency = writeStatus.reply.latencyMs;
                 });
-    } else {
-        return processReturn("getLatency", mStream->getLatency(), latency);
     }
+    if (status == WOULD_BLOCK) {
+        status = processReturn("getLatency", mStream->getLatency(), latency);
+    }
+    // Writes still in the data queue have been reported written but the HAL has not seen
+    // them yet. The queue and the format are set before mWriterClient.
+    if (status == OK && mWriterClient != 0 && mFrameSize != 0 && mSampleRate != 0) {
+        *latency += (uint64_t)mWriteQueue->queuedBytes() / mFrameSize * 1000 / mSampleRate;
+    }
+    return status;
 }
 
 status_t StreamOutHalHidl::setVolume(float left, float right) {
@@ -361,14 +381,14 @@ status_t StreamOutHalHidl::write(const void *buffer, size_t bytes, size_t *writt
     if (mStream == 0) return NO_INIT;
     *written = 0;
 
-    if (bytes == 0 && !mDataMQ) {
+    if (bytes == 0 && !mWriteQueue) {
         // Can't determine the size for the MQ buffer. Wait for a non-empty write request.
         ALOGW_IF(mCallback.unsafe_get(), "First call to async write with 0 bytes");
         return OK;
     }
 
     status_t status;
-    if (!mDataMQ) {
+    if (!mWriteQueue) {
         // In case if playback starts close to the end of a compressed track, the bytes
         // that need to be written is less than the actual buffer size. Need to use
         // full buffer size for the MQ since otherwise after seeking back to the middle
@@ -383,84 +403,45 @@ status_t StreamOutHalHidl::write(const void *buffer, size_t bytes, size_t *writt
         }
     }
 
-    status = callWriterThread(
-            WriteCommand::WRITE, "write", static_cast<const uint8_t*>(buffer), bytes,
-            [&] (const WriteStatus& writeStatus) {
-                *written = writeStatus.reply.written;
-                // Diagnostics of the cause of b/35813113.
-                ALOGE_IF(*written > bytes,
-                        "hal reports more bytes written than asked for: %lld > %lld",
-                        (long long)*written, (long long)bytes);
-            });
+    status = mWriteQueue->write(static_cast<const uint8_t*>(buffer), bytes, written);
     mStreamPowerLog.log(buffer, *written);
     return status;
 }
 
-status_t StreamOutHalHidl::callWriterThread(
-        WriteCommand cmd, const char* cmdName,
-        const uint8_t* data, size_t dataSize, StreamOutHalHidl::WriterCallback callback) {
-    if (!mCommandMQ->write(&cmd)) {
-        ALOGE("command message queue write failed for \"%s\"", cmdName);
-        return -EAGAIN;
-    }
-    if (data != nullptr) {
-        size_t availableToWrite = mDataMQ->availableToWrite();
-        if (dataSize > availableToWrite) {
-            ALOGW("truncating write data from %lld to %lld due to insufficient data queue space",
-                    (long long)dataSize, (long long)availableToWrite);
-            dataSize = availableToWrite;
-        }
-        if (!mDataMQ->write(data, dataSize)) {
-            ALOGE("data message queue write failed for \"%s\"", cmdName);
-        }
-    }
-    mEfGroup->wake(static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY));
-
-    // TODO: Remove manual event flag handling once blocking MQ is implemented. b/33815422
-    uint32_t efState = 0;
-retry:
-    status_t ret = mEfGroup->wait(static_cast<uint32_t>(MessageQueueFlagBits::NOT_FULL), &efState);
-    if (efState & static_cast<uint32_t>(MessageQueueFlagBits::NOT_FULL)) {
-        WriteStatus writeStatus;
-        writeStatus.retval = Result::NOT_INITIALIZED;
-        if (!mStatusMQ->read(&writeStatus)) {
-            ALOGE("status message read failed for \"%s\"", cmdName);
-        }
-        if (writeStatus.retval == Result::OK) {
-            ret = OK;
-            callback(writeStatus);
-        } else {
-            ret = processReturn(cmdName, writeStatus.retval);
-        }
-        return ret;
+status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
+    // Batching is only safe for blocking PCM writes: non-blocking writes rely on the
+    // HAL write result to request callbacks, and compressed data must not be delayed.
+    size_t writeBatchSize = 1;
+    audio_format_t format;
+    if (mCallback.unsafe_get() == nullptr && getFormat(&format) == OK &&
+            audio_is_linear_pcm(format)) {
+        writeBatchSize = std::clamp(
+                property_get_int32(kWriteBatchSizeProperty, 1), 1, kMaxWriteBatchSize);
     }
-    if (ret == -EAGAIN || ret == -EINTR) {
-        // Spurious wakeup. This normally retries no more than once.
-        goto retry;
+    if (writeBatchSize > 1 &&
+            (getFrameSize(&mFrameSize) != OK || getSampleRate(&mSampleRate) != OK)) {
+        writeBatchSize = 1;
     }
-    return ret;
-}
-
-status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
-    std::unique_ptr<CommandMQ> tempCommandMQ;
-    std::unique_ptr<DataMQ> tempDataMQ;
-    std::unique_ptr<StatusMQ> tempStatusMQ;
+    std::unique_ptr<StreamOutWriteQueue::CommandMQ> tempCommandMQ;
+    std::unique_ptr<StreamOutWriteQueue::DataMQ> tempDataMQ;
+    std::unique_ptr<StreamOutWriteQueue::StatusMQ> tempStatusMQ;
+    EventFlag* efGroup = nullptr;
     Result retval;
     pid_t halThreadPid, halThreadTid;
     Return<void> ret = mStream->prepareForWriting(
-            1, bufferSize,
+            1, bufferSize * writeBatchSize,
             [&](Result r,
-                    const CommandMQ::Descriptor& commandMQ,
-                    const DataMQ::Descriptor& dataMQ,
-                    const StatusMQ::Descriptor& statusMQ,
+                    const StreamOutWriteQueue::CommandMQ::Descriptor& commandMQ,
+                    const StreamOutWriteQueue::DataMQ::Descriptor& dataMQ,
+                    const StreamOutWriteQueue::StatusMQ::Descriptor& statusMQ,
                     const ThreadInfo& halThreadInfo) {
                 retval = r;
                 if (retval == Result::OK) {
-                    tempCommandMQ.reset(new CommandMQ(commandMQ));
-                    tempDataMQ.reset(new DataMQ(dataMQ));
-                    tempStatusMQ.reset(new StatusMQ(statusMQ));
+                    tempCommandMQ.reset(new StreamOutWriteQueue::CommandMQ(commandMQ));
+                    tempDataMQ.reset(new StreamOutWriteQueue::DataMQ(dataMQ));
+                    tempStatusMQ.reset(new StreamOutWriteQueue::StatusMQ(statusMQ));
                     if (tempDataMQ->isValid() && tempDataMQ->getEventFlagWord()) {
-                        EventFlag::createEventFlag(tempDataMQ->getEventFlagWord(), &mEfGroup);
+                        EventFlag::createEventFlag(tempDataMQ->getEventFlagWord(), &efGroup);
                     }
                     halThreadPid = halThreadInfo.pid;
                     halThreadTid = halThreadInfo.tid;
@@ -472,7 +453,7 @@ status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
     if (!tempCommandMQ || !tempCommandMQ->isValid() ||
             !tempDataMQ || !tempDataMQ->isValid() ||
             !tempStatusMQ || !tempStatusMQ->isValid() ||
-            !mEfGroup) {
+            !efGroup) {
         ALOGE_IF(!tempCommandMQ, "Failed to obtain command message queue for writing");
         ALOGE_IF(tempCommandMQ && !tempCommandMQ->isValid(),
                 "Command message queue for writing is invalid");
@@ -481,15 +462,18 @@ status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
         ALOGE_IF(!tempStatusMQ, "Failed to obtain status message queue for writing");
         ALOGE_IF(tempStatusMQ && !tempStatusMQ->isValid(),
                 "Status message queue for writing is invalid");
-        ALOGE_IF(!mEfGroup, "Event flag creation for writing failed");
+        ALOGE_IF(!efGroup, "Event flag creation for writing failed");
+        if (efGroup) {
+            EventFlag::deleteEventFlag(&efGroup);
+        }
         return NO_INIT;
     }
     requestHalThreadPriority(halThreadPid, halThreadTid);
 
-    mCommandMQ = std::move(tempCommandMQ);
-    mDataMQ = std::move(tempDataMQ);
-    mStatusMQ = std::move(tempStatusMQ);
+    mWriteQueue.reset(new StreamOutWriteQueue(std::move(tempCommandMQ), std::move(tempDataMQ),
+            std::move(tempStatusMQ), efGroup, writeBatchSize, &mFmqStats));
     mWriterClient = gettid();
+    ALOGI_IF(writeBatchSize > 1, "batching %zu writes per HAL wakeup", writeBatchSize);
     return OK;
 }
 
@@ -539,8 +523,19 @@ status_t StreamOutHalHidl::supportsPauseAndResume(bool *supportsPause, bool *sup
     return processReturn("supportsPauseAndResume", ret);
 }
 
+status_t StreamOutHalHidl::standby() {
+    if (mStream == 0) return NO_INIT;
+    if (mWriterClient == gettid() && mWriteQueue) {
+        (void)mWriteQueue->flushQueuedWrites("standby");
+    }
+    return StreamHalHidl::standby();
+}
+
 status_t StreamOutHalHidl::pause() {
     if (mStream == 0) return NO_INIT;
+    if (mWriterClient == gettid() && mWriteQueue) {
+        (void)mWriteQueue->flushQueuedWrites("pause");
+    }
     return processReturn("pause", mStream->pause());
 }
 
@@ -556,26 +551,37 @@ status_t StreamOutHalHidl::supportsDrain(bool *supportsDrain) {
 
 status_t StreamOutHalHidl::drain(bool earlyNotify) {
     if (mStream == 0) return NO_INIT;
+    if (mWriterClient == gettid() && mWriteQueue) {
+        (void)mWriteQueue->flushQueuedWrites("drain");
+    }
     return processReturn(
             "drain", mStream->drain(earlyNotify ? AudioDrain::EARLY_NOTIFY : AudioDrain::ALL));
 }
 
 status_t StreamOutHalHidl::flush() {
     if (mStream == 0) return NO_INIT;
+    // Queued writes must not reach the HAL after it has flushed.
+    if (mWriterClient == gettid() && mWriteQueue) {
+        (void)mWriteQueue->discardQueuedWrites();
+    }
     return processReturn("pause", mStream->flush());
 }
 
 status_t StreamOutHalHidl::getPresentationPosition(uint64_t *frames, struct timespec *timestamp) {
     if (mStream == 0) return NO_INIT;
-    if (mWriterClient == gettid() && mCommandMQ) {
-        return callWriterThread(
-                WriteCommand::GET_PRESENTATION_POSITION, "getPresentationPosition", nullptr, 0,
+    // Queued writes are not counted: the HAL only reports frames it has presented, and
+    // the queued writes are accounted in the latency.
+    status_t status = WOULD_BLOCK;
+    if (mWriterClient == gettid() && mWriteQueue) {
+        status = mWriteQueue->query(
+                WriteCommand::GET_PRESENTATION_POSITION, "getPresentationPosition",
                 [&](const WriteStatus& writeStatus) {
                     *frames = writeStatus.reply.presentationPosition.frames;
                     timestamp->tv_sec = writeStatus.reply.presentationPosition.timeStamp.tvSec;
                     timestamp->tv_nsec = writeStatus.reply.presentationPosition.timeStamp.tvNSec;
                 });
-    } else {
+    }
+    if (status == WOULD_BLOCK) {
         Result retval;
         Return<void> ret = mStream->getPresentationPosition(
                 [&](Result r, uint64_t hidlFrames, const TimeSpec& hidlTimeStamp) {
@@ -588,6 +594,7 @@ status_t StreamOutHalHidl::getPresentationPosition(uint64_t *frames, struct time
                 });
         return processReturn("getPresentationPosition", ret, retval);
     }
+    return status;
 }
 
 #if MAJOR_VERSION == 2
@@ -759,12 +766,15 @@ status_t StreamInHalHidl::callReaderThread(
         return -EAGAIN;
     }
     mEfGroup->wake(static_cast<uint32_t>(MessageQueueFlagBits::NOT_FULL));
+    mFmqStats.onWake(params.command == ReadCommand::READ ? 1 : 0);
 
     // TODO: Remove manual event flag handling once blocking MQ is implemented. b/33815422
     uint32_t efState = 0;
+    const nsecs_t waitStartNs = systemTime();
 retry:
     status_t ret = mEfGroup->wait(static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY), &efState);
     if (efState & static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY)) {
+        mFmqStats.onWait(systemTime() - waitStartNs);
         ReadStatus readStatus;
         readStatus.retval = Result::NOT_INITIALIZED;
         if (!mStatusMQ->read(&readStatus)) {
@@ -25,8 +25,10 @@
 #include <fmq/EventFlag.h>
 #include <fmq/MessageQueue.h>
 #include <media/audiohal/StreamHalInterface.h>
+#include <utils/Timers.h>
 
 #include "ConversionHelperHidl.h"
+#include "StreamFmqHidl.h"
 #include "StreamPowerLog.h"
 
 using ::android::hardware::audio::CPP_VERSION::IStream;
@@ -37,8 +39,6 @@ using ::android::hardware::MessageQueue;
 using ::android::hardware::Return;
 using ReadParameters = ::android::hardware::audio::CPP_VERSION::IStreamIn::ReadParameters;
 using ReadStatus = ::android::hardware::audio::CPP_VERSION::IStreamIn::ReadStatus;
-using WriteCommand = ::android::hardware::audio::CPP_VERSION::IStreamOut::WriteCommand;
-using WriteStatus = ::android::hardware::audio::CPP_VERSION::IStreamOut::WriteStatus;
 
 namespace android {
 namespace CPP_VERSION {
@@ -110,6 +110,9 @@ class StreamHalHidl : public virtual StreamHalInterface, public ConversionHelper
     // mStreamPowerLog is used for audio signal power logging.
     StreamPowerLog mStreamPowerLog;
 
+    // Fast message queue statistics, updated by the reader or writer thread.
+    StreamFmqStats mFmqStats;
+
   private:
     const int HAL_THREAD_PRIORITY_DEFAULT = -1;
     IStream *mStream;
@@ -147,6 +150,9 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     // Returns whether pause and resume operations are supported.
     virtual status_t supportsPauseAndResume(bool *supportsPause, bool *supportsResume);
 
+    // Put the audio hardware output into standby mode.
+    virtual status_t standby();
+
     // Notifies to the audio driver to resume playback following a pause.
     virtual status_t pause();
 
@@ -180,28 +186,20 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
 
   private:
     friend class DeviceHalHidl;
-    typedef MessageQueue<WriteCommand, hardware::kSynchronizedReadWrite> CommandMQ;
-    typedef MessageQueue<uint8_t, hardware::kSynchronizedReadWrite> DataMQ;
-    typedef MessageQueue<WriteStatus, hardware::kSynchronizedReadWrite> StatusMQ;
-
     wp<StreamOutHalInterfaceCallback> mCallback;
     wp<StreamOutHalInterfaceEventCallback> mEventCallback;
     sp<IStreamOut> mStream;
-    std::unique_ptr<CommandMQ> mCommandMQ;
-    std::unique_ptr<DataMQ> mDataMQ;
-    std::unique_ptr<StatusMQ> mStatusMQ;
+    std::unique_ptr<StreamOutWriteQueue> mWriteQueue;
     std::atomic<pid_t> mWriterClient;
-    EventFlag* mEfGroup;
+    // Set when writes are batched, to account the queued writes as latency.
+    size_t mFrameSize;
+    uint32_t mSampleRate;
 
     // Can not be constructed directly by clients.
     StreamOutHalHidl(const sp<IStreamOut>& stream);
 
     virtual ~StreamOutHalHidl();
 
-    using WriterCallback = std::function<void(const WriteStatus& writeStatus)>;
-    status_t callWriterThread(
-            WriteCommand cmd, const char* cmdName,
-            const uint8_t* data, size_t dataSize, WriterCallback callback);
     status_t prepareForWriting(size_t bufferSize);
 };
 
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "stream_fmq_tests"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "StreamFmqHidl.h"
+
+using namespace android;
+using namespace android::CPP_VERSION;
+using ::android::hardware::audio::CPP_VERSION::MessageQueueFlagBits;
+using ::android::hardware::audio::CPP_VERSION::Result;
+
+namespace {
+
+constexpr size_t kBufferBytes = 256;
+constexpr size_t kWriteBatchSize = 4;
+constexpr uint32_t kHalLatencyMs = 20;
+
+// HAL side of the output stream message queues, serving the commands the way the default
+// audio HAL write thread does: a WRITE command consumes all the data in the data queue.
+class StubStreamOutHal {
+  public:
+    StubStreamOutHal()
+            : mCommandMQ(1), mDataMQ(kBufferBytes * kWriteBatchSize, true /* EventFlag */),
+              mStatusMQ(1) {
+        EventFlag::createEventFlag(mDataMQ.getEventFlagWord(), &mEfGroup);
+        mThread = std::thread(&StubStreamOutHal::threadLoop, this);
+    }
+
+    ~StubStreamOutHal() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStop = true;
+            mHeld = false;
+        }
+        mCondition.notify_all();
+        mEfGroup->wake(static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY));
+        mThread.join();
+        EventFlag::deleteEventFlag(&mEfGroup);
+    }
+
+    // Client side of the queues, as set up by StreamOutHalHidl::prepareForWriting().
+    std::unique_ptr<StreamOutWriteQueue> createWriteQueue(size_t writeBatchSize) {
+        auto dataMQ = std::make_unique<StreamOutWriteQueue::DataMQ>(*mDataMQ.getDesc());
+        EventFlag* efGroup = nullptr;
+        EventFlag::createEventFlag(dataMQ->getEventFlagWord(), &efGroup);
+        return std::make_unique<StreamOutWriteQueue>(
+                std::make_unique<StreamOutWriteQueue::CommandMQ>(*mCommandMQ.getDesc()),
+                std::move(dataMQ),
+                std::make_unique<StreamOutWriteQueue::StatusMQ>(*mStatusMQ.getDesc()),
+                efGroup, writeBatchSize, &mStats);
+    }
+
+    // WRITE commands wait until release() is called.
+    void hold() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mHeld = true;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mHeld = false;
+        }
+        mCondition.notify_all();
+    }
+
+    // The next WRITE command only writes 'bytes' bytes of the data it consumes.
+    void limitNextWrite(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mWriteLimit = bytes;
+    }
+
+    std::vector<uint8_t> written() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mWritten;
+    }
+
+    size_t writeCommands() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mWriteCommands;
+    }
+
+  private:
+    void threadLoop() {
+        std::vector<uint8_t> buffer(mDataMQ.getQuantumCount());
+        for (;;) {
+            uint32_t efState = 0;
+            mEfGroup->wait(static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY), &efState);
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                if (mStop) return;
+            }
+            if (!(efState & static_cast<uint32_t>(MessageQueueFlagBits::NOT_EMPTY))) continue;
+            WriteStatus status{};
+            if (!mCommandMQ.read(&status.replyTo)) continue;
+            status.retval = Result::OK;
+            switch (status.replyTo) {
+                case WriteCommand::WRITE: {
+                    std::unique_lock<std::mutex> lock(mLock);
+                    mCondition.wait(lock, [this] { return !mHeld; });
+                    const size_t bytes = mDataMQ.availableToRead();
+                    EXPECT_TRUE(mDataMQ.read(buffer.data(), bytes));
+                    const size_t written = std::min(bytes, mWriteLimit);
+                    mWriteLimit = SIZE_MAX;
+                    mWritten.insert(mWritten.end(), buffer.begin(), buffer.begin() + written);
+                    mWriteCommands++;
+                    status.reply.written = written;
+                    break;
+                }
+                case WriteCommand::GET_PRESENTATION_POSITION:
+                    status.reply.presentationPosition.frames = 0;
+                    break;
+                case WriteCommand::GET_LATENCY:
+                    status.reply.latencyMs = kHalLatencyMs;
+                    break;
+            }
+            EXPECT_TRUE(mStatusMQ.write(&status));
+            mEfGroup->wake(static_cast<uint32_t>(MessageQueueFlagBits::NOT_FULL));
+        }
+    }
+
+    StreamOutWriteQueue::CommandMQ mCommandMQ;
+    StreamOutWriteQueue::DataMQ mDataMQ;
+    StreamOutWriteQueue::StatusMQ mStatusMQ;
+    EventFlag* mEfGroup = nullptr;
+    StreamFmqStats mStats;
+    std::thread mThread;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mStop = false;
+    bool mHeld = false;
+    size_t mWriteLimit = SIZE_MAX;
+    std::vector<uint8_t> mWritten;
+    size_t mWriteCommands = 0;
+};
+
+class StreamOutWriteQueueTest : public ::testing::Test {
+  protected:
+    // Distinct contents for each buffer written by a test.
+    static std::vector<uint8_t> buffer(size_t index) {
+        std::vector<uint8_t> data(kBufferBytes);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<uint8_t>(index * 31 + i);
+        }
+        return data;
+    }
+
+    static std::vector<uint8_t> buffers(std::initializer_list<size_t> indices) {
+        std::vector<uint8_t> data;
+        for (size_t index : indices) {
+            const std::vector<uint8_t> b = buffer(index);
+            data.insert(data.end(), b.begin(), b.end());
+        }
+        return data;
+    }
+
+    void write(StreamOutWriteQueue* queue, size_t index, size_t expectedWritten) {
+        const std::vector<uint8_t> data = buffer(index);
+        size_t written = 0;
+        ASSERT_EQ(OK, queue->write(data.data(), data.size(), &written));
+        EXPECT_EQ(expectedWritten, written);
+    }
+
+    StubStreamOutHal mHal;
+};
+
+TEST_F(StreamOutWriteQueueTest, UnbatchedWriteReturnsHalResult) {
+    std::unique_ptr<StreamOutWriteQueue> queue = mHal.createWriteQueue(1);
+    write(queue.get(), 0, kBufferBytes);
+    mHal.limitNextWrite(kBufferBytes / 2);
+    write(queue.get(), 1, kBufferBytes / 2);
+
+    EXPECT_EQ(2u, mHal.writeCommands());
+    std::vector<uint8_t> expected = buffers({0, 1});
+    expected.resize(kBufferBytes * 3 / 2);
+    EXPECT_EQ(expected, mHal.written());
+}
+
+TEST_F(StreamOutWriteQueueTest, BatchesWrites) {
+    std::unique_ptr<StreamOutWriteQueue> queue = mHal.createWriteQueue(kWriteBatchSize);
+    for (size_t i = 0; i < 2 * kWriteBatchSize + 1; i++) {
+        write(queue.get(), i, kBufferBytes);
+    }
+    EXPECT_EQ(kBufferBytes, queue->queuedBytes());
+    ASSERT_EQ(OK, queue->flushQueuedWrites("test"));
+
+    EXPECT_EQ(0u, queue->queuedBytes());
+    EXPECT_EQ(3u, mHal.writeCommands());
+    EXPECT_EQ(buffers({0, 1, 2, 3, 4, 5, 6, 7, 8}), mHal.written());
+}
+
+TEST_F(StreamOutWriteQueueTest, QueryDoesNotWaitForBatch) {
+    std::unique_ptr<StreamOutWriteQueue> queue = mHal.createWriteQueue(2);
+    mHal.hold();
+    // The second write sends the batch, and returns while the HAL is still holding it.
+    write(queue.get(), 0, kBufferBytes);
+    write(queue.get(), 1, kBufferBytes);
+    EXPECT_EQ(2 * kBufferBytes, queue->queuedBytes());
+
+    uint32_t latencyMs = 0;
+    auto getLatency = [&](const WriteStatus& writeStatus) {
+        latencyMs = writeStatus.reply.latencyMs;
+    };
+    EXPECT_EQ(WOULD_BLOCK, queue->query(WriteCommand::GET_LATENCY, "getLatency", getLatency));
+    EXPECT_EQ(0u, latencyMs);
+
+    mHal.release();
+    ASSERT_EQ(OK, queue->flushQueuedWrites("test"));
+    EXPECT_EQ(OK, queue->query(WriteCommand::GET_LATENCY, "getLatency", getLatency));
+    EXPECT_EQ(kHalLatencyMs, latencyMs);
+    EXPECT_EQ(0u, queue->queuedBytes());
+    EXPECT_EQ(buffers({0, 1}), mHal.written());
+}
+
+TEST_F(StreamOutWriteQueueTest, ShortBatchDisablesBatching) {
+    std::unique_ptr<StreamOutWriteQueue> queue = mHal.createWriteQueue(2);
+    mHal.limitNextWrite(kBufferBytes);
+    write(queue.get(), 0, kBufferBytes);
+    write(queue.get(), 1, kBufferBytes);
+    // Collects the short batch status, then writes without batching.
+    write(queue.get(), 2, kBufferBytes);
+    EXPECT_EQ(1u, queue->writeBatchSize());
+    EXPECT_EQ(0u, queue->queuedBytes());
+    write(queue.get(), 3, kBufferBytes);
+
+    EXPECT_EQ(3u, mHal.writeCommands());
+    EXPECT_EQ(buffers({0, 2, 3}), mHal.written());
+}
+
+TEST_F(StreamOutWriteQueueTest, DiscardDropsQueuedWrites) {
+    std::unique_ptr<StreamOutWriteQueue> queue = mHal.createWriteQueue(kWriteBatchSize);
+    write(queue.get(), 0, kBufferBytes);
+    write(queue.get(), 1, kBufferBytes);
+    ASSERT_EQ(OK, queue->discardQueuedWrites());
+    EXPECT_EQ(0u, queue->queuedBytes());
+
+    write(queue.get(), 2, kBufferBytes);
+    ASSERT_EQ(OK, queue->flushQueuedWrites("test"));
+    EXPECT_EQ(1u, mHal.writeCommands());
+    EXPECT_EQ(buffers({2}), mHal.written());
+}
+
+TEST_F(StreamOutWriteQueueTest, DiscardWaitsForBatchInFlight) {
+    std::unique_ptr<StreamOutWriteQueue> queue = mHal.createWriteQueue(2);
+    mHal.hold();
+    write(queue.get(), 0, kBufferBytes);
+    write(queue.get(), 1, kBufferBytes);
+    mHal.release();
+    // A batch already sent can not be recalled.
+    ASSERT_EQ(OK, queue->discardQueuedWrites());
+
+    EXPECT_EQ(1u, mHal.writeCommands());
+    EXPECT_EQ(buffers({0, 1}), mHal.written());
+}
+
+}  // namespace
@@ -39,6 +39,7 @@ namespace android {
 enum {
     SUBMIT_ITEM = IBinder::FIRST_CALL_TRANSACTION,
     SUBMIT_BUFFER,
+    SUBMIT_BATCH,
 };
 
 class BpMediaMetricsService: public BpInterface<IMediaMetricsService>
@@ -72,11 +73,22 @@ public:
     }
 
     status_t submitBuffer(const char *buffer, size_t length) override
+    {
+        return transactBuffer(SUBMIT_BUFFER, buffer, length);
+    }
+
+    status_t submitBatch(const char *buffer, size_t length) override
+    {
+        return transactBuffer(SUBMIT_BATCH, buffer, length);
+    }
+
+private:
+    status_t transactBuffer(uint32_t code, const char *buffer, size_t length)
     {
         if (buffer == nullptr || length > INT32_MAX) {
             return BAD_VALUE;
         }
-        ALOGV("%s: (ONEWAY) length:%zu", __func__, length);
+        ALOGV("%s: (ONEWAY) code:%u length:%zu", __func__, code, length);
 
         Parcel data;
         data.writeInterfaceToken(IMediaMetricsService::getInterfaceDescriptor());
@@ -88,7 +100,7 @@ public:
         }
 
         status = remote()->transact(
-                SUBMIT_BUFFER, data, nullptr /* reply */, IBinder::FLAG_ONEWAY);
+                code, data, nullptr /* reply */, IBinder::FLAG_ONEWAY);
         ALOGW_IF(status != NO_ERROR, "%s: bad response from service for submit, status=%d",
                 __func__, status);
         return status;
@@ -115,7 +127,8 @@ status_t BnMediaMetricsService::onTransact(
         // assume failure logged by submitInternal
         return NO_ERROR;
     }
-    case SUBMIT_BUFFER: {
+    case SUBMIT_BUFFER:
+    case SUBMIT_BATCH: {
         CHECK_INTERFACE(IMediaMetricsService, data, reply);
         int32_t length;
         status_t status = data.readInt32(&length);
@@ -126,8 +139,10 @@ status_t BnMediaMetricsService::onTransact(
         if (ptr == nullptr) {
             return BAD_VALUE;
         }
-        status = submitBuffer(static_cast<const char *>(ptr), length);
-        // assume failure logged by submitBuffer
+        status = code == SUBMIT_BUFFER
+                ? submitBuffer(static_cast<const char *>(ptr), length)
+                : submitBatch(static_cast<const char *>(ptr), length);
+        // assume failure logged by submitBuffer or submitBatch
         return NO_ERROR;
     }
 
@@ -17,12 +17,18 @@
 #define LOG_TAG "mediametrics::Item"
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <set>
+#include <thread>
+#include <vector>
 
 #include <binder/Parcel.h>
 #include <cutils/properties.h>
@@ -278,6 +284,18 @@ std::string mediametrics::Item::toString() const {
 // calls the appropriate daemon
 bool mediametrics::Item::selfrecord() {
     ALOGD_IF(DEBUG_API, "%s: delivering %s", __func__, this->toString().c_str());
+    if (isBatchingEnabled()) {
+        char *buffer = nullptr;
+        size_t length = 0;
+        const status_t status = writeToByteString(&buffer, &length);
+        if (status != NO_ERROR) {
+            ALOGW("%s: failed(%d) to serialize: %s", __func__, status, toString().c_str());
+            return false;
+        }
+        const bool queued = submitBufferBatched(buffer, length);
+        free(buffer);
+        return queued;
+    }
     sp<IMediaMetricsService> svc = getService();
     if (svc != NULL) {
         status_t status = svc->submit(this);
@@ -360,6 +378,183 @@ bool BaseItem::submitBuffer(const char *buffer, size_t size) {
     return false;
 }
 
+// Lock-free multi-producer, single-consumer queue of serialized items.
+// Producers push onto an intrusive stack with a compare and swap. The consumer takes
+// the whole stack with one exchange, restores the submission order and sends the
+// concatenated items in as few SUBMIT_BATCH transactions as kBatchMaxBytes allows.
+// The consumer is either the producer which crossed kBatchMaxBytes or the flusher thread,
+// woken by the first item of a batch, kBatchMaxDelayMs later. The flusher thread is only
+// started by the first item queued, and whatever is still queued is sent at exit().
+// A forked child starts with an empty queue and no flusher thread: the items queued before
+// fork() are delivered by the parent.
+class BatchSubmitter {
+public:
+    static BatchSubmitter& getInstance() {
+        // never destroyed: the flusher thread may outlive static destruction
+        static BatchSubmitter * const instance = new BatchSubmitter();
+        return *instance;
+    }
+
+    bool enqueue(const char *buffer, size_t size) {
+        Node * const node = (Node *)malloc(sizeof(Node) + size);
+        if (node == nullptr) {
+            return false;
+        }
+        node->size = size;
+        memcpy(node->data(), buffer, size);
+        Node *head = mHead.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!mHead.compare_exchange_weak(
+                head, node, std::memory_order_release, std::memory_order_relaxed));
+
+        const size_t pending = mPendingBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        if (pending >= BaseItem::kBatchMaxBytes) {
+            flush();
+        } else if (head == nullptr) {
+            wakeFlusher(); // first item of a batch
+        }
+        return true;
+    }
+
+    void flush() {
+        std::lock_guard _l(mFlushLock);
+        Node *node = mHead.exchange(nullptr, std::memory_order_acquire);
+        Node *ordered = nullptr;
+        while (node != nullptr) {
+            Node * const next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+        while (ordered != nullptr) {
+            if (mBatch.size() + ordered->size > BaseItem::kBatchMaxBytes) {
+                send_l();
+            }
+            mBatch.insert(mBatch.end(), ordered->data(), ordered->data() + ordered->size);
+            mPendingBytes.fetch_sub(ordered->size, std::memory_order_relaxed);
+            Node * const next = ordered->next;
+            free(ordered);
+            ordered = next;
+        }
+        send_l();
+    }
+
+private:
+    struct Node {
+        Node *next;
+        size_t size;
+        char *data() { return reinterpret_cast<char *>(this + 1); } // follows the node
+    };
+
+    BatchSubmitter() {
+        // Items queued less than kBatchMaxDelayMs before a normal exit would otherwise be lost.
+        atexit([] { getInstance().flush(); });
+        // The locks are held across fork(), so the child gets a consistent copy of the queue.
+        pthread_atfork([] { getInstance().lockForFork(); },
+                       [] { getInstance().unlockAfterFork(); },
+                       [] { getInstance().resetInChild(); });
+    }
+
+    void lockForFork() {
+        mFlushLock.lock();
+        mWakeLock.lock();
+    }
+
+    void unlockAfterFork() {
+        mWakeLock.unlock();
+        mFlushLock.unlock();
+    }
+
+    void resetInChild() {
+        Node *node = mHead.exchange(nullptr, std::memory_order_relaxed);
+        while (node != nullptr) {
+            Node * const next = node->next;
+            free(node);
+            node = next;
+        }
+        mPendingBytes.store(0, std::memory_order_relaxed);
+        mBatch.clear();
+        mFlusherStarted = false; // the thread was not forked
+        mWakeRequested = false;
+        unlockAfterFork();
+    }
+
+    void send_l() {
+        if (mBatch.empty()) return;
+        ALOGD_IF(DEBUG_API, "%s: delivering %zu bytes", __func__, mBatch.size());
+        sp<IMediaMetricsService> svc = BaseItem::getService();
+        if (svc != nullptr) {
+            const status_t status = svc->submitBatch(mBatch.data(), mBatch.size());
+            ALOGW_IF(status != NO_ERROR, "%s: failed(%d) to record: %zu bytes",
+                    __func__, status, mBatch.size());
+        }
+        mBatch.clear(); // keeps the capacity for the next batch
+    }
+
+    void wakeFlusher() {
+        std::lock_guard _l(mWakeLock);
+        if (!mFlusherStarted) {
+            mFlusherStarted = true;
+            std::thread(&BatchSubmitter::flusherLoop, this).detach();
+        }
+        mWakeRequested = true;
+        mWakeCondition.notify_one();
+    }
+
+    void flusherLoop() {
+        for (;;) {
+            {
+                std::unique_lock _l(mWakeLock);
+                mWakeCondition.wait(_l, [this] { return mWakeRequested; });
+                mWakeRequested = false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(BaseItem::kBatchMaxDelayMs));
+            flush();
+        }
+    }
+
+    std::atomic<Node *> mHead{nullptr};
+    std::atomic<size_t> mPendingBytes{0};
+
+    std::mutex mFlushLock;          // serializes consumers
+    std::vector<char> mBatch;       // GUARDED_BY(mFlushLock)
+
+    std::mutex mWakeLock;
+    std::condition_variable mWakeCondition;
+    bool mWakeRequested = false;    // GUARDED_BY(mWakeLock)
+    bool mFlusherStarted = false;   // GUARDED_BY(mWakeLock)
+};
+
+//static
+bool BaseItem::isBatchingEnabled() {
+    // This is checked only once in the lifetime of the process.
+    static const bool batching = isEnabled()
+            && property_get_int32(BatchProperty, BatchProperty_default) > 0;
+    return batching;
+}
+
+// static
+bool BaseItem::submitBufferBatched(const char *buffer, size_t size) {
+    if (buffer == nullptr || size < sizeof(uint32_t)) {
+        return false;
+    }
+    if (size > kBatchMaxBytes) {
+        return submitBuffer(buffer, size); // would be a batch on its own
+    }
+    return BatchSubmitter::getInstance().enqueue(buffer, size);
+}
+
+// static
+void BaseItem::flushBatch() {
+    BatchSubmitter::getInstance().flush();
+}
+
+// static
+bool BaseItem::deliverBuffer(const char *buffer, size_t size) {
+    return isBatchingEnabled() ? submitBufferBatched(buffer, size) : submitBuffer(buffer, size);
+}
+
 //static
 sp<IMediaMetricsService> BaseItem::getService() {
     static const char *servicename = "media.metrics";
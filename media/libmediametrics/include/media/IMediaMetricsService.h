@@ -50,6 +50,15 @@ public:
     virtual status_t submit(mediametrics::Item *item) = 0;
 
     virtual status_t submitBuffer(const char *buffer, size_t length) = 0;
+
+    /**
+     * Submits several serialized items in one transaction.
+     *
+     * \param buffer the concatenation of items as written by writeToByteString(),
+     *               each starting with its total size.
+     * \param length the total length of the buffer.
+     */
+    virtual status_t submitBatch(const char *buffer, size_t length) = 0;
 };
 
 // ----------------------------------------------------------------------------
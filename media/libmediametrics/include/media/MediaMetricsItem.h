@@ -250,8 +250,24 @@ protected:
     // let's reuse a binder connection
     static sp<IMediaMetricsService> sMediaMetricsService;
 
+    // Batching of client submissions, enabled 1, disabled 0.
+    // Off by default: queued items are only delivered by the flusher thread or at exit().
+    static constexpr const char * const BatchProperty = "media.metrics.batch";
+    static const int BatchProperty_default = 0;
+    // A batch is sent when this many bytes are pending or this long after its first item.
+    static constexpr size_t kBatchMaxBytes = 32 * 1024;
+    static constexpr int64_t kBatchMaxDelayMs = 100;
+
     static void dropInstance();
+    // Sends one serialized item to the service in its own binder transaction.
     static bool submitBuffer(const char *buffer, size_t len);
+    // Queues one serialized item without locking, see kBatchMaxBytes and kBatchMaxDelayMs.
+    static bool submitBufferBatched(const char *buffer, size_t len);
+    // Sends all queued items now.
+    static void flushBatch();
+    // submitBufferBatched() if batching is enabled for this process, else submitBuffer().
+    static bool deliverBuffer(const char *buffer, size_t len);
+    static bool isBatchingEnabled();
 
     template <typename T>
     struct is_item_type {
@@ -574,7 +590,7 @@ public:
 
     bool record() {
         return updateHeader()
-                && BaseItem::submitBuffer(getBuffer(), getLength());
+                && BaseItem::deliverBuffer(getBuffer(), getLength());
     }
 
     bool isValid () const {
@@ -57,6 +57,12 @@ public:
     virtual ssize_t write(const void *buffer, size_t count);
     //virtual ssize_t writeVia(writeVia_t via, size_t total, void *user, size_t block);
 
+    // Direct access for readers that track positions themselves instead of using a PipeReader:
+    // frame n of the stream (see framesWritten()) is at index n & (maxFrames() - 1) of buffer(),
+    // and remains valid until frame n + maxFrames() is written.
+    void*           buffer() const { return mBuffer; }
+    size_t          maxFrames() const { return mMaxFrames; }
+
 private:
     const size_t    mMaxFrames;     // always a power of 2
     void * const    mBuffer;
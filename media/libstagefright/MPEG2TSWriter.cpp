@@ -476,6 +476,9 @@ void MPEG2TSWriter::init() {
 
     initCrcTable();
 
+    mPacketBuffer = new ABuffer(kTSPacketSize * kMaxPacketsPerWrite);
+    mPacketBuffer->setRange(0, 0);
+
     mLooper = new ALooper;
     mLooper->setName("MPEG2TSWriter");
 
@@ -526,6 +529,9 @@ status_t MPEG2TSWriter::start(MetaData *param ) {
     mNumTSPacketsWritten = 0;
     mNumTSPacketsBeforeMeta = 0;
 
+    buildProgramAssociationTable();
+    buildProgramMap();
+
     for (size_t i = 0; i < mSources.size(); ++i) {
         sp<AMessage> notify =
             new AMessage(kWhatSourceNotify, mReflector);
@@ -661,7 +667,7 @@ void MPEG2TSWriter::onMessageReceived(const sp<AMessage> &msg) {
     }
 }
 
-void MPEG2TSWriter::writeProgramAssociationTable() {
+void MPEG2TSWriter::buildProgramAssociationTable() {
     // 0x47
     // transport_error_indicator = b0
     // payload_unit_start_indicator = b1
@@ -698,22 +704,26 @@ void MPEG2TSWriter::writeProgramAssociationTable() {
         0x00, 0x00, 0x00, 0x00   // b???? ???? ???? ???? ???? ???? ???? ????
     };
 
-    sp<ABuffer> buffer = new ABuffer(188);
-    memset(buffer->data(), 0xff, buffer->size());
-    memcpy(buffer->data(), kData, sizeof(kData));
+    uint8_t *packet = mProgramAssociationTable;
+    memset(packet, 0xff, kTSPacketSize);
+    memcpy(packet, kData, sizeof(kData));
+
+    // the continuity counter is not covered by the CRC.
+    uint32_t crc = htonl(crc32(&packet[5], 12));
+    memcpy(&packet[17], &crc, sizeof(crc));
+}
+
+void MPEG2TSWriter::writeProgramAssociationTable() {
+    uint8_t *packet = allocPacket();
+    memcpy(packet, mProgramAssociationTable, kTSPacketSize);
 
     if (++mPATContinuityCounter == 16) {
         mPATContinuityCounter = 0;
     }
-    buffer->data()[3] |= mPATContinuityCounter;
-
-    uint32_t crc = htonl(crc32(&buffer->data()[5], 12));
-    memcpy(&buffer->data()[17], &crc, sizeof(crc));
-
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
+    packet[3] |= mPATContinuityCounter;
 }
 
-void MPEG2TSWriter::writeProgramMap() {
+void MPEG2TSWriter::buildProgramMap() {
     // 0x47
     // transport_error_indicator = b0
     // payload_unit_start_indicator = b1
@@ -755,24 +765,19 @@ void MPEG2TSWriter::writeProgramMap() {
         0xe0, 0x00, 0xf0, 0x00   // b111? ???? ???? ???? 1111 0000 0000 0000
     };
 
-    sp<ABuffer> buffer = new ABuffer(188);
-    memset(buffer->data(), 0xff, buffer->size());
-    memcpy(buffer->data(), kData, sizeof(kData));
-
-    if (++mPMTContinuityCounter == 16) {
-        mPMTContinuityCounter = 0;
-    }
-    buffer->data()[3] |= mPMTContinuityCounter;
+    uint8_t *packet = mProgramMap;
+    memset(packet, 0xff, kTSPacketSize);
+    memcpy(packet, kData, sizeof(kData));
 
     size_t section_length = 5 * mSources.size() + 4 + 9;
-    buffer->data()[6] |= section_length >> 8;
-    buffer->data()[7] = section_length & 0xff;
+    packet[6] |= section_length >> 8;
+    packet[7] = section_length & 0xff;
 
     static const unsigned kPCR_PID = 0x1e1;
-    buffer->data()[13] |= (kPCR_PID >> 8) & 0x1f;
-    buffer->data()[14] = kPCR_PID & 0xff;
+    packet[13] |= (kPCR_PID >> 8) & 0x1f;
+    packet[14] = kPCR_PID & 0xff;
 
-    uint8_t *ptr = &buffer->data()[sizeof(kData)];
+    uint8_t *ptr = &packet[sizeof(kData)];
     for (size_t i = 0; i < mSources.size(); ++i) {
         *ptr++ = mSources.editItemAt(i)->streamType();
 
@@ -783,10 +788,19 @@ void MPEG2TSWriter::writeProgramMap() {
         *ptr++ = 0x00;
     }
 
-    uint32_t crc = htonl(crc32(&buffer->data()[5], 12+mSources.size()*5));
-    memcpy(&buffer->data()[17+mSources.size()*5], &crc, sizeof(crc));
+    // the continuity counter is not covered by the CRC.
+    uint32_t crc = htonl(crc32(&packet[5], 12+mSources.size()*5));
+    memcpy(&packet[17+mSources.size()*5], &crc, sizeof(crc));
+}
 
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
+void MPEG2TSWriter::writeProgramMap() {
+    uint8_t *packet = allocPacket();
+    memcpy(packet, mProgramMap, kTSPacketSize);
+
+    if (++mPMTContinuityCounter == 16) {
+        mPMTContinuityCounter = 0;
+    }
+    packet[3] |= mPMTContinuityCounter;
 }
 
 void MPEG2TSWriter::writeAccessUnit(
@@ -826,9 +840,6 @@ void MPEG2TSWriter::writeAccessUnit(
     // reserved = b1
     // the first fragment of "buffer" follows
 
-    sp<ABuffer> buffer = new ABuffer(188);
-    memset(buffer->data(), 0xff, buffer->size());
-
     const unsigned PID = 0x1e0 + sourceIndex + 1;
 
     const unsigned continuity_counter =
@@ -855,7 +866,8 @@ void MPEG2TSWriter::writeAccessUnit(
         PES_packet_length = 0;
     }
 
-    uint8_t *ptr = buffer->data();
+    uint8_t *packet = allocPacket();
+    uint8_t *ptr = packet;
     *ptr++ = 0x47;
     *ptr++ = 0x40 | (PID >> 8);
     *ptr++ = PID & 0xff;
@@ -865,6 +877,7 @@ void MPEG2TSWriter::writeAccessUnit(
         *ptr++ = paddingSize - 1;
         if (paddingSize >= 2) {
             *ptr++ = 0x00;
+            memset(ptr, 0xff, paddingSize - 2);  // stuffing bytes
             ptr += paddingSize - 2;
         }
     }
@@ -883,15 +896,14 @@ void MPEG2TSWriter::writeAccessUnit(
     *ptr++ = (PTS >> 7) & 0xff;
     *ptr++ = ((PTS & 0x7f) << 1) | 1;
 
-    size_t sizeLeft = buffer->data() + buffer->size() - ptr;
+    size_t sizeLeft = packet + kTSPacketSize - ptr;
     size_t copy = accessUnit->size();
     if (copy > sizeLeft) {
         copy = sizeLeft;
     }
 
     memcpy(ptr, accessUnit->data(), copy);
-
-    CHECK_EQ(internalWrite(buffer->data(), buffer->size()), (ssize_t)buffer->size());
+    memset(ptr + copy, 0xff, sizeLeft - copy);  // if the payload does not fill the packet
 
     size_t offset = copy;
     while (offset < accessUnit->size()) {
@@ -907,12 +919,11 @@ void MPEG2TSWriter::writeAccessUnit(
         // continuity_counter = b????
         // the fragment of "buffer" follows.
 
-        memset(buffer->data(), 0xff, buffer->size());
-
         const unsigned continuity_counter =
             mSources.editItemAt(sourceIndex)->incrementContinuityCounter();
 
-        ptr = buffer->data();
+        packet = allocPacket();
+        ptr = packet;
         *ptr++ = 0x47;
         *ptr++ = 0x00 | (PID >> 8);
         *ptr++ = PID & 0xff;
@@ -925,22 +936,44 @@ void MPEG2TSWriter::writeAccessUnit(
             *ptr++ = paddingSize - 1;
             if (paddingSize >= 2) {
                 *ptr++ = 0x00;
+                memset(ptr, 0xff, paddingSize - 2);  // stuffing bytes
                 ptr += paddingSize - 2;
             }
         }
 
-        size_t sizeLeft = buffer->data() + buffer->size() - ptr;
+        size_t sizeLeft = packet + kTSPacketSize - ptr;
         size_t copy = accessUnit->size() - offset;
         if (copy > sizeLeft) {
             copy = sizeLeft;
         }
 
         memcpy(ptr, accessUnit->data() + offset, copy);
-        CHECK_EQ(internalWrite(buffer->data(), buffer->size()),
-                 (ssize_t)buffer->size());
+        memset(ptr + copy, 0xff, sizeLeft - copy);
 
         offset += copy;
     }
+
+    // Write out the access unit, with the PAT and PMT preceding it if any.
+    flushPackets();
+}
+
+uint8_t *MPEG2TSWriter::allocPacket() {
+    if (mPacketBuffer->size() + kTSPacketSize > mPacketBuffer->capacity()) {
+        flushPackets();
+    }
+    uint8_t *packet = mPacketBuffer->data() + mPacketBuffer->size();
+    mPacketBuffer->setRange(0, mPacketBuffer->size() + kTSPacketSize);
+    return packet;
+}
+
+void MPEG2TSWriter::flushPackets() {
+    const size_t size = mPacketBuffer->size();
+    if (size == 0) {
+        return;
+    }
+    CHECK_EQ(internalWrite(mPacketBuffer->data(), size), (ssize_t)size);
+    mNumTSPacketsWritten += size / kTSPacketSize;
+    mPacketBuffer->setRange(0, 0);
 }
 
 void MPEG2TSWriter::writeTS() {
@@ -0,0 +1,437 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "m4venc_simd.h"
+
+#ifdef M4VENC_SIMD
+
+#define FDCT_SHIFT 10
+
+/* ----------------------------------------------------------------------
+ * v16 holds eight 16-bit lanes and is used for the row pass, whose
+ * intermediates stay within +/-4080 (inputs are 2*(cur - pred)).
+ * v32 holds four 32-bit lanes and is used for the column pass, which
+ * needs the full Int range of BlockDCT_AANwSub().
+ * ---------------------------------------------------------------------- */
+
+#if defined(M4VENC_NEON)
+
+typedef int16x8_t v16;
+typedef int32x4_t v32;
+
+static inline v16 add16(v16 a, v16 b) { return vaddq_s16(a, b); }
+static inline v16 sub16(v16 a, v16 b) { return vsubq_s16(a, b); }
+static inline v32 add32(v32 a, v32 b) { return vaddq_s32(a, b); }
+static inline v32 sub32(v32 a, v32 b) { return vsubq_s32(a, b); }
+static inline v32 set32(Int a) { return vdupq_n_s32(a); }
+static inline v32 mul32(v32 a, Int c) { return vmulq_n_s32(a, c); }
+static inline v32 sra32(v32 a) { return vshrq_n_s32(a, FDCT_SHIFT); }
+
+/* 2 * (cur[0..7] - pred[0..7]) */
+static inline v16 load_diff(const UChar *cur, const UChar *pred)
+{
+    v16 d = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(cur), vld1_u8(pred)));
+    return vaddq_s16(d, d);
+}
+
+/* (a * 724 + round) >> FDCT_SHIFT */
+static inline v16 mul724_16(v16 a)
+{
+    const int32x4_t round = vdupq_n_s32(1 << (FDCT_SHIFT - 1));
+    return vcombine_s16(vshrn_n_s32(vmlal_n_s16(round, vget_low_s16(a), 724), FDCT_SHIFT),
+                        vshrn_n_s32(vmlal_n_s16(round, vget_high_s16(a), 724), FDCT_SHIFT));
+}
+
+/* k4' = (k0 * 392 + k4 * 554 + round) >> FDCT_SHIFT,
+ * k6' = (k0 * 392 + k6 * 1338 + round) >> FDCT_SHIFT, with k0 = k4 - k6 */
+static inline void rotate16(v16 *k4, v16 *k6)
+{
+    const int32x4_t round = vdupq_n_s32(1 << (FDCT_SHIFT - 1));
+    v16 k0 = vsubq_s16(*k4, *k6);
+    int32x4_t lo = vmlal_n_s16(round, vget_low_s16(k0), 392);
+    int32x4_t hi = vmlal_n_s16(round, vget_high_s16(k0), 392);
+
+    *k4 = vcombine_s16(vshrn_n_s32(vmlal_n_s16(lo, vget_low_s16(*k4), 554), FDCT_SHIFT),
+                       vshrn_n_s32(vmlal_n_s16(hi, vget_high_s16(*k4), 554), FDCT_SHIFT));
+    *k6 = vcombine_s16(vshrn_n_s32(vmlal_n_s16(lo, vget_low_s16(*k6), 1338), FDCT_SHIFT),
+                       vshrn_n_s32(vmlal_n_s16(hi, vget_high_s16(*k6), 1338), FDCT_SHIFT));
+}
+
+static inline void transpose8x8(v16 r[8])
+{
+    int16x8x2_t t01 = vtrnq_s16(r[0], r[1]);
+    int16x8x2_t t23 = vtrnq_s16(r[2], r[3]);
+    int16x8x2_t t45 = vtrnq_s16(r[4], r[5]);
+    int16x8x2_t t67 = vtrnq_s16(r[6], r[7]);
+    int32x4x2_t u02 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[0]), vreinterpretq_s32_s16(t23.val[0]));
+    int32x4x2_t u13 = vtrnq_s32(vreinterpretq_s32_s16(t01.val[1]), vreinterpretq_s32_s16(t23.val[1]));
+    int32x4x2_t u46 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[0]), vreinterpretq_s32_s16(t67.val[0]));
+    int32x4x2_t u57 = vtrnq_s32(vreinterpretq_s32_s16(t45.val[1]), vreinterpretq_s32_s16(t67.val[1]));
+
+    r[0] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u02.val[0]), vget_low_s32(u46.val[0])));
+    r[4] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u02.val[0]), vget_high_s32(u46.val[0])));
+    r[2] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u02.val[1]), vget_low_s32(u46.val[1])));
+    r[6] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u02.val[1]), vget_high_s32(u46.val[1])));
+    r[1] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u13.val[0]), vget_low_s32(u57.val[0])));
+    r[5] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u13.val[0]), vget_high_s32(u57.val[0])));
+    r[3] = vreinterpretq_s16_s32(vcombine_s32(vget_low_s32(u13.val[1]), vget_low_s32(u57.val[1])));
+    r[7] = vreinterpretq_s16_s32(vcombine_s32(vget_high_s32(u13.val[1]), vget_high_s32(u57.val[1])));
+}
+
+static inline v32 widen_lo(v16 a) { return vmovl_s16(vget_low_s16(a)); }
+static inline v32 widen_hi(v16 a) { return vmovl_s16(vget_high_s16(a)); }
+
+/* keeps the low 16 bits of every lane, like a store to Short */
+static inline v16 narrow(v32 lo, v32 hi)
+{
+    return vcombine_s16(vmovn_s32(lo), vmovn_s32(hi));
+}
+
+/* sum_abs() from dct_inline.h, including its one's complement k0 term */
+static inline v32 sum_abs32(const v32 k[8])
+{
+    v32 sum = veorq_s32(k[0], vshrq_n_s32(k[0], 31));
+    for (Int i = 1; i < 8; i++)
+    {
+        sum = vaddq_s32(sum, vabsq_s32(k[i]));
+    }
+    return sum;
+}
+
+static inline v32 cmplt32(v32 a, v32 b)
+{
+    return vreinterpretq_s32_u32(vcltq_s32(a, b));
+}
+
+static inline v16 select16(v16 mask, v16 a, v16 b)
+{
+    return vbslq_s16(vreinterpretq_u16_s16(mask), a, b);
+}
+
+static inline v16 set16(Short a) { return vdupq_n_s16(a); }
+static inline v16 load16(const Short *p) { return vld1q_s16(p); }
+static inline void store16(Short *p, v16 a) { vst1q_s16(p, a); }
+
+#else /* M4VENC_SSSE3 */
+
+typedef __m128i v16;
+typedef __m128i v32;
+
+M4VENC_SIMD_TARGET static inline v16 add16(v16 a, v16 b) { return _mm_add_epi16(a, b); }
+M4VENC_SIMD_TARGET static inline v16 sub16(v16 a, v16 b) { return _mm_sub_epi16(a, b); }
+M4VENC_SIMD_TARGET static inline v32 add32(v32 a, v32 b) { return _mm_add_epi32(a, b); }
+M4VENC_SIMD_TARGET static inline v32 sub32(v32 a, v32 b) { return _mm_sub_epi32(a, b); }
+M4VENC_SIMD_TARGET static inline v32 set32(Int a) { return _mm_set1_epi32(a); }
+M4VENC_SIMD_TARGET static inline v32 sra32(v32 a) { return _mm_srai_epi32(a, FDCT_SHIFT); }
+
+/* low 32 bits of a * c, SSSE3 has no pmulld */
+M4VENC_SIMD_TARGET
+static inline v32 mul32(v32 a, Int c)
+{
+    const __m128i b = _mm_set1_epi32(c);
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), b);
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+M4VENC_SIMD_TARGET
+static inline v16 load_diff(const UChar *cur, const UChar *pred)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)cur), zero);
+    __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)pred), zero);
+    __m128i d = _mm_sub_epi16(c, p);
+    return _mm_add_epi16(d, d);
+}
+
+/* pmaddwd on (a, 1) pairs gives a * 724 + round in one step */
+M4VENC_SIMD_TARGET
+static inline v16 mul724_16(v16 a)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i coef = _mm_setr_epi16(724, 1 << (FDCT_SHIFT - 1), 724, 1 << (FDCT_SHIFT - 1),
+                                        724, 1 << (FDCT_SHIFT - 1), 724, 1 << (FDCT_SHIFT - 1));
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, one), coef);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, one), coef);
+    return _mm_packs_epi32(_mm_srai_epi32(lo, FDCT_SHIFT), _mm_srai_epi32(hi, FDCT_SHIFT));
+}
+
+M4VENC_SIMD_TARGET
+static inline void rotate16(v16 *k4, v16 *k6)
+{
+    const __m128i round = _mm_set1_epi32(1 << (FDCT_SHIFT - 1));
+    const __m128i c4 = _mm_setr_epi16(392, 554, 392, 554, 392, 554, 392, 554);
+    const __m128i c6 = _mm_setr_epi16(392, 1338, 392, 1338, 392, 1338, 392, 1338);
+    __m128i k0 = _mm_sub_epi16(*k4, *k6);
+    __m128i lo4 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(k0, *k4), c4), round);
+    __m128i hi4 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(k0, *k4), c4), round);
+    __m128i lo6 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(k0, *k6), c6), round);
+    __m128i hi6 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(k0, *k6), c6), round);
+
+    *k4 = _mm_packs_epi32(_mm_srai_epi32(lo4, FDCT_SHIFT), _mm_srai_epi32(hi4, FDCT_SHIFT));
+    *k6 = _mm_packs_epi32(_mm_srai_epi32(lo6, FDCT_SHIFT), _mm_srai_epi32(hi6, FDCT_SHIFT));
+}
+
+M4VENC_SIMD_TARGET
+static inline void transpose8x8(v16 r[8])
+{
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+M4VENC_SIMD_TARGET
+static inline v32 widen_lo(v16 a) { return _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16); }
+M4VENC_SIMD_TARGET
+static inline v32 widen_hi(v16 a) { return _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16); }
+
+M4VENC_SIMD_TARGET
+static inline v16 narrow(v32 lo, v32 hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    return _mm_packs_epi32(lo, hi);
+}
+
+M4VENC_SIMD_TARGET
+static inline v32 sum_abs32(const v32 k[8])
+{
+    v32 sum = _mm_xor_si128(k[0], _mm_srai_epi32(k[0], 31));
+    for (Int i = 1; i < 8; i++)
+    {
+        sum = _mm_add_epi32(sum, _mm_abs_epi32(k[i]));
+    }
+    return sum;
+}
+
+M4VENC_SIMD_TARGET
+static inline v32 cmplt32(v32 a, v32 b)
+{
+    return _mm_cmplt_epi32(a, b);
+}
+
+M4VENC_SIMD_TARGET
+static inline v16 select16(v16 mask, v16 a, v16 b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+M4VENC_SIMD_TARGET static inline v16 set16(Short a) { return _mm_set1_epi16(a); }
+M4VENC_SIMD_TARGET static inline v16 load16(const Short *p) { return _mm_loadu_si128((const __m128i*)p); }
+M4VENC_SIMD_TARGET static inline void store16(Short *p, v16 a) { _mm_storeu_si128((__m128i*)p, a); }
+
+#endif
+
+/* 16-bit lanes in the packed v32 masks are all ones or all zeros, so the
+ * truncating narrow() also packs the masks */
+#define narrow_mask(lo, hi) narrow(lo, hi)
+
+/* fdct_1 .. fdct_3 of BlockDCT_AANwSub() on eight rows at once. k[c] holds
+ * column c of the eight rows and is replaced by output coefficient c. */
+M4VENC_SIMD_TARGET
+static inline void fdct_rows(v16 k[8])
+{
+    v16 k0 = k[0], k1 = k[1], k2 = k[2], k3 = k[3];
+    v16 k4 = k[4], k5 = k[5], k6 = k[6], k7 = k[7];
+
+    /* fdct_1 */
+    k0 = add16(k0, k7);
+    k7 = sub16(k0, add16(k7, k7));
+    k1 = add16(k1, k6);
+    k6 = sub16(k1, add16(k6, k6));
+    k2 = add16(k2, k5);
+    k5 = sub16(k2, add16(k5, k5));
+    k3 = add16(k3, k4);
+    k4 = sub16(k3, add16(k4, k4));
+
+    k0 = add16(k0, k3);
+    k3 = sub16(k0, add16(k3, k3));
+    k1 = add16(k1, k2);
+    k2 = sub16(k1, add16(k2, k2));
+
+    k0 = add16(k0, k1);
+    k1 = sub16(k0, add16(k1, k1));
+    k[0] = k0;
+    k[4] = k1;
+    /* fdct_2 */
+    k4 = add16(k4, k5);
+    k5 = add16(k5, k6);
+    k6 = add16(k6, k7);
+    k2 = add16(k2, k3);
+    k5 = mul724_16(k5);
+    k2 = mul724_16(k2);
+    k2 = add16(k2, k3);
+    k3 = sub16(add16(k3, k3), k2);
+    k[2] = k2;
+    k[6] = add16(k3, k3);
+    /* fdct_3 */
+    rotate16(&k4, &k6);
+    k5 = add16(k5, k7);
+    k7 = sub16(add16(k7, k7), k5);
+    k4 = add16(k4, k7);
+    k7 = sub16(add16(k7, k7), k4);
+    k5 = add16(k5, k6);
+    k4 = add16(k4, k4);
+    k6 = sub16(k5, add16(k6, k6));
+    k6 = add16(k6, k6);
+    k[5] = k4;
+    k[1] = k5;
+    k[7] = add16(k6, k6);
+    k[3] = k7;
+}
+
+/* The vertical pass of BlockDCT_AANwSub() on four columns, k[r] holds row r. */
+M4VENC_SIMD_TARGET
+static inline void fdct_cols(v32 k[8])
+{
+    const v32 round = set32(1 << (FDCT_SHIFT - 1));
+    v32 k0 = k[0], k1 = k[1], k2 = k[2], k3 = k[3];
+    v32 k4 = k[4], k5 = k[5], k6 = k[6], k7 = k[7];
+
+    /* fdct_1 */
+    k0 = add32(k0, k7);
+    k7 = sub32(k0, add32(k7, k7));
+    k1 = add32(k1, k6);
+    k6 = sub32(k1, add32(k6, k6));
+    k2 = add32(k2, k5);
+    k5 = sub32(k2, add32(k5, k5));
+    k3 = add32(k3, k4);
+    k4 = sub32(k3, add32(k4, k4));
+
+    k0 = add32(k0, k3);
+    k3 = sub32(k0, add32(k3, k3));
+    k1 = add32(k1, k2);
+    k2 = sub32(k1, add32(k2, k2));
+
+    k0 = add32(k0, k1);
+    k1 = sub32(k0, add32(k1, k1));
+    k[4] = k1;
+    k[0] = k0;
+    /* fdct_2 */
+    k4 = add32(k4, k5);
+    k5 = add32(k5, k6);
+    k6 = add32(k6, k7);
+    k2 = add32(k2, k3);
+    k5 = sra32(add32(mul32(k5, 724), round));
+    k2 = sra32(add32(mul32(k2, 724), round));
+    k2 = add32(k2, k3);
+    k3 = sub32(add32(k3, k3), k2);
+    k[6] = add32(k3, k3);
+    k[2] = k2;
+    /* fdct_3 */
+    k0 = sub32(k4, k6);
+    k1 = add32(mul32(k0, 392), round);
+    k4 = sra32(add32(mul32(k4, 554), k1));
+    k6 = sra32(add32(mul32(k6, 1338), k1));
+    k5 = add32(k5, k7);
+    k7 = sub32(add32(k7, k7), k5);
+    k4 = add32(k4, k7);
+    k7 = sub32(add32(k7, k7), k4);
+    k5 = add32(k5, k6);
+    k4 = add32(k4, k4);
+    k6 = sub32(k5, add32(k6, k6));
+    k6 = add32(k6, k6);
+    k[3] = k7;
+    k[7] = add32(k6, k6);
+    k[1] = k5;
+    k[5] = k4;
+}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**************************************************************************/
+    /*  Function:   BlockDCT_AANwSub_SIMD
+        Input:      same as BlockDCT_AANwSub
+        Output:     out[64] ==> next block, bit-exact with BlockDCT_AANwSub
+        Purpose:    Row pass on 16-bit lanes between two transposes, column
+                    pass on 32-bit lanes. Columns below the ColTh deadzone
+                    keep the row pass result with 0x7fff in row 0.
+    **************************************************************************/
+    M4VENC_SIMD_TARGET
+    Void BlockDCT_AANwSub_SIMD(Short *out, UChar *cur, UChar *pred, Int width)
+    {
+        v16 k[8];
+        v32 lo[8], hi[8];
+        v32 colTh, skipLo, skipHi;
+        v16 skip;
+        Int i;
+
+        out += 64;
+        colTh = set32(out[0]);
+
+        for (i = 0; i < 8; i++)
+        {
+            k[i] = load_diff(cur, pred);
+            cur += width;
+            pred += 16;
+        }
+
+        transpose8x8(k);
+        fdct_rows(k);
+        transpose8x8(k);
+
+        for (i = 0; i < 8; i++)
+        {
+            lo[i] = widen_lo(k[i]);
+            hi[i] = widen_hi(k[i]);
+        }
+
+        skipLo = cmplt32(sum_abs32(lo), colTh);
+        skipHi = cmplt32(sum_abs32(hi), colTh);
+        skip = narrow_mask(skipLo, skipHi);
+
+        fdct_cols(lo);
+        fdct_cols(hi);
+
+        store16(out, select16(skip, set16(0x7fff), narrow(lo[0], hi[0])));
+        for (i = 1; i < 8; i++)
+        {
+            store16(out + 8 * i, select16(skip, k[i], narrow(lo[i], hi[i])));
+        }
+
+        return ;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* M4VENC_SIMD */
@@ -118,9 +118,9 @@ PV_STATUS CodeMB_H263(VideoEncData *video, approxDCT *function, Int QP, Int ncoe
         BlockDCT1x1 = &Block1x1DCTwSub;
         BlockDCT2x2 = &Block2x2DCT_AANwSub;
         BlockDCT4x4 = &Block4x4DCT_AANwSub;
-        BlockDCT8x8 = &BlockDCT_AANwSub;
+        BlockDCT8x8 = video->functionPointer->BlockDCT8x8wSub;
 
-        BlockQuantDequantH263 = &BlockQuantDequantH263Inter;
+        BlockQuantDequantH263 = video->functionPointer->BlockQuantDequantH263Inter;
         BlockQuantDequantH263DC = &BlockQuantDequantH263DCInter;
         ColTh = ColThInter[QP];
         DctTh1 = (Int)(16 * QP);  //9*QP;
@@ -341,7 +341,7 @@ PV_STATUS CodeMB_MPEG(VideoEncData *video, approxDCT *function, Int QP, Int ncoe
         BlockDCT1x1 = &Block1x1DCTwSub;
         BlockDCT2x2 = &Block2x2DCT_AANwSub;
         BlockDCT4x4 = &Block4x4DCT_AANwSub;
-        BlockDCT8x8 = &BlockDCT_AANwSub;
+        BlockDCT8x8 = video->functionPointer->BlockDCT8x8wSub;
 
         BlockQuantDequantMPEG = &BlockQuantDequantMPEGInter;
         BlockQuantDequantMPEGDC = &BlockQuantDequantMPEGDCInter;
@@ -17,6 +17,7 @@
  */
 #include "mp4enc_lib.h"
 #include "fastquant_inline.h"
+#include "m4venc_simd.h"
 
 #define siz 63
 #define LSL 18
@@ -266,6 +267,188 @@ NONZERO1:
         return 0;
 }
 
+#ifdef M4VENC_SIMD
+/********************************************************************
+ *  Function:   BlockQuantDequantH263Inter_SIMD
+ *  Purpose:    Same output as BlockQuantDequantH263Inter, one row of
+ *              eight coefficients per step. The whole dctMode x dctMode
+ *              region is quantized without the QPx2plus deadzone test;
+ *              coefficients inside the deadzone always quantize to zero,
+ *              so only the non-zero results are scattered to qcoeff,
+ *              rcoeff and the bitmaps, as the scalar code does.
+ ********************************************************************/
+M4VENC_SIMD_TARGET
+Int BlockQuantDequantH263Inter_SIMD(Short *rcoeff, Short *qcoeff, struct QPstruct *QuantParam,
+                                    UChar bitmapcol[ ], UChar *bitmaprow, UInt *bitmapzz,
+                                    Int dctMode, Int comp, Int dummy, UChar shortHeader)
+{
+    Int i, r, c, zz;
+    Int tmp;
+    Int QPdiv2 = QuantParam->QPdiv2;
+    Int QPx2 = QuantParam->QPx2;
+    Int Addition = QuantParam->Addition;
+    Int q_scale = scaleArrayV[QuantParam->QP];
+    Int shift = 15 + (QPx2 >> 4);
+    Int *temp;
+    Int ac_clip;    /* quantized coeff bound */
+    UInt bits;
+    Short qv[8], dv[8];
+    Short valid[8];
+
+    OSCL_UNUSED_ARG(comp);
+    OSCL_UNUSED_ARG(dummy);
+
+    if (shortHeader) ac_clip = 126; /* clip between [-127,126] (standard allows 127!) */
+    else ac_clip = 2047;  /* clip between [-2048,2047] */
+
+    /* reset all bitmap to zero */
+    temp = (Int*) bitmapcol;
+    temp[0] = temp[1] = 0;
+    bitmapzz[0] = bitmapzz[1] = 0;
+    *bitmaprow = 0;
+
+    rcoeff += 64; /* actual data is 64 item ahead */
+
+    /* columns outside dctMode or marked all zero by the FDCT are skipped */
+    for (c = 0; c < 8; c++)
+    {
+        valid[c] = (c < dctMode && rcoeff[c] != 0x7fff) ? -1 : 0;
+    }
+
+#if defined(M4VENC_NEON)
+    static const uint16_t kLaneBit[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint16x8_t laneBit = vld1q_u16(kLaneBit);
+    const uint16x8_t vvalid = vreinterpretq_u16_s16(vld1q_s16(valid));
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int32x4_t round = vdupq_n_s32(1 << 15);
+    const int32x4_t qpdiv2 = vdupq_n_s32(QPdiv2);
+    const int32x4_t nshift = vdupq_n_s32(-shift);
+    const int16x8_t clipHi = vdupq_n_s16(ac_clip);
+    const int16x8_t clipLo = vdupq_n_s16(-ac_clip - 1);
+    const int16x8_t dqHi = vdupq_n_s16(2047);
+    const int16x8_t dqLo = vdupq_n_s16(-2048);
+#else
+    const __m128i vvalid = _mm_loadu_si128((const __m128i*)valid);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+    const __m128i half = _mm_set1_epi16(1 << 14);   /* 2 * (1 << 14) is the round */
+    const __m128i qpdiv2 = _mm_set1_epi32(QPdiv2);
+    const __m128i qscale = _mm_set1_epi32(q_scale); /* (q_scale, 0) pairs */
+    const __m128i vshift = _mm_cvtsi32_si128(shift);
+    const __m128i dqmul = _mm_setr_epi16(QPx2, Addition, QPx2, Addition,
+                                         QPx2, Addition, QPx2, Addition);
+    const __m128i clipHi = _mm_set1_epi16(ac_clip);
+    const __m128i clipLo = _mm_set1_epi16(-ac_clip - 1);
+    const __m128i dqHi = _mm_set1_epi16(2047);
+    const __m128i dqLo = _mm_set1_epi16(-2048);
+#endif
+
+    for (r = 0; r < dctMode; r++)
+    {
+#if defined(M4VENC_NEON)
+        int16x8_t coeff = vld1q_s16(rcoeff + (r << 3));
+        int16x8_t aan = vld1q_s16(AANScale + (r << 3));
+        int32x4_t lo, hi, sgn;
+        int16x8_t q, qsgn, dq;
+        uint16x8_t nz;
+        uint64x2_t sum;
+
+        /* aan_scale() */
+        lo = vshrq_n_s32(vmlal_s16(round, vget_low_s16(coeff), vget_low_s16(aan)), 16);
+        hi = vshrq_n_s32(vmlal_s16(round, vget_high_s16(coeff), vget_high_s16(aan)), 16);
+        sgn = vshrq_n_s32(lo, 31);
+        lo = vsubq_s32(lo, vsubq_s32(veorq_s32(qpdiv2, sgn), sgn));
+        sgn = vshrq_n_s32(hi, 31);
+        hi = vsubq_s32(hi, vsubq_s32(veorq_s32(qpdiv2, sgn), sgn));
+        /* coeff_quant() */
+        lo = vshlq_s32(vmulq_n_s32(lo, q_scale), nshift);
+        hi = vshlq_s32(vmulq_n_s32(hi, q_scale), nshift);
+        lo = vsubq_s32(lo, vshrq_n_s32(lo, 31));
+        hi = vsubq_s32(hi, vshrq_n_s32(hi, 31));
+        /* coeff_clip() */
+        q = vcombine_s16(vmovn_s32(lo), vmovn_s32(hi));
+        q = vminq_s16(vmaxq_s16(q, clipLo), clipHi);
+        /* coeff_dequant() */
+        qsgn = vsubq_s16(vreinterpretq_s16_u16(vcltq_s16(q, zero)),
+                         vreinterpretq_s16_u16(vcgtq_s16(q, zero)));
+        lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(q), QPx2), vget_low_s16(qsgn), Addition);
+        hi = vmlal_n_s16(vmull_n_s16(vget_high_s16(q), QPx2), vget_high_s16(qsgn), Addition);
+        dq = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+        dq = vminq_s16(vmaxq_s16(dq, dqLo), dqHi);
+
+        nz = vbicq_u16(vvalid, vceqq_s16(q, zero));
+        sum = vpaddlq_u32(vpaddlq_u16(vandq_u16(nz, laneBit)));
+        bits = (UInt)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+        vst1q_s16(qv, q);
+        vst1q_s16(dv, dq);
+#else
+        __m128i coeff = _mm_loadu_si128((const __m128i*)(rcoeff + (r << 3)));
+        __m128i aan = _mm_loadu_si128((const __m128i*)(AANScale + (r << 3)));
+        __m128i lo, hi, sgn, q, qsgn, dq, nz;
+
+        /* aan_scale(), pmaddwd on (coeff, 2) x (scale, 1 << 14) */
+        lo = _mm_madd_epi16(_mm_unpacklo_epi16(coeff, two), _mm_unpacklo_epi16(aan, half));
+        hi = _mm_madd_epi16(_mm_unpackhi_epi16(coeff, two), _mm_unpackhi_epi16(aan, half));
+        lo = _mm_srai_epi32(lo, 16);
+        hi = _mm_srai_epi32(hi, 16);
+        sgn = _mm_srai_epi32(lo, 31);
+        lo = _mm_sub_epi32(lo, _mm_sub_epi32(_mm_xor_si128(qpdiv2, sgn), sgn));
+        sgn = _mm_srai_epi32(hi, 31);
+        hi = _mm_sub_epi32(hi, _mm_sub_epi32(_mm_xor_si128(qpdiv2, sgn), sgn));
+        /* coeff_quant(), the scaled coefficient fits in 16 bits */
+        q = _mm_packs_epi32(lo, hi);
+        lo = _mm_sra_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(q, zero), qscale), vshift);
+        hi = _mm_sra_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(q, zero), qscale), vshift);
+        lo = _mm_sub_epi32(lo, _mm_srai_epi32(lo, 31));
+        hi = _mm_sub_epi32(hi, _mm_srai_epi32(hi, 31));
+        /* coeff_clip() */
+        q = _mm_packs_epi32(lo, hi);
+        q = _mm_min_epi16(_mm_max_epi16(q, clipLo), clipHi);
+        /* coeff_dequant(), pmaddwd on (q, sign(q)) x (QPx2, Addition) */
+        qsgn = _mm_sign_epi16(one, q);
+        lo = _mm_madd_epi16(_mm_unpacklo_epi16(q, qsgn), dqmul);
+        hi = _mm_madd_epi16(_mm_unpackhi_epi16(q, qsgn), dqmul);
+        dq = _mm_packs_epi32(lo, hi);
+        dq = _mm_min_epi16(_mm_max_epi16(dq, dqLo), dqHi);
+
+        nz = _mm_andnot_si128(_mm_cmpeq_epi16(q, zero), vvalid);
+        bits = _mm_movemask_epi8(_mm_packs_epi16(nz, zero));
+        _mm_storeu_si128((__m128i*)qv, q);
+        _mm_storeu_si128((__m128i*)dv, dq);
+#endif
+
+        while (bits)
+        {
+            c = __builtin_ctz(bits);
+            bits &= bits - 1;
+            i = (r << 3) + c;
+            zz = ZZTab[i] >> 1;
+
+            qcoeff[zz] = qv[c];
+            rcoeff[i-64] = dv[c];
+
+            bitmapcol[c] |= imask[r];
+            if (zz > 31) bitmapzz[1] |= (1 << (63 - zz));
+            else        bitmapzz[0] |= (1 << (31 - zz));
+        }
+    }
+
+    i = dctMode;
+    tmp = 1 << (8 - i);
+    while (i--)
+    {
+        if (bitmapcol[i])(*bitmaprow) |= tmp;
+        tmp <<= 1;
+    }
+
+    if (*bitmaprow)
+        return 1;
+    else
+        return 0;
+}
+#endif /* M4VENC_SIMD */
+
 Int BlockQuantDequantH263Intra(Short *rcoeff, Short *qcoeff, struct QPstruct *QuantParam,
                                UChar bitmapcol[ ], UChar *bitmaprow, UInt *bitmapzz,
                                Int dctMode, Int comp, Int dc_scaler, UChar shortHeader)
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _M4VENC_SIMD_H_
+#define _M4VENC_SIMD_H_
+
+/*
+ * Vector kernels for the hot paths of the encoder: 16x16 SAD (full-pel and
+ * HTFM half-pel), the 8x8 AAN forward DCT with subtraction and the H.263
+ * inter quantizer. Every kernel is bit-exact with its _C counterpart, so
+ * picking one or the other never changes the bitstream.
+ *
+ * NEON is part of the arm64 ABI and is selected at compile time there (and
+ * on 32-bit ARM builds that enable it). On x86 the kernels are built for
+ * SSSE3 with a function target attribute and only installed when the CPU
+ * reports it, see M4VEnc_HasSIMD().
+ */
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define M4VENC_NEON (true)
+#include <arm_neon.h>
+#define M4VENC_SIMD_TARGET
+#elif (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#define M4VENC_SSSE3 (true)
+#include <tmmintrin.h>
+#define M4VENC_SIMD_TARGET __attribute__((target("ssse3")))
+#endif
+
+#if defined(M4VENC_NEON) || defined(M4VENC_SSSE3)
+#define M4VENC_SIMD (true)
+#endif
+
+#include "mp4lib_int.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Returns true when the kernels below may be called on this CPU. */
+    Bool M4VEnc_HasSIMD(void);
+
+#ifdef M4VENC_SIMD
+    /* defined in sad_simd.cpp */
+    Int SAD_Macroblock_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int SAD_MB_HTFM_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int SAD_MB_HP_HTFMxh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HP_HTFMyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+    Int SAD_MB_HP_HTFMxhyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info);
+
+    /* defined in dct_simd.cpp */
+    Void BlockDCT_AANwSub_SIMD(Short *out, UChar *cur, UChar *pred, Int width);
+
+    /* defined in fastquant.cpp */
+    Int BlockQuantDequantH263Inter_SIMD(Short *rcoeff, Short *qcoeff, struct QPstruct *QuantParam,
+                                        UChar bitmapcol[ ], UChar *bitmaprow, UInt *bitmapzz,
+                                        Int dctMode, Int comp, Int dummy, UChar shortHeader);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _M4VENC_SIMD_H_ */
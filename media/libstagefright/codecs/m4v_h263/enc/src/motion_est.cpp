@@ -569,11 +569,11 @@ void InitHTFM(VideoEncData *video, HTFM_Stat *htfm_stat, double *newvar, Int *co
     else
     {
 //      video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING_HTFM;
-        video->functionPointer->SAD_Macroblock = &SAD_MB_HTFM;
+        video->functionPointer->SAD_Macroblock = video->functionPointer->SAD_MB_HTFM;
         video->functionPointer->SAD_MB_HalfPel[0] = NULL;
-        video->functionPointer->SAD_MB_HalfPel[1] = &SAD_MB_HP_HTFMxh;
-        video->functionPointer->SAD_MB_HalfPel[2] = &SAD_MB_HP_HTFMyh;
-        video->functionPointer->SAD_MB_HalfPel[3] = &SAD_MB_HP_HTFMxhyh;
+        video->functionPointer->SAD_MB_HalfPel[1] = video->functionPointer->SAD_MB_HP_HTFM[1];
+        video->functionPointer->SAD_MB_HalfPel[2] = video->functionPointer->SAD_MB_HP_HTFM[2];
+        video->functionPointer->SAD_MB_HalfPel[3] = video->functionPointer->SAD_MB_HP_HTFM[3];
         video->sad_extra_info = (void*)(video->nrmlz_th);
         offset = video->nrmlz_th + 16;
         offset2 = video->nrmlz_th + 32;
@@ -20,6 +20,8 @@
 #include "bitstream_io.h"
 #include "rate_control.h"
 #include "m4venc_oscl.h"
+#include "dct.h"
+#include "m4venc_simd.h"
 
 #ifndef INT32_MAX
 #define INT32_MAX 0x7fffffff
@@ -1088,6 +1090,31 @@ OSCL_EXPORT_REF Bool    PVInitVideoEncoder(VideoEncControls *encoderControl, Vid
     video->functionPointer->ChooseMode = &ChooseMode_C;
     video->functionPointer->GetHalfPelMBRegion = &GetHalfPelMBRegion_C;
 //  video->functionPointer->SAD_MB_PADDING = &SAD_MB_PADDING; /* 4/21/01 */
+#ifdef HTFM
+    video->functionPointer->SAD_MB_HTFM = &SAD_MB_HTFM;
+    video->functionPointer->SAD_MB_HP_HTFM[0] = NULL;
+    video->functionPointer->SAD_MB_HP_HTFM[1] = &SAD_MB_HP_HTFMxh;
+    video->functionPointer->SAD_MB_HP_HTFM[2] = &SAD_MB_HP_HTFMyh;
+    video->functionPointer->SAD_MB_HP_HTFM[3] = &SAD_MB_HP_HTFMxhyh;
+#endif
+    video->functionPointer->BlockDCT8x8wSub = &BlockDCT_AANwSub;
+    video->functionPointer->BlockQuantDequantH263Inter = &BlockQuantDequantH263Inter;
+
+#ifdef M4VENC_SIMD
+    /* bit-exact vector kernels, see m4venc_simd.h */
+    if (M4VEnc_HasSIMD())
+    {
+        video->functionPointer->SAD_Macroblock = &SAD_Macroblock_SIMD;
+#ifdef HTFM
+        video->functionPointer->SAD_MB_HTFM = &SAD_MB_HTFM_SIMD;
+        video->functionPointer->SAD_MB_HP_HTFM[1] = &SAD_MB_HP_HTFMxh_SIMD;
+        video->functionPointer->SAD_MB_HP_HTFM[2] = &SAD_MB_HP_HTFMyh_SIMD;
+        video->functionPointer->SAD_MB_HP_HTFM[3] = &SAD_MB_HP_HTFMxhyh_SIMD;
+#endif
+        video->functionPointer->BlockDCT8x8wSub = &BlockDCT_AANwSub_SIMD;
+        video->functionPointer->BlockQuantDequantH263Inter = &BlockQuantDequantH263Inter_SIMD;
+    }
+#endif
 
 
     encoderControl->videoEncoderInit = 1;  /* init done! */
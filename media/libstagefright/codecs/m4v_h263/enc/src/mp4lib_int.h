@@ -231,6 +231,8 @@ typedef struct tagVideoEncParams
 
 } VideoEncParams;
 
+struct QPstruct;
+
 /* platform dependent functions */
 typedef struct tagFuncPtr
 {
@@ -244,7 +246,13 @@ typedef struct tagFuncPtr
     void (*ChooseMode)(UChar *Mode, UChar *cur, Int lx, Int min_SAD);
     void (*GetHalfPelMBRegion)(UChar *cand, UChar *hmem, Int lx);
     void (*blockIdct)(Int *block);
-
+    /* HTFM kernels installed by InitHTFM() outside of the collecting frames */
+    Int(*SAD_MB_HTFM)(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info);
+    Int(*SAD_MB_HP_HTFM[4])(UChar*, UChar*, Int, void *);
+    Void(*BlockDCT8x8wSub)(Short *out, UChar *cur, UChar *pred, Int width);
+    Int(*BlockQuantDequantH263Inter)(Short *rcoeff, Short *qcoeff, struct QPstruct *QuantParam,
+                                     UChar bitmapcol[ ], UChar *bitmaprow, UInt *bitmapzz,
+                                     Int dctMode, Int comp, Int dummy, UChar shortHeader);
 
 } FuncPtr;
 
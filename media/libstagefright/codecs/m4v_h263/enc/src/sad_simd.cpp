@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "m4venc_simd.h"
+
+#ifdef M4VENC_SIMD
+
+/* ----------------------------------------------------------------------
+ * 16-byte helpers shared by the kernels below. The HTFM kernels work on
+ * "stages" of 16 pixels: 4 lines of the uniform 4:1 subsampling pattern
+ * (columns 0, 4, 8, 12), which matches 16 consecutive bytes of the
+ * reordered current MB prepared by HTFMPrepareCurMB().
+ * ---------------------------------------------------------------------- */
+
+#if defined(M4VENC_NEON)
+
+typedef uint8x16_t vec_u8;
+
+static inline vec_u8 load_u8(const UChar *p)
+{
+    return vld1q_u8(p);
+}
+
+static inline Int sad_u8(vec_u8 a, vec_u8 b)
+{
+    uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vabdq_u8(a, b))));
+    return (Int)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+}
+
+/* (a + b + 1) >> 1 */
+static inline vec_u8 avg2_u8(vec_u8 a, vec_u8 b)
+{
+    return vrhaddq_u8(a, b);
+}
+
+/* (a + b + c + d + 2) >> 2 */
+static inline vec_u8 avg4_u8(vec_u8 a, vec_u8 b, vec_u8 c, vec_u8 d)
+{
+    uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+                              vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+    uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+                              vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+    return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+}
+
+/* Gather p[0], p[4], p[8], p[12] of 4 lines spaced lx4 apart. Only bytes
+ * p[0..12] of each line are read. */
+static inline vec_u8 gather_stage(const UChar *p, Int lx4)
+{
+    static const uint8_t kIdx0[8] = {0, 4, 11, 15, 255, 255, 255, 255};
+    static const uint8_t kIdx1[8] = {255, 255, 255, 255, 0, 4, 11, 15};
+    const uint8x8_t idx0 = vld1_u8(kIdx0);
+    const uint8x8_t idx1 = vld1_u8(kIdx1);
+    uint8x8x2_t l0, l1, l2, l3;
+
+    l0.val[0] = vld1_u8(p);
+    l0.val[1] = vld1_u8(p + 5);
+    p += lx4;
+    l1.val[0] = vld1_u8(p);
+    l1.val[1] = vld1_u8(p + 5);
+    p += lx4;
+    l2.val[0] = vld1_u8(p);
+    l2.val[1] = vld1_u8(p + 5);
+    p += lx4;
+    l3.val[0] = vld1_u8(p);
+    l3.val[1] = vld1_u8(p + 5);
+
+    return vcombine_u8(vorr_u8(vtbl2_u8(l0, idx0), vtbl2_u8(l1, idx1)),
+                       vorr_u8(vtbl2_u8(l2, idx0), vtbl2_u8(l3, idx1)));
+}
+
+#else /* M4VENC_SSSE3 */
+
+typedef __m128i vec_u8;
+
+M4VENC_SIMD_TARGET
+static inline vec_u8 load_u8(const UChar *p)
+{
+    return _mm_loadu_si128((const __m128i*)p);
+}
+
+M4VENC_SIMD_TARGET
+static inline Int sad_u8(vec_u8 a, vec_u8 b)
+{
+    __m128i s = _mm_sad_epu8(a, b);
+    return _mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+}
+
+M4VENC_SIMD_TARGET
+static inline vec_u8 avg2_u8(vec_u8 a, vec_u8 b)
+{
+    return _mm_avg_epu8(a, b);
+}
+
+M4VENC_SIMD_TARGET
+static inline vec_u8 avg4_u8(vec_u8 a, vec_u8 b, vec_u8 c, vec_u8 d)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                               _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+    __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                               _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+    return _mm_packus_epi16(lo, hi);
+}
+
+M4VENC_SIMD_TARGET
+static inline __m128i load_line(const UChar *p)
+{
+    return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p),
+                              _mm_loadl_epi64((const __m128i*)(p + 5)));
+}
+
+M4VENC_SIMD_TARGET
+static inline vec_u8 gather_stage(const UChar *p, Int lx4)
+{
+    const __m128i idx0 = _mm_setr_epi8(0, 4, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i idx1 = _mm_setr_epi8(-1, -1, -1, -1, 0, 4, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i idx2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 11, 15, -1, -1, -1, -1);
+    const __m128i idx3 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 11, 15);
+    __m128i r0 = _mm_shuffle_epi8(load_line(p), idx0);
+    __m128i r1 = _mm_shuffle_epi8(load_line(p + lx4), idx1);
+    __m128i r2 = _mm_shuffle_epi8(load_line(p + 2 * lx4), idx2);
+    __m128i r3 = _mm_shuffle_epi8(load_line(p + 3 * lx4), idx3);
+
+    return _mm_or_si128(_mm_or_si128(r0, r1), _mm_or_si128(r2, r3));
+}
+
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    Bool M4VEnc_HasSIMD(void)
+    {
+#if defined(M4VENC_SSSE3)
+        return __builtin_cpu_supports("ssse3") ? true : false;
+#else
+        return true;
+#endif
+    }
+
+    /*==================================================================
+        Function:   SAD_Macroblock_SIMD
+        Purpose:    Same as SAD_Macroblock_C, 16 pixels per row at once.
+                    Stops as soon as a row pushes the SAD above dmin and
+                    returns the partial sum, like simd_sad_mb().
+      ==================================================================*/
+    M4VENC_SIMD_TARGET
+    Int SAD_Macroblock_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        Int sad = 0;
+        Int dmin = (ULong)dmin_lx >> 16;
+        Int lx = dmin_lx & 0xFFFF;
+        Int i;
+
+        OSCL_UNUSED_ARG(extra_info);
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += sad_u8(load_u8(ref), load_u8(blk));
+            if (sad > dmin)
+            {
+                break;
+            }
+            ref += lx;
+            blk += 16;
+        }
+
+        return sad;
+    }
+
+#ifdef HTFM
+    /*==================================================================
+        Function:   SAD_MB_HTFM_SIMD, SAD_MB_HP_HTFMxh/yh/xhyh_SIMD
+        Purpose:    Same as SAD_MB_HTFM and SAD_MB_HP_HTFMxx, one HTFM
+                    stage (16 subsampled pixels) per iteration with the
+                    same hypothesis test after every stage.
+      ==================================================================*/
+    M4VENC_SIMD_TARGET
+    Int SAD_MB_HTFM_SIMD(UChar *ref, UChar *blk, Int dmin_lx, void *extra_info)
+    {
+        Int sad = 0;
+        Int i;
+        Int lx4 = (dmin_lx << 2) & 0x3FFFC;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = (Int*) extra_info + 32;
+
+        madstar = (ULong)dmin_lx >> 20;
+
+        for (i = 0; i < 16; i++)
+        {
+            sad += sad_u8(gather_stage(ref + offsetRef[i], lx4), load_u8(blk));
+            blk += 16;
+
+            sadstar += madstar;
+            if (((ULong)sad <= ((ULong)dmin_lx >> 16)) && (sad <= (sadstar - *nrmlz_th++)))
+                ;
+            else
+                return 65536;
+        }
+
+        return sad;
+    }
+
+    M4VENC_SIMD_TARGET
+    Int SAD_MB_HP_HTFMxh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        UChar *p1;
+        Int rx = dmin_rx & 0xFFFF;
+        Int refwx4 = rx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = nrmlz_th + 32;
+
+        madstar = (ULong)dmin_rx >> 20;
+
+        for (i = 0; i < 16; i++)
+        {
+            p1 = ref + offsetRef[i];
+            sad += sad_u8(avg2_u8(gather_stage(p1, refwx4), gather_stage(p1 + 1, refwx4)),
+                          load_u8(blk));
+            blk += 16;
+
+            sadstar += madstar;
+            if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+            {
+                return 65536;
+            }
+        }
+
+        return sad;
+    }
+
+    M4VENC_SIMD_TARGET
+    Int SAD_MB_HP_HTFMyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        UChar *p1;
+        Int rx = dmin_rx & 0xFFFF;
+        Int refwx4 = rx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = nrmlz_th + 32;
+
+        madstar = (ULong)dmin_rx >> 20;
+
+        for (i = 0; i < 16; i++)
+        {
+            p1 = ref + offsetRef[i];
+            sad += sad_u8(avg2_u8(gather_stage(p1, refwx4), gather_stage(p1 + rx, refwx4)),
+                          load_u8(blk));
+            blk += 16;
+
+            sadstar += madstar;
+            if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+            {
+                return 65536;
+            }
+        }
+
+        return sad;
+    }
+
+    M4VENC_SIMD_TARGET
+    Int SAD_MB_HP_HTFMxhyh_SIMD(UChar *ref, UChar *blk, Int dmin_rx, void *extra_info)
+    {
+        Int i;
+        Int sad = 0;
+        UChar *p1, *p2;
+        Int rx = dmin_rx & 0xFFFF;
+        Int refwx4 = rx << 2;
+        Int sadstar = 0, madstar;
+        Int *nrmlz_th = (Int*) extra_info;
+        Int *offsetRef = nrmlz_th + 32;
+
+        madstar = (ULong)dmin_rx >> 20;
+
+        for (i = 0; i < 16; i++)
+        {
+            p1 = ref + offsetRef[i];
+            p2 = p1 + rx;
+            sad += sad_u8(avg4_u8(gather_stage(p1, refwx4), gather_stage(p1 + 1, refwx4),
+                                  gather_stage(p2, refwx4), gather_stage(p2 + 1, refwx4)),
+                          load_u8(blk));
+            blk += 16;
+
+            sadstar += madstar;
+            if (sad > sadstar - nrmlz_th[i] || sad > (Int)((ULong)dmin_rx >> 16))
+            {
+                return 65536;
+            }
+        }
+
+        return sad;
+    }
+#endif /* HTFM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#else /* M4VENC_SIMD */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    Bool M4VEnc_HasSIMD(void)
+    {
+        return false;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* M4VENC_SIMD */
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Encode speed of the MPEG-4 / H.263 software encoder in frames per second.
+// The input is synthetic: a noisy texture panning at a half-pel velocity
+// with a moving bright object, so that motion estimation, half-pel
+// refinement and residual coding all see realistic work.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "mp4enc_api.h"
+
+static constexpr int32_t kNumFrames = 16;
+// Core profile level 2 admits 23760 macroblocks per second. Larger frames
+// are configured with a proportionally lower nominal frame rate, which only
+// affects rate control, not how fast frames are fed to the encoder.
+static constexpr int32_t kMaxMbsPerSec = 23760;
+static constexpr int32_t kMaxFrameRate = 30;
+// Large enough for any frame of the noisy 720p input, so the encoder never
+// has to spill into its overrun buffer.
+static constexpr int32_t kOutputBufferSize = 2 * 1024 * 1024;
+static constexpr int32_t kMaxBitrate = 2000000;
+
+static void generateFrames(int32_t width, int32_t height, std::vector<uint8_t> *frames) {
+    const int32_t frameSize = width * height * 3 / 2;
+    const int32_t texWidth = width + 64;
+    const int32_t texHeight = height + 64;
+    std::vector<uint8_t> texture(texWidth * texHeight);
+    uint32_t seed = 1;
+    for (int32_t y = 0; y < texHeight; ++y) {
+        for (int32_t x = 0; x < texWidth; ++x) {
+            seed = seed * 1103515245 + 12345;
+            texture[y * texWidth + x] =
+                    (uint8_t)(((x * 7) ^ (y * 5)) + (x >> 3) * (y >> 4) + ((seed >> 16) & 31));
+        }
+    }
+
+    frames->resize((size_t)frameSize * kNumFrames);
+    for (int32_t t = 0; t < kNumFrames; ++t) {
+        uint8_t *yChan = frames->data() + (size_t)frameSize * t;
+        // pan right by 1.5 and down by 1 pixel per frame
+        const int32_t dx = (t * 3) >> 1;
+        const bool halfPel = (t & 1) != 0;
+        const int32_t objX = width / 4 + t * 4;
+        const int32_t objY = height / 3;
+        for (int32_t y = 0; y < height; ++y) {
+            const uint8_t *row = texture.data() + ((y + t) % texHeight) * texWidth;
+            for (int32_t x = 0; x < width; ++x) {
+                const int32_t x0 = (x + dx) % texWidth;
+                const int32_t x1 = (x0 + 1) % texWidth;
+                int32_t v = halfPel ? (row[x0] + row[x1] + 1) >> 1 : row[x0];
+                if (x >= objX && x < objX + 48 && y >= objY && y < objY + 32) {
+                    v = (v + 3 * 235) >> 2;
+                }
+                yChan[y * width + x] = (uint8_t)v;
+            }
+        }
+        uint8_t *uChan = yChan + width * height;
+        for (int32_t i = 0; i < width * height / 2; ++i) {
+            uChan[i] = (uint8_t)(128 + ((i / width + t) & 15));
+        }
+    }
+}
+
+// range(0): width, range(1): height, range(2): 1 for H.263 baseline
+static void BM_Encode(benchmark::State &state) {
+    const int32_t width = state.range(0);
+    const int32_t height = state.range(1);
+    const bool h263 = state.range(2) != 0;
+    const int32_t frameSize = width * height * 3 / 2;
+    const int32_t frameRate = std::min(kMaxFrameRate, kMaxMbsPerSec / (width * height / 256));
+
+    std::vector<uint8_t> frames;
+    generateFrames(width, height, &frames);
+    std::vector<uint8_t> output(kOutputBufferSize);
+
+    tagvideoEncOptions encParams;
+    memset(&encParams, 0, sizeof(encParams));
+    if (!PVGetDefaultEncOption(&encParams, 0)) {
+        state.SkipWithError("PVGetDefaultEncOption failed");
+        return;
+    }
+    // Same configuration as the codec components, without frame skipping.
+    encParams.encMode = h263 ? H263_MODE : COMBINE_MODE_WITH_ERR_RES;
+    encParams.encWidth[0] = width;
+    encParams.encHeight[0] = height;
+    encParams.encFrameRate[0] = frameRate;
+    encParams.rcType = VBR_1;
+    encParams.vbvDelay = 5.0f;
+    encParams.profile_level = CORE_PROFILE_LEVEL2;
+    encParams.packetSize = 32;
+    encParams.rvlcEnable = PV_OFF;
+    encParams.numLayers = 1;
+    encParams.timeIncRes = 1000;
+    encParams.tickPerSrc = encParams.timeIncRes / frameRate;
+    encParams.bitRate[0] = std::min(width * height * 4, kMaxBitrate);
+    encParams.iQuant[0] = 15;
+    encParams.pQuant[0] = 12;
+    encParams.quantType[0] = 0;
+    encParams.noFrameSkipped = PV_ON;
+    encParams.intraPeriod = frameRate;
+    encParams.numIntraMB = 0;
+    encParams.sceneDetect = PV_ON;
+    encParams.searchRange = 16;
+    encParams.mv8x8Enable = PV_OFF;
+    encParams.gobHeaderInterval = 0;
+    encParams.useACPred = PV_ON;
+    encParams.intraDCVlcTh = 0;
+
+    tagvideoEncControls handle;
+    memset(&handle, 0, sizeof(handle));
+    if (!PVInitVideoEncoder(&handle, &encParams)) {
+        state.SkipWithError("PVInitVideoEncoder failed");
+        return;
+    }
+
+    int32_t headerLength = kOutputBufferSize;
+    PVGetVolHeader(&handle, output.data(), &headerLength, 0);
+
+    int64_t numFrames = 0;
+    int64_t numBytes = 0;
+    for (auto _ : state) {
+        VideoEncFrameIO vin, vout;
+        memset(&vin, 0, sizeof(vin));
+        memset(&vout, 0, sizeof(vout));
+        vin.height = height;
+        vin.pitch = width;
+        vin.timestamp = (uint32_t)(numFrames * 1000 / frameRate);
+        vin.yChan = frames.data() + (size_t)frameSize * (numFrames % kNumFrames);
+        vin.uChan = vin.yChan + width * height;
+        vin.vChan = vin.uChan + width * height / 4;
+
+        uint32_t modTimeMs = 0;
+        int32_t nLayer = 0;
+        int32_t dataLength = kOutputBufferSize;
+        if (!PVEncodeVideoFrame(&handle, &vin, &vout, &modTimeMs,
+                output.data(), &dataLength, &nLayer)) {
+            state.SkipWithError("PVEncodeVideoFrame failed");
+            break;
+        }
+        PVGetOverrunBuffer(&handle);
+        numBytes += dataLength;
+        ++numFrames;
+    }
+    state.counters["fps"] = benchmark::Counter(numFrames, benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(numBytes);
+
+    PVCleanUpVideoEncoder(&handle);
+}
+
+BENCHMARK(BM_Encode)
+        ->ArgNames({"width", "height", "h263"})
+        ->Args({352, 288, 0})   // CIF
+        ->Args({352, 288, 1})
+        ->Args({640, 480, 0})   // VGA
+        ->Args({1280, 720, 0})  // 720p
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
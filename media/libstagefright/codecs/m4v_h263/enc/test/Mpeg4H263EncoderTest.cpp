@@ -21,8 +21,13 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 
+// mp4enc_lib.h comes first: mp4def.h has to define the library types before mp4enc_api.h does.
+#include "mp4enc_lib.h"
+#include "dct.h"
+#include "m4venc_simd.h"
 #include "mp4enc_api.h"
 
 #include "Mpeg4H263EncoderTestEnvironment.h"
@@ -237,6 +242,177 @@ INSTANTIATE_TEST_SUITE_P(
                 make_tuple("football_qvga.yuv", false, 176, 144, 30, 1024),
                 make_tuple("football_qvga.yuv", true, 176, 144, 30, 1024)));
 
+#ifdef M4VENC_SIMD
+// Checks every _SIMD kernel against its scalar version on random blocks. The kernels
+// must be bit-exact, since the encoder picks one or the other at run time.
+class Mpeg4H263EncoderSimdTest : public ::testing::Test {
+  public:
+    Mpeg4H263EncoderSimdTest() : mSeed(12345) {}
+
+    void SetUp() override {
+        if (!M4VEnc_HasSIMD()) {
+            GTEST_SKIP() << "SIMD kernels are not supported on this CPU";
+        }
+    }
+
+    uint32_t rand() {
+        mSeed = mSeed * 1103515245 + 12345;
+        return mSeed >> 8;
+    }
+
+    void checkQuant(Short *rcoeff, int32_t qp, int32_t dctMode, UChar shortHeader);
+
+  private:
+    uint32_t mSeed;
+};
+
+// The quantizer reads the column markers at rcoeff[64 + c] and writes the dequantized
+// block back in place, so the buffer holds 64 spare entries past the markers.
+static constexpr int32_t kQuantBufferSize = 192;
+
+void Mpeg4H263EncoderSimdTest::checkQuant(Short *rcoeff, int32_t qp, int32_t dctMode,
+                                          UChar shortHeader) {
+    struct QPstruct quantParam;
+    quantParam.QPx2 = qp << 1;
+    quantParam.QP = qp;
+    quantParam.QPdiv2 = qp >> 1;
+    quantParam.QPx2plus = quantParam.QPx2 + quantParam.QPdiv2;
+    quantParam.Addition = qp - 1 + (qp & 0x1);
+
+    Short rcoeffSimd[kQuantBufferSize];
+    Short qcoeff[64], qcoeffSimd[64];
+    memcpy(rcoeffSimd, rcoeff, sizeof(rcoeffSimd));
+    for (int32_t i = 0; i < 64; i++) {
+        qcoeff[i] = qcoeffSimd[i] = rand();
+    }
+
+    UChar bitmapCol[8], bitmapColSimd[8], bitmapRow, bitmapRowSimd;
+    UInt bitmapZz[2], bitmapZzSimd[2];
+    Int status = BlockQuantDequantH263Inter(rcoeff, qcoeff, &quantParam, bitmapCol, &bitmapRow,
+                                            bitmapZz, dctMode, 0, 0, shortHeader);
+    Int statusSimd = BlockQuantDequantH263Inter_SIMD(rcoeffSimd, qcoeffSimd, &quantParam,
+                                                     bitmapColSimd, &bitmapRowSimd, bitmapZzSimd,
+                                                     dctMode, 0, 0, shortHeader);
+
+    SCOPED_TRACE(testing::Message() << "QP " << qp << " dctMode " << dctMode << " shortHeader "
+                                    << (int32_t)shortHeader);
+    ASSERT_EQ(status, statusSimd);
+    ASSERT_EQ(0, memcmp(rcoeff, rcoeffSimd, sizeof(rcoeffSimd))) << "Dequantized block differs";
+    ASSERT_EQ(0, memcmp(qcoeff, qcoeffSimd, sizeof(qcoeff))) << "Quantized block differs";
+    ASSERT_EQ(0, memcmp(bitmapCol, bitmapColSimd, sizeof(bitmapCol)));
+    ASSERT_EQ(bitmapRow, bitmapRowSimd);
+    ASSERT_EQ(bitmapZz[0], bitmapZzSimd[0]);
+    ASSERT_EQ(bitmapZz[1], bitmapZzSimd[1]);
+}
+
+TEST_F(Mpeg4H263EncoderSimdTest, SADTest) {
+    constexpr int32_t kLx = 64;
+    static UChar ref[kLx * kLx];
+    UChar blk[256];
+    // HTFM extra_info: 16 thresholds followed, from entry 32, by the 4:1 subsampling offsets.
+    Int extraInfo[48];
+    const Int offsets[16] = {0,           2 * kLx + 2, 2,       2 * kLx,     kLx + 1, 3 * kLx + 3,
+                             kLx + 3,     3 * kLx + 1, kLx,     3 * kLx + 2, 1,       2 * kLx + 3,
+                             3 * kLx,     kLx + 2,     2 * kLx + 1, 3};
+    for (int32_t i = 0; i < 16; i++) {
+        extraInfo[32 + i] = offsets[i];
+    }
+
+    for (int32_t iter = 0; iter < 20000; iter++) {
+        // Odd iterations use noise, even ones a flat block so the early exits are not taken.
+        bool noise = iter & 1;
+        for (int32_t i = 0; i < kLx * kLx; i++) {
+            ref[i] = noise ? rand() : 100 + rand() % 20;
+        }
+        for (int32_t i = 0; i < 256; i++) {
+            blk[i] = noise ? rand() : 100 + rand() % 20;
+        }
+        for (int32_t i = 0; i < 16; i++) {
+            extraInfo[i] = rand() % 200;
+        }
+        UChar *org = ref + 3 + kLx * 2;
+        Int dmin = rand() % 65536;
+        Int dminLx = (Int)(((UInt)dmin << 16) | kLx);
+
+        SCOPED_TRACE(testing::Message() << "iteration " << iter << " dmin " << dmin);
+        ASSERT_EQ(SAD_Macroblock_C(org, blk, dminLx, extraInfo),
+                  SAD_Macroblock_SIMD(org, blk, dminLx, extraInfo));
+        ASSERT_EQ(SAD_MB_HTFM(org, blk, dminLx, extraInfo),
+                  SAD_MB_HTFM_SIMD(org, blk, dminLx, extraInfo));
+        ASSERT_EQ(SAD_MB_HP_HTFMxh(org, blk, dminLx, extraInfo),
+                  SAD_MB_HP_HTFMxh_SIMD(org, blk, dminLx, extraInfo));
+        ASSERT_EQ(SAD_MB_HP_HTFMyh(org, blk, dminLx, extraInfo),
+                  SAD_MB_HP_HTFMyh_SIMD(org, blk, dminLx, extraInfo));
+        ASSERT_EQ(SAD_MB_HP_HTFMxhyh(org, blk, dminLx, extraInfo),
+                  SAD_MB_HP_HTFMxhyh_SIMD(org, blk, dminLx, extraInfo));
+    }
+}
+
+TEST_F(Mpeg4H263EncoderSimdTest, DCTTest) {
+    constexpr int32_t kWidth = 40;
+    UChar cur[8 * kWidth], pred[8 * 16];
+    Short out[kQuantBufferSize], outSimd[kQuantBufferSize];
+
+    for (int32_t iter = 0; iter < 50000; iter++) {
+        // Full range noise, saturated edges and near-flat blocks.
+        int32_t content = iter % 3;
+        for (int32_t i = 0; i < 8 * kWidth; i++) {
+            cur[i] = content == 0   ? rand()
+                     : content == 1 ? (rand() & 1) * 255
+                                    : 128 + (int32_t)(rand() % 9) - 4;
+        }
+        for (int32_t i = 0; i < 8 * 16; i++) {
+            pred[i] = content == 1 ? (rand() & 1) * 255 : rand();
+        }
+        for (int32_t i = 0; i < kQuantBufferSize; i++) {
+            out[i] = outSimd[i] = rand();
+        }
+        // out[64] carries the zero-column threshold in, and the 0x7fff column markers out.
+        out[64] = outSimd[64] = (iter & 1) ? ColThInter[rand() % 32] : rand() % 20000;
+
+        BlockDCT_AANwSub(out, cur, pred, kWidth);
+        BlockDCT_AANwSub_SIMD(outSimd, cur, pred, kWidth);
+        ASSERT_EQ(0, memcmp(out, outSimd, sizeof(out))) << "iteration " << iter;
+    }
+}
+
+TEST_F(Mpeg4H263EncoderSimdTest, QuantTest) {
+    Short rcoeff[kQuantBufferSize];
+    const int32_t ranges[] = {65536, 4096, 600};
+
+    for (int32_t iter = 0; iter < 50000; iter++) {
+        int32_t range = ranges[iter % 3];
+        for (int32_t i = 0; i < kQuantBufferSize; i++) {
+            rcoeff[i] = (Short)((int32_t)(rand() % range) - range / 2);
+        }
+        for (int32_t c = 0; c < 8; c++) {
+            if (rand() % 4 == 0) rcoeff[64 + c] = 0x7fff;
+        }
+        ASSERT_NO_FATAL_FAILURE(
+                checkQuant(rcoeff, 1 + rand() % 31, 1 + rand() % 8, rand() & 1));
+    }
+}
+
+TEST_F(Mpeg4H263EncoderSimdTest, QuantClipTest) {
+    Short rcoeff[kQuantBufferSize];
+
+    // Extreme coefficients quantize past ac_clip (126 for short header, 2047 otherwise)
+    // and dequantize past 2047 at every QP.
+    for (int32_t qp = 1; qp <= 31; qp++) {
+        for (int32_t dctMode = 1; dctMode <= 8; dctMode++) {
+            for (UChar shortHeader = 0; shortHeader <= 1; shortHeader++) {
+                for (int32_t i = 0; i < kQuantBufferSize; i++) {
+                    rcoeff[i] = (rand() & 1) ? 32766 : -32768;
+                }
+                // one column marked all zero by the FDCT
+                rcoeff[64 + (qp & 7)] = 0x7fff;
+                ASSERT_NO_FATAL_FAILURE(checkQuant(rcoeff, qp, dctMode, shortHeader));
+            }
+        }
+    }
+}
+#endif  // M4VENC_SIMD
+
 int32_t main(int argc, char **argv) {
     gEnv = new Mpeg4H263EncoderTestEnvironment();
     ::testing::AddGlobalTestEnvironment(gEnv);
@@ -97,6 +97,7 @@ Input
 
 #include "pvmp3_dct_16.h"
 #include "pv_mp3dec_fxd_op.h"
+#include "pvmp3_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -362,6 +363,40 @@ void pvmp3_merge_in_place_N32(int32 vec[])
 }
 
 
+#ifdef PVMP3_SIMD
+/*
+ *  pvmp3_split() four butterflies at a time. The lower half of the input
+ *  and the cosine terms are walked backwards, so they are loaded reversed.
+ */
+PVMP3_SIMD_TARGET
+static void pvmp3_split_x4(int32 *vect)
+{
+    for (int32 n = 0; n < 16; n += 4)
+    {
+        vec4_int32 tmp2 = vec4_load(&vect[n]);
+        vec4_int32 tmp1 = vec4_reverse(vec4_load(&vect[-4 - n]));
+        vec4_int32 cosx = vec4_reverse(vec4_load(&CosTable_dct32[12 - n]));
+        vec4_int32 diff = vec4_sub(tmp1, tmp2);
+
+        vec4_store(&vect[-4 - n], vec4_reverse(vec4_add(tmp1, tmp2)));
+
+        if (n == 0)
+        {
+            vec4_store(&vect[n], vec4_mul_Q27(diff, cosx));
+        }
+        else if (n == 4)    /* terms 4, 5 are Q27, 6, 7 are Q32 */
+        {
+            vec4_store(&vect[n], vec4_select_lo_hi(vec4_mul_Q27(diff, cosx),
+                                                   vec4_mul_Q32(vec4_shl1(diff), cosx)));
+        }
+        else
+        {
+            vec4_store(&vect[n], vec4_mul_Q32(vec4_shl1(diff), cosx));
+        }
+    }
+}
+#endif
+
 /*----------------------------------------------------------------------------
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
@@ -371,6 +406,13 @@ void pvmp3_merge_in_place_N32(int32 vec[])
 __attribute__((no_sanitize("integer")))
 void pvmp3_split(int32 *vect)
 {
+#ifdef PVMP3_SIMD
+    if (pvmp3_simd_level() != PVMP3_SIMD_NONE)
+    {
+        pvmp3_split_x4(vect);
+        return;
+    }
+#endif
 
     int32 i;
     const int32 *pt_cosTerms = &CosTable_dct32[15];
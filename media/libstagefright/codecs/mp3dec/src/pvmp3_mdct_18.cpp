@@ -70,6 +70,7 @@ Returns
 
 #include "pv_mp3dec_fxd_op.h"
 #include "pvmp3_mdct_18.h"
+#include "pvmp3_simd.h"
 
 
 /*----------------------------------------------------------------------------
@@ -123,6 +124,57 @@ const int32 cosTerms_1_ov_cos_phi[18] =
 ; Declare variables used in this module but defined elsewhere
 ----------------------------------------------------------------------------*/
 
+#ifdef PVMP3_SIMD
+/*
+ *  First eight butterflies of the input stage of pvmp3_mdct_18(); the upper
+ *  half of vec[] and of the 1/cos table run backwards and are loaded
+ *  reversed. The middle pair vec[8], vec[9] is left to the scalar loop.
+ */
+PVMP3_SIMD_TARGET
+static void pvmp3_mdct_18_split_x4(int32 vec[])
+{
+    for (int32 i = 0; i < 8; i += 4)
+    {
+        vec4_int32 tmp  = vec4_load(&vec[i]);
+        vec4_int32 tmp1 = vec4_reverse(vec4_load(&vec[14 - i]));
+        vec4_int32 cosv = vec4_load(&cosTerms_1_ov_cos_phi[i]);
+        vec4_int32 cosx = vec4_reverse(vec4_load(&cosTerms_1_ov_cos_phi[14 - i]));
+
+        tmp  = vec4_mul_Q32(vec4_shl1(tmp), cosv);
+        tmp1 = vec4_mul_Q27(tmp1, cosx);
+
+        vec4_store(&vec[i], vec4_add(tmp, tmp1));
+        vec4_store(&vec[14 - i],
+                   vec4_reverse(vec4_mul_Q28(vec4_sub(tmp, tmp1),
+                                             vec4_load(&cosTerms_dct18[i]))));
+    }
+}
+
+/*
+ *  Windowed overlap for the next granule, from history[0..8]:
+ *  history[k] = history[8-k] * window[18+k] and history[9+k] =
+ *  history[k] * window[27+k], both on the doubled value.
+ */
+__attribute__((no_sanitize("integer")))
+PVMP3_SIMD_TARGET
+static void pvmp3_mdct_18_overlap_x4(int32 *history, const int32 *window)
+{
+    vec4_int32 h0 = vec4_shl1(vec4_load(&history[0]));
+    vec4_int32 h1 = vec4_shl1(vec4_load(&history[1]));
+    vec4_int32 h4 = vec4_shl1(vec4_load(&history[4]));
+    vec4_int32 h5 = vec4_shl1(vec4_load(&history[5]));
+    int32 tmp  = history[0] << 1;
+    int32 tmp1 = history[8] << 1;
+
+    vec4_store(&history[ 0], vec4_mul_Q32(vec4_reverse(h5), vec4_load(&window[18])));
+    vec4_store(&history[ 4], vec4_mul_Q32(vec4_reverse(h1), vec4_load(&window[22])));
+    history[8] = fxp_mul32_Q32(tmp, window[26]);
+    vec4_store(&history[ 9], vec4_mul_Q32(h0, vec4_load(&window[27])));
+    vec4_store(&history[13], vec4_mul_Q32(h4, vec4_load(&window[31])));
+    history[17] = fxp_mul32_Q32(tmp1, window[35]);
+}
+#endif
+
 /*----------------------------------------------------------------------------
 ; FUNCTION CODE
 ----------------------------------------------------------------------------*/
@@ -147,8 +199,23 @@ void pvmp3_mdct_18(int32 vec[], int32 *history, const int32 *window)
     int32 *pt_vec   =  vec;
     int32 *pt_vec_o = &vec[17];
 
+    i = 9;
+
+#ifdef PVMP3_SIMD
+    int32 simd = pvmp3_simd_level();
+    if (simd != PVMP3_SIMD_NONE)
+    {
+        pvmp3_mdct_18_split_x4(vec);
+        pt_cos_split += 8;
+        pt_cos       += 8;
+        pt_cos_x     -= 8;
+        pt_vec       += 8;
+        pt_vec_o     -= 8;
+        i = 1;
+    }
+#endif
 
-    for (i = 9; i != 0; i--)
+    for (; i != 0; i--)
     {
         tmp  = *(pt_vec);
         tmp1 = *(pt_vec_o);
@@ -244,6 +311,14 @@ void pvmp3_mdct_18(int32 vec[], int32 *history, const int32 *window)
 
     /* next iteration overlap */
 
+#ifdef PVMP3_SIMD
+    if (simd != PVMP3_SIMD_NONE)
+    {
+        pvmp3_mdct_18_overlap_x4(history, window);
+        return;
+    }
+#endif
+
     tmp1 = history[ 8];
     tmp3 = history[ 7];
     tmp2 = history[ 1];
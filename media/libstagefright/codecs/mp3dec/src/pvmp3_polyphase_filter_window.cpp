@@ -75,6 +75,7 @@ Input
 #include "pv_mp3dec_fxd_op.h"
 #include "pvmp3_dec_defs.h"
 #include "pvmp3_tables.h"
+#include "pvmp3_simd.h"
 
 /*----------------------------------------------------------------------------
 ; MACROS
@@ -94,6 +95,128 @@ Input
 ; Function Prototype declaration
 ----------------------------------------------------------------------------*/
 
+#ifdef PVMP3_SIMD
+/*
+ *  Symmetric outputs j = 1..15 of the window loop below, with j across the
+ *  lanes. Lane j = 16 is computed and dropped, its loads stay inside the
+ *  synthesis buffer and pqmfSynthWin. The 16 window coefficients of each j
+ *  are contiguous, so four rows are transposed into one vector per tap.
+ *  sum1[j-1] and sum2[j-1] receive the accumulators, before the final shift.
+ */
+PVMP3_SIMD_TARGET
+static void pvmp3_polyphase_filter_window_x4(const int32 *synth_buffer,
+        int32 *sum1,
+        int32 *sum2)
+{
+    for (int32 j = 1; j < SUBBANDS_NUMBER / 2; j += 4)
+    {
+        const int32 *winPtr = &pqmfSynthWin[(j - 1) << 4];
+        const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j];
+        const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j - 3];
+        vec4_int32 acc1 = vec4_dup(0x00000020);
+        vec4_int32 acc2 = acc1;
+
+        for (int32 k = 0; k < 16; k += 4)
+        {
+            vec4_int32 w0 = vec4_load(&winPtr[k]);
+            vec4_int32 w1 = vec4_load(&winPtr[k + 16]);
+            vec4_int32 w2 = vec4_load(&winPtr[k + 32]);
+            vec4_int32 w3 = vec4_load(&winPtr[k + 48]);
+            vec4_transpose(&w0, &w1, &w2, &w3);
+
+            vec4_int32 temp1 = vec4_load(&pt_1[k << 4]);
+            vec4_int32 temp3 = vec4_reverse(vec4_load(&pt_2[SUBBANDS_NUMBER*15 - (k << 4)]));
+            vec4_int32 temp2 = vec4_reverse(vec4_load(&pt_2[SUBBANDS_NUMBER + (k << 4)]));
+            vec4_int32 temp4 = vec4_load(&pt_1[SUBBANDS_NUMBER*14 - (k << 4)]);
+
+            acc1 = vec4_add(acc1, vec4_mul_Q32(temp1, w0));
+            acc1 = vec4_sub(acc1, vec4_mul_Q32(temp3, w1));
+            acc1 = vec4_add(acc1, vec4_mul_Q32(temp2, w2));
+            acc1 = vec4_add(acc1, vec4_mul_Q32(temp4, w3));
+            acc2 = vec4_add(acc2, vec4_mul_Q32(temp3, w0));
+            acc2 = vec4_add(acc2, vec4_mul_Q32(temp1, w1));
+            acc2 = vec4_sub(acc2, vec4_mul_Q32(temp4, w2));
+            acc2 = vec4_add(acc2, vec4_mul_Q32(temp2, w3));
+        }
+
+        vec4_store(&sum1[j - 1], acc1);
+        vec4_store(&sum2[j - 1], acc2);
+    }
+}
+#endif
+
+#ifdef PVMP3_SSE
+static inline PVMP3_AVX2_TARGET __m256i mul8_Q32(__m256i a, __m256i b)
+{
+    __m256i even = _mm256_mul_epi32(a, b);
+    __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+/* rows j..j+3 of pqmfSynthWin in the low half, rows j+4..j+7 in the high half */
+static inline PVMP3_AVX2_TARGET __m256i load_rows8(const int32 *p)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+                                   _mm_loadu_si128((const __m128i *)(p + 64)), 1);
+}
+
+/*
+ *  Same as pvmp3_polyphase_filter_window_x4() with eight j per vector. The
+ *  in-lane transpose of AVX2 unpacks matches the row split of load_rows8().
+ */
+PVMP3_AVX2_TARGET
+static void pvmp3_polyphase_filter_window_x8(const int32 *synth_buffer,
+        int32 *sum1,
+        int32 *sum2)
+{
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+    for (int32 j = 1; j < SUBBANDS_NUMBER / 2; j += 8)
+    {
+        const int32 *winPtr = &pqmfSynthWin[(j - 1) << 4];
+        const int32 *pt_1 = &synth_buffer[(SUBBANDS_NUMBER >> 1) + j];
+        const int32 *pt_2 = &synth_buffer[(SUBBANDS_NUMBER >> 1) - j - 7];
+        __m256i acc1 = _mm256_set1_epi32(0x00000020);
+        __m256i acc2 = acc1;
+
+        for (int32 k = 0; k < 16; k += 4)
+        {
+            __m256i r0 = load_rows8(&winPtr[k]);
+            __m256i r1 = load_rows8(&winPtr[k + 16]);
+            __m256i r2 = load_rows8(&winPtr[k + 32]);
+            __m256i r3 = load_rows8(&winPtr[k + 48]);
+            __m256i t0 = _mm256_unpacklo_epi32(r0, r1);
+            __m256i t1 = _mm256_unpacklo_epi32(r2, r3);
+            __m256i t2 = _mm256_unpackhi_epi32(r0, r1);
+            __m256i t3 = _mm256_unpackhi_epi32(r2, r3);
+            __m256i w0 = _mm256_unpacklo_epi64(t0, t1);
+            __m256i w1 = _mm256_unpackhi_epi64(t0, t1);
+            __m256i w2 = _mm256_unpacklo_epi64(t2, t3);
+            __m256i w3 = _mm256_unpackhi_epi64(t2, t3);
+
+            __m256i temp1 = _mm256_loadu_si256((const __m256i *)&pt_1[k << 4]);
+            __m256i temp3 = _mm256_permutevar8x32_epi32(
+                                _mm256_loadu_si256((const __m256i *)&pt_2[SUBBANDS_NUMBER*15 - (k << 4)]), reverse);
+            __m256i temp2 = _mm256_permutevar8x32_epi32(
+                                _mm256_loadu_si256((const __m256i *)&pt_2[SUBBANDS_NUMBER + (k << 4)]), reverse);
+            __m256i temp4 = _mm256_loadu_si256((const __m256i *)&pt_1[SUBBANDS_NUMBER*14 - (k << 4)]);
+
+            acc1 = _mm256_add_epi32(acc1, mul8_Q32(temp1, w0));
+            acc1 = _mm256_sub_epi32(acc1, mul8_Q32(temp3, w1));
+            acc1 = _mm256_add_epi32(acc1, mul8_Q32(temp2, w2));
+            acc1 = _mm256_add_epi32(acc1, mul8_Q32(temp4, w3));
+            acc2 = _mm256_add_epi32(acc2, mul8_Q32(temp3, w0));
+            acc2 = _mm256_add_epi32(acc2, mul8_Q32(temp1, w1));
+            acc2 = _mm256_sub_epi32(acc2, mul8_Q32(temp4, w2));
+            acc2 = _mm256_add_epi32(acc2, mul8_Q32(temp2, w3));
+        }
+
+        _mm256_storeu_si256((__m256i *)&sum1[j - 1], acc1);
+        _mm256_storeu_si256((__m256i *)&sum2[j - 1], acc2);
+    }
+}
+#endif
+
 /*----------------------------------------------------------------------------
 ; LOCAL STORE/BUFFER/POINTER DEFINITIONS
 ; Variable declaration - defined here and used outside this module1
@@ -120,9 +243,37 @@ void pvmp3_polyphase_filter_window(int32 *synth_buffer,
     int32 sum2;
     const int32 *winPtr = pqmfSynthWin;
     int32 i;
+    int16 j = 1;
 
+#ifdef PVMP3_SIMD
+    int32 simd = pvmp3_simd_level();
+    if (simd != PVMP3_SIMD_NONE)
+    {
+        int32 vsum1[SUBBANDS_NUMBER / 2];
+        int32 vsum2[SUBBANDS_NUMBER / 2];
+
+#ifdef PVMP3_SSE
+        if (simd == PVMP3_SIMD_AVX2)
+        {
+            pvmp3_polyphase_filter_window_x8(synth_buffer, vsum1, vsum2);
+        }
+        else
+#endif
+        {
+            pvmp3_polyphase_filter_window_x4(synth_buffer, vsum1, vsum2);
+        }
+
+        for (; j < SUBBANDS_NUMBER / 2; j++)
+        {
+            int32 k = j << (numChannels - 1);
+            outPcm[k] = saturate16(vsum1[j - 1] >> 6);
+            outPcm[(numChannels<<5) - k] = saturate16(vsum2[j - 1] >> 6);
+        }
+        winPtr += (SUBBANDS_NUMBER / 2 - 1) << 4;
+    }
+#endif
 
-    for (int16 j = 1; j < SUBBANDS_NUMBER / 2; j++)
+    for (; j < SUBBANDS_NUMBER / 2; j++)
     {
         sum1 = 0x00000020;
         sum2 = 0x00000020;
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pvmp3_simd.h"
+
+#if defined(PVMP3_SSE)
+static int32 pvmp3_detect_simd_level(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return PVMP3_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return PVMP3_SIMD_SSE4_1;
+    }
+    return PVMP3_SIMD_NONE;
+}
+#endif
+
+static int32 pvmp3_simd_max_level = PVMP3_SIMD_AVX2;
+
+int32 pvmp3_simd_level(void)
+{
+#if defined(PVMP3_NEON)
+    return PVMP3_SIMD_NEON < pvmp3_simd_max_level ? PVMP3_SIMD_NEON : pvmp3_simd_max_level;
+#elif defined(PVMP3_SSE)
+    static const int32 level = pvmp3_detect_simd_level();
+    return level < pvmp3_simd_max_level ? level : pvmp3_simd_max_level;
+#else
+    return PVMP3_SIMD_NONE;
+#endif
+}
+
+void pvmp3_simd_set_max_level(int32 level)
+{
+    pvmp3_simd_max_level = level;
+}
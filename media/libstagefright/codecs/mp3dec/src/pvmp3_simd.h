@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PVMP3_SIMD_H
+#define PVMP3_SIMD_H
+
+/*
+ * Four lane int32 vector layer for the decoder hot loops (polyphase window,
+ * DCT-32 split, MDCT-18 pre and post twiddles, long block dequantization).
+ * The vec4_mul_Q* helpers keep the low 32 bits of ((int64)a * b) >> N, the
+ * same as the fxp_mul32_Q* macros, so every vector kernel is bit-exact with
+ * the scalar code it replaces.
+ *
+ * NEON is part of the arm64 ABI and is used unconditionally there; 32-bit
+ * ARM keeps its hand written assembly. On x86 the kernels are built with a
+ * function target attribute (SSE4.1, plus an AVX2 variant of the polyphase
+ * window) and only called when pvmp3_simd_level() reports the extension.
+ */
+
+#include "pvmp3_audio_type_defs.h"
+
+#if defined(__aarch64__)
+#define PVMP3_NEON (true)
+#include <arm_neon.h>
+#define PVMP3_SIMD_TARGET
+#elif (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#define PVMP3_SSE (true)
+#include <immintrin.h>
+#define PVMP3_SIMD_TARGET __attribute__((target("sse4.1")))
+#define PVMP3_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#if defined(PVMP3_NEON) || defined(PVMP3_SSE)
+#define PVMP3_SIMD (true)
+#endif
+
+typedef enum
+{
+    PVMP3_SIMD_NONE = 0,
+    PVMP3_SIMD_NEON,
+    PVMP3_SIMD_SSE4_1,
+    PVMP3_SIMD_AVX2
+} e_pvmp3_simd_level;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Best vector extension usable on this CPU, PVMP3_SIMD_NONE if none. */
+    int32 pvmp3_simd_level(void);
+
+    /*
+     * Caps pvmp3_simd_level() to 'level', so that tests can compare each
+     * kernel with the scalar code. Not for use while decoding.
+     */
+    void pvmp3_simd_set_max_level(int32 level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(PVMP3_NEON)
+
+typedef int32x4_t vec4_int32;
+
+static inline vec4_int32 vec4_load(const int32 *p)
+{
+    return vld1q_s32(p);
+}
+
+static inline void vec4_store(int32 *p, vec4_int32 a)
+{
+    vst1q_s32(p, a);
+}
+
+/* p[3], p[2], p[1], p[0] */
+static inline vec4_int32 vec4_reverse(vec4_int32 a)
+{
+    a = vrev64q_s32(a);
+    return vextq_s32(a, a, 2);
+}
+
+static inline vec4_int32 vec4_dup(int32 a)
+{
+    return vdupq_n_s32(a);
+}
+
+static inline vec4_int32 vec4_add(vec4_int32 a, vec4_int32 b)
+{
+    return vaddq_s32(a, b);
+}
+
+static inline vec4_int32 vec4_sub(vec4_int32 a, vec4_int32 b)
+{
+    return vsubq_s32(a, b);
+}
+
+static inline vec4_int32 vec4_shl1(vec4_int32 a)
+{
+    return vshlq_n_s32(a, 1);
+}
+
+static inline vec4_int32 vec4_shl16(vec4_int32 a)
+{
+    return vshlq_n_s32(a, 16);
+}
+
+/* 0 <= n < 32 */
+static inline vec4_int32 vec4_sll(vec4_int32 a, int32 n)
+{
+    return vshlq_s32(a, vdupq_n_s32(n));
+}
+
+/* 0 <= n < 32 */
+static inline vec4_int32 vec4_sra(vec4_int32 a, int32 n)
+{
+    return vshlq_s32(a, vdupq_n_s32(-n));
+}
+
+/* lanes 0, 1 from a, lanes 2, 3 from b */
+static inline vec4_int32 vec4_select_lo_hi(vec4_int32 a, vec4_int32 b)
+{
+    return vcombine_s32(vget_low_s32(a), vget_high_s32(b));
+}
+
+#define PVMP3_VEC4_MUL_QN(name, n)                                          \
+    static inline vec4_int32 name(vec4_int32 a, vec4_int32 b)               \
+    {                                                                       \
+        int64x2_t lo = vmull_s32(vget_low_s32(a), vget_low_s32(b));         \
+        int64x2_t hi = vmull_high_s32(a, b);                                \
+        return vcombine_s32(vshrn_n_s64(lo, n), vshrn_n_s64(hi, n));        \
+    }
+
+/* rows r0..r3 become columns */
+static inline void vec4_transpose(vec4_int32 *r0, vec4_int32 *r1,
+                                  vec4_int32 *r2, vec4_int32 *r3)
+{
+    int64x2_t t0 = vreinterpretq_s64_s32(vtrn1q_s32(*r0, *r1));
+    int64x2_t t1 = vreinterpretq_s64_s32(vtrn2q_s32(*r0, *r1));
+    int64x2_t t2 = vreinterpretq_s64_s32(vtrn1q_s32(*r2, *r3));
+    int64x2_t t3 = vreinterpretq_s64_s32(vtrn2q_s32(*r2, *r3));
+    *r0 = vreinterpretq_s32_s64(vtrn1q_s64(t0, t2));
+    *r1 = vreinterpretq_s32_s64(vtrn1q_s64(t1, t3));
+    *r2 = vreinterpretq_s32_s64(vtrn2q_s64(t0, t2));
+    *r3 = vreinterpretq_s32_s64(vtrn2q_s64(t1, t3));
+}
+
+#elif defined(PVMP3_SSE)
+
+typedef __m128i vec4_int32;
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_load(const int32 *p)
+{
+    return _mm_loadu_si128((const __m128i *)p);
+}
+
+static inline PVMP3_SIMD_TARGET void vec4_store(int32 *p, vec4_int32 a)
+{
+    _mm_storeu_si128((__m128i *)p, a);
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_reverse(vec4_int32 a)
+{
+    return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_dup(int32 a)
+{
+    return _mm_set1_epi32(a);
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_add(vec4_int32 a, vec4_int32 b)
+{
+    return _mm_add_epi32(a, b);
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_sub(vec4_int32 a, vec4_int32 b)
+{
+    return _mm_sub_epi32(a, b);
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_shl1(vec4_int32 a)
+{
+    return _mm_add_epi32(a, a);
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_shl16(vec4_int32 a)
+{
+    return _mm_slli_epi32(a, 16);
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_sll(vec4_int32 a, int32 n)
+{
+    return _mm_sll_epi32(a, _mm_cvtsi32_si128(n));
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_sra(vec4_int32 a, int32 n)
+{
+    return _mm_sra_epi32(a, _mm_cvtsi32_si128(n));
+}
+
+static inline PVMP3_SIMD_TARGET vec4_int32 vec4_select_lo_hi(vec4_int32 a, vec4_int32 b)
+{
+    return _mm_blend_epi16(a, b, 0xF0);
+}
+
+/*
+ * pmuldq only multiplies the even lanes; the odd lanes are shifted down
+ * first. Bits N..N+31 of each product are then moved into place with 64-bit
+ * shifts and merged.
+ */
+#define PVMP3_VEC4_MUL_QN(name, n)                                          \
+    static inline PVMP3_SIMD_TARGET vec4_int32 name(vec4_int32 a, vec4_int32 b) \
+    {                                                                       \
+        __m128i even = _mm_mul_epi32(a, b);                                 \
+        __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)); \
+        return _mm_blend_epi16(_mm_srli_epi64(even, n),                     \
+                               _mm_slli_epi64(odd, 32 - (n)), 0xCC);        \
+    }
+
+static inline PVMP3_SIMD_TARGET void vec4_transpose(vec4_int32 *r0, vec4_int32 *r1,
+        vec4_int32 *r2, vec4_int32 *r3)
+{
+    __m128i t0 = _mm_unpacklo_epi32(*r0, *r1);
+    __m128i t1 = _mm_unpacklo_epi32(*r2, *r3);
+    __m128i t2 = _mm_unpackhi_epi32(*r0, *r1);
+    __m128i t3 = _mm_unpackhi_epi32(*r2, *r3);
+    *r0 = _mm_unpacklo_epi64(t0, t1);
+    *r1 = _mm_unpackhi_epi64(t0, t1);
+    *r2 = _mm_unpacklo_epi64(t2, t3);
+    *r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+#endif
+
+#ifdef PVMP3_SIMD
+
+PVMP3_VEC4_MUL_QN(vec4_mul_Q32, 32)
+PVMP3_VEC4_MUL_QN(vec4_mul_Q30, 30)
+PVMP3_VEC4_MUL_QN(vec4_mul_Q28, 28)
+PVMP3_VEC4_MUL_QN(vec4_mul_Q27, 27)
+
+#endif
+
+#endif  /* PVMP3_SIMD_H */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Decode speed of the PV MP3 decoder over the Mp3DecoderTest corpus. Each
+// stream is split into frames and kept in memory, then decoded from start
+// to end once per iteration, so file I/O is not measured. The "realtime"
+// counter is seconds of audio decoded per second of CPU time.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "mp3reader.h"
+#include "pvmp3decoder_api.h"
+
+constexpr int32_t kInputBufferSize = 1024 * 10;
+constexpr int32_t kOutputBufferSize = 4608 * 2;
+
+static std::string gRes = "/data/local/tmp/Mp3DecoderTestRes/";
+
+static const char *const kCorpus[] = {
+        "bbb_44100hz_2ch_128kbps_mp3_30sec.mp3",
+        "bbb_44100hz_2ch_128kbps_mp3_5mins.mp3",
+        "bbb_mp3_stereo_192kbps_48000hz.mp3",
+};
+
+static void BM_Decode(benchmark::State &state, const std::string &file) {
+    Mp3Reader reader;
+    if (!reader.init((gRes + file).c_str())) {
+        state.SkipWithError("Unable to initialize the mp3Reader");
+        return;
+    }
+    std::vector<std::vector<uint8_t>> frames;
+    uint8_t inputBuf[kInputBufferSize];
+    uint32_t bytesRead;
+    while (reader.getFrame(inputBuf, &bytesRead)) {
+        frames.emplace_back(inputBuf, inputBuf + bytesRead);
+    }
+    reader.close();
+
+    std::vector<uint8_t> decoderBuf(pvmp3_decoderMemRequirements());
+    int16_t outputBuf[kOutputBufferSize];
+    tPVMP3DecoderExternal config{};
+    config.equalizerType = flat;
+    config.crcEnabled = false;
+
+    int64_t numSamples = 0;
+    int64_t numBytes = 0;
+    for (auto _ : state) {
+        pvmp3_InitDecoder(&config, decoderBuf.data());
+        for (std::vector<uint8_t> &frame : frames) {
+            config.inputBufferCurrentLength = frame.size();
+            config.inputBufferMaxLength = 0;
+            config.inputBufferUsedLength = 0;
+            config.pInputBuffer = frame.data();
+            config.pOutputBuffer = outputBuf;
+            config.outputFrameSize = kOutputBufferSize / sizeof(int16_t);
+            if (pvmp3_framedecoder(&config, decoderBuf.data()) != NO_DECODING_ERROR) {
+                state.SkipWithError("Failed to decode the frames");
+                return;
+            }
+            numSamples += config.outputFrameSize / config.num_channels;
+            numBytes += frame.size();
+        }
+    }
+    if (config.samplingRate > 0) {
+        state.counters["realtime"] = benchmark::Counter(
+                (double)numSamples / config.samplingRate, benchmark::Counter::kIsRate);
+    }
+    state.SetBytesProcessed(numBytes);
+}
+
+int main(int argc, char **argv) {
+    // -P <path> points at the resource folder, as for Mp3DecoderTest.
+    int argCount = 1;
+    for (int i = 1; i < argc; ++i) {
+        if ((!strcmp(argv[i], "-P") || !strcmp(argv[i], "--res")) && i + 1 < argc) {
+            gRes = argv[++i];
+        } else {
+            argv[argCount++] = argv[i];
+        }
+    }
+    argc = argCount;
+
+    for (const char *file : kCorpus) {
+        benchmark::RegisterBenchmark(file, BM_Decode, std::string(file))
+                ->Unit(benchmark::kMillisecond);
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
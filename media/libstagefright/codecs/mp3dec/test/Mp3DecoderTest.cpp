@@ -22,7 +22,15 @@
 #include <audio_utils/sndfile.h>
 #include <stdio.h>
 
+#include <random>
+#include <vector>
+
 #include "mp3reader.h"
+#include "pvmp3_dct_16.h"
+#include "pvmp3_dequantize_sample.h"
+#include "pvmp3_mdct_18.h"
+#include "pvmp3_polyphase_filter_window.h"
+#include "pvmp3_simd.h"
 #include "pvmp3decoder_api.h"
 
 #include "Mp3DecoderTestEnvironment.h"
@@ -182,6 +190,137 @@ TEST_P(Mp3DecoderTest, ResetDecoderTest) {
     }
 }
 
+// Runs each vector kernel and the scalar code on the same random input, the outputs must be
+// bit-exact. The parameter is the vector extension tested, skipped if the CPU does not have it.
+class Mp3DecoderSimdTest : public ::testing::TestWithParam<int32> {
+  public:
+    static constexpr int32_t kIterations = 2000;
+
+    virtual void SetUp() override {
+        if (pvmp3_simd_level() < GetParam()) {
+            GTEST_SKIP() << "vector extension " << GetParam() << " not supported";
+        }
+    }
+
+    virtual void TearDown() override { pvmp3_simd_set_max_level(PVMP3_SIMD_AVX2); }
+
+    int32 random(int32 min, int32 max) {
+        return std::uniform_int_distribution<int32>(min, max)(mRandom);
+    }
+
+    void fillRandom(std::vector<int32> *data, int32 bits) {
+        for (int32 &value : *data) {
+            value = random(-(1 << bits), (1 << bits) - 1);
+        }
+    }
+
+    // Runs 'kernel' on a copy of each buffer at the scalar and the tested level.
+    template <typename T, typename F>
+    void compare(std::vector<std::vector<T> *> buffers, F kernel) {
+        std::vector<std::vector<T>> scalar;
+        for (std::vector<T> *buffer : buffers) {
+            scalar.push_back(*buffer);
+        }
+        std::vector<T *> scalarPtrs;
+        for (std::vector<T> &buffer : scalar) {
+            scalarPtrs.push_back(buffer.data());
+        }
+        pvmp3_simd_set_max_level(PVMP3_SIMD_NONE);
+        kernel(scalarPtrs);
+
+        std::vector<T *> vectorPtrs;
+        for (std::vector<T> *buffer : buffers) {
+            vectorPtrs.push_back(buffer->data());
+        }
+        pvmp3_simd_set_max_level(GetParam());
+        kernel(vectorPtrs);
+
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            ASSERT_EQ(scalar[i], *buffers[i]) << "buffer " << i;
+        }
+    }
+
+    std::mt19937 mRandom{0x6d703364};
+};
+
+TEST_P(Mp3DecoderSimdTest, Split) {
+    std::vector<int32> vec(SUBBANDS_NUMBER);
+    for (int32_t n = 0; n < kIterations; ++n) {
+        fillRandom(&vec, 28);
+        compare<int32>({&vec}, [](std::vector<int32 *> b) { pvmp3_split(&b[0][16]); });
+        if (HasFatalFailure()) return;
+    }
+}
+
+TEST_P(Mp3DecoderSimdTest, Mdct18) {
+    std::vector<int32> vec(FILTERBANK_BANDS);
+    std::vector<int32> history(FILTERBANK_BANDS);
+    std::vector<int32> window(2 * FILTERBANK_BANDS);
+    for (int32_t n = 0; n < kIterations; ++n) {
+        fillRandom(&vec, 26);
+        fillRandom(&history, 26);
+        fillRandom(&window, 30);
+        compare<int32>({&vec, &history}, [&window](std::vector<int32 *> b) {
+            pvmp3_mdct_18(b[0], b[1], window.data());
+        });
+        if (HasFatalFailure()) return;
+    }
+}
+
+TEST_P(Mp3DecoderSimdTest, PolyphaseFilterWindow) {
+    // The window reads 512 samples after the start of the synthesis buffer.
+    std::vector<int32> synth(HAN_SIZE + SUBBANDS_NUMBER);
+    for (int32_t n = 0; n < kIterations; ++n) {
+        fillRandom(&synth, 26);
+        const int32 numChannels = random(1, 2);
+        std::vector<int16> pcmScalar(2 * SUBBANDS_NUMBER * numChannels, 0x5555);
+        std::vector<int16> pcmVector(pcmScalar);
+        pvmp3_simd_set_max_level(PVMP3_SIMD_NONE);
+        pvmp3_polyphase_filter_window(synth.data(), pcmScalar.data(), numChannels);
+        pvmp3_simd_set_max_level(GetParam());
+        pvmp3_polyphase_filter_window(synth.data(), pcmVector.data(), numChannels);
+        ASSERT_EQ(pcmScalar, pcmVector) << "iteration " << n;
+    }
+}
+
+TEST_P(Mp3DecoderSimdTest, DequantizeLongBlocks) {
+    std::vector<int32> is(SUBBANDS_NUMBER * FILTERBANK_BANDS);
+    for (int32_t n = 0; n < kIterations; ++n) {
+        mp3Header info{};
+        info.version_x = MPEG_1;
+        info.sampling_frequency = random(0, 2);
+        granuleInfo grInfo{};
+        grInfo.global_gain = random(0, 255);
+        grInfo.scalefac_scale = random(0, 1);
+        grInfo.preflag = random(0, 1);
+        mp3ScaleFactors scalefac{};
+        for (int32 &sf : scalefac.l) {
+            sf = random(0, 15);
+        }
+        for (int32 &value : is) {
+            // mostly small quantized values, as decoded from the Huffman tables
+            value = random(0, 7) ? random(-15, 15) : random(-8206, 8206);
+        }
+        const int32 usedFreqLines = random(0, (int32)is.size());
+        compare<int32>({&is}, [&](std::vector<int32 *> b) {
+            pvmp3_dequantize_sample(b[0], &scalefac, &grInfo, usedFreqLines, &info);
+        });
+        if (HasFatalFailure()) return;
+    }
+}
+
+// The vector extensions of the target architecture.
+static const int32 kSimdLevels[] = {
+#if defined(PVMP3_NEON)
+        PVMP3_SIMD_NEON,
+#else
+        PVMP3_SIMD_SSE4_1, PVMP3_SIMD_AVX2,
+#endif
+};
+
+INSTANTIATE_TEST_SUITE_P(Mp3DecoderSimdTestAll, Mp3DecoderSimdTest,
+                         ::testing::ValuesIn(kSimdLevels));
+
 INSTANTIATE_TEST_SUITE_P(Mp3DecoderTestAll, Mp3DecoderTest,
                          ::testing::Values(("bbb_44100hz_2ch_128kbps_mp3_30sec.mp3"),
                                            ("bbb_44100hz_2ch_128kbps_mp3_5mins.mp3"),
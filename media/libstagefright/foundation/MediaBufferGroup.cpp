@@ -17,7 +17,10 @@
 #define LOG_TAG "MediaBufferGroup"
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 #include <binder/MemoryDealer.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -37,12 +40,131 @@ static const size_t kSharedMemoryThreshold = MIN(
         (size_t)MediaBuffer::kSharedMemThreshold, (size_t)(4 * 1024));
 
 struct MediaBufferGroup::InternalData {
+    struct Entry {
+        MediaBufferBase *mBuffer;
+        bool mFree;  // on one of the mFree lists
+    };
+    typedef std::list<Entry>::iterator EntryIt;
+
+    // Free buffers are bucketed by floor(log2(size)).
+    static constexpr size_t kNumBuckets = 64;
+
     Mutex mLock;
     Condition mCondition;
     size_t mGrowthLimit;  // Do not automatically grow group larger than this.
-    std::list<MediaBufferBase *> mBuffers;
+    size_t mWaiters = 0;  // threads blocked in acquire_buffer()
+    std::list<Entry> mBuffers;
+    std::unordered_map<MediaBufferBase *, EntryIt> mIndex;
+    std::vector<EntryIt> mFree[kNumBuckets];
+    uint64_t mFreeMask = 0;  // bit b set iff mFree[b] is not empty
+
+    static size_t bucketOf(size_t size) {
+        return size == 0 ? 0 : 63 - __builtin_clzll((unsigned long long)size);
+    }
+
+    void addLocked(MediaBufferBase *buffer, bool makeFree);
+    void removeLocked(EntryIt it);
+    void pushFreeLocked(EntryIt it);
+    EntryIt popFreeLocked(size_t bucket, size_t pos);
+    EntryIt findFreeLocked(size_t requestedSize);
+    EntryIt smallestFreeLocked();
+    size_t reclaimLocked();
 };
 
+void MediaBufferGroup::InternalData::addLocked(MediaBufferBase *buffer, bool makeFree) {
+    EntryIt it = mBuffers.insert(mBuffers.end(), Entry{buffer, false});
+    mIndex[buffer] = it;
+    if (makeFree) {
+        pushFreeLocked(it);
+    }
+}
+
+void MediaBufferGroup::InternalData::removeLocked(EntryIt it) {
+    if (it->mFree) {
+        std::vector<EntryIt> &list = mFree[bucketOf(it->mBuffer->size())];
+        for (size_t i = 0; i < list.size(); ++i) {
+            if (list[i] == it) {
+                popFreeLocked(bucketOf(it->mBuffer->size()), i);
+                break;
+            }
+        }
+    }
+    mIndex.erase(it->mBuffer);
+    mBuffers.erase(it);
+}
+
+void MediaBufferGroup::InternalData::pushFreeLocked(EntryIt it) {
+    const size_t bucket = bucketOf(it->mBuffer->size());
+    it->mFree = true;
+    mFree[bucket].push_back(it);
+    mFreeMask |= 1ull << bucket;
+}
+
+MediaBufferGroup::InternalData::EntryIt MediaBufferGroup::InternalData::popFreeLocked(
+        size_t bucket, size_t pos) {
+    std::vector<EntryIt> &list = mFree[bucket];
+    EntryIt it = list[pos];
+    list[pos] = list.back();
+    list.pop_back();
+    if (list.empty()) {
+        mFreeMask &= ~(1ull << bucket);
+    }
+    it->mFree = false;
+    return it;
+}
+
+// Returns a free buffer of at least requestedSize, preferring the most
+// recently returned one of the smallest size class that fits.
+MediaBufferGroup::InternalData::EntryIt MediaBufferGroup::InternalData::findFreeLocked(
+        size_t requestedSize) {
+    const size_t bucket = bucketOf(requestedSize);
+    if (requestedSize > 0 && (mFreeMask & (1ull << bucket))) {
+        // Only this bucket may hold buffers smaller than requestedSize.
+        const std::vector<EntryIt> &list = mFree[bucket];
+        for (size_t i = list.size(); i-- > 0;) {
+            if (list[i]->mBuffer->size() >= requestedSize) {
+                return popFreeLocked(bucket, i);
+            }
+        }
+    }
+    const uint64_t larger = requestedSize == 0 ? mFreeMask
+            : mFreeMask & ~((2ull << bucket) - 1);
+    if (larger == 0) {
+        return mBuffers.end();
+    }
+    const size_t found = __builtin_ctzll(larger);
+    return popFreeLocked(found, mFree[found].size() - 1);
+}
+
+MediaBufferGroup::InternalData::EntryIt MediaBufferGroup::InternalData::smallestFreeLocked() {
+    if (mFreeMask == 0) {
+        return mBuffers.end();
+    }
+    const size_t bucket = __builtin_ctzll(mFreeMask);
+    const std::vector<EntryIt> &list = mFree[bucket];
+    size_t smallest = 0;
+    for (size_t i = 1; i < list.size(); ++i) {
+        if (list[i]->mBuffer->size() < list[smallest]->mBuffer->size()) {
+            smallest = i;
+        }
+    }
+    return popFreeLocked(bucket, smallest);
+}
+
+// Buffers only reach the free lists through signalBufferReturned(). A buffer
+// whose last reference was remote, or that was claim()ed, is found here by
+// scanning for a zero refcount. Only called when no listed buffer fits.
+size_t MediaBufferGroup::InternalData::reclaimLocked() {
+    size_t reclaimed = 0;
+    for (EntryIt it = mBuffers.begin(); it != mBuffers.end(); ++it) {
+        if (!it->mFree && it->mBuffer->refcount() == 0) {
+            pushFreeLocked(it);
+            ++reclaimed;
+        }
+    }
+    return reclaimed;
+}
+
 MediaBufferGroup::MediaBufferGroup(size_t growthLimit)
     : mWrapper(nullptr), mInternal(new InternalData()) {
     mInternal->mGrowthLimit = growthLimit;
@@ -102,7 +224,8 @@ void MediaBufferGroup::init(size_t buffers, size_t buffer_size, size_t growthLim
 }
 
 MediaBufferGroup::~MediaBufferGroup() {
-    for (MediaBufferBase *buffer : mInternal->mBuffers) {
+    for (const InternalData::Entry &entry : mInternal->mBuffers) {
+        MediaBufferBase *buffer = entry.mBuffer;
         if (buffer->refcount() != 0) {
             const int localRefcount = buffer->localRefcount();
             const int remoteRefcount = buffer->remoteRefcount();
@@ -132,82 +255,81 @@ void MediaBufferGroup::add_buffer(MediaBufferBase *buffer) {
     Mutex::Autolock autoLock(mInternal->mLock);
 
     // if we're above our growth limit, release buffers if we can
-    for (auto it = mInternal->mBuffers.begin();
-            mInternal->mGrowthLimit > 0
-            && mInternal->mBuffers.size() >= mInternal->mGrowthLimit
-            && it != mInternal->mBuffers.end();) {
-        if ((*it)->refcount() == 0) {
-            (*it)->setObserver(nullptr);
-            (*it)->release();
-            it = mInternal->mBuffers.erase(it);
-        } else {
-            ++it;
+    if (mInternal->mGrowthLimit > 0
+            && mInternal->mBuffers.size() >= mInternal->mGrowthLimit) {
+        mInternal->reclaimLocked();
+        while (mInternal->mBuffers.size() >= mInternal->mGrowthLimit) {
+            InternalData::EntryIt it = mInternal->smallestFreeLocked();
+            if (it == mInternal->mBuffers.end()) {
+                break;
+            }
+            it->mBuffer->setObserver(nullptr);
+            it->mBuffer->release();
+            mInternal->removeLocked(it);
         }
     }
 
     buffer->setObserver(this);
-    mInternal->mBuffers.emplace_back(buffer);
+    mInternal->addLocked(buffer, buffer->refcount() == 0);
+    if (mInternal->mWaiters > 0) {
+        mInternal->mCondition.signal();
+    }
 }
 
 bool MediaBufferGroup::has_buffers() {
+    Mutex::Autolock autoLock(mInternal->mLock);
     if (mInternal->mBuffers.size() < mInternal->mGrowthLimit) {
         return true; // We can add more buffers internally.
     }
-    for (MediaBufferBase *buffer : mInternal->mBuffers) {
-        if (buffer->refcount() == 0) {
-            return true;
-        }
-    }
-    return false;
+    return mInternal->mFreeMask != 0 || mInternal->reclaimLocked() > 0;
 }
 
 status_t MediaBufferGroup::acquire_buffer(
         MediaBufferBase **out, bool nonBlocking, size_t requestedSize) {
     Mutex::Autolock autoLock(mInternal->mLock);
     for (;;) {
-        size_t smallest = requestedSize;
-        size_t biggest = requestedSize;
         MediaBufferBase *buffer = nullptr;
-        auto free = mInternal->mBuffers.end();
-        for (auto it = mInternal->mBuffers.begin(); it != mInternal->mBuffers.end(); ++it) {
-            const size_t size = (*it)->size();
-            if (size > biggest) {
-                biggest = size;
-            }
-            if ((*it)->refcount() == 0) {
-                if (size >= requestedSize) {
-                    buffer = *it;
-                    break;
-                }
-                if (size < smallest) {
-                    smallest = size; // always free the smallest buf
-                    free = it;
-                }
-            }
+        InternalData::EntryIt it = mInternal->findFreeLocked(requestedSize);
+        if (it == mInternal->mBuffers.end() && mInternal->reclaimLocked() > 0) {
+            it = mInternal->findFreeLocked(requestedSize);
         }
-        if (buffer == nullptr
-                && (free != mInternal->mBuffers.end()
-                    || mInternal->mBuffers.size() < mInternal->mGrowthLimit)) {
-            // We alloc before we free so failure leaves group unchanged.
-            const size_t allocateSize = requestedSize == 0 ? biggest :
-                    requestedSize < SIZE_MAX / 3 * 2 /* NB: ordering */ ?
-                    requestedSize * 3 / 2 : requestedSize;
-            buffer = new MediaBuffer(allocateSize);
-            if (buffer->data() == nullptr) {
-                ALOGE("Allocation failure for size %zu", allocateSize);
-                delete buffer; // Invalid alloc, prefer not to call release.
-                buffer = nullptr;
-            } else {
-                buffer->setObserver(this);
-                if (free != mInternal->mBuffers.end()) {
-                    ALOGV("reallocate buffer, requested size %zu vs available %zu",
-                            requestedSize, (*free)->size());
-                    (*free)->setObserver(nullptr);
-                    (*free)->release();
-                    *free = buffer; // in-place replace
+        if (it != mInternal->mBuffers.end()) {
+            buffer = it->mBuffer;
+        } else {
+            // Nothing free fits: replace the smallest free buffer, or grow.
+            InternalData::EntryIt free = mInternal->smallestFreeLocked();
+            if (free != mInternal->mBuffers.end()
+                    || mInternal->mBuffers.size() < mInternal->mGrowthLimit) {
+                size_t biggest = requestedSize;
+                if (requestedSize == 0) {
+                    for (const InternalData::Entry &entry : mInternal->mBuffers) {
+                        biggest = std::max(biggest, entry.mBuffer->size());
+                    }
+                }
+                // We alloc before we free so failure leaves group unchanged.
+                const size_t allocateSize = requestedSize == 0 ? biggest :
+                        requestedSize < SIZE_MAX / 3 * 2 /* NB: ordering */ ?
+                        requestedSize * 3 / 2 : requestedSize;
+                buffer = new MediaBuffer(allocateSize);
+                if (buffer->data() == nullptr) {
+                    ALOGE("Allocation failure for size %zu", allocateSize);
+                    delete buffer; // Invalid alloc, prefer not to call release.
+                    buffer = nullptr;
+                    if (free != mInternal->mBuffers.end()) {
+                        mInternal->pushFreeLocked(free);
+                    }
                 } else {
-                    ALOGV("allocate buffer, requested size %zu", requestedSize);
-                    mInternal->mBuffers.emplace_back(buffer);
+                    buffer->setObserver(this);
+                    if (free != mInternal->mBuffers.end()) {
+                        ALOGV("reallocate buffer, requested size %zu vs available %zu",
+                                requestedSize, free->mBuffer->size());
+                        free->mBuffer->setObserver(nullptr);
+                        free->mBuffer->release();
+                        mInternal->removeLocked(free);
+                    } else {
+                        ALOGV("allocate buffer, requested size %zu", requestedSize);
+                    }
+                    mInternal->addLocked(buffer, false /* makeFree */);
                 }
             }
         }
@@ -222,7 +344,9 @@ status_t MediaBufferGroup::acquire_buffer(
             return WOULD_BLOCK;
         }
         // All buffers are in use, block until one of them is returned.
+        ++mInternal->mWaiters;
         mInternal->mCondition.wait(mInternal->mLock);
+        --mInternal->mWaiters;
     }
     // Never gets here.
 }
@@ -231,9 +355,29 @@ size_t MediaBufferGroup::buffers() const {
     return mInternal->mBuffers.size();
 }
 
-void MediaBufferGroup::signalBufferReturned(MediaBufferBase *) {
+void MediaBufferGroup::signalBufferReturned(MediaBufferBase *buffer) {
     Mutex::Autolock autoLock(mInternal->mLock);
-    mInternal->mCondition.signal();
+    if (buffer == nullptr) {
+        // Remote releases are not individually signalled and may have freed
+        // several buffers; let every waiter rescan.
+        if (mInternal->mWaiters > 0) {
+            mInternal->mCondition.broadcast();
+        }
+        return;
+    }
+    auto found = mInternal->mIndex.find(buffer);
+    if (found == mInternal->mIndex.end()) {
+        return;
+    }
+    InternalData::EntryIt it = found->second;
+    // A remote reference may still be outstanding; reclaimLocked() will
+    // pick the buffer up once it is dropped.
+    if (!it->mFree && buffer->refcount() == 0) {
+        mInternal->pushFreeLocked(it);
+    }
+    if (mInternal->mWaiters > 0) {
+        mInternal->mCondition.signal();
+    }
 }
 
 }  // namespace android
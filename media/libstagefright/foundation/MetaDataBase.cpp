@@ -79,11 +79,123 @@ struct MetaDataBase::Rect {
 };
 
 
+// Per-sample keys that extractors set on nearly every buffer and that
+// consumers read back for every buffer. These live in fixed inline slots
+// rather than in the sorted item map. Must be in ascending key order so
+// that iteration merges them with the map in key order.
+static constexpr uint32_t kHotKeys[] = {
+    kKeyIsCodecConfig,
+    kKeyCryptoMode,
+    kKeyDecodingTime,
+    kKeyDuration,
+    kKeyIsSyncFrame,
+    kKeyTargetTime,
+    kKeyTime,
+    kKeyValidSamples,
+};
+
+static constexpr size_t kNumHotKeys = sizeof(kHotKeys) / sizeof(kHotKeys[0]);
+
+static constexpr bool hotKeysAreSorted(size_t i = 1) {
+    return i >= kNumHotKeys ||
+            (kHotKeys[i - 1] < kHotKeys[i] && hotKeysAreSorted(i + 1));
+}
+
+static_assert(hotKeysAreSorted(), "kHotKeys must be in ascending order");
+static_assert(kNumHotKeys <= 8, "hot slot masks are 8 bits wide");
+
+static inline ssize_t hotSlotIndex(uint32_t key) {
+    switch (key) {
+        case kKeyIsCodecConfig: return 0;
+        case kKeyCryptoMode:    return 1;
+        case kKeyDecodingTime:  return 2;
+        case kKeyDuration:      return 3;
+        case kKeyIsSyncFrame:   return 4;
+        case kKeyTargetTime:    return 5;
+        case kKeyTime:          return 6;
+        case kKeyValidSamples:  return 7;
+        default:                return -1;
+    }
+}
+
 struct MetaDataBase::MetaDataInternal {
+    // Fixed storage for a hot key whose value fits in 8 bytes. A hot key set
+    // with a larger value spills into mItems instead.
+    struct HotSlot {
+        uint32_t mType;
+        uint32_t mSize;
+        union {
+            int64_t i64;
+            uint8_t bytes[8];
+        } u;
+    };
+
     std::mutex mLock;
+    uint8_t mHotPresent = 0;  // bit i set: mHot[i] holds kHotKeys[i]
+    uint8_t mHotSpilled = 0;  // bit i set: kHotKeys[i] is in mItems
+    HotSlot mHot[kNumHotKeys];
     KeyedVector<uint32_t, MetaDataBase::typed_data> mItems;
+
+    void copyItemsFrom(const MetaDataInternal &from) {
+        mHotPresent = from.mHotPresent;
+        mHotSpilled = from.mHotSpilled;
+        for (size_t i = 0; i < kNumHotKeys; ++i) {
+            if (mHotPresent & (1u << i)) {
+                mHot[i] = from.mHot[i];
+            }
+        }
+        mItems = from.mItems;
+    }
+
+    size_t numItems() const {
+        return mItems.size() + __builtin_popcount(mHotPresent);
+    }
+
+    // Calls fn(key, type, data, size) for every item in key order.
+    template <typename Fn>
+    void forEachItem(bool descending, Fn fn) const;
 };
 
+template <typename Fn>
+void MetaDataBase::MetaDataInternal::forEachItem(bool descending, Fn fn) const {
+    const size_t numMapItems = mItems.size();
+    size_t h = 0;
+    size_t i = 0;
+    for (;;) {
+        size_t hot = 0;
+        while (h < kNumHotKeys) {
+            hot = descending ? kNumHotKeys - 1 - h : h;
+            if (mHotPresent & (1u << hot)) {
+                break;
+            }
+            ++h;
+        }
+        const bool hotLeft = h < kNumHotKeys;
+        const bool mapLeft = i < numMapItems;
+        if (!hotLeft && !mapLeft) {
+            break;
+        }
+        const size_t item = descending ? numMapItems - 1 - i : i;
+        bool takeHot = hotLeft;
+        if (hotLeft && mapLeft) {
+            takeHot = descending ? kHotKeys[hot] > mItems.keyAt(item)
+                                 : kHotKeys[hot] < mItems.keyAt(item);
+        }
+        if (takeHot) {
+            const HotSlot &slot = mHot[hot];
+            fn(kHotKeys[hot], slot.mType, (const void *)slot.u.bytes, (size_t)slot.mSize);
+            ++h;
+        } else {
+            uint32_t type;
+            const void *data;
+            size_t size;
+            mItems.valueAt(item).getData(&type, &data, &size);
+            fn(mItems.keyAt(item), type, data, size);
+            ++i;
+        }
+    }
+}
+
 
 MetaDataBase::MetaDataBase()
     : mInternalData(new MetaDataInternal()) {
@@ -91,11 +203,13 @@ MetaDataBase::MetaDataBase()
 
 MetaDataBase::MetaDataBase(const MetaDataBase &from)
     : mInternalData(new MetaDataInternal()) {
-    mInternalData->mItems = from.mInternalData->mItems;
+    mInternalData->copyItemsFrom(*from.mInternalData);
 }
 
 MetaDataBase& MetaDataBase::operator = (const MetaDataBase &rhs) {
-    this->mInternalData->mItems = rhs.mInternalData->mItems;
+    if (this != &rhs) {
+        this->mInternalData->copyItemsFrom(*rhs.mInternalData);
+    }
     return *this;
 }
 
@@ -106,11 +220,26 @@ MetaDataBase::~MetaDataBase() {
 
 void MetaDataBase::clear() {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    mInternalData->mHotPresent = 0;
+    mInternalData->mHotSpilled = 0;
     mInternalData->mItems.clear();
 }
 
 bool MetaDataBase::remove(uint32_t key) {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    ssize_t hot = hotSlotIndex(key);
+    if (hot >= 0) {
+        const uint8_t bit = 1u << hot;
+        if (mInternalData->mHotPresent & bit) {
+            mInternalData->mHotPresent &= ~bit;
+            return true;
+        }
+        if (!(mInternalData->mHotSpilled & bit)) {
+            return false;
+        }
+        mInternalData->mHotSpilled &= ~bit;
+    }
+
     ssize_t i = mInternalData->mItems.indexOfKey(key);
 
     if (i < 0) {
@@ -256,14 +385,40 @@ bool MetaDataBase::findRect(
 bool MetaDataBase::setData(
         uint32_t key, uint32_t type, const void *data, size_t size) {
     bool overwrote_existing = true;
+    bool wasInline = false;
 
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    ssize_t hot = hotSlotIndex(key);
+    if (hot >= 0) {
+        const uint8_t bit = 1u << hot;
+        MetaDataInternal::HotSlot &slot = mInternalData->mHot[hot];
+        if (size <= sizeof(slot.u)) {
+            overwrote_existing = mInternalData->mHotPresent & bit;
+            if (mInternalData->mHotSpilled & bit) {
+                mInternalData->mItems.removeItem(key);
+                mInternalData->mHotSpilled &= ~bit;
+                overwrote_existing = true;
+            }
+            slot.mType = type;
+            slot.mSize = size;
+            if (size > 0) {
+                memmove(slot.u.bytes, data, size);
+            }
+            mInternalData->mHotPresent |= bit;
+            return overwrote_existing;
+        }
+        // Too large for the slot; keep it in the map.
+        wasInline = mInternalData->mHotPresent & bit;
+        mInternalData->mHotPresent &= ~bit;
+        mInternalData->mHotSpilled |= bit;
+    }
+
     ssize_t i = mInternalData->mItems.indexOfKey(key);
     if (i < 0) {
         typed_data item;
         i = mInternalData->mItems.add(key, item);
 
-        overwrote_existing = false;
+        overwrote_existing = wasInline;
     }
 
     typed_data &item = mInternalData->mItems.editValueAt(i);
@@ -276,6 +431,21 @@ bool MetaDataBase::setData(
 bool MetaDataBase::findData(uint32_t key, uint32_t *type,
                         const void **data, size_t *size) const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    ssize_t hot = hotSlotIndex(key);
+    if (hot >= 0) {
+        const uint8_t bit = 1u << hot;
+        if (mInternalData->mHotPresent & bit) {
+            const MetaDataInternal::HotSlot &slot = mInternalData->mHot[hot];
+            *type = slot.mType;
+            *data = slot.u.bytes;
+            *size = slot.mSize;
+            return true;
+        }
+        if (!(mInternalData->mHotSpilled & bit)) {
+            return false;
+        }
+    }
+
     ssize_t i = mInternalData->mItems.indexOfKey(key);
 
     if (i < 0) {
@@ -291,6 +461,17 @@ bool MetaDataBase::findData(uint32_t key, uint32_t *type,
 
 bool MetaDataBase::hasData(uint32_t key) const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
+    ssize_t hot = hotSlotIndex(key);
+    if (hot >= 0) {
+        const uint8_t bit = 1u << hot;
+        if (mInternalData->mHotPresent & bit) {
+            return true;
+        }
+        if (!(mInternalData->mHotSpilled & bit)) {
+            return false;
+        }
+    }
+
     ssize_t i = mInternalData->mItems.indexOfKey(key);
 
     if (i < 0) {
@@ -438,74 +619,72 @@ static void MakeFourCCString(uint32_t x, char *s) {
 String8 MetaDataBase::toString() const {
     String8 s;
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+    size_t remaining = mInternalData->numItems();
+    mInternalData->forEachItem(true /* descending */,
+            [&](uint32_t key, uint32_t type, const void *data, size_t size) {
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        typed_data item;
+        item.setData(type, data, size);
         s.appendFormat("%s: %s", cc, item.asString(false).string());
-        if (i != 0) {
+        if (--remaining != 0) {
             s.append(", ");
         }
-    }
+    });
     return s;
 }
 
 void MetaDataBase::dumpToLog() const {
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    for (int i = mInternalData->mItems.size(); --i >= 0;) {
-        int32_t key = mInternalData->mItems.keyAt(i);
+    mInternalData->forEachItem(true /* descending */,
+            [](uint32_t key, uint32_t type, const void *data, size_t size) {
         char cc[5];
         MakeFourCCString(key, cc);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
+        typed_data item;
+        item.setData(type, data, size);
         ALOGI("%s: %s", cc, item.asString(true /* verbose */).string());
-    }
+    });
 }
 
 #ifndef __ANDROID_VNDK__
 status_t MetaDataBase::writeToParcel(Parcel &parcel) {
     status_t ret;
     std::lock_guard<std::mutex> guard(mInternalData->mLock);
-    size_t numItems = mInternalData->mItems.size();
+    size_t numItems = mInternalData->numItems();
     ret = parcel.writeUint32(uint32_t(numItems));
     if (ret) {
         return ret;
     }
-    for (size_t i = 0; i < numItems; i++) {
-        int32_t key = mInternalData->mItems.keyAt(i);
-        const typed_data &item = mInternalData->mItems.valueAt(i);
-        uint32_t type;
-        const void *data;
-        size_t size;
-        item.getData(&type, &data, &size);
+    mInternalData->forEachItem(false /* descending */,
+            [&](uint32_t key, uint32_t type, const void *data, size_t size) {
+        if (ret) {
+            return;
+        }
         ret = parcel.writeInt32(key);
         if (ret) {
-            return ret;
+            return;
         }
         ret = parcel.writeUint32(type);
         if (ret) {
-            return ret;
+            return;
         }
         if (type == TYPE_NONE) {
             android::Parcel::WritableBlob blob;
             ret = parcel.writeUint32(static_cast<uint32_t>(size));
             if (ret) {
-                return ret;
+                return;
             }
             ret = parcel.writeBlob(size, false, &blob);
             if (ret) {
-                return ret;
+                return;
             }
             memcpy(blob.data(), data, size);
             blob.release();
         } else {
             ret = parcel.writeByteArray(size, (uint8_t*)data);
-            if (ret) {
-                return ret;
-            }
         }
-    }
-    return OK;
+    });
+    return ret;
 }
 
 status_t MetaDataBase::updateFromParcel(const Parcel &parcel) {
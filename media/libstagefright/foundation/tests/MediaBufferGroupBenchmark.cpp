@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Acquire/release throughput of a shared MediaBufferGroup with several
+// reader threads, as when multiple tracks of an extractor share a group.
+
+#include <benchmark/benchmark.h>
+
+#include <media/stagefright/MediaBufferGroup.h>
+
+using namespace android;
+
+static MediaBufferGroup *sGroup;
+
+// range(0): number of buffers in the group.
+// range(1): 1 to request sizes that cycle over the buffer size classes.
+static void BM_AcquireRelease(benchmark::State &state) {
+    const size_t numBuffers = state.range(0);
+    const bool sizeHints = state.range(1) != 0;
+    if (state.thread_index == 0) {
+        sGroup = new MediaBufferGroup;
+        // a mix of small and large buffers, e.g. audio plus 4K video
+        for (size_t i = 0; i < numBuffers; ++i) {
+            sGroup->add_buffer(MediaBufferBase::Create(i % 4 == 0 ? 1024 * 1024 : 2048));
+        }
+    }
+
+    size_t n = state.thread_index;
+    for (auto _ : state) {
+        const size_t requestedSize = !sizeHints ? 0 : (n++ % 4 == 0) ? 512 * 1024 : 1024;
+        MediaBufferBase *buffer;
+        if (sGroup->acquire_buffer(&buffer, false /* nonBlocking */, requestedSize) != OK) {
+            state.SkipWithError("acquire_buffer failed");
+            break;
+        }
+        benchmark::DoNotOptimize(buffer->data());
+        buffer->release();
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index == 0) {
+        delete sGroup;
+        sGroup = nullptr;
+    }
+}
+
+BENCHMARK(BM_AcquireRelease)
+        ->ArgNames({"buffers", "sizeHints"})
+        ->Args({4, 0})
+        ->Args({64, 0})
+        ->Args({64, 1})
+        ->ThreadRange(1, 8)
+        ->UseRealTime();
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <utils/Log.h>
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+#include <media/stagefright/MediaBufferGroup.h>
+
+namespace android {
+
+class MediaBufferGroupTest : public ::testing::Test {
+};
+
+TEST_F(MediaBufferGroupTest, SizeHints) {
+    MediaBufferGroup group;
+    group.add_buffer(MediaBufferBase::Create(100));
+    group.add_buffer(MediaBufferBase::Create(5000));
+    group.add_buffer(MediaBufferBase::Create(300));
+
+    MediaBufferBase *a, *b, *c, *d;
+    ASSERT_EQ(OK, group.acquire_buffer(&a, true /* nonBlocking */, 200));
+    EXPECT_EQ(300u, a->size());
+    ASSERT_EQ(OK, group.acquire_buffer(&b, true /* nonBlocking */, 1000));
+    EXPECT_EQ(5000u, b->size());
+    ASSERT_EQ(OK, group.acquire_buffer(&c, true /* nonBlocking */, 0));
+    EXPECT_EQ(100u, c->size());
+    EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&d, true /* nonBlocking */, 0));
+    EXPECT_FALSE(group.has_buffers());
+
+    b->release();
+    EXPECT_TRUE(group.has_buffers());
+    ASSERT_EQ(OK, group.acquire_buffer(&d, true /* nonBlocking */, 4000));
+    EXPECT_EQ(b, d);
+
+    a->release();
+    c->release();
+    d->release();
+    EXPECT_EQ(3u, group.buffers());
+}
+
+TEST_F(MediaBufferGroupTest, ReplacesSmallestWhenNothingFits) {
+    MediaBufferGroup group(2 /* growthLimit */);
+    group.add_buffer(MediaBufferBase::Create(100));
+
+    // a free buffer that is too small is replaced by a larger one
+    MediaBufferBase *a, *b;
+    ASSERT_EQ(OK, group.acquire_buffer(&a, true /* nonBlocking */, 1000));
+    EXPECT_EQ(1500u, a->size());
+    EXPECT_EQ(1u, group.buffers());
+
+    // with nothing free the group grows up to its limit
+    ASSERT_EQ(OK, group.acquire_buffer(&b, true /* nonBlocking */, 200));
+    EXPECT_EQ(300u, b->size());
+    EXPECT_EQ(2u, group.buffers());
+
+    MediaBufferBase *c;
+    EXPECT_EQ(WOULD_BLOCK, group.acquire_buffer(&c, true /* nonBlocking */, 0));
+
+    a->release();
+    b->release();
+}
+
+TEST_F(MediaBufferGroupTest, BlockingAcquireWakesOnRelease) {
+    MediaBufferGroup group(1 /* buffers */, 64 /* buffer_size */);
+    MediaBufferBase *a;
+    ASSERT_EQ(OK, group.acquire_buffer(&a));
+
+    std::thread releaser([a] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        a->release();
+    });
+    MediaBufferBase *b;
+    ASSERT_EQ(OK, group.acquire_buffer(&b));
+    EXPECT_EQ(a, b);
+    releaser.join();
+    b->release();
+}
+
+} // namespace android
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <utils/Log.h>
+
+#include "gtest/gtest.h"
+
+#include <media/stagefright/MetaDataBase.h>
+
+namespace android {
+
+class MetaDataBaseTest : public ::testing::Test {
+};
+
+TEST_F(MetaDataBaseTest, InlineKeys) {
+    MetaDataBase meta;
+    int64_t timeUs;
+    int32_t sync;
+
+    EXPECT_FALSE(meta.hasData(kKeyTime));
+    EXPECT_FALSE(meta.setInt64(kKeyTime, 1234));
+    EXPECT_TRUE(meta.setInt64(kKeyTime, 5678));
+    EXPECT_FALSE(meta.setInt32(kKeyIsSyncFrame, 1));
+    EXPECT_FALSE(meta.setInt32(kKeyWidth, 640));
+
+    ASSERT_TRUE(meta.findInt64(kKeyTime, &timeUs));
+    EXPECT_EQ(5678, timeUs);
+    ASSERT_TRUE(meta.findInt32(kKeyIsSyncFrame, &sync));
+    EXPECT_EQ(1, sync);
+    // type mismatches still fail on inline keys
+    EXPECT_FALSE(meta.findInt32(kKeyTime, &sync));
+
+    EXPECT_TRUE(meta.remove(kKeyTime));
+    EXPECT_FALSE(meta.remove(kKeyTime));
+    EXPECT_FALSE(meta.findInt64(kKeyTime, &timeUs));
+
+    meta.clear();
+    EXPECT_FALSE(meta.hasData(kKeyIsSyncFrame));
+    EXPECT_FALSE(meta.hasData(kKeyWidth));
+}
+
+TEST_F(MetaDataBaseTest, OversizedInlineKey) {
+    MetaDataBase meta;
+    const uint8_t big[16] = { 1, 2, 3 };
+    uint32_t type;
+    const void *data;
+    size_t size;
+    int64_t timeUs;
+
+    // a hot key set with a value too large for its slot must still round trip
+    EXPECT_FALSE(meta.setInt64(kKeyDuration, 10));
+    EXPECT_TRUE(meta.setData(kKeyDuration, 'blob', big, sizeof(big)));
+    ASSERT_TRUE(meta.findData(kKeyDuration, &type, &data, &size));
+    EXPECT_EQ((uint32_t)'blob', type);
+    ASSERT_EQ(sizeof(big), size);
+    EXPECT_EQ(0, memcmp(big, data, size));
+
+    EXPECT_TRUE(meta.setInt64(kKeyDuration, 20));
+    ASSERT_TRUE(meta.findInt64(kKeyDuration, &timeUs));
+    EXPECT_EQ(20, timeUs);
+    EXPECT_TRUE(meta.remove(kKeyDuration));
+    EXPECT_FALSE(meta.hasData(kKeyDuration));
+}
+
+TEST_F(MetaDataBaseTest, CopyAndToString) {
+    MetaDataBase meta;
+    meta.setInt32(kKeyWidth, 640);
+    meta.setInt64(kKeyTime, 33);
+    meta.setInt32(kKeyIsSyncFrame, 1);
+    meta.setCString(kKeyMIMEType, "video/avc");
+
+    MetaDataBase copy(meta);
+    int64_t timeUs;
+    ASSERT_TRUE(copy.findInt64(kKeyTime, &timeUs));
+    EXPECT_EQ(33, timeUs);
+
+    // items are listed in descending key order, inline keys included
+    EXPECT_STREQ("widt: (int32_t) 640, time: (int64_t) 33, "
+                 "sync: (int32_t) 1, mime: (char*) video/avc",
+                 copy.toString().string());
+}
+
+} // namespace android
@@ -51,6 +51,13 @@ private:
         kWhatSourceNotify = 'noti'
     };
 
+    enum {
+        kTSPacketSize = 188,
+        // Packets are written out once their access unit is complete,
+        // larger access units are written out this many packets at a time.
+        kMaxPacketsPerWrite = 256,
+    };
+
     struct SourceInfo;
 
     FILE *mFile;
@@ -72,11 +79,23 @@ private:
     int mPMTContinuityCounter;
     uint32_t mCrcTable[256];
 
+    // Packets not written out yet, see kMaxPacketsPerWrite.
+    sp<ABuffer> mPacketBuffer;
+
+    // PAT and PMT only change with the sources, they are built on start()
+    // and written out with their continuity counter patched in.
+    uint8_t mProgramAssociationTable[kTSPacketSize];
+    uint8_t mProgramMap[kTSPacketSize];
+
     void init();
 
     void writeTS();
+    void buildProgramAssociationTable();
+    void buildProgramMap();
     void writeProgramAssociationTable();
     void writeProgramMap();
+    uint8_t *allocPacket();
+    void flushPackets();
     void writeAccessUnit(int32_t sourceIndex, const sp<ABuffer> &buffer);
     void initCrcTable();
     uint32_t crc32(const uint8_t *start, size_t length);
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MPEG2TSWriterBenchmark"
+#include <utils/Log.h>
+
+#include <atomic>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MediaBuffer.h>
+#include <media/stagefright/MediaDefs.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/MediaSource.h>
+#include <media/stagefright/MetaData.h>
+#include <media/stagefright/MPEG2TSWriter.h>
+
+using namespace android;
+
+// Generates AVC access units of a fixed size, 60 per second.
+class SyntheticAVCSource : public MediaSource {
+  public:
+    SyntheticAVCSource(size_t accessUnitSize, size_t numAccessUnits)
+        : mAccessUnitSize(accessUnitSize), mNumAccessUnits(numAccessUnits) {}
+
+    sp<MetaData> getFormat() override {
+        sp<MetaData> meta = new MetaData;
+        meta->setCString(kKeyMIMEType, MEDIA_MIMETYPE_VIDEO_AVC);
+        meta->setInt32(kKeyWidth, 1920);
+        meta->setInt32(kKeyHeight, 1080);
+        return meta;
+    }
+
+    status_t start(MetaData * /* params */) override { return OK; }
+    status_t stop() override { return OK; }
+
+    status_t read(MediaBufferBase **buffer, const ReadOptions * /* options */) override {
+        if (mNumRead == mNumAccessUnits) {
+            return ERROR_END_OF_STREAM;
+        }
+        MediaBuffer *accessUnit = new MediaBuffer(mAccessUnitSize);
+        memset(accessUnit->data(), mNumRead & 0xff, mAccessUnitSize);
+        accessUnit->meta_data().setInt64(kKeyTime, mNumRead * 1000000LL / 60);
+        ++mNumRead;
+        *buffer = accessUnit;
+        return OK;
+    }
+
+  private:
+    const size_t mAccessUnitSize;
+    const size_t mNumAccessUnits;
+    size_t mNumRead = 0;
+};
+
+// Counts what the writer hands to its sink.
+struct Sink {
+    std::atomic<int64_t> bytes{0};
+    std::atomic<int64_t> writes{0};
+
+    static ssize_t write(void *cookie, const void * /* data */, size_t size) {
+        Sink *sink = static_cast<Sink *>(cookie);
+        sink->bytes += size;
+        ++sink->writes;
+        return size;
+    }
+};
+
+// Writes 300 access units of state.range(0) bytes, 50 Mbps at 60 fps is about 100 KiB.
+static void BM_MPEG2TSWriter(benchmark::State &state) {
+    const size_t accessUnitSize = state.range(0);
+    constexpr size_t kNumAccessUnits = 300;
+    int64_t bytes = 0;
+    int64_t writes = 0;
+
+    while (state.KeepRunning()) {
+        Sink sink;
+        sp<MPEG2TSWriter> writer = new MPEG2TSWriter(&sink, &Sink::write);
+        if (writer->addSource(new SyntheticAVCSource(accessUnitSize, kNumAccessUnits)) != OK ||
+            writer->start() != OK) {
+            state.SkipWithError("cannot start writer");
+            return;
+        }
+        while (!writer->reachedEOS()) {
+            usleep(1000);
+        }
+        writer->stop();
+        bytes += sink.bytes;
+        writes += sink.writes;
+    }
+
+    state.SetBytesProcessed(bytes);
+    state.counters["writesPerAccessUnit"] =
+            (double)writes / (state.iterations() * kNumAccessUnits);
+}
+
+BENCHMARK(BM_MPEG2TSWriter)->Arg(1024)->Arg(16 * 1024)->Arg(100 * 1024)->UseRealTime();
+
+BENCHMARK_MAIN();
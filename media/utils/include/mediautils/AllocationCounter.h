@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_ALLOCATION_COUNTER_H
+#define ANDROID_ALLOCATION_COUNTER_H
+
+#include <stdint.h>
+
+#include <benchmark/benchmark.h>
+
+namespace android {
+
+// Returns the number of allocations made through operator new by the whole process, including
+// the libraries it uses. Only for benchmarks: linking libmediautils_allocationcounter replaces
+// the global operator new and delete.
+uint64_t getAllocationCount();
+
+// Reports the allocations made since its construction as the "allocs/op" counter of a benchmark.
+class AllocationCounter {
+public:
+    AllocationCounter() : mStart(getAllocationCount()) {}
+
+    void report(benchmark::State& state) const {
+        state.counters["allocs/op"] = benchmark::Counter(
+                getAllocationCount() - mStart, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    const uint64_t mStart;
+};
+
+} // namespace android
+
+#endif // ANDROID_ALLOCATION_COUNTER_H
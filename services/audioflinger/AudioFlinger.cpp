@@ -23,6 +23,7 @@
 #define AUDIO_ARRAYS_STATIC_CHECK 1
 
 #include "Configuration.h"
+#include <algorithm>
 #include <dirent.h>
 #include <math.h>
 #include <signal.h>
@@ -171,6 +172,7 @@ std::string formatToString(audio_format_t format) {
 AudioFlinger::AudioFlinger()
     : BnAudioFlinger(),
       mMediaLogNotifier(new AudioFlinger::MediaLogNotifier()),
+      mIdleClientReaper(new AudioFlinger::IdleClientReaper(this)),
       mPrimaryHardwareDev(NULL),
       mAudioHwDevs(NULL),
       mHardwareStatus(AUDIO_HW_IDLE),
@@ -210,6 +212,7 @@ AudioFlinger::AudioFlinger()
     mEffectsFactoryHal = EffectsFactoryHalInterface::create();
 
     mMediaLogNotifier->run("MediaLogNotifier");
+    mIdleClientReaper->run("IdleClientReaper");
     std::vector<pid_t> halPids;
     mDevicesFactoryHal->getHalPids(&halPids);
     TimeCheck::setAudioHalPids(halPids);
@@ -476,7 +479,9 @@ void AudioFlinger::dumpClients(int fd, const Vector<String16>& args __unused)
     for (size_t i = 0; i < mClients.size(); ++i) {
         sp<Client> client = mClients.valueAt(i).promote();
         if (client != 0) {
-            result.appendFormat("  pid: %d\n", client->pid());
+            result.appendFormat("  pid: %d", client->pid());
+            client->dumpTrackMemoryPool(result);
+            result.append("\n");
         }
     }
 
@@ -513,6 +518,7 @@ void AudioFlinger::dumpInternals(int fd, const Vector<String16>& args __unused)
                             hardwareStatus,
                             (uint32_t)(mStandbyTimeInNsecs / 1000000));
     result.append(buffer);
+    result.appendFormat("Track create latency: %s\n", mTrackCreateLatencies.toString().c_str());
     write(fd, result.string(), result.size());
 }
 
@@ -570,6 +576,10 @@ status_t AudioFlinger::dump(int fd, const Vector<String16>& args)
             write(fd, result.string(), result.size());
         }
 
+        if (clientLocked) {
+            // so that the dump does not list clients that are only kept past their retention
+            pruneIdleClients_l();
+        }
         dumpClients(fd, args);
         if (clientLocked) {
             mClientLock.unlock();
@@ -671,6 +681,7 @@ status_t AudioFlinger::dump(int fd, const Vector<String16>& args)
 sp<AudioFlinger::Client> AudioFlinger::registerPid(pid_t pid)
 {
     Mutex::Autolock _cl(mClientLock);
+    pruneIdleClients_l();
     // If pid is already in the mClients wp<> map, then use that entry
     // (for which promote() is always != 0), otherwise create a new entry and Client.
     sp<Client> client = mClients.valueFor(pid).promote();
@@ -743,6 +754,7 @@ sp<IAudioTrack> AudioFlinger::createTrack(const CreateTrackInput& input,
                                           CreateTrackOutput& output,
                                           status_t *status)
 {
+    const nsecs_t createStartNs = systemTime();
     sp<PlaybackThread::Track> track;
     sp<TrackHandle> trackHandle;
     sp<Client> client;
@@ -1001,6 +1013,7 @@ sp<IAudioTrack> AudioFlinger::createTrack(const CreateTrackInput& input,
 
     // return handle to client
     trackHandle = new TrackHandle(track);
+    mTrackCreateLatencies.add(systemTime() - createStartNs);
 
 Exit:
     if (lStatus != NO_ERROR && output.outputId != AUDIO_IO_HANDLE_NONE) {
@@ -1812,6 +1825,8 @@ void AudioFlinger::removeNotificationClient(pid_t pid)
         {
             Mutex::Autolock _cl(mClientLock);
             mNotificationClients.removeItem(pid);
+            // the process is gone, its pooled track memory will not be used again
+            mIdleClients.remove(pid);
         }
 
         ALOGV("%d died, releasing its sessions", pid);
@@ -1860,6 +1875,32 @@ void AudioFlinger::removeClient_l(pid_t pid)
     mClients.removeItem(pid);
 }
 
+// retainIdleClient_l() must be called with AudioFlinger::mClientLock held
+void AudioFlinger::retainIdleClient_l(const sp<Client>& client)
+{
+    if (!client->hasPooledTrackMemory()) return;
+    const nsecs_t nextExpiry = mIdleClients.retain(client->pid(), client, systemTime());
+    if (nextExpiry != 0) {
+        mIdleClientReaper->requestPrune(nextExpiry);
+    }
+}
+
+// pruneIdleClients_l() must be called with AudioFlinger::mClientLock held
+void AudioFlinger::pruneIdleClients_l()
+{
+    // may destroy Clients, which requires mClientLock
+    const nsecs_t nextExpiry = mIdleClients.prune(systemTime());
+    if (nextExpiry != 0) {
+        mIdleClientReaper->requestPrune(nextExpiry);
+    }
+}
+
+void AudioFlinger::pruneIdleClients()
+{
+    Mutex::Autolock _cl(mClientLock);
+    pruneIdleClients_l();
+}
+
 // getEffectThread_l() must be called with AudioFlinger::mLock held
 sp<AudioFlinger::ThreadBase> AudioFlinger::getEffectThread_l(audio_session_t sessionId,
         int effectId)
@@ -1974,11 +2015,12 @@ String8 AudioFlinger::setDefaultDev(bool input, const String8& devName, bool nee
 AudioFlinger::Client::Client(const sp<AudioFlinger>& audioFlinger, pid_t pid)
     :   RefBase(),
         mAudioFlinger(audioFlinger),
-        mPid(pid)
-{
-    mMemoryDealer = new MemoryDealer(
+        mMemoryDealer(new MemoryDealer(
             audioFlinger->getClientSharedHeapSize(),
-            (std::string("AudioFlinger::Client(") + std::to_string(pid) + ")").c_str());
+            (std::string("AudioFlinger::Client(") + std::to_string(pid) + ")").c_str())),
+        mPid(pid),
+        mTrackMemory(mMemoryDealer)
+{
 }
 
 // Client destructor must be called with AudioFlinger::mClientLock held
@@ -1992,6 +2034,56 @@ sp<MemoryDealer> AudioFlinger::Client::heap() const
     return mMemoryDealer;
 }
 
+sp<IMemory> AudioFlinger::Client::allocateTrackMemory(size_t size)
+{
+    return mTrackMemory.allocate(size);
+}
+
+void AudioFlinger::Client::releaseTrackMemory(sp<IMemory>& memory)
+{
+    mTrackMemory.release(memory);
+}
+
+bool AudioFlinger::Client::hasPooledTrackMemory() const
+{
+    return mTrackMemory.pooledBytes() != 0;
+}
+
+void AudioFlinger::Client::dumpTrackMemoryPool(String8& result) const
+{
+    mTrackMemory.dump(result);
+}
+
+// ----------------------------------------------------------------------------
+
+void AudioFlinger::TrackCreateLatencies::add(nsecs_t latencyNs)
+{
+    Mutex::Autolock _l(mLock);
+    mSamples[mCount++ % kMaxSamples] = latencyNs;
+}
+
+std::string AudioFlinger::TrackCreateLatencies::toString() const
+{
+    std::vector<nsecs_t> samples;
+    uint64_t count;
+    {
+        Mutex::Autolock _l(mLock);
+        count = mCount;
+        samples.assign(mSamples, mSamples + std::min<uint64_t>(mCount, kMaxSamples));
+    }
+    if (samples.empty()) return "none";
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](size_t p) {
+        return samples[(samples.size() - 1) * p / 100] * 1e-6;
+    };
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer),
+            "%llu created, last %zu: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms",
+            (unsigned long long)count, samples.size(),
+            percentile(50), percentile(90), percentile(99), samples.back() * 1e-6);
+    return buffer;
+}
+
 // ----------------------------------------------------------------------------
 
 AudioFlinger::NotificationClient::NotificationClient(const sp<AudioFlinger>& audioFlinger,
@@ -2044,6 +2136,40 @@ bool AudioFlinger::MediaLogNotifier::threadLoop() {
     return true;
 }
 
+AudioFlinger::IdleClientReaper::IdleClientReaper(AudioFlinger* audioFlinger)
+    : mAudioFlinger(audioFlinger), mPruneTime(0) {}
+
+void AudioFlinger::IdleClientReaper::requestPrune(nsecs_t when) {
+    AutoMutex _l(mMutex);
+    if (mPruneTime != 0 && mPruneTime <= when) {
+        return;
+    }
+    mPruneTime = when;
+    mCond.signal();
+}
+
+bool AudioFlinger::IdleClientReaper::threadLoop() {
+    // Wait until the pending prune is due
+    {
+        AutoMutex _l(mMutex);
+        for (;;) {
+            if (mPruneTime == 0) {
+                mCond.wait(mMutex);
+                continue;
+            }
+            const nsecs_t now = systemTime();
+            if (now >= mPruneTime) {
+                break;
+            }
+            mCond.waitRelative(mMutex, mPruneTime - now);
+        }
+        mPruneTime = 0;
+    }
+    // Takes mClientLock, so mMutex must not be held; requests the next prune if clients remain
+    mAudioFlinger->pruneIdleClients();
+    return true;
+}
+
 void AudioFlinger::requestLogMerge() {
     mMediaLogNotifier->requestMerge();
 }
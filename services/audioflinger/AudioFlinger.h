@@ -83,11 +83,15 @@
 #include "FastCapture.h"
 #include "FastMixer.h"
 #include <media/nbaio/NBAIO.h>
+#include <media/nbaio/Pipe.h>
 #include "AudioWatchdog.h"
 #include "AudioStreamOut.h"
 #include "SpdifStreamOut.h"
 #include "AudioHwDevice.h"
 #include "NBAIO_Tee.h"
+#include "SharedMixCursor.h"
+#include "SharedRecordConverter.h"
+#include "ClientTrackMemory.h"
 #include "ThreadMetrics.h"
 #include "TrackMetrics.h"
 
@@ -481,12 +485,37 @@ private:
         pid_t               pid() const { return mPid; }
         sp<AudioFlinger>    audioFlinger() const { return mAudioFlinger; }
 
+        // Allocates the control block and buffer of a track from the client heap,
+        // see TrackMemoryPool.
+        sp<IMemory>         allocateTrackMemory(size_t size);
+        // Returns the memory of a destroyed track to the pool when the client process
+        // no longer references it, otherwise frees it. Clears 'memory'.
+        void                releaseTrackMemory(sp<IMemory>& memory);
+        bool                hasPooledTrackMemory() const;
+        void                dumpTrackMemoryPool(String8& result) const;
+
     private:
         DISALLOW_COPY_AND_ASSIGN(Client);
 
         const sp<AudioFlinger> mAudioFlinger;
-              sp<MemoryDealer> mMemoryDealer;
+        const sp<MemoryDealer> mMemoryDealer;
         const pid_t         mPid;
+        // Declared after mMemoryDealer so that the pooled memory is freed before the heap.
+        TrackMemoryPool     mTrackMemory;
+    };
+
+    // Latency of the recent successful createTrack() calls.
+    class TrackCreateLatencies {
+    public:
+        void                add(nsecs_t latencyNs);
+        std::string         toString() const;
+
+    private:
+        static constexpr size_t kMaxSamples = 256;
+
+        mutable Mutex       mLock;
+        uint64_t            mCount = 0;     // total number of samples added
+        nsecs_t             mSamples[kMaxSamples];
     };
 
     // --- Notification Client ---
@@ -543,6 +572,32 @@ private:
 
     const sp<MediaLogNotifier> mMediaLogNotifier;
 
+    // --- IdleClientReaper ---
+    // Thread in charge of releasing the idle clients once their retention time is over, so that
+    // their pooled track memory is not held until the next client activity happens to prune them.
+    class IdleClientReaper : public Thread {
+    public:
+        explicit IdleClientReaper(AudioFlinger* audioFlinger);
+
+        // Requests a prune at the given time. It's ignored if an earlier one is already pending,
+        // as that prune requests the next one.
+        void requestPrune(nsecs_t when);
+    private:
+        // Every iteration blocks until the pending prune is due, then prunes the idle clients.
+        virtual bool threadLoop() override;
+
+        AudioFlinger* const mAudioFlinger;  // lives as long as audioserver
+
+        nsecs_t mPruneTime;  // 0 if no prune is pending
+
+        // Mutex and condition variable around mPruneTime's value.
+        // Never held while taking AudioFlinger::mClientLock.
+        Mutex       mMutex;
+        Condition   mCond;
+    };
+
+    const sp<IdleClientReaper> mIdleClientReaper;
+
     // This is a helper that is called during incoming binder calls.
     void requestLogMerge();
 
@@ -763,6 +818,11 @@ using effect_buffer_t = int16_t;
 
 
                 void        removeClient_l(pid_t pid);
+                // Keeps an idle client alive for a while so that its pooled track memory
+                // can serve its next track. Must be called with mClientLock held.
+                void        retainIdleClient_l(const sp<Client>& client);
+                void        pruneIdleClients_l();
+                void        pruneIdleClients();
                 void        removeNotificationClient(pid_t pid);
                 bool isNonOffloadableGlobalEffectEnabled_l();
                 void onNonOffloadableGlobalEffectEnable();
@@ -837,6 +897,13 @@ using effect_buffer_t = int16_t;
     mutable     Mutex                               mClientLock;
                 // protected by mClientLock
                 DefaultKeyedVector< pid_t, wp<Client> >     mClients;   // see ~Client()
+                // Clients with pooled track memory, protected by mClientLock.
+                static constexpr nsecs_t kIdleClientRetentionNs = 10 * 1000000000LL;
+                static constexpr size_t kMaxIdleClients = 16;
+                IdleClients<Client>                 mIdleClients{kIdleClientRetentionNs,
+                                                                 kMaxIdleClients};
+
+                TrackCreateLatencies                mTrackCreateLatencies;
 
                 mutable     Mutex                   mHardwareLock;
                 // NOTE: If both mLock and mHardwareLock mutexes must be held,
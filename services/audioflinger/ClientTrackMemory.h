@@ -0,0 +1,214 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_AUDIO_CLIENT_TRACK_MEMORY_H
+#define ANDROID_AUDIO_CLIENT_TRACK_MEMORY_H
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <android-base/macros.h>
+#include <binder/IMemory.h>
+#include <binder/MemoryDealer.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * Track memory of an AudioFlinger client, allocated from the client heap.
+ * The memory of destroyed tracks is kept in power-of-two size classes and handed out again,
+ * so that short-lived tracks neither go through the heap allocator nor fragment the heap.
+ */
+class TrackMemoryPool {
+public:
+    // Smallest and largest pooled size classes, and the share of the heap the pool may keep.
+    static constexpr size_t kMinSizeClass = 1024;
+    static constexpr size_t kMaxSizeClassHeapFraction = 8;  // largest class: heap size / 8
+    static constexpr size_t kPoolHeapFraction = 4;          // pool budget: heap size / 4
+    static constexpr size_t kMaxFreePerClass = 4;
+
+    explicit TrackMemoryPool(const sp<MemoryDealer>& heap) : mHeap(heap) {}
+
+    // Returns the size class of a track memory size, 0 on overflow.
+    static size_t sizeClass(size_t size) {
+        size_t sizeClass = kMinSizeClass;
+        while (sizeClass < size) {
+            if (sizeClass > SIZE_MAX / 2) return 0;
+            sizeClass <<= 1;
+        }
+        return sizeClass;
+    }
+
+    // Allocates the control block and buffer of a track, from the pool if possible.
+    sp<IMemory> allocate(size_t size) {
+        const size_t heapSize = mHeap->getMemoryHeap()->getSize();
+        size_t pooledSize = sizeClass(size);
+        if (pooledSize > heapSize / kMaxSizeClassHeapFraction) {
+            pooledSize = 0; // not pooled
+        }
+
+        Mutex::Autolock _l(mLock);
+        mAllocations++;
+        if (pooledSize != 0) {
+            auto it = mFree.find(pooledSize);
+            if (it != mFree.end() && !it->second.empty()) {
+                sp<IMemory> memory = it->second.back();
+                it->second.pop_back();
+                mFreeBytes -= pooledSize;
+                mRecycled++;
+                return memory;
+            }
+        }
+        sp<IMemory> memory;
+        if (pooledSize != 0) {
+            memory = mHeap->allocate(pooledSize);
+        }
+        if (memory == 0) {
+            // The pool or the rounding up may be what prevents the allocation.
+            trim_l();
+            memory = mHeap->allocate(size);
+        }
+        return memory;
+    }
+
+    // Returns the memory of a destroyed track to the pool when the client process no longer
+    // references it, otherwise frees it. Clears 'memory'.
+    void release(sp<IMemory>& memory) {
+        sp<IMemory> released = memory;
+        memory.clear();
+        if (released == 0) return;
+        const size_t size = released->size();
+        // A reference held by the client process keeps a strong reference on the binder
+        // object: only pool memory that nobody else can access anymore.
+        if (sizeClass(size) != size || released->getStrongCount() != 1) return;
+
+        Mutex::Autolock _l(mLock);
+        const size_t budget = mHeap->getMemoryHeap()->getSize() / kPoolHeapFraction;
+        std::vector<sp<IMemory>>& pool = mFree[size];
+        if (pool.size() >= kMaxFreePerClass || mFreeBytes + size > budget) {
+            return;
+        }
+        pool.push_back(released);
+        mFreeBytes += size;
+    }
+
+    size_t pooledBytes() const {
+        Mutex::Autolock _l(mLock);
+        return mFreeBytes;
+    }
+
+    uint64_t recycled() const {
+        Mutex::Autolock _l(mLock);
+        return mRecycled;
+    }
+
+    void dump(String8& result) const {
+        Mutex::Autolock _l(mLock);
+        result.appendFormat(" track memory: %llu allocations, %llu recycled, %zu bytes pooled",
+                (unsigned long long)mAllocations, (unsigned long long)mRecycled, mFreeBytes);
+    }
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(TrackMemoryPool);
+
+    void trim_l() {
+        mFree.clear();
+        mFreeBytes = 0;
+    }
+
+    const sp<MemoryDealer>  mHeap;
+
+    mutable Mutex           mLock;
+    // Free track memory by size class
+    std::map<size_t, std::vector<sp<IMemory>>> mFree;
+    size_t                  mFreeBytes = 0;
+    uint64_t                mAllocations = 0;
+    uint64_t                mRecycled = 0;
+};
+
+/**
+ * Clients kept alive while idle, so that their pooled track memory can serve their next track.
+ * A client is kept for a retention time after it was last retained, and only the most recently
+ * retained ones are kept beyond a maximum number of clients.
+ * Not thread safe: releasing a client destroys it if nothing else references it, so the owner
+ * calls every method with the lock the client destructor requires.
+ */
+template <typename ClientT>
+class IdleClients {
+public:
+    IdleClients(nsecs_t retentionNs, size_t maxClients)
+        : mRetentionNs(retentionNs), mMaxClients(maxClients) {}
+
+    // Keeps 'client' until 'now' plus the retention time, then prunes, see prune().
+    nsecs_t retain(pid_t pid, const sp<ClientT>& client, nsecs_t now) {
+        mClients[pid] = std::make_pair(client, now);
+        return prune(now);
+    }
+
+    // Releases a client, e.g. because its process died.
+    void remove(pid_t pid) { mClients.erase(pid); }
+
+    /* Releases the clients whose retention time is over at 'now', and the least recently
+     * retained one above the maximum number of clients.
+     * Returns the time the next client expires, 0 if no client is left.
+     */
+    nsecs_t prune(nsecs_t now) {
+        auto oldest = mClients.end();
+        for (auto it = mClients.begin(); it != mClients.end(); ) {
+            if (now - it->second.second >= mRetentionNs) {
+                // may destroy the client
+                it = mClients.erase(it);
+                continue;
+            }
+            if (oldest == mClients.end() || it->second.second < oldest->second.second) {
+                oldest = it;
+            }
+            ++it;
+        }
+        if (mClients.size() > mMaxClients) {
+            mClients.erase(oldest);
+        }
+        if (mClients.empty()) {
+            return 0;
+        }
+        nsecs_t nextExpiry = INT64_MAX;
+        for (const auto& client : mClients) {
+            nextExpiry = std::min(nextExpiry, client.second.second + mRetentionNs);
+        }
+        return nextExpiry;
+    }
+
+    bool contains(pid_t pid) const { return mClients.count(pid) != 0; }
+    size_t size() const { return mClients.size(); }
+
+private:
+    const nsecs_t   mRetentionNs;
+    const size_t    mMaxClients;
+    // Client and the time it was last retained, by pid
+    std::map<pid_t, std::pair<sp<ClientT>, nsecs_t>> mClients;
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_CLIENT_TRACK_MEMORY_H
@@ -326,7 +326,8 @@ public:
                                 audio_format_t format,
                                 audio_channel_mask_t channelMask,
                                 size_t frameCount,
-                                uid_t uid);
+                                uid_t uid,
+                                const sp<Pipe>& sharedMix = nullptr);
     virtual             ~OutputTrack();
 
     virtual status_t    start(AudioSystem::sync_event_t event =
@@ -334,6 +335,13 @@ public:
                              audio_session_t triggerSession = AUDIO_SESSION_NONE);
     virtual void        stop();
             ssize_t     write(void* data, uint32_t frames);
+            // Shared mix mode: the duplicating thread has already written 'frames' frames of mix
+            // to the shared Pipe starting at stream position 'position'; only the frame count is
+            // queued here and the downstream mixer reads the Pipe in place.
+            // Returns the number of frames queued, frames that could not be queued are dropped.
+            ssize_t     writeShared(uint32_t frames, int64_t position);
+            bool        usesSharedMix() const { return mSharedMix != nullptr; }
+            uint64_t    sharedMixFramesDropped() const { return mSharedMix->framesDropped(); }
             bool        bufferQueueEmpty() const { return mBufferQueue.size() == 0; }
             bool        isActive() const { return mActive; }
     const wp<ThreadBase>& thread() const { return mThread; }
@@ -354,6 +362,10 @@ public:
                             return timestamp;
                         }
 
+protected:
+    // AudioBufferProvider interface
+    status_t getNextBuffer(AudioBufferProvider::Buffer* buffer) override;
+
 private:
     status_t            obtainBuffer(AudioBufferProvider::Buffer* buffer,
                                      uint32_t waitTimeMs);
@@ -370,6 +382,9 @@ private:
     DuplicatingThread* const    mSourceThread; // for waitTimeMs() in write()
     sp<AudioTrackClientProxy>   mClientProxy;
 
+    // Shared mix mode, see writeShared(). Null when the track has its own buffer.
+    const std::unique_ptr<SharedMixCursor> mSharedMix;
+
     /** Attributes of the source tracks.
      *
      * This member must be accessed with mTrackMetadatasMutex taken.
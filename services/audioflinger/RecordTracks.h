@@ -143,6 +143,11 @@ private:
 
             // used by the record thread to convert frames to proper destination format
             RecordBufferConverter              *mRecordBufferConverter;
+
+            // if set, used instead of mRecordBufferConverter, with the track read position
+            // in the converted frames
+            sp<SharedRecordConverter>          mSharedConverter;
+            int64_t                            mSharedConverterFront;
             audio_input_flags_t                mFlags;
 
             bool                               mSilenced;
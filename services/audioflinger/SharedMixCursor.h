@@ -0,0 +1,92 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_AUDIO_SHARED_MIX_CURSOR_H
+#define ANDROID_AUDIO_SHARED_MIX_CURSOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <media/nbaio/Pipe.h>
+
+namespace android {
+
+/**
+ * Position bookkeeping of an OutputTrack reading the DuplicatingThread mix in place.
+ *
+ * The track control block only carries frame counts: frame 'position' of the control block
+ * is frame 'position + offset' of the mix. The offset is set by the writer when the first
+ * frames are queued, and after frames had to be dropped it is only changed again once the
+ * reader has drained the control block, so that every queued frame keeps a single mapping.
+ */
+class SharedMixCursor {
+public:
+    explicit SharedMixCursor(const sp<Pipe>& mix) : mMix(mix) {}
+
+    const sp<Pipe>& mix() const { return mMix; }
+
+    // Writer side, before queueing 'frames' frames written to the mix at stream position
+    // 'position'. 'rear' is the control block rear and 'framesReady' the frames queued but
+    // not yet read. Returns false if the frames must be dropped, the reader is still
+    // draining frames queued before a drop.
+    bool beginWrite(int64_t position, int32_t rear, size_t framesReady, uint32_t frames) {
+        if (mResync) {
+            if (framesReady != 0) {
+                mFramesDropped += frames;
+                return false;
+            }
+            mOffset.store((uint32_t)position - (uint32_t)rear, std::memory_order_release);
+            mResync = false;
+        }
+        return true;
+    }
+
+    // Writer side, 'frames' frames written to the mix could not be queued.
+    void dropped(uint32_t frames) {
+        mFramesDropped += frames;
+        mResync = true;
+    }
+
+    // Reader side, index in the mix of control block position 'front'.
+    size_t index(uint32_t front) const {
+        return (front + mOffset.load(std::memory_order_acquire)) & (mMix->maxFrames() - 1);
+    }
+
+    // Reader side, frames that can be read in place starting at control block position
+    // 'front', at most 'desired' and without wrapping around the end of the mix.
+    size_t contiguousFrames(uint32_t front, uint32_t rear, size_t desired) const {
+        return std::min({desired, (size_t)(rear - front), mMix->maxFrames() - index(front)});
+    }
+
+    void* address(size_t index, size_t frameSize) const {
+        return (int8_t *)mMix->buffer() + index * frameSize;
+    }
+
+    uint64_t framesDropped() const { return mFramesDropped; }
+
+private:
+    const sp<Pipe>          mMix;
+    std::atomic<uint32_t>   mOffset{0};
+    bool                    mResync = true;     // writer only: offset must be recomputed
+    std::atomic<uint64_t>   mFramesDropped{0};
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_SHARED_MIX_CURSOR_H
@@ -0,0 +1,306 @@
+/*
+**
+** Copyright 2026, The Android Open Source Project
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef ANDROID_AUDIO_SHARED_RECORD_CONVERTER_H
+#define ANDROID_AUDIO_SHARED_RECORD_CONVERTER_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <android-base/macros.h>
+#include <log/log.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioResamplerPublic.h>
+#include <media/RecordBufferConverter.h>
+#include <system/audio.h>
+#include <utils/RefBase.h>
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * Supplies the frames converted by a SharedRecordConverter. The RecordThread implements it
+ * with a ResamplerBufferProvider reading the thread buffer.
+ */
+class SharedRecordSource : public AudioBufferProvider {
+public:
+    // skips the frames available so far
+    virtual void reset() = 0;
+
+    // returns the frames available to getNextBuffer(), and whether frames were lost since
+    // the previous call
+    virtual void sync(size_t *framesAvailable, bool *hasOverrun) = 0;
+};
+
+/**
+ * Converts the RecordThread data once for all the RecordTracks with the same sample rate,
+ * format and channel mask.
+ * Converted frames are kept in a ring buffer that each RecordTrack reads at its own position,
+ * so a client that does not keep up overruns without holding back the other clients.
+ * Accessed from the RecordThread loop only, except for the statistics.
+ */
+class SharedRecordConverter : public RefBase {
+public:
+    SharedRecordConverter(std::unique_ptr<SharedRecordSource> source,
+            audio_channel_mask_t srcChannelMask, audio_format_t srcFormat,
+            uint32_t srcSampleRate, size_t srcFrames,
+            audio_channel_mask_t channelMask, audio_format_t format, uint32_t sampleRate)
+        : mChannelMask(channelMask),
+          mFormat(format),
+          mSampleRate(sampleRate),
+          mSrcSampleRate(srcSampleRate),
+          mSource(std::move(source)),
+          mConverter(srcChannelMask, srcFormat, srcSampleRate, channelMask, format, sampleRate),
+          mFrameSize(audio_bytes_per_frame(audio_channel_count_from_in_mask(channelMask), format)),
+          // as many frames as the source holds, so that a track overruns about when it
+          // would have overrun reading from the source
+          mFrames(destinationFramesPossible(srcFrames, srcSampleRate, sampleRate)) {
+        if (mConverter.initCheck() != NO_ERROR || mFrames == 0) {
+            ALOGE("%s: unable to convert to %#x %#x %u Hz",
+                    __func__, channelMask, format, sampleRate);
+            return;
+        }
+        mBuffer.reset(new uint8_t[mFrames * mFrameSize]);
+        mSource->reset();
+    }
+
+    status_t initCheck() const { return mBuffer != nullptr ? NO_ERROR : NO_INIT; }
+
+    // true if the converter produces frames for the given configuration
+    bool matches(audio_channel_mask_t channelMask, audio_format_t format,
+            uint32_t sampleRate) const {
+        return channelMask == mChannelMask && format == mFormat && sampleRate == mSampleRate;
+    }
+
+    // returns the position from which a newly added RecordTrack reads
+    int64_t attach() const { return mRear; }
+
+    // converts the frames made available by the source since the previous call
+    void process() {
+        const nsecs_t startNs = systemTime(SYSTEM_TIME_THREAD);
+        size_t framesIn;
+        bool hasOverrun;
+        mSource->sync(&framesIn, &hasOverrun);
+        if (hasOverrun) {
+            // the RecordThread did not run for longer than its buffer, all tracks miss data
+            mOverruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        size_t framesOut = std::min(mFrames,
+                destinationFramesPossible(framesIn, mSrcSampleRate, mSampleRate));
+        while (framesOut > 0) {
+            // convert up to the end of the ring buffer, then wrap around
+            const size_t offset = mRear % mFrames;
+            const size_t frames = std::min(framesOut, mFrames - offset);
+            const size_t converted = mConverter.convert(
+                    mBuffer.get() + offset * mFrameSize, mSource.get(), frames);
+            mRear += converted;
+            mFramesConverted.fetch_add(converted, std::memory_order_relaxed);
+            if (converted < frames) {
+                break;
+            }
+            framesOut -= converted;
+        }
+        mCpuTimeNs.fetch_add(systemTime(SYSTEM_TIME_THREAD) - startNs,
+                std::memory_order_relaxed);
+    }
+
+    /* Synchronizes a RecordTrack read position with the converter, like
+     * ResamplerBufferProvider::sync().
+     *
+     * Parameters
+     *           front:  RecordTrack read position, updated on overrun.
+     * framesAvailable:  returns the converted frames available to the RecordTrack.
+     *      hasOverrun:  returns true if the RecordTrack has overrun.
+     */
+    void sync(int64_t *front, size_t *framesAvailable, bool *hasOverrun) const {
+        const int64_t filled = mRear - *front;
+        bool overrun = false;
+        size_t framesIn;
+        if (filled < 0) {
+            // should not happen, but treat like a massive overrun and re-sync
+            framesIn = 0;
+            *front = mRear;
+            overrun = true;
+        } else if ((uint64_t) filled <= mFrames) {
+            framesIn = (size_t) filled;
+        } else {
+            // client is not keeping up with server, but give it latest data
+            framesIn = mFrames;
+            *front = mRear - mFrames;
+            overrun = true;
+        }
+        *framesAvailable = framesIn;
+        *hasOverrun = overrun;
+    }
+
+    // copies up to frames converted frames from front to dst and advances front.
+    // Returns the number of frames copied.
+    size_t read(void *dst, size_t frames, int64_t *front) const {
+        ALOG_ASSERT(*front <= mRear && mRear - *front <= (int64_t) mFrames);
+        frames = std::min(frames, (size_t) (mRear - *front));
+        const size_t offset = *front % mFrames;
+        const size_t part1 = std::min(frames, mFrames - offset);
+        memcpy(dst, mBuffer.get() + offset * mFrameSize, part1 * mFrameSize);
+        memcpy((uint8_t *) dst + part1 * mFrameSize, mBuffer.get(),
+                (frames - part1) * mFrameSize);
+        *front += frames;
+        return frames;
+    }
+
+    void dump(String8& result) const {
+        result.appendFormat("    %#x %#x %u Hz: %zu track(s), %lld frames, cpu %.3f ms, "
+                "%lld overrun(s)\n",
+                mChannelMask, mFormat, mSampleRate, mTrackCount,
+                (long long) framesConverted(), cpuTimeNs() * 1e-6,
+                (long long) mOverruns.load(std::memory_order_relaxed));
+    }
+
+    int64_t framesConverted() const { return mFramesConverted.load(std::memory_order_relaxed); }
+    int64_t cpuTimeNs() const { return mCpuTimeNs.load(std::memory_order_relaxed); }
+
+    // number of active RecordTracks reading from this converter, counted by
+    // SharedRecordConverters::assign()
+    size_t mTrackCount = 0;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SharedRecordConverter);
+
+    const audio_channel_mask_t          mChannelMask;
+    const audio_format_t                mFormat;
+    const uint32_t                      mSampleRate;
+    const uint32_t                      mSrcSampleRate;
+
+    const std::unique_ptr<SharedRecordSource> mSource;
+    RecordBufferConverter               mConverter;
+
+    const size_t                        mFrameSize;
+    const size_t                        mFrames;        // size of mBuffer in frames
+    std::unique_ptr<uint8_t[]>          mBuffer;
+    int64_t                             mRear = 0;      // last converted frame + 1, never cleared
+
+    // statistics
+    std::atomic<int64_t>                mFramesConverted{0};
+    std::atomic<int64_t>                mCpuTimeNs{0};
+    std::atomic<int64_t>                mOverruns{0};
+};
+
+/**
+ * The SharedRecordConverters of a RecordThread, one per RecordTrack configuration.
+ * The active tracks are assigned again on every change of the active track list, between
+ * beginAssign() and endAssign(); converters no track was assigned to are then released.
+ * Only modified by the RecordThread loop with the thread lock held.
+ */
+class SharedRecordConverters {
+public:
+    // creates a converter to the given configuration, from the current thread configuration
+    typedef std::function<sp<SharedRecordConverter>(audio_channel_mask_t channelMask,
+            audio_format_t format, uint32_t sampleRate)> Factory;
+
+    explicit SharedRecordConverters(Factory factory) : mFactory(std::move(factory)) {}
+
+    void beginAssign() {
+        for (const sp<SharedRecordConverter>& converter : mConverters) {
+            converter->mTrackCount = 0;
+        }
+    }
+
+    /* Assigns the converter of a track configuration, creating it if needed.
+     *
+     * Parameters
+     * converter:  the track converter, kept if it was not released since it was assigned.
+     *     front:  the track read position, set to the converter position if the track is
+     *             assigned a converter, like ResamplerBufferProvider::reset().
+     *
+     * Returns false, with converter cleared, if no converter can be created for the
+     * configuration. The track then keeps using its own RecordBufferConverter.
+     */
+    bool assign(audio_channel_mask_t channelMask, audio_format_t format, uint32_t sampleRate,
+            sp<SharedRecordConverter> *converter, int64_t *front) {
+        if (*converter != 0 && std::find(mConverters.begin(), mConverters.end(),
+                *converter) == mConverters.end()) {
+            // released by clear() or endAssign()
+            converter->clear();
+        }
+        if (*converter == 0) {
+            auto it = std::find_if(mConverters.begin(), mConverters.end(),
+                    [&](const sp<SharedRecordConverter>& c) {
+                        return c->matches(channelMask, format, sampleRate);
+                    });
+            if (it != mConverters.end()) {
+                *converter = *it;
+            } else {
+                sp<SharedRecordConverter> newConverter =
+                        mFactory(channelMask, format, sampleRate);
+                if (newConverter == 0 || newConverter->initCheck() != NO_ERROR) {
+                    return false;
+                }
+                mConverters.push_back(newConverter);
+                *converter = newConverter;
+            }
+            // skip previously converted data
+            *front = (*converter)->attach();
+        }
+        (*converter)->mTrackCount++;
+        return true;
+    }
+
+    // releases the converters no track was assigned to since beginAssign()
+    void endAssign() {
+        mConverters.erase(std::remove_if(mConverters.begin(), mConverters.end(),
+                [](const sp<SharedRecordConverter>& c) { return c->mTrackCount == 0; }),
+                mConverters.end());
+    }
+
+    // releases all the converters, the tracks are assigned new ones
+    void clear() { mConverters.clear(); }
+
+    // converts the frames read by the RecordThread, once per configuration
+    void process() {
+        for (const sp<SharedRecordConverter>& converter : mConverters) {
+            converter->process();
+        }
+    }
+
+    size_t size() const { return mConverters.size(); }
+
+    void dump(String8& result) const {
+        int64_t cpuTimeNs = 0;
+        String8 converters;
+        for (const sp<SharedRecordConverter>& converter : mConverters) {
+            cpuTimeNs += converter->cpuTimeNs();
+            converter->dump(converters);
+        }
+        result.appendFormat("  Shared record converters: %zu, cpu %.3f ms\n",
+                mConverters.size(), cpuTimeNs * 1e-6);
+        result.append(converters);
+    }
+
+private:
+    const Factory                               mFactory;
+    std::vector<sp<SharedRecordConverter>>      mConverters;
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_SHARED_RECORD_CONVERTER_H
@@ -6631,6 +6631,19 @@ AudioFlinger::DuplicatingThread::DuplicatingThread(const sp<AudioFlinger>& audio
                     systemReady, DUPLICATING),
         mWaitTimeMs(UINT_MAX)
 {
+    if (property_get_bool("af.duplicating.shared_mix", false /* default_value */)) {
+        const NBAIO_Format format = Format_from_SR_C(mSampleRate, mChannelCount, mFormat);
+        sp<Pipe> sharedMix = new Pipe(kSharedMixPeriods * mNormalFrameCount, format);
+        const NBAIO_Format offers[1] = {format};
+        size_t numCounterOffers = 0;
+        ssize_t index = sharedMix->negotiate(offers, 1, NULL, numCounterOffers);
+        if (index == 0) {
+            mSharedMix = sharedMix;
+        } else {
+            ALOGW("%s: shared mix negotiation failed %zd, using per track copies",
+                    __func__, index);
+        }
+    }
     addOutputTrack(mainThread);
 }
 
@@ -6681,8 +6694,22 @@ void AudioFlinger::DuplicatingThread::threadLoop_sleepTime()
 
 ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 {
+    const nsecs_t startCpuNs = systemTime(SYSTEM_TIME_THREAD);
+    // Write the mix once for all the tracks reading it in place.
+    int64_t sharedMixPosition = 0;
+    if (mSharedMix != 0 && writeFrames != 0) {
+        for (size_t i = 0; i < outputTracks.size(); i++) {
+            if (outputTracks[i]->usesSharedMix()) {
+                sharedMixPosition = mSharedMix->framesWritten();
+                mSharedMix->write(mSinkBuffer, writeFrames);
+                break;
+            }
+        }
+    }
     for (size_t i = 0; i < outputTracks.size(); i++) {
-        const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
+        const ssize_t actualWritten = outputTracks[i]->usesSharedMix()
+                ? outputTracks[i]->writeShared(writeFrames, sharedMixPosition)
+                : outputTracks[i]->write(mSinkBuffer, writeFrames);
 
         // Consider the first OutputTrack for timestamp and frame counting.
 
@@ -6699,6 +6726,11 @@ ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 
         // TODO: Report correction for the other output tracks and show in the dump.
     }
+    // includes neither the time blocked on full OutputTracks nor the downstream mix
+    const nsecs_t cpuNs = systemTime(SYSTEM_TIME_THREAD) - startCpuNs;
+    mWriteCpuNs += cpuNs;
+    mWriteCpuMaxNs = std::max(mWriteCpuMaxNs, cpuNs);
+    mWriteCount++;
     if (mStandby) {
         mThreadMetrics.logBeginInterval();
         mStandby = false;
@@ -6731,10 +6763,22 @@ void AudioFlinger::DuplicatingThread::dumpInternals_l(int fd, const Vector<Strin
             } else {
                 ss << "null";
             }
+            if (track->usesSharedMix()) {
+                ss << ", shared, " << track->sharedMixFramesDropped() << " dropped";
+            }
             ss << ")";
         }
     }
     ss << "\n";
+    if (mSharedMix != 0) {
+        ss << "  Shared mix: " << mSharedMix->maxFrames() << " frames, "
+                << mSharedMix->framesWritten() << " written\n";
+    }
+    if (mWriteCount > 0) {
+        ss << "  Write CPU time: avg " << mWriteCpuNs / mWriteCount / 1000
+                << " us, max " << mWriteCpuMaxNs / 1000 << " us over " << mWriteCount
+                << " writes\n";
+    }
     std::string result = ss.str();
     write(fd, result.c_str(), result.size());
 }
@@ -6761,13 +6805,18 @@ void AudioFlinger::DuplicatingThread::addOutputTrack(MixerThread *thread)
     // from different OutputTracks and their associated MixerThreads (e.g. one may
     // nearly empty and the other may be dropping data).
 
+    // The track can read the shared mix in place if the mix holds its whole buffer
+    // plus the sink buffer being written, otherwise it gets its own copy.
+    const bool sharedMix = mSharedMix != 0 &&
+            roundup(frameCount) + mNormalFrameCount <= mSharedMix->maxFrames();
     sp<OutputTrack> outputTrack = new OutputTrack(thread,
                                             this,
                                             mSampleRate,
                                             mFormat,
                                             mChannelMask,
                                             frameCount,
-                                            IPCThreadState::self()->getCallingUid());
+                                            IPCThreadState::self()->getCallingUid(),
+                                            sharedMix ? mSharedMix : nullptr);
     status_t status = outputTrack != 0 ? outputTrack->initCheck() : (status_t) NO_MEMORY;
     if (status != NO_ERROR) {
         ALOGE("addOutputTrack() initCheck failed %d", status);
@@ -6871,6 +6920,13 @@ AudioFlinger::RecordThread::RecordThread(const sp<AudioFlinger>& audioFlinger,
     mRsmpInBuffer(NULL),
     // mRsmpInFrames, mRsmpInFramesP2, and mRsmpInFramesOA are set by readInputParameters_l()
     mRsmpInRear(0)
+    , mSharedConverters([this](audio_channel_mask_t channelMask, audio_format_t format,
+            uint32_t sampleRate) -> sp<SharedRecordConverter> {
+        // reads the thread buffer at the current thread configuration
+        return new SharedRecordConverter(std::make_unique<ResamplerBufferProvider>(this),
+                mChannelMask, mFormat, mSampleRate, mRsmpInFrames,
+                channelMask, format, sampleRate);
+    })
     , mReadOnlyHeap(new MemoryDealer(kRecordThreadReadOnlyHeapSize,
             "RecordThreadRO", MemoryHeapBase::READ_ONLY))
     // mFastCapture below
@@ -7203,6 +7259,8 @@ reacquire_wakelock:
 
             }
 
+            updateSharedConverters_l(activeTracks);
+
             mActiveTracks.updatePowerState(this);
 
             updateMetadata_l();
@@ -7436,6 +7494,10 @@ reacquire_wakelock:
         }
         rear = mRsmpInRear += framesRead;
 
+        // convert once for all the tracks with the same configuration.
+        // mSharedConverters is only modified by this thread, so it can be read without mLock.
+        mSharedConverters.process();
+
         size = activeTracks.size();
 
         // loop over each active track
@@ -7468,7 +7530,15 @@ reacquire_wakelock:
                 // if the record track isn't draining fast enough.
                 bool hasOverrun;
                 size_t framesIn;
-                activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                const sp<SharedRecordConverter>& sharedConverter =
+                        activeTrack->mSharedConverter;
+                if (sharedConverter != 0) {
+                    // framesIn are already converted
+                    sharedConverter->sync(
+                            &activeTrack->mSharedConverterFront, &framesIn, &hasOverrun);
+                } else {
+                    activeTrack->mResamplerBufferProvider->sync(&framesIn, &hasOverrun);
+                }
                 if (hasOverrun) {
                     overrun = OVERRUN_TRUE;
                 }
@@ -7480,11 +7550,16 @@ reacquire_wakelock:
                 // from framesIn.
                 // This isn't strictly necessary but helps limit buffer resizing in
                 // RecordBufferConverter.  TODO: remove when no longer needed.
-                framesOut = min(framesOut,
+                framesOut = min(framesOut, sharedConverter != 0 ? framesIn :
                         destinationFramesPossible(
                                 framesIn, mSampleRate, activeTrack->mSampleRate));
 
-                if (activeTrack->isDirect()) {
+                if (sharedConverter != 0) {
+                    // frames were converted by the shared converter, copy them
+                    framesOut = sharedConverter->read(
+                            activeTrack->mSink.raw, framesOut,
+                            &activeTrack->mSharedConverterFront);
+                } else if (activeTrack->isDirect()) {
                     // No RecordBufferConverter used for direct streams. Pass
                     // straight from RecordThread buffer to RecordTrack buffer.
                     AudioBufferProvider::Buffer buffer;
@@ -7942,6 +8017,8 @@ status_t AudioFlinger::RecordThread::start(RecordThread::RecordTrack* recordTrac
         if (!recordTrack->isDirect()) {
             // clear any converter state as new data will be discontinuous
             recordTrack->mRecordBufferConverter->reset();
+            // the thread loop attaches the track to a shared converter again
+            recordTrack->mSharedConverter.clear();
         }
         recordTrack->mState = TrackBase::STARTING_2;
         // signal thread to start
@@ -8106,6 +8183,10 @@ void AudioFlinger::RecordThread::dumpInternals_l(int fd, const Vector<String16>&
     dprintf(fd, "  Fast capture thread: %s\n", hasFastCapture() ? "yes" : "no");
     dprintf(fd, "  Fast track available: %s\n", mFastTrackAvail ? "yes" : "no");
 
+    String8 converters;
+    mSharedConverters.dump(converters);
+    write(fd, converters.string(), converters.size());
+
     // Make a non-atomic copy of fast capture dump state so it won't change underneath us
     // while we are dumping it.  It may be inconsistent, but it won't mutate!
     // This is a large object so we place it on the heap.
@@ -8170,9 +8251,15 @@ void AudioFlinger::RecordThread::setRecordSilenced(audio_port_handle_t portId, b
     }
 }
 
+AudioFlinger::RecordThread::ResamplerBufferProvider::ResamplerBufferProvider(
+        RecordTrack* recordTrack)
+    : ResamplerBufferProvider(recordTrack->mThread)
+{
+}
+
 void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     mRsmpInFront = recordThread->mRsmpInRear;
     mRsmpInUnrel = 0;
@@ -8181,7 +8268,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::reset()
 void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
         size_t *framesAvailable, bool *hasOverrun)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     RecordThread *recordThread = (RecordThread *) threadBase.get();
     const int32_t rear = recordThread->mRsmpInRear;
     const int32_t front = mRsmpInFront;
@@ -8215,7 +8302,7 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::sync(
 status_t AudioFlinger::RecordThread::ResamplerBufferProvider::getNextBuffer(
         AudioBufferProvider::Buffer* buffer)
 {
-    sp<ThreadBase> threadBase = mRecordTrack->mThread.promote();
+    sp<ThreadBase> threadBase = mThread.promote();
     if (threadBase == 0) {
         buffer->frameCount = 0;
         buffer->raw = NULL;
@@ -8268,6 +8355,22 @@ void AudioFlinger::RecordThread::ResamplerBufferProvider::releaseBuffer(
     buffer->frameCount = 0;
 }
 
+void AudioFlinger::RecordThread::updateSharedConverters_l(
+        const Vector< sp<RecordTrack> >& activeTracks)
+{
+    mSharedConverters.beginAssign();
+    for (const sp<RecordTrack>& track : activeTracks) {
+        // fast tracks are served by FastCapture, direct tracks are not converted
+        if (track->isFastTrack() || track->isDirect()) {
+            continue;
+        }
+        // on failure the track keeps using its own converter
+        mSharedConverters.assign(track->channelMask(), track->format(), track->sampleRate(),
+                &track->mSharedConverter, &track->mSharedConverterFront);
+    }
+    mSharedConverters.endAssign();
+}
+
 void AudioFlinger::RecordThread::checkBtNrec()
 {
     Mutex::Autolock _l(mLock);
@@ -8464,6 +8567,8 @@ void AudioFlinger::RecordThread::readInputParameters_l()
 
     // Over-allocate beyond mRsmpInFramesP2 to permit a HAL read past end of buffer
     mRsmpInFramesOA = mRsmpInFramesP2 + mFrameCount - 1;
+    // shared converters read from mRsmpInBuffer, the thread loop will create new ones
+    mSharedConverters.clear();
     (void)posix_memalign(&mRsmpInBuffer, 32, mRsmpInFramesOA * mFrameSize);
     // if posix_memalign fails, will segv here.
     memset(mRsmpInBuffer, 0, mRsmpInFramesOA * mFrameSize);
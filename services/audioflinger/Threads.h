@@ -1495,6 +1495,16 @@ private:
                 uint32_t    mWaitTimeMs;
     SortedVector < sp<OutputTrack> >  outputTracks;
     SortedVector < sp<OutputTrack> >  mOutputTracks;
+
+    // Shared mix mode (af.duplicating.shared_mix): each mix is written once to mSharedMix and
+    // read in place by the OutputTracks that fit in it, instead of being copied to every one.
+    static constexpr size_t kSharedMixPeriods = 16;  // mix capacity in normal sink buffers
+                sp<Pipe>    mSharedMix;
+
+    // threadLoop_write() statistics, written by threadLoop only.
+                int64_t     mWriteCount = 0;
+                nsecs_t     mWriteCpuNs = 0;     // thread CPU time spent fanning out the mix
+                nsecs_t     mWriteCpuMaxNs = 0;
 public:
     virtual     bool        hasFastMixer() const { return false; }
                 status_t    threadloop_getHalTimestamp_l(
@@ -1526,11 +1536,12 @@ public:
      * RecordThread.  It maintains local state on the relative position of the read
      * position of the RecordTrack compared with the RecordThread.
      */
-    class ResamplerBufferProvider : public AudioBufferProvider
+    class ResamplerBufferProvider : public SharedRecordSource
     {
     public:
-        explicit ResamplerBufferProvider(RecordTrack* recordTrack) :
-            mRecordTrack(recordTrack),
+        explicit ResamplerBufferProvider(RecordTrack* recordTrack);
+        explicit ResamplerBufferProvider(const wp<ThreadBase>& thread) :
+            mThread(thread),
             mRsmpInUnrel(0), mRsmpInFront(0) { }
         virtual ~ResamplerBufferProvider() { }
 
@@ -1555,7 +1566,7 @@ public:
         virtual status_t    getNextBuffer(AudioBufferProvider::Buffer* buffer);
         virtual void        releaseBuffer(AudioBufferProvider::Buffer* buffer);
     private:
-        RecordTrack * const mRecordTrack;
+        const wp<ThreadBase> mThread;
         size_t              mRsmpInUnrel;   // unreleased frames remaining from
                                             // most recent getNextBuffer
                                             // for debug only
@@ -1696,6 +1707,10 @@ private:
 
             void    checkBtNrec_l();
 
+            // assigns the SharedRecordConverter of the active tracks and releases the
+            // converters no longer used
+            void    updateSharedConverters_l(const Vector< sp<RecordTrack> >& activeTracks);
+
             AudioStreamIn                       *mInput;
             Source                              *mSource;
             SortedVector < sp<RecordTrack> >    mTracks;
@@ -1714,6 +1729,10 @@ private:
             // rolling index that is never cleared
             int32_t                             mRsmpInRear;    // last filled frame + 1
 
+            // one converter per track configuration, shared by the tracks with that
+            // configuration. Only modified by threadLoop() with mLock held.
+            SharedRecordConverters              mSharedConverters;
+
             // For dumpsys
             const sp<MemoryDealer>              mReadOnlyHeap;
 
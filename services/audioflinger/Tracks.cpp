@@ -150,7 +150,7 @@ AudioFlinger::ThreadBase::TrackBase::TrackBase(
     }
 
     if (client != 0) {
-        mCblkMemory = client->heap()->allocate(size);
+        mCblkMemory = client->allocateTrackMemory(size);
         if (mCblkMemory == 0 ||
                 (mCblk = static_cast<audio_track_cblk_t *>(mCblkMemory->unsecurePointer())) == NULL) {
             ALOGE("%s(%d): not enough memory for AudioTrack size=%zu", __func__, mId, size);
@@ -242,10 +242,12 @@ AudioFlinger::ThreadBase::TrackBase::~TrackBase()
     // delete the proxy before deleting the shared memory it refers to, to avoid dangling reference
     mServerProxy.clear();
     releaseCblk();
-    mCblkMemory.clear();    // free the shared memory before releasing the heap it belongs to
     if (mClient != 0) {
+        // free or pool the shared memory before releasing the heap it belongs to
+        mClient->releaseTrackMemory(mCblkMemory);
         // Client destructor must run with AudioFlinger client mutex locked
         Mutex::Autolock _l(mClient->audioFlinger()->mClientLock);
+        mClient->audioFlinger()->retainIdleClient_l(mClient);
         // If the client's reference count drops to zero, the associated destructor
         // must run with AudioFlinger lock held. Thus the explicit clear() rather than
         // relying on the automatic clear() at end of scope.
@@ -1604,14 +1606,21 @@ AudioFlinger::PlaybackThread::OutputTrack::OutputTrack(
             audio_format_t format,
             audio_channel_mask_t channelMask,
             size_t frameCount,
-            uid_t uid)
+            uid_t uid,
+            const sp<Pipe>& sharedMix)
     :   Track(playbackThread, NULL, AUDIO_STREAM_PATCH,
               audio_attributes_t{} /* currently unused for output track */,
               sampleRate, format, channelMask, frameCount,
-              nullptr /* buffer */, (size_t)0 /* bufferSize */, nullptr /* sharedBuffer */,
+              // in shared mix mode the data is read from the mix, no track buffer is allocated
+              sharedMix != 0 ? sharedMix->buffer() : nullptr /* buffer */,
+              sharedMix != 0 ? sharedMix->maxFrames() * audio_bytes_per_frame(
+                      audio_channel_count_from_out_mask(channelMask), format)
+                      : (size_t)0 /* bufferSize */,
+              nullptr /* sharedBuffer */,
               AUDIO_SESSION_NONE, getpid(), uid, AUDIO_OUTPUT_FLAG_NONE,
               TYPE_OUTPUT),
-    mActive(false), mSourceThread(sourceThread)
+    mActive(false), mSourceThread(sourceThread),
+    mSharedMix(sharedMix != 0 ? new SharedMixCursor(sharedMix) : nullptr)
 {
 
     if (mCblk != NULL) {
@@ -1771,6 +1780,101 @@ ssize_t AudioFlinger::PlaybackThread::OutputTrack::write(void* data, uint32_t fr
     return frames - inBuffer.frameCount;  // number of frames consumed.
 }
 
+ssize_t AudioFlinger::PlaybackThread::OutputTrack::writeShared(uint32_t frames, int64_t position)
+{
+    if (!mActive && frames != 0) {
+        (void) start();
+    }
+
+    // Calling writeShared() with 0 frames means that no more data will be written:
+    // the frames already queued still refer to valid mix data and play out after stop().
+    if (frames == 0) {
+        if (mActive) {
+            stop();
+        }
+        return 0;
+    }
+
+    // After a drop the control block position no longer follows the mix position:
+    // the frames already queued must play out before the control block is mapped again.
+    if (!mSharedMix->beginWrite(position, mCblk->u.mStreaming.mRear,
+            mAudioTrackServerProxy->framesReadySafe(), frames)) {
+        return 0;
+    }
+
+    uint32_t waitTimeLeftMs = mSourceThread->waitTimeMs();
+    uint32_t queuedFrames = 0;
+    while (queuedFrames < frames && waitTimeLeftMs) {
+        AudioBufferProvider::Buffer buffer;
+        buffer.frameCount = frames - queuedFrames;
+        nsecs_t startTime = systemTime();
+        status_t status = obtainBuffer(&buffer, waitTimeLeftMs);
+        if (status != NO_ERROR && status != NOT_ENOUGH_DATA) {
+            ALOGV("%s(%d): thread %d no more output buffers; status %d",
+                    __func__, mId, (int)mThreadIoHandle, status);
+            break;
+        }
+        uint32_t waitTimeMs = (uint32_t)ns2ms(systemTime() - startTime);
+        if (waitTimeLeftMs >= waitTimeMs) {
+            waitTimeLeftMs -= waitTimeMs;
+        } else {
+            waitTimeLeftMs = 0;
+        }
+        if (status == NOT_ENOUGH_DATA) {
+            restartIfDisabled();
+            continue;
+        }
+
+        // The data is already in the mix, only advance the control block.
+        Proxy::Buffer buf;
+        buf.mFrameCount = buffer.frameCount;
+        buf.mRaw = NULL;
+        mClientProxy->releaseBuffer(&buf);
+        restartIfDisabled();
+        queuedFrames += buffer.frameCount;
+    }
+
+    if (queuedFrames < frames) {
+        // There are no overflow buffers in this mode: the mix will be overwritten
+        // before the destination thread could read the remaining frames.
+        ALOGV("%s(%d): thread %d dropping %u frames",
+                __func__, mId, (int)mThreadIoHandle, frames - queuedFrames);
+        mSharedMix->dropped(frames - queuedFrames);
+    }
+    return queuedFrames;
+}
+
+// AudioBufferProvider interface
+status_t AudioFlinger::PlaybackThread::OutputTrack::getNextBuffer(
+        AudioBufferProvider::Buffer* buffer)
+{
+    if (mSharedMix == nullptr) {
+        return Track::getNextBuffer(buffer);
+    }
+    // The offset read after the rear applies to all frames queued before that rear:
+    // the writer only changes it once the control block has been drained.
+    const uint32_t rear = (uint32_t)android_atomic_acquire_load(&mCblk->u.mStreaming.mRear);
+    const uint32_t front = (uint32_t)mCblk->u.mStreaming.mFront;
+    const size_t index = mSharedMix->index(front);
+    const size_t desiredFrames = buffer->frameCount;
+    buffer->frameCount = mSharedMix->contiguousFrames(front, rear, desiredFrames);
+    if (buffer->frameCount == 0) {
+        // ServerProxy::obtainBuffer() does not accept 0 frame requests, tally as it would.
+        buffer->raw = nullptr;
+        if (!isStopping() && !isStopped() && !isPaused()) {
+            mAudioTrackServerProxy->tallyUnderrunFrames(desiredFrames);
+        } else {
+            mAudioTrackServerProxy->tallyUnderrunFrames(0);
+        }
+        return NOT_ENOUGH_DATA;
+    }
+    status_t status = Track::getNextBuffer(buffer);
+    if (buffer->frameCount != 0) {
+        buffer->raw = mSharedMix->address(index, mFrameSize);
+    }
+    return status;
+}
+
 void AudioFlinger::PlaybackThread::OutputTrack::copyMetadataTo(MetadataInserter& backInserter) const
 {
     std::lock_guard<std::mutex> lock(mTrackMetadatasMutex);
@@ -2137,6 +2241,7 @@ AudioFlinger::RecordThread::RecordTrack::RecordTrack(
         mFramesToDrop(0),
         mResamplerBufferProvider(NULL), // initialize in case of early constructor exit
         mRecordBufferConverter(NULL),
+        mSharedConverterFront(0),
         mFlags(flags),
         mSilenced(false),
         mOpRecordAudioMonitor(OpRecordAudioMonitor::createIfNeeded(uid, attr, opPackageName))
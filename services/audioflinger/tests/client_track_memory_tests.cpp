@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ClientTrackMemoryTest"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ClientTrackMemory.h"
+
+namespace android {
+namespace {
+
+constexpr size_t kHeapSize = 64 * 1024;
+// largest pooled size class of kHeapSize
+constexpr size_t kMaxSizeClass = kHeapSize / TrackMemoryPool::kMaxSizeClassHeapFraction;
+constexpr nsecs_t kRetentionNs = 10 * 1000000000LL;
+constexpr size_t kMaxClients = 16;
+
+class TrackMemoryPoolTest : public ::testing::Test {
+protected:
+    TrackMemoryPoolTest()
+        : mHeap(new MemoryDealer(kHeapSize, "TrackMemoryPoolTest")), mPool(mHeap) {}
+
+    const sp<MemoryDealer> mHeap;
+    TrackMemoryPool mPool;
+};
+
+TEST_F(TrackMemoryPoolTest, SizeClasses) {
+    EXPECT_EQ(1024u, TrackMemoryPool::sizeClass(1));
+    EXPECT_EQ(1024u, TrackMemoryPool::sizeClass(1024));
+    EXPECT_EQ(2048u, TrackMemoryPool::sizeClass(1025));
+    EXPECT_EQ(0u, TrackMemoryPool::sizeClass(SIZE_MAX));
+}
+
+TEST_F(TrackMemoryPoolTest, ReleasedMemoryIsReused) {
+    sp<IMemory> memory = mPool.allocate(1000);
+    ASSERT_NE(nullptr, memory.get());
+    EXPECT_EQ(1024u, memory->size());
+    void* const pointer = memory->unsecurePointer();
+
+    mPool.release(memory);
+    EXPECT_EQ(nullptr, memory.get());
+    EXPECT_EQ(1024u, mPool.pooledBytes());
+
+    // Any size of the same class gets the released memory back
+    memory = mPool.allocate(600);
+    ASSERT_NE(nullptr, memory.get());
+    EXPECT_EQ(pointer, memory->unsecurePointer());
+    EXPECT_EQ(1u, mPool.recycled());
+    EXPECT_EQ(0u, mPool.pooledBytes());
+
+    // Other classes do not
+    sp<IMemory> other = mPool.allocate(2000);
+    ASSERT_NE(nullptr, other.get());
+    EXPECT_EQ(2048u, other->size());
+    EXPECT_EQ(1u, mPool.recycled());
+}
+
+TEST_F(TrackMemoryPoolTest, ReferencedMemoryIsNotPooled) {
+    // Still mapped by the client process
+    sp<IMemory> memory = mPool.allocate(1024);
+    const sp<IMemory> reference = memory;
+    mPool.release(memory);
+    EXPECT_EQ(nullptr, memory.get());
+    EXPECT_EQ(0u, mPool.pooledBytes());
+
+    // Too large to be pooled
+    memory = mPool.allocate(kMaxSizeClass + 1);
+    ASSERT_NE(nullptr, memory.get());
+    EXPECT_EQ(kMaxSizeClass + 1, memory->size());
+    mPool.release(memory);
+    EXPECT_EQ(0u, mPool.pooledBytes());
+}
+
+TEST_F(TrackMemoryPoolTest, PoolIsBounded) {
+    // At most kMaxFreePerClass blocks per class
+    std::vector<sp<IMemory>> memories;
+    for (size_t i = 0; i <= TrackMemoryPool::kMaxFreePerClass; i++) {
+        memories.push_back(mPool.allocate(1024));
+    }
+    for (sp<IMemory>& memory : memories) {
+        mPool.release(memory);
+    }
+    EXPECT_EQ(TrackMemoryPool::kMaxFreePerClass * 1024, mPool.pooledBytes());
+
+    // At most a quarter of the heap
+    const size_t budget = kHeapSize / TrackMemoryPool::kPoolHeapFraction;
+    memories.clear();
+    for (size_t i = 0; i < budget / kMaxSizeClass; i++) {
+        memories.push_back(mPool.allocate(kMaxSizeClass));
+    }
+    for (sp<IMemory>& memory : memories) {
+        mPool.release(memory);
+    }
+    EXPECT_EQ(budget - kMaxSizeClass + TrackMemoryPool::kMaxFreePerClass * 1024,
+            mPool.pooledBytes());
+}
+
+TEST_F(TrackMemoryPoolTest, PoolIsTrimmedWhenHeapIsFull) {
+    std::vector<sp<IMemory>> memories = {mPool.allocate(kMaxSizeClass),
+                                         mPool.allocate(kMaxSizeClass)};
+    for (sp<IMemory>& memory : memories) {
+        mPool.release(memory);
+    }
+    ASSERT_EQ(2 * kMaxSizeClass, mPool.pooledBytes());
+
+    // The rest of the heap, then memory of another class only available once the pool is freed
+    sp<IMemory> rest = mPool.allocate(kHeapSize - 2 * kMaxSizeClass);
+    ASSERT_NE(nullptr, rest.get());
+    sp<IMemory> memory = mPool.allocate(1024);
+    ASSERT_NE(nullptr, memory.get());
+    EXPECT_EQ(0u, mPool.pooledBytes());
+    EXPECT_EQ(0u, mPool.recycled());
+}
+
+class TestClient : public RefBase {
+public:
+    explicit TestClient(int* destroyed) : mDestroyed(destroyed) {}
+    ~TestClient() override { (*mDestroyed)++; }
+
+private:
+    int* const mDestroyed;
+};
+
+class IdleClientsTest : public ::testing::Test {
+protected:
+    IdleClientsTest() : mIdleClients(kRetentionNs, kMaxClients) {}
+
+    // retains a client only referenced by mIdleClients
+    nsecs_t retain(pid_t pid, nsecs_t now) {
+        return mIdleClients.retain(pid, new TestClient(&mDestroyed), now);
+    }
+
+    int mDestroyed = 0;
+    IdleClients<TestClient> mIdleClients;
+};
+
+TEST_F(IdleClientsTest, ClientReleasedAfterRetentionTime) {
+    constexpr nsecs_t kStart = 1000000000LL;
+    EXPECT_EQ(kStart + kRetentionNs, retain(1, kStart));
+    EXPECT_EQ(kStart + kRetentionNs, mIdleClients.prune(kStart + kRetentionNs - 1));
+    EXPECT_TRUE(mIdleClients.contains(1));
+    EXPECT_EQ(0, mDestroyed);
+
+    EXPECT_EQ(0, mIdleClients.prune(kStart + kRetentionNs));
+    EXPECT_FALSE(mIdleClients.contains(1));
+    EXPECT_EQ(1, mDestroyed);
+}
+
+TEST_F(IdleClientsTest, RetainingAgainExtendsRetention) {
+    constexpr nsecs_t kStart = 1000000000LL;
+    constexpr nsecs_t kLater = kStart + kRetentionNs / 2;
+    retain(1, kStart);
+    retain(2, kStart + 1);
+    EXPECT_EQ(kStart + 1 + kRetentionNs, retain(1, kLater));
+    // the client retained first was replaced
+    EXPECT_EQ(1, mDestroyed);
+
+    // next expiry is the one of client 2
+    EXPECT_EQ(kLater + kRetentionNs, mIdleClients.prune(kStart + 1 + kRetentionNs));
+    EXPECT_TRUE(mIdleClients.contains(1));
+    EXPECT_FALSE(mIdleClients.contains(2));
+    EXPECT_EQ(0, mIdleClients.prune(kLater + kRetentionNs));
+    EXPECT_EQ(0u, mIdleClients.size());
+}
+
+TEST_F(IdleClientsTest, OldestClientReleasedAboveMaxClients) {
+    constexpr nsecs_t kStart = 1000000000LL;
+    for (size_t i = 0; i < kMaxClients; i++) {
+        retain(100 + i, kStart + i);
+    }
+    EXPECT_EQ(kMaxClients, mIdleClients.size());
+    EXPECT_EQ(0, mDestroyed);
+
+    // Retaining a client again does not release another one
+    retain(100, kStart + kMaxClients);
+    EXPECT_EQ(kMaxClients, mIdleClients.size());
+    EXPECT_TRUE(mIdleClients.contains(101));
+    EXPECT_EQ(1, mDestroyed);
+
+    // A new client releases the least recently retained one
+    EXPECT_EQ(kStart + 2 + kRetentionNs, retain(200, kStart + kMaxClients + 1));
+    EXPECT_EQ(kMaxClients, mIdleClients.size());
+    EXPECT_FALSE(mIdleClients.contains(101));
+    EXPECT_TRUE(mIdleClients.contains(100));
+    EXPECT_TRUE(mIdleClients.contains(200));
+    EXPECT_EQ(2, mDestroyed);
+}
+
+TEST_F(IdleClientsTest, RemovedClientIsReleased) {
+    int destroyed = 0;
+    sp<TestClient> client = new TestClient(&destroyed);
+    mIdleClients.retain(1, client, 0);
+    mIdleClients.remove(1);
+    EXPECT_FALSE(mIdleClients.contains(1));
+    EXPECT_EQ(0, destroyed);
+    client.clear();
+    EXPECT_EQ(1, destroyed);
+}
+
+} // namespace
+} // namespace android
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Fan-out cost of the DuplicatingThread with 1, 2 or 3 outputs, with the OutputTracks
+// copying the mix into their own buffer ("copy") or reading it in place ("shared").
+// Each iteration is one sink buffer: the mix is written, queued on every track, and every
+// track is read back once by its destination, which sums the samples as a stand-in for the
+// downstream mixer (the same work in both modes).
+// The "fanout_us" counter is the time taken to queue the mix on all the tracks, i.e.
+// DuplicatingThread::threadLoop_write(): the latency added before the last destination
+// can see the period. The tracks are otherwise equally deep in both modes.
+
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <audio_utils/roundup.h>
+#include <benchmark/benchmark.h>
+
+#include "shared_mix_test_utils.h"
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr unsigned kChannelCount = 2;
+constexpr size_t kPeriodFrames = 960;               // 20 ms
+// As DuplicatingThread::addOutputTrack() and kSharedMixPeriods.
+constexpr size_t kTrackFrames = 3 * kPeriodFrames;
+constexpr size_t kMixPeriods = 16;
+constexpr size_t kFrameSize = kChannelCount * sizeof(int16_t);
+
+// An OutputTrack with its own buffer, as OutputTrack::write() without overflow buffers.
+class CopyTrack {
+public:
+    explicit CopyTrack(size_t frameCount)
+        // The proxies wrap at the next power of 2, as TrackBase allocates it.
+        : mBuffer(roundup(frameCount) * kFrameSize),
+          mCblk(new (mCblkMemory) audio_track_cblk_t()),
+          mClientProxy(new AudioTrackClientProxy(mCblk, mBuffer.data(), frameCount, kFrameSize,
+                  true /*clientInServer*/)),
+          mServerProxy(new AudioTrackServerProxy(mCblk, mBuffer.data(), frameCount, kFrameSize,
+                  true /*clientInServer*/, kSampleRate)) {
+    }
+
+    ~CopyTrack() { mCblk->~audio_track_cblk_t(); }
+
+    ssize_t write(const void* data, uint32_t frames) {
+        uint32_t queuedFrames = 0;
+        while (queuedFrames < frames) {
+            Proxy::Buffer buf;
+            buf.mFrameCount = frames - queuedFrames;
+            if (mClientProxy->obtainBuffer(&buf, &ClientProxy::kNonBlocking) != NO_ERROR) {
+                break;
+            }
+            memcpy(buf.mRaw, (const int8_t*)data + queuedFrames * kFrameSize,
+                    buf.mFrameCount * kFrameSize);
+            mClientProxy->releaseBuffer(&buf);
+            queuedFrames += buf.mFrameCount;
+        }
+        return queuedFrames;
+    }
+
+    size_t read(size_t desired, const void** data) {
+        Proxy::Buffer buf;
+        buf.mFrameCount = desired;
+        if (mServerProxy->obtainBuffer(&buf) != NO_ERROR) {
+            return 0;
+        }
+        *data = buf.mRaw;
+        return buf.mFrameCount;
+    }
+
+    void release(size_t frames) {
+        Proxy::Buffer buf;
+        buf.mFrameCount = frames;
+        buf.mRaw = NULL;
+        mServerProxy->releaseBuffer(&buf);
+    }
+
+private:
+    std::vector<int8_t> mBuffer;
+    alignas(audio_track_cblk_t) uint8_t mCblkMemory[sizeof(audio_track_cblk_t)];
+    audio_track_cblk_t* const mCblk;
+    const sp<AudioTrackClientProxy> mClientProxy;
+    const sp<AudioTrackServerProxy> mServerProxy;
+};
+
+// One period read by a destination thread.
+template <typename Track>
+int32_t consume(Track* track) {
+    int32_t sum = 0;
+    size_t framesRead = 0;
+    while (framesRead < kPeriodFrames) {
+        const void* data;
+        const size_t frames = track->read(kPeriodFrames - framesRead, &data);
+        if (frames == 0) {
+            break;
+        }
+        const int16_t* samples = (const int16_t*)data;
+        for (size_t i = 0; i < frames * kChannelCount; i++) {
+            sum += samples[i];
+        }
+        track->release(frames);
+        framesRead += frames;
+    }
+    return sum;
+}
+
+std::vector<int16_t> makePeriod() {
+    std::vector<int16_t> period(kPeriodFrames * kChannelCount);
+    for (size_t i = 0; i < period.size(); i++) {
+        period[i] = (int16_t)(i * 37);
+    }
+    return period;
+}
+
+void reportCounters(benchmark::State& state, std::chrono::nanoseconds fanout) {
+    state.counters["fanout_us"] = benchmark::Counter(
+            std::chrono::duration<double, std::micro>(fanout).count(),
+            benchmark::Counter::kAvgIterations);
+    state.SetBytesProcessed(state.iterations() * kPeriodFrames * kFrameSize);
+}
+
+void BM_DuplicatingCopy(benchmark::State& state) {
+    const size_t numTracks = state.range(0);
+    std::vector<std::unique_ptr<CopyTrack>> tracks;
+    for (size_t i = 0; i < numTracks; i++) {
+        tracks.emplace_back(new CopyTrack(kTrackFrames));
+    }
+    const std::vector<int16_t> period = makePeriod();
+    for (auto& track : tracks) {
+        track->write(period.data(), kPeriodFrames);
+    }
+
+    std::chrono::nanoseconds fanout{0};
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        for (auto& track : tracks) {
+            if (track->write(period.data(), kPeriodFrames) != (ssize_t)kPeriodFrames) {
+                state.SkipWithError("track full");
+                return;
+            }
+        }
+        fanout += std::chrono::steady_clock::now() - start;
+        for (auto& track : tracks) {
+            benchmark::DoNotOptimize(consume(track.get()));
+        }
+    }
+    reportCounters(state, fanout);
+}
+
+void BM_DuplicatingShared(benchmark::State& state) {
+    const size_t numTracks = state.range(0);
+    const sp<Pipe> mix = createSharedMix(kMixPeriods * kPeriodFrames, kChannelCount);
+    if (mix == nullptr) {
+        state.SkipWithError("mix negotiation failed");
+        return;
+    }
+    std::vector<std::unique_ptr<SharedMixTrack>> tracks;
+    for (size_t i = 0; i < numTracks; i++) {
+        tracks.emplace_back(new SharedMixTrack(mix, kTrackFrames));
+    }
+    const std::vector<int16_t> period = makePeriod();
+    int64_t position = mix->framesWritten();
+    mix->write(period.data(), kPeriodFrames);
+    for (auto& track : tracks) {
+        track->write(kPeriodFrames, position);
+    }
+
+    std::chrono::nanoseconds fanout{0};
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        position = mix->framesWritten();
+        mix->write(period.data(), kPeriodFrames);
+        for (auto& track : tracks) {
+            if (track->write(kPeriodFrames, position) != (ssize_t)kPeriodFrames) {
+                state.SkipWithError("track full");
+                return;
+            }
+        }
+        fanout += std::chrono::steady_clock::now() - start;
+        for (auto& track : tracks) {
+            benchmark::DoNotOptimize(consume(track.get()));
+        }
+    }
+    reportCounters(state, fanout);
+}
+
+BENCHMARK(BM_DuplicatingCopy)->DenseRange(1, 3);
+BENCHMARK(BM_DuplicatingShared)->DenseRange(1, 3);
+
+} // namespace
+
+BENCHMARK_MAIN();
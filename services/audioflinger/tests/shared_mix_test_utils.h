@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SHARED_MIX_TEST_UTILS_H
+#define ANDROID_SHARED_MIX_TEST_UTILS_H
+
+#include <new>
+
+#include <cutils/atomic.h>
+#include <media/nbaio/Pipe.h>
+#include <private/media/AudioTrackShared.h>
+
+#include "SharedMixCursor.h"
+
+namespace android {
+
+// The DuplicatingThread mix, negotiated as in DuplicatingThread::addOutputTrack().
+static inline sp<Pipe> createSharedMix(size_t frames, unsigned channelCount = 1,
+        audio_format_t format = AUDIO_FORMAT_PCM_16_BIT) {
+    const NBAIO_Format offers[1] = {Format_from_SR_C(48000, channelCount, format)};
+    sp<Pipe> mix = new Pipe(frames, offers[0]);
+    size_t numCounterOffers = 0;
+    if (mix->negotiate(offers, 1, NULL, numCounterOffers) != 0) {
+        return nullptr;
+    }
+    return mix;
+}
+
+// The control block path of an OutputTrack in shared mix mode, without the threads:
+// write() follows OutputTrack::writeShared() with a non-blocking obtainBuffer() standing
+// in for the wait on a full track, and read() follows OutputTrack::getNextBuffer().
+class SharedMixTrack {
+public:
+    SharedMixTrack(const sp<Pipe>& mix, size_t frameCount)
+        : mCursor(mix),
+          mFrameSize(Format_frameSize(mix->format())),
+          mCblk(new (mCblkMemory) audio_track_cblk_t()),
+          // The proxies only move the control block positions, the frames are in the mix.
+          mClientProxy(new AudioTrackClientProxy(mCblk, mix->buffer(), frameCount, mFrameSize,
+                  true /*clientInServer*/)),
+          mServerProxy(new AudioTrackServerProxy(mCblk, mix->buffer(), frameCount, mFrameSize,
+                  true /*clientInServer*/, Format_sampleRate(mix->format()))) {
+    }
+
+    ~SharedMixTrack() { mCblk->~audio_track_cblk_t(); }
+
+    SharedMixTrack(const SharedMixTrack&) = delete;
+    SharedMixTrack& operator=(const SharedMixTrack&) = delete;
+
+    // Queues 'frames' frames written to the mix at 'position', returns the frames queued.
+    ssize_t write(uint32_t frames, int64_t position) {
+        if (!mCursor.beginWrite(position, mCblk->u.mStreaming.mRear,
+                mServerProxy->framesReadySafe(), frames)) {
+            return 0;
+        }
+        uint32_t queuedFrames = 0;
+        while (queuedFrames < frames) {
+            Proxy::Buffer buf;
+            buf.mFrameCount = frames - queuedFrames;
+            if (mClientProxy->obtainBuffer(&buf, &ClientProxy::kNonBlocking) != NO_ERROR) {
+                break;
+            }
+            buf.mRaw = NULL;
+            mClientProxy->releaseBuffer(&buf);
+            queuedFrames += buf.mFrameCount;
+        }
+        if (queuedFrames < frames) {
+            mCursor.dropped(frames - queuedFrames);
+        }
+        return queuedFrames;
+    }
+
+    // Obtains up to 'desired' contiguous frames and points 'data' at them in the mix.
+    // Returns the number of frames obtained, to be released with release().
+    size_t read(size_t desired, const void** data) {
+        const uint32_t rear = (uint32_t)android_atomic_acquire_load(&mCblk->u.mStreaming.mRear);
+        const uint32_t front = (uint32_t)mCblk->u.mStreaming.mFront;
+        const size_t index = mCursor.index(front);
+        Proxy::Buffer buf;
+        buf.mFrameCount = mCursor.contiguousFrames(front, rear, desired);
+        if (buf.mFrameCount == 0 || mServerProxy->obtainBuffer(&buf) != NO_ERROR) {
+            return 0;
+        }
+        *data = mCursor.address(index, mFrameSize);
+        return buf.mFrameCount;
+    }
+
+    void release(size_t frames) {
+        Proxy::Buffer buf;
+        buf.mFrameCount = frames;
+        buf.mRaw = NULL;
+        mServerProxy->releaseBuffer(&buf);
+    }
+
+    uint64_t framesDropped() const { return mCursor.framesDropped(); }
+
+private:
+    SharedMixCursor mCursor;
+    const size_t mFrameSize;
+    alignas(audio_track_cblk_t) uint8_t mCblkMemory[sizeof(audio_track_cblk_t)];
+    audio_track_cblk_t* const mCblk;
+    const sp<AudioTrackClientProxy> mClientProxy;
+    const sp<AudioTrackServerProxy> mServerProxy;
+};
+
+} // namespace android
+
+#endif // ANDROID_SHARED_MIX_TEST_UTILS_H
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "shared_mix_tests"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "shared_mix_test_utils.h"
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kPeriodFrames = 192;
+// Same mix capacity as DuplicatingThread::kSharedMixPeriods.
+constexpr size_t kMixPeriods = 16;
+
+// One OutputTrack of the duplicating thread and the downstream thread reading it, checking
+// that every frame read in place is the mix frame that was queued at that position.
+class CheckedTrack : public SharedMixTrack {
+public:
+    CheckedTrack(const sp<Pipe>& mix, size_t frameCount) : SharedMixTrack(mix, frameCount) {}
+
+    ssize_t write(uint32_t frames, int64_t position) {
+        const ssize_t queued = SharedMixTrack::write(frames, position);
+        for (ssize_t i = 0; i < queued; i++) {
+            mExpected.push_back(position + i);
+        }
+        return queued;
+    }
+
+    // Reads up to 'frames' frames, in as many chunks as the mix wrap requires.
+    size_t read(size_t frames) {
+        size_t framesRead = 0;
+        while (framesRead < frames) {
+            const void* raw;
+            const size_t chunk = SharedMixTrack::read(frames - framesRead, &raw);
+            if (chunk == 0) {
+                break;
+            }
+            const int16_t* data = (const int16_t*)raw;
+            for (size_t i = 0; i < chunk; i++) {
+                if (mExpected.empty()) {
+                    ADD_FAILURE() << "read a frame that was not queued";
+                    return framesRead;
+                }
+                EXPECT_EQ((int16_t)mExpected.front(), data[i])
+                        << "at mix position " << mExpected.front();
+                mExpected.pop_front();
+            }
+            release(chunk);
+            framesRead += chunk;
+        }
+        return framesRead;
+    }
+
+    size_t queuedFrames() const { return mExpected.size(); }
+
+private:
+    std::deque<int64_t> mExpected;  // mix position of each queued frame
+};
+
+class SharedMixTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mMix = createSharedMix(kMixPeriods * kPeriodFrames);
+        ASSERT_NE(nullptr, mMix.get());
+        mPeriod.resize(kPeriodFrames);
+    }
+
+    // DuplicatingThread::threadLoop_write(): the mix is written once, then queued on
+    // every track. Frame n of the mix holds the sample value (int16_t)n.
+    int64_t writeMix(size_t frames) {
+        const int64_t position = mMix->framesWritten();
+        for (size_t i = 0; i < frames; i++) {
+            mPeriod[i] = (int16_t)(position + i);
+        }
+        EXPECT_EQ((ssize_t)frames, mMix->write(mPeriod.data(), frames));
+        return position;
+    }
+
+    sp<Pipe> mMix;
+    std::vector<int16_t> mPeriod;
+};
+
+TEST_F(SharedMixTest, ThreeTracksInLockstep) {
+    std::vector<std::unique_ptr<CheckedTrack>> tracks;
+    for (size_t periods : {2, 4, 8}) {
+        tracks.emplace_back(new CheckedTrack(mMix, periods * kPeriodFrames));
+    }
+    // More than one turn of the mix, with each reader one period behind.
+    for (size_t cycle = 0; cycle < 4 * kMixPeriods; cycle++) {
+        const int64_t position = writeMix(kPeriodFrames);
+        for (auto& track : tracks) {
+            ASSERT_EQ((ssize_t)kPeriodFrames, track->write(kPeriodFrames, position));
+            if (cycle > 0) {
+                ASSERT_EQ(kPeriodFrames, track->read(kPeriodFrames));
+            }
+        }
+    }
+    for (auto& track : tracks) {
+        EXPECT_EQ(kPeriodFrames, track->read(2 * kPeriodFrames));
+        EXPECT_EQ(0u, track->queuedFrames());
+        EXPECT_EQ(0u, track->framesDropped());
+    }
+}
+
+TEST_F(SharedMixTest, SlowReaderDropsAndResyncs) {
+    CheckedTrack fast(mMix, 4 * kPeriodFrames);
+    CheckedTrack slow(mMix, 2 * kPeriodFrames);
+
+    // The slow reader stalls: its track fills up and the frames that do not fit are dropped,
+    // the other track is not affected.
+    for (size_t cycle = 0; cycle < 4; cycle++) {
+        const int64_t position = writeMix(kPeriodFrames);
+        ASSERT_EQ((ssize_t)kPeriodFrames, fast.write(kPeriodFrames, position));
+        ASSERT_EQ(kPeriodFrames, fast.read(kPeriodFrames));
+        slow.write(kPeriodFrames, position);
+    }
+    EXPECT_EQ(2 * kPeriodFrames, slow.queuedFrames());
+    EXPECT_EQ(2 * kPeriodFrames, slow.framesDropped());
+
+    // While the frames queued before the drop are read, new frames are dropped: they would
+    // be mapped with the old offset.
+    ASSERT_EQ(kPeriodFrames, slow.read(kPeriodFrames));
+    int64_t position = writeMix(kPeriodFrames);
+    ASSERT_EQ((ssize_t)kPeriodFrames, fast.write(kPeriodFrames, position));
+    EXPECT_EQ(0, slow.write(kPeriodFrames, position));
+    EXPECT_EQ(3 * kPeriodFrames, slow.framesDropped());
+    ASSERT_EQ(kPeriodFrames, slow.read(kPeriodFrames));
+
+    // Once drained, the track follows the mix again at its new position.
+    for (size_t cycle = 0; cycle < 2 * kMixPeriods; cycle++) {
+        position = writeMix(kPeriodFrames);
+        ASSERT_EQ((ssize_t)kPeriodFrames, fast.write(kPeriodFrames, position));
+        ASSERT_EQ((ssize_t)kPeriodFrames, slow.write(kPeriodFrames, position));
+        ASSERT_EQ(kPeriodFrames, fast.read(kPeriodFrames));
+        ASSERT_EQ(kPeriodFrames, slow.read(kPeriodFrames));
+    }
+    EXPECT_EQ(0u, fast.framesDropped());
+    EXPECT_EQ(3 * kPeriodFrames, slow.framesDropped());
+    EXPECT_EQ(kPeriodFrames, fast.queuedFrames());
+    EXPECT_EQ(0u, slow.queuedFrames());
+}
+
+TEST_F(SharedMixTest, ReadsSplitAtMixWrap) {
+    // Writes and reads that do not divide the mix size, so that reads straddle its end.
+    constexpr size_t kWriteFrames = 100;
+    constexpr size_t kReadFrames = 73;
+    // Tracks added while the mix is running: their control block positions do not line up
+    // with the mix positions, so the proxies do not split reads at the mix end by themselves.
+    writeMix(kReadFrames);
+    CheckedTrack first(mMix, 4 * kPeriodFrames);
+    CheckedTrack second(mMix, 8 * kPeriodFrames);
+    for (size_t cycle = 0; cycle < 3 * mMix->maxFrames() / kWriteFrames; cycle++) {
+        const int64_t position = writeMix(kWriteFrames);
+        ASSERT_EQ((ssize_t)kWriteFrames, first.write(kWriteFrames, position));
+        ASSERT_EQ((ssize_t)kWriteFrames, second.write(kWriteFrames, position));
+        if (cycle > 0) {
+            for (size_t frames : {kReadFrames, kWriteFrames - kReadFrames}) {
+                ASSERT_EQ(frames, first.read(frames));
+                ASSERT_EQ(frames, second.read(frames));
+            }
+        }
+    }
+    EXPECT_EQ(kWriteFrames, first.queuedFrames());
+    EXPECT_EQ(kWriteFrames, second.queuedFrames());
+    EXPECT_EQ(0u, first.framesDropped());
+    EXPECT_EQ(0u, second.framesDropped());
+}
+
+} // namespace
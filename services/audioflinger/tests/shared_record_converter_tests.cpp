@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SharedRecordConverterTest"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "SharedRecordConverter.h"
+
+namespace android {
+namespace {
+
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kThreadFrames = 1024;
+constexpr size_t kPeriodFrames = 256;
+
+// The RecordThread buffer, mono PCM 16 at kSampleRate. Frame n holds the sample value
+// (int16_t)n.
+class TestThreadBuffer {
+public:
+    TestThreadBuffer() : mFrames(kThreadFrames) {}
+
+    void write(size_t frames) {
+        for (size_t i = 0; i < frames; i++, mRear++) {
+            mFrames[mRear % kThreadFrames] = (int16_t)mRear;
+        }
+    }
+
+    int64_t rear() const { return mRear; }
+    int16_t* frame(int64_t position) { return &mFrames[position % kThreadFrames]; }
+
+private:
+    std::vector<int16_t> mFrames;
+    int64_t mRear = 0;
+};
+
+// Reads the thread buffer like RecordThread::ResamplerBufferProvider.
+class TestSource : public SharedRecordSource {
+public:
+    explicit TestSource(TestThreadBuffer* thread) : mThread(thread) {}
+
+    void reset() override { mFront = mThread->rear(); }
+
+    void sync(size_t *framesAvailable, bool *hasOverrun) override {
+        *hasOverrun = mThread->rear() - mFront > (int64_t)kThreadFrames;
+        if (*hasOverrun) {
+            mFront = mThread->rear() - kThreadFrames;
+        }
+        *framesAvailable = mThread->rear() - mFront;
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        buffer->frameCount = std::min({buffer->frameCount, (size_t)(mThread->rear() - mFront),
+                kThreadFrames - (size_t)(mFront % kThreadFrames)});
+        buffer->raw = buffer->frameCount > 0 ? mThread->frame(mFront) : nullptr;
+        return buffer->frameCount > 0 ? NO_ERROR : NOT_ENOUGH_DATA;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mFront += buffer->frameCount;
+        buffer->raw = nullptr;
+        buffer->frameCount = 0;
+    }
+
+private:
+    TestThreadBuffer* const mThread;
+    int64_t mFront = 0;
+};
+
+// The shared converter state of a RecordTrack, as set by RecordThread::threadLoop().
+struct TestTrack {
+    TestTrack(audio_format_t format) : mFormat(format) {}
+
+    const audio_format_t mFormat;
+    sp<SharedRecordConverter> mConverter;
+    int64_t mFront = 0;
+    // thread buffer position of converter position 0
+    int64_t mOffset = 0;
+};
+
+class SharedRecordConverterTest : public ::testing::Test {
+protected:
+    SharedRecordConverterTest()
+        : mConverters([this](audio_channel_mask_t channelMask, audio_format_t format,
+                uint32_t sampleRate) -> sp<SharedRecordConverter> {
+            mConvertersCreated++;
+            return new SharedRecordConverter(std::make_unique<TestSource>(&mThread),
+                    AUDIO_CHANNEL_IN_MONO, AUDIO_FORMAT_PCM_16_BIT, kSampleRate, kThreadFrames,
+                    channelMask, format, sampleRate);
+        }) {}
+
+    // RecordThread::updateSharedConverters_l()
+    void assign(const std::vector<TestTrack*>& activeTracks) {
+        mConverters.beginAssign();
+        for (TestTrack* track : activeTracks) {
+            ASSERT_TRUE(mConverters.assign(AUDIO_CHANNEL_IN_MONO, track->mFormat, kSampleRate,
+                    &track->mConverter, &track->mFront));
+            // the converters are up to date with the thread buffer between loops
+            track->mOffset = mThread.rear() - track->mConverter->attach();
+        }
+        mConverters.endAssign();
+    }
+
+    // One RecordThread loop: read from the HAL, then convert.
+    void writeAndProcess(size_t frames) {
+        mThread.write(frames);
+        mConverters.process();
+    }
+
+    // RecordThread::threadLoop() for one track: returns the frames available, checking
+    // that each one holds the value of the thread buffer frame it was converted from.
+    size_t read(TestTrack* track, bool* hasOverrun) {
+        size_t framesIn;
+        track->mConverter->sync(&track->mFront, &framesIn, hasOverrun);
+        const int64_t front = track->mFront;
+        std::vector<float> floatFrames(framesIn);
+        std::vector<int16_t> pcm16Frames(framesIn);
+        const size_t framesRead = track->mConverter->read(
+                track->mFormat == AUDIO_FORMAT_PCM_FLOAT ? (void*)floatFrames.data()
+                                                         : (void*)pcm16Frames.data(),
+                framesIn, &track->mFront);
+        EXPECT_EQ(framesIn, framesRead);
+        for (size_t i = 0; i < framesRead; i++) {
+            const int16_t expected = (int16_t)(track->mOffset + front + i);
+            if (track->mFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                EXPECT_EQ(expected / 32768.f, floatFrames[i]) << "frame " << front + i;
+            } else {
+                EXPECT_EQ(expected, pcm16Frames[i]) << "frame " << front + i;
+            }
+        }
+        return framesRead;
+    }
+
+    TestThreadBuffer mThread;
+    SharedRecordConverters mConverters;
+    int mConvertersCreated = 0;
+};
+
+TEST_F(SharedRecordConverterTest, TracksWithSameConfigurationShareConverter) {
+    TestTrack first(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack second(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack other(AUDIO_FORMAT_PCM_16_BIT);
+    assign({&first, &second, &other});
+    ASSERT_NE(nullptr, first.mConverter.get());
+    ASSERT_NE(nullptr, other.mConverter.get());
+    EXPECT_EQ(first.mConverter.get(), second.mConverter.get());
+    EXPECT_NE(first.mConverter.get(), other.mConverter.get());
+    EXPECT_EQ(2u, mConverters.size());
+    EXPECT_EQ(2, mConvertersCreated);
+    EXPECT_EQ(2u, first.mConverter->mTrackCount);
+    EXPECT_EQ(1u, other.mConverter->mTrackCount);
+
+    // More than one turn of the ring buffers, with periods that do not divide their size so
+    // that reads straddle their end
+    constexpr size_t kFrames = 100;
+    bool hasOverrun;
+    for (size_t cycle = 0; cycle < 3 * kThreadFrames / kFrames; cycle++) {
+        writeAndProcess(kFrames);
+        for (TestTrack* track : {&first, &second, &other}) {
+            ASSERT_EQ(kFrames, read(track, &hasOverrun));
+            EXPECT_FALSE(hasOverrun);
+        }
+    }
+
+    // The frames read by both tracks were converted once
+    EXPECT_EQ(mThread.rear(), first.mConverter->framesConverted());
+    EXPECT_EQ(mThread.rear(), other.mConverter->framesConverted());
+
+    // Assigning the same tracks again keeps their converters and positions
+    const int64_t front = first.mFront;
+    assign({&first, &second, &other});
+    EXPECT_EQ(first.mConverter.get(), second.mConverter.get());
+    EXPECT_EQ(front, first.mFront);
+    EXPECT_EQ(2, mConvertersCreated);
+}
+
+TEST_F(SharedRecordConverterTest, ConverterReleasedWithoutTracks) {
+    TestTrack first(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack other(AUDIO_FORMAT_PCM_16_BIT);
+    assign({&first, &other});
+    writeAndProcess(kPeriodFrames);
+
+    // The converter of a stopped track is released
+    const sp<SharedRecordConverter> released = other.mConverter;
+    assign({&first});
+    EXPECT_EQ(1u, mConverters.size());
+    const int64_t framesConverted = released->framesConverted();
+    writeAndProcess(kPeriodFrames);
+    EXPECT_EQ(framesConverted, released->framesConverted());
+
+    // When restarted, the track gets a new converter and reads the frames that follow
+    assign({&first, &other});
+    EXPECT_EQ(3, mConvertersCreated);
+    EXPECT_NE(released.get(), other.mConverter.get());
+    EXPECT_EQ(0, other.mFront);
+    writeAndProcess(kPeriodFrames);
+    bool hasOverrun;
+    EXPECT_EQ(kPeriodFrames, read(&other, &hasOverrun));
+    EXPECT_EQ(3 * kPeriodFrames, read(&first, &hasOverrun));
+
+    // A track started later shares the running converter from its current position
+    TestTrack late(AUDIO_FORMAT_PCM_FLOAT);
+    assign({&first, &other, &late});
+    EXPECT_EQ(first.mConverter.get(), late.mConverter.get());
+    EXPECT_EQ(3, mConvertersCreated);
+    writeAndProcess(kPeriodFrames);
+    EXPECT_EQ(kPeriodFrames, read(&late, &hasOverrun));
+    EXPECT_FALSE(hasOverrun);
+
+    // A reconfiguration of the input releases all the converters
+    mConverters.clear();
+    const sp<SharedRecordConverter> cleared = first.mConverter;
+    assign({&first, &other});
+    EXPECT_NE(cleared.get(), first.mConverter.get());
+    EXPECT_EQ(5, mConvertersCreated);
+}
+
+TEST_F(SharedRecordConverterTest, SlowTrackOverrunsAlone) {
+    TestTrack fast(AUDIO_FORMAT_PCM_FLOAT);
+    TestTrack slow(AUDIO_FORMAT_PCM_FLOAT);
+    assign({&fast, &slow});
+
+    // The slow track does not read for longer than the ring buffer holds
+    bool hasOverrun;
+    for (size_t cycle = 0; cycle < 2 * kThreadFrames / kPeriodFrames; cycle++) {
+        writeAndProcess(kPeriodFrames);
+        ASSERT_EQ(kPeriodFrames, read(&fast, &hasOverrun));
+        EXPECT_FALSE(hasOverrun);
+    }
+
+    // It gets the latest frames, the fast track is not affected
+    EXPECT_EQ(kThreadFrames, read(&slow, &hasOverrun));
+    EXPECT_TRUE(hasOverrun);
+    EXPECT_EQ(mThread.rear(), slow.mFront);
+    writeAndProcess(kPeriodFrames);
+    EXPECT_EQ(kPeriodFrames, read(&slow, &hasOverrun));
+    EXPECT_FALSE(hasOverrun);
+    EXPECT_EQ(kPeriodFrames, read(&fast, &hasOverrun));
+    EXPECT_FALSE(hasOverrun);
+}
+
+} // namespace
+} // namespace android
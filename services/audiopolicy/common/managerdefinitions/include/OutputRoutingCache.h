@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <sys/types.h>
+#include <unordered_map>
+
+#include <system/audio.h>
+#include <utils/String8.h>
+
+#include "DeviceDescriptor.h"
+
+namespace android {
+
+/**
+ * Routing request as seen by AudioPolicyManager::getOutputForAttrInt(), before any policy is
+ * applied.
+ */
+struct OutputRoutingKey
+{
+    // Use when the routing cannot depend on the requester uid
+    static constexpr uid_t kAnyUid = static_cast<uid_t>(-1);
+
+    audio_attributes_t attributes; // as requested, AUDIO_ATTRIBUTES_INITIALIZER if none
+    audio_stream_type_t stream;
+    audio_output_flags_t flags;
+    uint32_t sampleRate;
+    audio_channel_mask_t channelMask;
+    audio_format_t format;
+    uid_t uid;
+
+    bool operator==(const OutputRoutingKey &other) const;
+};
+
+struct OutputRoutingKeyHash
+{
+    size_t operator()(const OutputRoutingKey &key) const;
+};
+
+/**
+ * Outcome of a routing request resolved by the engine to a mixed output.
+ */
+struct OutputRoutingDecision
+{
+    audio_attributes_t attributes;
+    audio_stream_type_t stream;
+    audio_output_flags_t flags;
+    DeviceVector devices; // as selected by the engine
+    audio_io_handle_t output;
+    audio_port_handle_t selectedDeviceId;
+};
+
+/**
+ * Memoizes output routing decisions. The cache is invalidated in O(1) by bumping its
+ * generation: entries stored in a previous generation are ignored and replaced lazily.
+ * Not thread safe, the audio policy manager is serialized by the policy service lock.
+ */
+class OutputRoutingCache
+{
+public:
+    using Validator = std::function<bool(const OutputRoutingDecision &decision)>;
+
+    // Returns the decision stored for the key in the current generation, or nullptr.
+    // The decision is also dropped if the validator, when given, rejects it.
+    const OutputRoutingDecision *find(const OutputRoutingKey &key,
+                                      const Validator &isValid = nullptr);
+    void add(const OutputRoutingKey &key, const OutputRoutingDecision &decision);
+    void invalidate();
+
+    uint32_t getGeneration() const { return mGeneration; }
+    uint64_t getHits() const { return mHits; }
+
+    void dump(String8 *dst) const;
+
+private:
+    static constexpr size_t kMaxEntries = 32;
+
+    struct Entry {
+        uint32_t generation;
+        OutputRoutingDecision decision;
+    };
+
+    std::unordered_map<OutputRoutingKey, Entry, OutputRoutingKeyHash> mEntries;
+    uint32_t mGeneration = 0;
+
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+    uint64_t mStale = 0;
+    uint64_t mInvalidations = 0;
+};
+
+} // namespace android
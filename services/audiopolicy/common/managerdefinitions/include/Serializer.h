@@ -22,4 +22,23 @@ namespace android {
 
 status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config);
 
+/**
+ * Same as deserializeAudioPolicyFile(), but uses the binary cache at cacheFileName if it was
+ * built from fileName and none of the XML files involved have changed since. Otherwise parses
+ * the XML file and rewrites the cache; failing to write the cache is not an error.
+ */
+status_t deserializeAudioPolicyFileCached(const char *fileName, const char *cacheFileName,
+                                          AudioPolicyConfig *config);
+
+/**
+ * Loads the configuration from the binary cache only.
+ * @return NO_ERROR if the configuration was loaded,
+ *         NAME_NOT_FOUND if there is no cache,
+ *         INVALID_OPERATION if the cache is out of date or was built from another file,
+ *         BAD_VALUE if the cache is corrupt.
+ * config is left untouched unless NO_ERROR is returned.
+ */
+status_t loadAudioPolicyConfigCache(const char *cacheFileName, const char *fileName,
+                                    AudioPolicyConfig *config);
+
 } // namespace android
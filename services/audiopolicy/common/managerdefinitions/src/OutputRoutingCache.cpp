@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "APM_OutputRoutingCache"
+//#define LOG_NDEBUG 0
+
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include "OutputRoutingCache.h"
+
+namespace android {
+
+bool OutputRoutingKey::operator==(const OutputRoutingKey &other) const
+{
+    return attributes.usage == other.attributes.usage &&
+            attributes.content_type == other.attributes.content_type &&
+            attributes.source == other.attributes.source &&
+            attributes.flags == other.attributes.flags &&
+            strncmp(attributes.tags, other.attributes.tags, AUDIO_ATTRIBUTES_TAGS_MAX_SIZE) == 0 &&
+            stream == other.stream &&
+            flags == other.flags &&
+            sampleRate == other.sampleRate &&
+            channelMask == other.channelMask &&
+            format == other.format &&
+            uid == other.uid;
+}
+
+size_t OutputRoutingKeyHash::operator()(const OutputRoutingKey &key) const
+{
+    // The tags are compared on equality but not hashed: they are almost always empty.
+    size_t hash = std::hash<uint32_t>()(key.attributes.usage);
+    auto combine = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(key.attributes.content_type);
+    combine(key.attributes.flags);
+    combine(key.stream);
+    combine(key.flags);
+    combine(key.sampleRate);
+    combine(key.channelMask);
+    combine(key.format);
+    combine(key.uid);
+    return hash;
+}
+
+const OutputRoutingDecision *OutputRoutingCache::find(const OutputRoutingKey &key,
+                                                     const Validator &isValid)
+{
+    auto it = mEntries.find(key);
+    if (it == mEntries.end()) {
+        mMisses++;
+        return nullptr;
+    }
+    if (it->second.generation != mGeneration
+            || (isValid != nullptr && !isValid(it->second.decision))) {
+        mEntries.erase(it);
+        mMisses++;
+        mStale++;
+        return nullptr;
+    }
+    mHits++;
+    return &it->second.decision;
+}
+
+void OutputRoutingCache::add(const OutputRoutingKey &key, const OutputRoutingDecision &decision)
+{
+    if (mEntries.size() >= kMaxEntries && mEntries.find(key) == mEntries.end()) {
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            it = it->second.generation != mGeneration ? mEntries.erase(it) : std::next(it);
+        }
+        if (mEntries.size() >= kMaxEntries) {
+            ALOGV("%s: cache full, clearing %zu entries", __func__, mEntries.size());
+            mEntries.clear();
+        }
+    }
+    mEntries[key] = Entry{mGeneration, decision};
+}
+
+void OutputRoutingCache::invalidate()
+{
+    mGeneration++;
+    mInvalidations++;
+}
+
+void OutputRoutingCache::dump(String8 *dst) const
+{
+    dst->appendFormat("\nOutput Routing Cache: generation %u, %zu entries\n",
+            mGeneration, mEntries.size());
+    dst->appendFormat("  hits %llu misses %llu stale %llu invalidations %llu\n",
+            (unsigned long long)mHits, (unsigned long long)mMisses,
+            (unsigned long long)mStale, (unsigned long long)mInvalidations);
+}
+
+} // namespace android
@@ -17,10 +17,19 @@
 #define LOG_TAG "APM::Serializer"
 //#define LOG_NDEBUG 0
 
+#include <errno.h>
+#include <fcntl.h>
 #include <memory>
+#include <string.h>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
 #include <utility>
+#include <vector>
 
+#include <cutils/properties.h>
 #include <hidl/Status.h>
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
@@ -235,7 +244,12 @@ public:
     {
         ALOGV("%s: Version=%s Root=%s", __func__, mVersion.c_str(), rootName);
     }
-    status_t deserialize(const char *configFile, AudioPolicyConfig *config);
+    /**
+     * @param sources if not null, receives the path of configFile followed by the paths of
+     *        all the files it XIncludes.
+     */
+    status_t deserialize(const char *configFile, AudioPolicyConfig *config,
+                         std::vector<std::string> *sources = nullptr);
 
 private:
     static constexpr const char *rootName = "audioPolicyConfiguration";
@@ -329,11 +343,17 @@ status_t deserializeCollection(const xmlNode *cur,
     return NO_ERROR;
 }
 
+// Gains are indexed in the order they are created, whether parsed or loaded from the cache.
+uint32_t nextAudioGainIndex()
+{
+    static uint32_t index = 0;
+    return index++;
+}
+
 Return<AudioGainTraits::Element> AudioGainTraits::deserialize(const xmlNode *cur,
         PtrSerializingCtx /*serializingContext*/)
 {
-    static uint32_t index = 0;
-    Element gain = new AudioGain(index++, true);
+    Element gain = new AudioGain(nextAudioGainIndex(), true);
 
     std::string mode = getXmlAttribute(cur, Attributes::mode);
     if (!mode.empty()) {
@@ -749,7 +769,36 @@ Return<SurroundSoundFormatTraits::Element> SurroundSoundFormatTraits::deserializ
     return pair;
 }
 
-status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig *config)
+/** Appends the resolved href of every XInclude processed under cur. */
+void collectXIncludeSources(const xmlNode *cur, std::vector<std::string> *sources)
+{
+    for (; cur != NULL; cur = cur->next) {
+        if (cur->type == XML_XINCLUDE_START) {
+            // The xi:include element is kept as the start marker, but xmlGetProp() only works on
+            // element nodes.
+            for (const xmlAttr *attr = cur->properties; attr != NULL; attr = attr->next) {
+                if (xmlStrcmp(attr->name, reinterpret_cast<const xmlChar*>("href"))) {
+                    continue;
+                }
+                auto href = make_xmlUnique(xmlNodeListGetString(cur->doc, attr->children, 1));
+                auto base = make_xmlUnique(xmlNodeGetBase(cur->doc, cur));
+                if (href == nullptr) {
+                    break;
+                }
+                auto uri = make_xmlUnique(xmlBuildURI(href.get(), base.get()));
+                if (uri != nullptr) {
+                    sources->push_back(reinterpret_cast<const char*>(uri.get()));
+                }
+                break;
+            }
+        } else if (cur->type == XML_ELEMENT_NODE) {
+            collectXIncludeSources(cur->children, sources);
+        }
+    }
+}
+
+status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig *config,
+                                       std::vector<std::string> *sources)
 {
     auto doc = make_xmlUnique(xmlParseFile(configFile));
     if (doc == nullptr) {
@@ -764,6 +813,11 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     if (xmlXIncludeProcess(doc.get()) < 0) {
         ALOGE("%s: libxml failed to resolve XIncludes on %s document.", __func__, configFile);
     }
+    if (sources != nullptr) {
+        sources->clear();
+        sources->push_back(configFile);
+        collectXIncludeSources(root, sources);
+    }
 
     if (xmlStrcmp(root->name, reinterpret_cast<const xmlChar*>(rootName)))  {
         ALOGE("%s: No %s root element found in xml data %s.", __func__, rootName,
@@ -799,6 +853,620 @@ status_t PolicySerializer::deserialize(const char *configFile, AudioPolicyConfig
     return android::OK;
 }
 
+/**
+ * Binary cache of a deserialized configuration.
+ *
+ * Holds the converted values of the modules, ports, devices and routes, so that the same graph
+ * can be rebuilt without libxml2 and without converting any literal. The cache is keyed on the
+ * contents of all the XML files it was built from and on the build fingerprint, as the literal
+ * converters may change with the platform.
+ */
+class PolicyConfigCache
+{
+public:
+    static status_t write(const char *cacheFile, const std::vector<std::string> &sources,
+                          const AudioPolicyConfig &config);
+    static status_t load(const char *cacheFile, const char *configFile,
+                         AudioPolicyConfig *config);
+
+private:
+    /** Bump whenever the layout or the meaning of any field changes. */
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMagic = 0x43435041; // "APCC"
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t payloadSize;
+        uint64_t payloadHash;
+    };
+
+    /** Route ends refer to a mix port by index, or to a device by index with this bit set. */
+    static constexpr uint32_t kDevicePortRef = 0x80000000;
+    static constexpr uint32_t kNoIndex = UINT32_MAX;
+
+    class Writer {
+    public:
+        template <typename T>
+        void put(T value) {
+            static_assert(std::is_trivially_copyable<T>::value, "put() takes plain values");
+            mData.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        void putString(const std::string &value) {
+            put<uint32_t>(value.size());
+            mData.append(value);
+        }
+        const std::string &data() const { return mData; }
+    private:
+        std::string mData;
+    };
+
+    /** Bounds checked reader; any overrun makes all further reads return zero. */
+    class Reader {
+    public:
+        Reader(const uint8_t *data, size_t size) : mPos(data), mEnd(data + size) {}
+        template <typename T>
+        T get() {
+            T value{};
+            if (static_cast<size_t>(mEnd - mPos) < sizeof(T)) {
+                mOk = false;
+            } else {
+                memcpy(&value, mPos, sizeof(T));
+                mPos += sizeof(T);
+            }
+            return value;
+        }
+        std::string getString() {
+            uint32_t size = get<uint32_t>();
+            if (static_cast<size_t>(mEnd - mPos) < size) {
+                mOk = false;
+                return "";
+            }
+            std::string value(reinterpret_cast<const char*>(mPos), size);
+            mPos += size;
+            return value;
+        }
+        /** Element count; every element takes at least one byte, which bounds allocations. */
+        uint32_t getCount() {
+            uint32_t count = get<uint32_t>();
+            if (static_cast<size_t>(mEnd - mPos) < count) {
+                mOk = false;
+                return 0;
+            }
+            return count;
+        }
+        bool ok() const { return mOk; }
+        bool atEnd() const { return mPos == mEnd; }
+    private:
+        const uint8_t *mPos;
+        const uint8_t *mEnd;
+        bool mOk = true;
+    };
+
+    /** Read-only mapping of a whole file. */
+    class MappedFile {
+    public:
+        explicit MappedFile(const char *path);
+        ~MappedFile();
+        bool exists() const { return mExists; }
+        const uint8_t *data() const { return static_cast<const uint8_t*>(mData); }
+        size_t size() const { return mSize; }
+    private:
+        bool mExists = false;
+        void *mData = nullptr;
+        size_t mSize = 0;
+    };
+
+    static uint64_t hash(const uint8_t *data, size_t size);
+    static std::string buildFingerprint();
+
+    static void writeProfiles(Writer *writer, const AudioProfileVector &profiles);
+    static void writeGains(Writer *writer, const AudioGains &gains);
+    static status_t writeModule(Writer *writer, const sp<HwModule> &module,
+                                const AudioPolicyConfig &config);
+
+    static bool isUpToDate(Reader *reader, const char *configFile);
+    static AudioProfileVector readProfiles(Reader *reader);
+    static AudioGains readGains(Reader *reader);
+    static sp<HwModule> readModule(Reader *reader, std::vector<sp<DeviceDescriptor>> *devices,
+                                   DeviceVector *attachedDevices);
+};
+
+PolicyConfigCache::MappedFile::MappedFile(const char *path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        mExists = true;
+        mSize = st.st_size;
+        if (mSize > 0) {
+            mData = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mData == MAP_FAILED) {
+                mData = nullptr;
+                mExists = false;
+            }
+        }
+    }
+    close(fd);
+}
+
+PolicyConfigCache::MappedFile::~MappedFile()
+{
+    if (mData != nullptr) {
+        munmap(mData, mSize);
+    }
+}
+
+// FNV-1a, 64 bit
+uint64_t PolicyConfigCache::hash(const uint8_t *data, size_t size)
+{
+    uint64_t value = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        value = (value ^ data[i]) * 0x100000001b3ULL;
+    }
+    return value;
+}
+
+std::string PolicyConfigCache::buildFingerprint()
+{
+    char value[PROPERTY_VALUE_MAX];
+    property_get("ro.build.fingerprint", value, "");
+    return value;
+}
+
+void PolicyConfigCache::writeProfiles(Writer *writer, const AudioProfileVector &profiles)
+{
+    writer->put<uint32_t>(profiles.size());
+    for (const auto &profile : profiles) {
+        writer->put<uint32_t>(profile->getFormat());
+        writer->put<uint32_t>(profile->getChannels().size());
+        for (audio_channel_mask_t channelMask : profile->getChannels()) {
+            writer->put<uint32_t>(channelMask);
+        }
+        writer->put<uint32_t>(profile->getSampleRates().size());
+        for (uint32_t rate : profile->getSampleRates()) {
+            writer->put<uint32_t>(rate);
+        }
+        writer->put<uint8_t>(profile->isDynamicFormat());
+        writer->put<uint8_t>(profile->isDynamicChannels());
+        writer->put<uint8_t>(profile->isDynamicRate());
+    }
+}
+
+void PolicyConfigCache::writeGains(Writer *writer, const AudioGains &gains)
+{
+    writer->put<uint32_t>(gains.size());
+    for (const auto &gain : gains) {
+        writer->put<uint32_t>(gain->getMode());
+        writer->put<uint32_t>(gain->getChannelMask());
+        writer->put<int32_t>(gain->getMinValueInMb());
+        writer->put<int32_t>(gain->getMaxValueInMb());
+        writer->put<int32_t>(gain->getDefaultValueInMb());
+        writer->put<uint32_t>(gain->getStepValueInMb());
+        writer->put<uint32_t>(gain->getMinRampInMs());
+        writer->put<uint32_t>(gain->getMaxRampInMs());
+        writer->put<uint8_t>(gain->canUseForVolume());
+    }
+}
+
+status_t PolicyConfigCache::writeModule(Writer *writer, const sp<HwModule> &module,
+                                        const AudioPolicyConfig &config)
+{
+    writer->putString(module->getName());
+    writer->put<uint32_t>(module->getHalVersionMajor());
+    writer->put<uint32_t>(module->getHalVersionMinor());
+
+    IOProfileCollection mixPorts;
+    mixPorts.appendVector(module->getOutputProfiles());
+    mixPorts.appendVector(module->getInputProfiles());
+    writer->put<uint32_t>(mixPorts.size());
+    for (const auto &mixPort : mixPorts) {
+        writer->putString(mixPort->getName());
+        writer->put<uint32_t>(mixPort->getRole());
+        writer->put<uint32_t>(mixPort->getFlags());
+        writer->put<uint32_t>(mixPort->maxOpenCount);
+        writer->put<uint32_t>(mixPort->maxActiveCount);
+        writeProfiles(writer, mixPort->getAudioProfiles());
+        writeGains(writer, mixPort->getGains());
+    }
+
+    const DeviceVector &devices = module->getDeclaredDevices();
+    writer->put<uint32_t>(devices.size());
+    for (const auto &device : devices) {
+        writer->putString(device->getTagName());
+        writer->put<uint32_t>(device->type());
+        writer->putString(device->address());
+        writer->put<uint32_t>(device->encodedFormats().size());
+        for (audio_format_t format : device->encodedFormats()) {
+            writer->put<uint32_t>(format);
+        }
+        writeProfiles(writer, device->getAudioProfiles());
+        writeGains(writer, device->getGains());
+    }
+
+    auto portRef = [&](const sp<PolicyAudioPort> &port) -> uint32_t {
+        for (size_t i = 0; i < mixPorts.size(); i++) {
+            if (port.get() == static_cast<PolicyAudioPort*>(mixPorts[i].get())) return i;
+        }
+        for (size_t i = 0; i < devices.size(); i++) {
+            if (port.get() == static_cast<PolicyAudioPort*>(devices[i].get())) {
+                return kDevicePortRef | i;
+            }
+        }
+        return kNoIndex;
+    };
+    const AudioRouteVector &routes = module->getRoutes();
+    writer->put<uint32_t>(routes.size());
+    for (const auto &route : routes) {
+        writer->put<uint32_t>(route->getType());
+        uint32_t sink = portRef(route->getSink());
+        if (sink == kNoIndex) {
+            return BAD_VALUE;
+        }
+        writer->put<uint32_t>(sink);
+        writer->put<uint32_t>(route->getSources().size());
+        for (const auto &source : route->getSources()) {
+            uint32_t ref = portRef(source);
+            if (ref == kNoIndex) {
+                return BAD_VALUE;
+            }
+            writer->put<uint32_t>(ref);
+        }
+    }
+
+    std::vector<uint32_t> attached;
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (config.getOutputDevices().indexOf(devices[i]) >= 0 ||
+                config.getInputDevices().indexOf(devices[i]) >= 0) {
+            attached.push_back(i);
+        }
+    }
+    writer->put<uint32_t>(attached.size());
+    for (uint32_t index : attached) {
+        writer->put<uint32_t>(index);
+    }
+    return NO_ERROR;
+}
+
+status_t PolicyConfigCache::write(const char *cacheFile, const std::vector<std::string> &sources,
+                                  const AudioPolicyConfig &config)
+{
+    Writer writer;
+    writer.putString(buildFingerprint());
+    writer.put<uint32_t>(sources.size());
+    for (const auto &source : sources) {
+        MappedFile file(source.c_str());
+        writer.putString(source);
+        writer.put<uint8_t>(file.exists());
+        writer.put<uint64_t>(file.size());
+        writer.put<uint64_t>(hash(file.data(), file.size()));
+    }
+
+    writer.put<uint8_t>(config.isSpeakerDrcEnabled());
+    writer.put<uint8_t>(config.isCallScreenModeSupported());
+    writer.putString(config.getEngineLibraryNameSuffix());
+    writer.put<uint32_t>(config.getSurroundFormats().size());
+    for (const auto &surround : config.getSurroundFormats()) {
+        writer.put<uint32_t>(surround.first);
+        writer.put<uint32_t>(surround.second.size());
+        for (audio_format_t subformat : surround.second) {
+            writer.put<uint32_t>(subformat);
+        }
+    }
+
+    const HwModuleCollection modules = config.getHwModules();
+    writer.put<uint32_t>(modules.size());
+    uint32_t defaultModule = kNoIndex;
+    uint32_t defaultDevice = kNoIndex;
+    for (size_t i = 0; i < modules.size(); i++) {
+        status_t status = writeModule(&writer, modules[i], config);
+        if (status != NO_ERROR) {
+            ALOGW("%s: cannot cache module %s", __func__, modules[i]->getName());
+            return status;
+        }
+        ssize_t index = modules[i]->getDeclaredDevices().indexOf(config.getDefaultOutputDevice());
+        if (index >= 0 && defaultModule == kNoIndex) {
+            defaultModule = i;
+            defaultDevice = index;
+        }
+    }
+    writer.put<uint32_t>(defaultModule);
+    writer.put<uint32_t>(defaultDevice);
+
+    const std::string &payload = writer.data();
+    Header header = {
+        .magic = kMagic,
+        .version = kVersion,
+        .payloadSize = payload.size(),
+        .payloadHash = hash(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()),
+    };
+
+    // Write to a temporary file and rename it, so that a concurrent or interrupted boot never
+    // sees a partial cache.
+    std::string tmpFile = std::string(cacheFile) + ".tmp";
+    int fd = open(tmpFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        ALOGW("%s: cannot create %s: %s", __func__, tmpFile.c_str(), strerror(errno));
+        return INVALID_OPERATION;
+    }
+    std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+    contents.append(payload);
+    const char *data = contents.data();
+    size_t left = contents.size();
+    while (left > 0) {
+        ssize_t written = TEMP_FAILURE_RETRY(::write(fd, data, left));
+        if (written <= 0) {
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+    bool ok = left == 0 && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmpFile.c_str(), cacheFile) != 0) {
+        ALOGW("%s: cannot write %s: %s", __func__, cacheFile, strerror(errno));
+        unlink(tmpFile.c_str());
+        return INVALID_OPERATION;
+    }
+    ALOGV("%s: wrote %zu bytes to %s", __func__, contents.size(), cacheFile);
+    return NO_ERROR;
+}
+
+bool PolicyConfigCache::isUpToDate(Reader *reader, const char *configFile)
+{
+    if (reader->getString() != buildFingerprint()) {
+        ALOGV("%s: built for another build", __func__);
+        return false;
+    }
+    uint32_t sourceCount = reader->getCount();
+    for (uint32_t i = 0; i < sourceCount; i++) {
+        std::string path = reader->getString();
+        bool existed = reader->get<uint8_t>() != 0;
+        uint64_t size = reader->get<uint64_t>();
+        uint64_t sourceHash = reader->get<uint64_t>();
+        if (!reader->ok()) {
+            return false;
+        }
+        // Check the cheap things first, the cache is tried for every candidate config file.
+        if (i == 0 && path != configFile) {
+            ALOGV("%s: built from %s, not %s", __func__, path.c_str(), configFile);
+            return false;
+        }
+        MappedFile file(path.c_str());
+        if (file.exists() != existed || file.size() != size ||
+                hash(file.data(), file.size()) != sourceHash) {
+            ALOGV("%s: %s has changed", __func__, path.c_str());
+            return false;
+        }
+    }
+    return sourceCount > 0;
+}
+
+AudioProfileVector PolicyConfigCache::readProfiles(Reader *reader)
+{
+    AudioProfileVector profiles;
+    uint32_t count = reader->getCount();
+    for (uint32_t i = 0; i < count && reader->ok(); i++) {
+        audio_format_t format = static_cast<audio_format_t>(reader->get<uint32_t>());
+        ChannelMaskSet channelMasks;
+        for (uint32_t n = reader->getCount(); n > 0; n--) {
+            channelMasks.insert(static_cast<audio_channel_mask_t>(reader->get<uint32_t>()));
+        }
+        SampleRateSet samplingRates;
+        for (uint32_t n = reader->getCount(); n > 0; n--) {
+            samplingRates.insert(reader->get<uint32_t>());
+        }
+        sp<AudioProfile> profile = new AudioProfile(format, channelMasks, samplingRates);
+        profile->setDynamicFormat(reader->get<uint8_t>() != 0);
+        profile->setDynamicChannels(reader->get<uint8_t>() != 0);
+        profile->setDynamicRate(reader->get<uint8_t>() != 0);
+        profiles.add(profile);
+    }
+    return profiles;
+}
+
+AudioGains PolicyConfigCache::readGains(Reader *reader)
+{
+    AudioGains gains;
+    uint32_t count = reader->getCount();
+    for (uint32_t i = 0; i < count && reader->ok(); i++) {
+        sp<AudioGain> gain = new AudioGain(nextAudioGainIndex(), true);
+        gain->setMode(static_cast<audio_gain_mode_t>(reader->get<uint32_t>()));
+        gain->setChannelMask(static_cast<audio_channel_mask_t>(reader->get<uint32_t>()));
+        gain->setMinValueInMb(reader->get<int32_t>());
+        gain->setMaxValueInMb(reader->get<int32_t>());
+        gain->setDefaultValueInMb(reader->get<int32_t>());
+        gain->setStepValueInMb(reader->get<uint32_t>());
+        gain->setMinRampInMs(reader->get<uint32_t>());
+        gain->setMaxRampInMs(reader->get<uint32_t>());
+        gain->setUseForVolume(reader->get<uint8_t>() != 0);
+        gains.add(gain);
+    }
+    return gains;
+}
+
+sp<HwModule> PolicyConfigCache::readModule(Reader *reader,
+                                           std::vector<sp<DeviceDescriptor>> *devices,
+                                           DeviceVector *attachedDevices)
+{
+    std::string name = reader->getString();
+    uint32_t versionMajor = reader->get<uint32_t>();
+    uint32_t versionMinor = reader->get<uint32_t>();
+    sp<HwModule> module = new HwModule(name.c_str(), versionMajor, versionMinor);
+
+    IOProfileCollection mixPorts;
+    uint32_t mixPortCount = reader->getCount();
+    for (uint32_t i = 0; i < mixPortCount && reader->ok(); i++) {
+        std::string portName = reader->getString();
+        audio_port_role_t role = static_cast<audio_port_role_t>(reader->get<uint32_t>());
+        sp<IOProfile> mixPort = new IOProfile(portName, role);
+        mixPort->setFlags(reader->get<uint32_t>());
+        mixPort->maxOpenCount = reader->get<uint32_t>();
+        mixPort->maxActiveCount = reader->get<uint32_t>();
+        mixPort->setAudioProfiles(readProfiles(reader));
+        mixPort->setGains(readGains(reader));
+        mixPorts.add(mixPort);
+    }
+    module->setProfiles(mixPorts);
+
+    // Devices are referred to by their position in the cache, which is not the order of the
+    // rebuilt DeviceVector as it sorts its items by address.
+    uint32_t deviceCount = reader->getCount();
+    for (uint32_t i = 0; i < deviceCount && reader->ok(); i++) {
+        std::string tagName = reader->getString();
+        audio_devices_t type = static_cast<audio_devices_t>(reader->get<uint32_t>());
+        std::string address = reader->getString();
+        FormatVector encodedFormats;
+        for (uint32_t n = reader->getCount(); n > 0; n--) {
+            encodedFormats.push_back(static_cast<audio_format_t>(reader->get<uint32_t>()));
+        }
+        sp<DeviceDescriptor> device =
+                new DeviceDescriptor(type, tagName, address, encodedFormats);
+        device->setAudioProfiles(readProfiles(reader));
+        device->setGains(readGains(reader));
+        devices->push_back(device);
+    }
+    DeviceVector declaredDevices;
+    for (const auto &device : *devices) {
+        declaredDevices.add(device);
+    }
+    module->setDeclaredDevices(declaredDevices);
+
+    auto port = [&](uint32_t ref) -> sp<PolicyAudioPort> {
+        sp<PolicyAudioPort> result;
+        if ((ref & kDevicePortRef) == 0) {
+            if (ref < mixPorts.size()) result = mixPorts[ref];
+        } else if ((ref & ~kDevicePortRef) < devices->size()) {
+            result = (*devices)[ref & ~kDevicePortRef];
+        }
+        return result;
+    };
+    AudioRouteVector routes;
+    uint32_t routeCount = reader->getCount();
+    for (uint32_t i = 0; i < routeCount && reader->ok(); i++) {
+        sp<AudioRoute> route =
+                new AudioRoute(static_cast<audio_route_type_t>(reader->get<uint32_t>()));
+        sp<PolicyAudioPort> sink = port(reader->get<uint32_t>());
+        PolicyAudioPortVector sources;
+        for (uint32_t n = reader->getCount(); n > 0; n--) {
+            sp<PolicyAudioPort> source = port(reader->get<uint32_t>());
+            if (source == nullptr) {
+                return nullptr;
+            }
+            sources.add(source);
+        }
+        if (sink == nullptr) {
+            return nullptr;
+        }
+        // Same wiring as RouteTraits::deserialize()
+        route->setSink(sink);
+        sink->addRoute(route);
+        for (const auto &source : sources) {
+            source->addRoute(route);
+        }
+        route->setSources(sources);
+        routes.add(route);
+    }
+    module->setRoutes(routes);
+
+    for (uint32_t n = reader->getCount(); n > 0; n--) {
+        uint32_t index = reader->get<uint32_t>();
+        if (index >= devices->size()) {
+            return nullptr;
+        }
+        attachedDevices->add((*devices)[index]);
+    }
+    return reader->ok() ? module : nullptr;
+}
+
+status_t PolicyConfigCache::load(const char *cacheFile, const char *configFile,
+                                 AudioPolicyConfig *config)
+{
+    MappedFile cache(cacheFile);
+    if (!cache.exists()) {
+        return NAME_NOT_FOUND;
+    }
+    Header header;
+    if (cache.size() < sizeof(header)) {
+        return BAD_VALUE;
+    }
+    memcpy(&header, cache.data(), sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion) {
+        ALOGV("%s: %s has version %u, expected %u", __func__, cacheFile, header.version,
+              kVersion);
+        return INVALID_OPERATION;
+    }
+    const uint8_t *payload = cache.data() + sizeof(header);
+    if (header.payloadSize != cache.size() - sizeof(header) ||
+            header.payloadHash != hash(payload, header.payloadSize)) {
+        ALOGW("%s: %s is corrupt", __func__, cacheFile);
+        return BAD_VALUE;
+    }
+
+    Reader reader(payload, header.payloadSize);
+    if (!isUpToDate(&reader, configFile)) {
+        return reader.ok() ? INVALID_OPERATION : BAD_VALUE;
+    }
+
+    bool speakerDrcEnabled = reader.get<uint8_t>() != 0;
+    bool callScreenModeSupported = reader.get<uint8_t>() != 0;
+    std::string engineLibrarySuffix = reader.getString();
+    AudioPolicyConfig::SurroundFormats surroundFormats;
+    uint32_t surroundCount = reader.getCount();
+    for (uint32_t i = 0; i < surroundCount && reader.ok(); i++) {
+        auto &subformats =
+                surroundFormats[static_cast<audio_format_t>(reader.get<uint32_t>())];
+        for (uint32_t n = reader.getCount(); n > 0; n--) {
+            subformats.insert(static_cast<audio_format_t>(reader.get<uint32_t>()));
+        }
+    }
+
+    HwModuleCollection modules;
+    std::vector<std::vector<sp<DeviceDescriptor>>> moduleDevices;
+    DeviceVector attachedDevices;
+    uint32_t moduleCount = reader.getCount();
+    for (uint32_t i = 0; i < moduleCount && reader.ok(); i++) {
+        moduleDevices.emplace_back();
+        sp<HwModule> module = readModule(&reader, &moduleDevices.back(), &attachedDevices);
+        if (module == nullptr) {
+            ALOGW("%s: %s is corrupt", __func__, cacheFile);
+            return BAD_VALUE;
+        }
+        modules.add(module);
+    }
+    uint32_t defaultModule = reader.get<uint32_t>();
+    uint32_t defaultDevice = reader.get<uint32_t>();
+    sp<DeviceDescriptor> defaultOutputDevice;
+    if (defaultModule != kNoIndex) {
+        if (defaultModule >= moduleDevices.size() ||
+                defaultDevice >= moduleDevices[defaultModule].size()) {
+            return BAD_VALUE;
+        }
+        defaultOutputDevice = moduleDevices[defaultModule][defaultDevice];
+    }
+    if (!reader.ok() || !reader.atEnd()) {
+        ALOGW("%s: %s is corrupt", __func__, cacheFile);
+        return BAD_VALUE;
+    }
+
+    // Everything was read, now apply in the same order as PolicySerializer::deserialize().
+    for (const auto &device : attachedDevices) {
+        config->addDevice(device);
+    }
+    if (defaultOutputDevice != nullptr && config->getDefaultOutputDevice() == nullptr) {
+        config->setDefaultOutputDevice(defaultOutputDevice);
+    }
+    config->setHwModules(modules);
+    config->setSpeakerDrcEnabled(speakerDrcEnabled);
+    config->setCallScreenModeSupported(callScreenModeSupported);
+    config->setEngineLibraryNameSuffix(engineLibrarySuffix);
+    config->setSurroundFormats(surroundFormats);
+    return NO_ERROR;
+}
+
 }  // namespace
 
 status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *config)
@@ -807,4 +1475,27 @@ status_t deserializeAudioPolicyFile(const char *fileName, AudioPolicyConfig *con
     return serializer.deserialize(fileName, config);
 }
 
+status_t deserializeAudioPolicyFileCached(const char *fileName, const char *cacheFileName,
+                                          AudioPolicyConfig *config)
+{
+    status_t status = PolicyConfigCache::load(cacheFileName, fileName, config);
+    if (status == NO_ERROR) {
+        ALOGV("%s: loaded %s from %s", __func__, fileName, cacheFileName);
+        return NO_ERROR;
+    }
+    PolicySerializer serializer;
+    std::vector<std::string> sources;
+    status = serializer.deserialize(fileName, config, &sources);
+    if (status == NO_ERROR) {
+        PolicyConfigCache::write(cacheFileName, sources, *config);
+    }
+    return status;
+}
+
+status_t loadAudioPolicyConfigCache(const char *cacheFileName, const char *fileName,
+                                    AudioPolicyConfig *config)
+{
+    return PolicyConfigCache::load(cacheFileName, fileName, config);
+}
+
 } // namespace android
@@ -35,6 +35,8 @@
         "audio_policy_configuration_a2dp_offload_disabled.xml"
 #define AUDIO_POLICY_BLUETOOTH_LEGACY_HAL_XML_CONFIG_FILE_NAME \
         "audio_policy_configuration_bluetooth_legacy_hal.xml"
+#define AUDIO_POLICY_XML_CONFIG_CACHE_FILE_PATH \
+        "/data/misc/audioserver/audio_policy_configuration.cache"
 
 #include <algorithm>
 #include <inttypes.h>
@@ -652,6 +654,7 @@ void AudioPolicyManager::setPhoneState(audio_mode_t state)
         ALOGW("setPhoneState() invalid or same state %d", state);
         return;
     }
+    mOutputRoutingCache.invalidate();
     /// Opens: can these line be executed after the switch of volume curves???
     if (isStateInCall(oldState)) {
         ALOGV("setPhoneState() in call state management: new state is %d", state);
@@ -759,6 +762,7 @@ void AudioPolicyManager::setForceUse(audio_policy_force_use_t usage,
         ALOGW("setForceUse() could not set force cfg %d for usage %d", config, usage);
         return;
     }
+    mOutputRoutingCache.invalidate();
     bool forceVolumeReeval = (usage == AUDIO_POLICY_FORCE_FOR_COMMUNICATION) ||
             (usage == AUDIO_POLICY_FORCE_FOR_DOCK) ||
             (usage == AUDIO_POLICY_FORCE_FOR_SYSTEM);
@@ -915,11 +919,60 @@ status_t AudioPolicyManager::getOutputForAttrInt(
 {
     DeviceVector outputDevices;
     const audio_port_handle_t requestedPortId = *selectedDeviceId;
-    DeviceVector msdDevices = getMsdAudioOutDevices();
     const sp<DeviceDescriptor> requestedDevice =
         mAvailableOutputDevices.getDeviceFromId(requestedPortId);
 
     *outputType = API_OUTPUT_INVALID;
+
+    // Requests which cannot be explicitly routed nor attached to a direct output are memoized.
+    // A decision is only stored once it is known not to involve any dynamic policy, MSD or
+    // telephony routing, and the cache is invalidated on any change of devices, outputs,
+    // policy mixes or forced usages.
+    static const audio_output_flags_t kUncachedFlags = (audio_output_flags_t)
+        (AUDIO_OUTPUT_FLAG_DIRECT | AUDIO_OUTPUT_FLAG_COMPRESS_OFFLOAD |
+            AUDIO_OUTPUT_FLAG_HW_AV_SYNC | AUDIO_OUTPUT_FLAG_MMAP_NOIRQ |
+            AUDIO_OUTPUT_FLAG_INCALL_MUSIC);
+    const bool useRoutingCache = requestedDevice == nullptr &&
+            (*flags & kUncachedFlags) == 0 &&
+            audio_is_linear_pcm(config->format) && config->sample_rate <= SAMPLE_RATE_HZ_MAX &&
+            audio_channel_count_from_out_mask(config->channel_mask) <= 2;
+    OutputRoutingKey routingKey{};
+    if (useRoutingCache) {
+        routingKey.attributes = AUDIO_ATTRIBUTES_INITIALIZER;
+        if (attr != nullptr) {
+            routingKey.attributes = *attr;
+        }
+        routingKey.stream = *stream;
+        routingKey.flags = *flags;
+        routingKey.sampleRate = config->sample_rate;
+        routingKey.channelMask = config->channel_mask;
+        routingKey.format = config->format;
+        // The uid only matters to dynamic policies and capture policies
+        routingKey.uid = mPolicyMixes.isEmpty() &&
+                mAllowedCapturePolicies.find(uid) == end(mAllowedCapturePolicies) ?
+                OutputRoutingKey::kAnyUid : uid;
+
+        const OutputRoutingDecision *decision = mOutputRoutingCache.find(routingKey,
+                [&](const OutputRoutingDecision &cached) {
+                    // The engine also takes the activity of the streams into account
+                    outputDevices = mEngine->getOutputDevicesForAttributes(
+                            cached.attributes, nullptr, false /*fromCache*/);
+                    return outputDevices == cached.devices;
+                });
+        if (decision != nullptr) {
+            *resultAttr = decision->attributes;
+            *stream = decision->stream;
+            *flags = decision->flags;
+            *output = decision->output;
+            *selectedDeviceId = decision->selectedDeviceId;
+            *outputType = API_OUTPUT_LEGACY;
+            ALOGV("%s returns cached output %d selectedDeviceId %d", __func__, *output,
+                  *selectedDeviceId);
+            return NO_ERROR;
+        }
+    }
+
+    DeviceVector msdDevices = getMsdAudioOutDevices();
     status_t status = getAudioAttributes(resultAttr, attr, *stream);
     if (status != NO_ERROR) {
         return status;
@@ -1045,6 +1098,16 @@ status_t AudioPolicyManager::getOutputForAttrInt(
         *outputType = API_OUTPUT_LEGACY;
     }
 
+    // Without secondary outputs requested, matching secondary mixes are not reported.
+    const bool noSecondaryMix = secondaryMixes != nullptr ?
+            secondaryMixes->empty() : mPolicyMixes.isEmpty();
+    if (useRoutingCache && primaryMix == nullptr && noSecondaryMix && msdDevices.isEmpty() &&
+            *outputType == API_OUTPUT_LEGACY && *stream != AUDIO_STREAM_VOICE_CALL &&
+            (resultAttr->flags & AUDIO_FLAG_HW_AV_SYNC) == 0) {
+        mOutputRoutingCache.add(routingKey, {*resultAttr, *stream, *flags, outputDevices,
+                *output, *selectedDeviceId});
+    }
+
     ALOGV("%s returns output %d selectedDeviceId %d", __func__, *output, *selectedDeviceId);
 
     return NO_ERROR;
@@ -3002,6 +3065,7 @@ status_t AudioPolicyManager::registerPolicyMixes(const Vector<AudioMix>& mixes)
             }
         }
     }
+    mOutputRoutingCache.invalidate();
     if (res != NO_ERROR) {
         unregisterPolicyMixes(mixes);
     } else if (checkOutputs) {
@@ -3061,6 +3125,7 @@ status_t AudioPolicyManager::unregisterPolicyMixes(Vector<AudioMix> mixes)
             }
         }
     }
+    mOutputRoutingCache.invalidate();
     if (res == NO_ERROR && checkOutputs) {
         checkForDeviceAndOutputChanges();
         updateCallAndOutputRouting();
@@ -3273,6 +3338,7 @@ void AudioPolicyManager::dump(String8 *dst) const
     mAudioPatches.dump(dst);
     mPolicyMixes.dump(dst);
     mAudioSources.dump(dst);
+    mOutputRoutingCache.dump(dst);
 
     dst->appendFormat(" AllowedCapturePolicies:\n");
     for (auto& policy : mAllowedCapturePolicies) {
@@ -3294,6 +3360,7 @@ status_t AudioPolicyManager::dump(int fd)
 status_t AudioPolicyManager::setAllowedCapturePolicy(uid_t uid, audio_flags_mask_t capturePolicy)
 {
     mAllowedCapturePolicies[uid] = capturePolicy;
+    mOutputRoutingCache.invalidate();
     return NO_ERROR;
 }
 
@@ -4468,7 +4535,8 @@ static status_t deserializeAudioPolicyXmlConfig(AudioPolicyConfig &config) {
         for (const auto& path : audio_get_configuration_paths()) {
             snprintf(audioPolicyXmlConfigFile, sizeof(audioPolicyXmlConfigFile),
                      "%s/%s", path.c_str(), fileName);
-            ret = deserializeAudioPolicyFile(audioPolicyXmlConfigFile, &config);
+            ret = deserializeAudioPolicyFileCached(audioPolicyXmlConfigFile,
+                    AUDIO_POLICY_XML_CONFIG_CACHE_FILE_PATH, &config);
             if (ret == NO_ERROR) {
                 config.setSource(audioPolicyXmlConfigFile);
                 return ret;
@@ -4737,12 +4805,14 @@ void AudioPolicyManager::addOutput(audio_io_handle_t output,
     updateMono(output); // update mono status when adding to output list
     selectOutputForMusicEffects();
     nextAudioPortGeneration();
+    mOutputRoutingCache.invalidate();
 }
 
 void AudioPolicyManager::removeOutput(audio_io_handle_t output)
 {
     mOutputs.removeItem(output);
     selectOutputForMusicEffects();
+    mOutputRoutingCache.invalidate();
 }
 
 void AudioPolicyManager::addInput(audio_io_handle_t input,
@@ -5666,6 +5736,7 @@ void AudioPolicyManager::updateDevicesAndOutputs()
 {
     mEngine->updateDeviceSelectionCache();
     mPreviousOutputs = mOutputs;
+    mOutputRoutingCache.invalidate();
 }
 
 uint32_t AudioPolicyManager::checkDeviceMuteStrategies(const sp<AudioOutputDescriptor>& outputDesc,
@@ -45,6 +45,7 @@
 #include <AudioInputDescriptor.h>
 #include <AudioOutputDescriptor.h>
 #include <AudioPolicyMix.h>
+#include <OutputRoutingCache.h>
 #include <EffectDescriptor.h>
 #include <SoundTriggerSession.h>
 #include "EngineLibrary.h"
@@ -787,6 +788,9 @@ protected:
         std::unordered_set<audio_format_t> mManualSurroundFormats;
 
         std::unordered_map<uid_t, audio_flags_mask_t> mAllowedCapturePolicies;
+
+        // Routing decisions of getOutputForAttrInt() for requests resolved to mixed outputs
+        OutputRoutingCache mOutputRoutingCache;
 protected:
         void onNewAudioModulesAvailableInt(DeviceVector *newDevices);
 
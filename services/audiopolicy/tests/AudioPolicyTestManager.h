@@ -30,6 +30,11 @@ class AudioPolicyTestManager : public AudioPolicyManager {
     using AudioPolicyManager::getAvailableOutputDevices;
     using AudioPolicyManager::getAvailableInputDevices;
     uint32_t getAudioPortGeneration() const { return mAudioPortGeneration; }
+    uint32_t getOutputRoutingCacheGeneration() const {
+        return mOutputRoutingCache.getGeneration();
+    }
+    uint64_t getOutputRoutingCacheHits() const { return mOutputRoutingCache.getHits(); }
+    void invalidateOutputRoutingCache() { mOutputRoutingCache.invalidate(); }
 };
 
 }  // namespace android
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioPolicyConfigCache_Test"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <Serializer.h>
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <utils/Log.h>
+
+using namespace android;
+using base::StringPrintf;
+
+namespace {
+
+// All the files in services/audiopolicy/config. Only the top-level configurations deserialize,
+// the others are XIncluded fragments which must fail the same way through both paths.
+const char *kConfigFiles[] = {
+    "a2dp_audio_policy_configuration.xml",
+    "a2dp_in_audio_policy_configuration.xml",
+    "audio_policy_configuration.xml",
+    "audio_policy_configuration_bluetooth_legacy_hal.xml",
+    "audio_policy_configuration_generic.xml",
+    "audio_policy_configuration_generic_configurable.xml",
+    "audio_policy_configuration_generic_tv.xml",
+    "audio_policy_configuration_stub.xml",
+    "audio_policy_volumes.xml",
+    "bluetooth_audio_policy_configuration.xml",
+    "default_volume_tables.xml",
+    "hearing_aid_audio_policy_configuration.xml",
+    "msd_audio_policy_configuration.xml",
+    "primary_audio_policy_configuration.xml",
+    "primary_audio_policy_configuration_tv.xml",
+    "r_submix_audio_policy_configuration.xml",
+    "stub_audio_policy_configuration.xml",
+    "surround_sound_configuration_5_0.xml",
+    "usb_audio_policy_configuration.xml",
+};
+
+const std::string sExecutableDir = base::GetExecutableDirectory() + "/";
+
+struct TestConfig {
+    HwModuleCollection hwModules;
+    DeviceVector outputDevices;
+    DeviceVector inputDevices;
+    sp<DeviceDescriptor> defaultOutputDevice;
+    AudioPolicyConfig config{hwModules, outputDevices, inputDevices, defaultOutputDevice};
+};
+
+std::string describeProfilesAndGains(const sp<AudioPort> &port) {
+    std::string result;
+    port->getAudioProfiles().dump(&result, 4);
+    for (size_t i = 0; i < port->getGains().size(); i++) {
+        port->getGains()[i]->dump(&result, 4, i);
+    }
+    return result;
+}
+
+std::string describeDevice(const sp<DeviceDescriptor> &device) {
+    std::string result = StringPrintf("device %s type %08x address '%s' encoded",
+            device->getTagName().c_str(), device->type(), device->address().c_str());
+    for (audio_format_t format : device->encodedFormats()) {
+        result += StringPrintf(" %08x", format);
+    }
+    return result + "\n" + describeProfilesAndGains(device);
+}
+
+// DeviceVector is ordered by address, so compare its items independently of their order.
+std::string describeDevices(const DeviceVector &devices) {
+    std::vector<std::string> descriptions;
+    for (const auto &device : devices) {
+        descriptions.push_back(describeDevice(device));
+    }
+    std::sort(descriptions.begin(), descriptions.end());
+    std::string result;
+    for (const auto &description : descriptions) {
+        result += description;
+    }
+    return result;
+}
+
+std::string describeMixPorts(const IOProfileCollection &mixPorts) {
+    std::string result;
+    for (const auto &mixPort : mixPorts) {
+        result += StringPrintf("mixPort %s role %d flags %08x max open %u active %u routes %zu\n",
+                mixPort->getName().c_str(), mixPort->getRole(), mixPort->getFlags(),
+                mixPort->maxOpenCount, mixPort->maxActiveCount, mixPort->getRoutes().size());
+        result += describeProfilesAndGains(mixPort);
+        result += "  supported:\n" + describeDevices(mixPort->getSupportedDevices());
+    }
+    return result;
+}
+
+std::string describeConfig(const AudioPolicyConfig &config) {
+    std::string result;
+    for (const auto &module : config.getHwModules()) {
+        result += StringPrintf("module %s version %u.%u\n", module->getName(),
+                module->getHalVersionMajor(), module->getHalVersionMinor());
+        result += describeMixPorts(module->getOutputProfiles());
+        result += describeMixPorts(module->getInputProfiles());
+        result += describeDevices(module->getDeclaredDevices());
+        for (const auto &route : module->getRoutes()) {
+            result += StringPrintf("route type %d sink %s sources", route->getType(),
+                    route->getSink()->getTagName().c_str());
+            for (const auto &source : route->getSources()) {
+                result += " " + source->getTagName();
+            }
+            result += "\n";
+        }
+    }
+    result += "outputs:\n" + describeDevices(config.getOutputDevices());
+    result += "inputs:\n" + describeDevices(config.getInputDevices());
+    if (config.getDefaultOutputDevice() != nullptr) {
+        result += "default " + describeDevice(config.getDefaultOutputDevice());
+    }
+    result += StringPrintf("speaker drc %d call screen %d engine %s\n",
+            config.isSpeakerDrcEnabled(), config.isCallScreenModeSupported(),
+            config.getEngineLibraryNameSuffix().c_str());
+    std::vector<std::string> surroundFormats;
+    for (const auto &surround : config.getSurroundFormats()) {
+        std::vector<audio_format_t> subformats(surround.second.begin(), surround.second.end());
+        std::sort(subformats.begin(), subformats.end());
+        std::string description = StringPrintf("surround %08x:", surround.first);
+        for (audio_format_t subformat : subformats) {
+            description += StringPrintf(" %08x", subformat);
+        }
+        surroundFormats.push_back(description + "\n");
+    }
+    std::sort(surroundFormats.begin(), surroundFormats.end());
+    for (const auto &description : surroundFormats) {
+        result += description;
+    }
+    return result;
+}
+
+bool copyFile(const std::string &from, const std::string &to) {
+    std::string contents;
+    return base::ReadFileToString(from, &contents) && base::WriteStringToFile(contents, to);
+}
+
+} // namespace
+
+class AudioPolicyConfigCacheTest : public testing::Test {
+protected:
+    std::string cacheFile() const { return std::string(mCacheDir.path) + "/config.cache"; }
+
+    TemporaryDir mCacheDir;
+};
+
+class AudioPolicyConfigCacheFileTest : public AudioPolicyConfigCacheTest,
+        public testing::WithParamInterface<const char*> {
+};
+
+TEST_P(AudioPolicyConfigCacheFileTest, SameAsXml) {
+    const std::string configFile = sExecutableDir + GetParam();
+
+    TestConfig xml;
+    auto xmlStart = std::chrono::steady_clock::now();
+    status_t xmlStatus = deserializeAudioPolicyFile(configFile.c_str(), &xml.config);
+    auto xmlTime = std::chrono::steady_clock::now() - xmlStart;
+
+    // No cache yet: parses the XML, and writes the cache if that succeeded
+    TestConfig parsed;
+    ASSERT_EQ(xmlStatus, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile().c_str(), &parsed.config));
+
+    TestConfig cached;
+    auto cacheStart = std::chrono::steady_clock::now();
+    status_t cacheStatus = loadAudioPolicyConfigCache(
+            cacheFile().c_str(), configFile.c_str(), &cached.config);
+    auto cacheTime = std::chrono::steady_clock::now() - cacheStart;
+    if (xmlStatus != NO_ERROR) {
+        EXPECT_EQ(NAME_NOT_FOUND, cacheStatus);
+        EXPECT_TRUE(cached.hwModules.isEmpty());
+        return;
+    }
+    ASSERT_EQ(NO_ERROR, cacheStatus);
+    EXPECT_FALSE(cached.hwModules.isEmpty());
+    EXPECT_EQ(describeConfig(xml.config), describeConfig(cached.config));
+    EXPECT_EQ(describeConfig(parsed.config), describeConfig(cached.config));
+
+    // And through the cached entry point, which is what the policy manager uses
+    TestConfig loaded;
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile().c_str(), &loaded.config));
+    EXPECT_EQ(describeConfig(xml.config), describeConfig(loaded.config));
+
+    using std::chrono::microseconds;
+    ALOGI("%s: XML %lld us, cache %lld us", GetParam(),
+            static_cast<long long>(std::chrono::duration_cast<microseconds>(xmlTime).count()),
+            static_cast<long long>(std::chrono::duration_cast<microseconds>(cacheTime).count()));
+}
+
+INSTANTIATE_TEST_CASE_P(
+        ConfigFiles,
+        AudioPolicyConfigCacheFileTest,
+        testing::ValuesIn(kConfigFiles));
+
+TEST_F(AudioPolicyConfigCacheTest, Invalidation) {
+    // Work on a copy so that included files can be modified
+    TemporaryDir configDir;
+    const std::vector<std::string> files = {
+        "audio_policy_configuration_generic.xml",
+        "primary_audio_policy_configuration.xml",
+        "r_submix_audio_policy_configuration.xml",
+        "audio_policy_volumes.xml",
+        "default_volume_tables.xml",
+        "surround_sound_configuration_5_0.xml",
+    };
+    for (const auto &file : files) {
+        ASSERT_TRUE(copyFile(sExecutableDir + file, std::string(configDir.path) + "/" + file));
+    }
+    const std::string configFile = std::string(configDir.path) + "/" + files[0];
+    const std::string includedFile = std::string(configDir.path) + "/" + files.back();
+
+    TestConfig parsed;
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile().c_str(), &parsed.config));
+    {
+        TestConfig cached;
+        EXPECT_EQ(NO_ERROR, loadAudioPolicyConfigCache(
+                cacheFile().c_str(), configFile.c_str(), &cached.config));
+    }
+    {
+        // Built from another file
+        TestConfig cached;
+        EXPECT_EQ(INVALID_OPERATION, loadAudioPolicyConfigCache(
+                cacheFile().c_str(), includedFile.c_str(), &cached.config));
+        EXPECT_TRUE(cached.hwModules.isEmpty());
+    }
+
+    // Changing an XIncluded file invalidates the cache
+    std::string contents;
+    ASSERT_TRUE(base::ReadFileToString(includedFile, &contents));
+    ASSERT_TRUE(base::WriteStringToFile(contents + "<!-- changed -->\n", includedFile));
+    {
+        TestConfig cached;
+        EXPECT_EQ(INVALID_OPERATION, loadAudioPolicyConfigCache(
+                cacheFile().c_str(), configFile.c_str(), &cached.config));
+        EXPECT_TRUE(cached.hwModules.isEmpty());
+    }
+    // ...until it is rebuilt
+    TestConfig reparsed;
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile().c_str(), &reparsed.config));
+    EXPECT_EQ(describeConfig(parsed.config), describeConfig(reparsed.config));
+    {
+        TestConfig cached;
+        EXPECT_EQ(NO_ERROR, loadAudioPolicyConfigCache(
+                cacheFile().c_str(), configFile.c_str(), &cached.config));
+        EXPECT_EQ(describeConfig(parsed.config), describeConfig(cached.config));
+    }
+
+    // A corrupt cache is detected and leaves the configuration untouched
+    ASSERT_TRUE(base::ReadFileToString(cacheFile(), &contents));
+    contents[contents.size() / 2] ^= 0x55;
+    ASSERT_TRUE(base::WriteStringToFile(contents, cacheFile()));
+    {
+        TestConfig cached;
+        EXPECT_EQ(BAD_VALUE, loadAudioPolicyConfigCache(
+                cacheFile().c_str(), configFile.c_str(), &cached.config));
+        EXPECT_TRUE(cached.hwModules.isEmpty());
+        EXPECT_TRUE(cached.outputDevices.isEmpty());
+    }
+    TestConfig recovered;
+    ASSERT_EQ(NO_ERROR, deserializeAudioPolicyFileCached(
+            configFile.c_str(), cacheFile().c_str(), &recovered.config));
+    EXPECT_EQ(describeConfig(parsed.config), describeConfig(recovered.config));
+}
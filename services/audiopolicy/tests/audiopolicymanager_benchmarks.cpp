@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "APM_Benchmark"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <Serializer.h>
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <media/AudioPolicy.h>
+#include <mediautils/AllocationCounter.h>
+#include <utils/Log.h>
+#include <utils/Vector.h>
+
+#include "AudioPolicyInterface.h"
+#include "AudioPolicyManagerTestClient.h"
+#include "AudioPolicyTestManager.h"
+
+using namespace android;
+using base::StringPrintf;
+
+namespace {
+
+const std::string sExecutableDir = base::GetExecutableDirectory() + "/";
+const std::string sDefaultConfig = sExecutableDir + "test_audio_policy_configuration.xml";
+
+// A policy manager on top of the test client, as in audiopolicymanager_tests.
+class BenchmarkManager {
+public:
+    BenchmarkManager()
+            : mClient(new AudioPolicyManagerTestClient),
+              mManager(new AudioPolicyTestManager(mClient.get())) {}
+
+    ~BenchmarkManager() {
+        mManager.reset();
+        mClient.reset();
+    }
+
+    AudioPolicyTestManager* operator->() { return mManager.get(); }
+
+    bool initialize(benchmark::State& state, const std::string& configFile = sDefaultConfig) {
+        status_t status = deserializeAudioPolicyFile(configFile.c_str(), &mManager->getConfig());
+        if (status != NO_ERROR) {
+            state.SkipWithError(StringPrintf("cannot load %s", configFile.c_str()).c_str());
+            return false;
+        }
+        return initializeWithConfig(state);
+    }
+
+    // For a configuration already set up through getConfig()
+    bool initializeWithConfig(benchmark::State& state) {
+        if (mManager->initialize() != NO_ERROR || mManager->initCheck() != NO_ERROR) {
+            state.SkipWithError("cannot initialize the policy manager");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::unique_ptr<AudioPolicyManagerTestClient> mClient;
+    std::unique_ptr<AudioPolicyTestManager> mManager;
+};
+
+audio_config_t pcmConfig() {
+    audio_config_t config = AUDIO_CONFIG_INITIALIZER;
+    config.sample_rate = 48000;
+    config.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+    config.format = AUDIO_FORMAT_PCM_16_BIT;
+    return config;
+}
+
+} // namespace
+
+static void BM_DeserializeConfig(benchmark::State& state) {
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        HwModuleCollection hwModules;
+        DeviceVector outputDevices;
+        DeviceVector inputDevices;
+        sp<DeviceDescriptor> defaultOutputDevice;
+        AudioPolicyConfig config(hwModules, outputDevices, inputDevices, defaultOutputDevice);
+        if (deserializeAudioPolicyFile(sDefaultConfig.c_str(), &config) != NO_ERROR) {
+            state.SkipWithError("cannot load the configuration");
+            return;
+        }
+        benchmark::DoNotOptimize(hwModules);
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_DeserializeConfig);
+
+// Configuration load and initialization, as done when the audio server starts
+static void BM_InitializeManager(benchmark::State& state) {
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        BenchmarkManager manager;
+        if (!manager.initialize(state)) return;
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_InitializeManager);
+
+// Connection and disconnection of a device reachable through N mix ports, which opens and
+// closes N outputs.
+static void BM_DeviceConnection(benchmark::State& state) {
+    const int outputCount = state.range(0);
+    BenchmarkManager manager;
+    AudioPolicyConfig& config = manager->getConfig();
+    config.setDefault();
+
+    sp<DeviceDescriptor> usbDevice = new DeviceDescriptor(AUDIO_DEVICE_OUT_USB_DEVICE);
+    sp<AudioProfile> pcmProfile = new AudioProfile(
+            AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO, 48000);
+    usbDevice->addAudioProfile(pcmProfile);
+    sp<HwModule> usbModule = new HwModule(AUDIO_HARDWARE_MODULE_ID_USB, 2 /*halVersionMajor*/);
+    usbModule->setDeclaredDevices(DeviceVector(usbDevice));
+    for (int i = 0; i < outputCount; i++) {
+        sp<OutputProfile> profile = new OutputProfile(StringPrintf("usb output %d", i));
+        profile->addAudioProfile(pcmProfile);
+        profile->addSupportedDevice(usbDevice);
+        usbModule->addOutputProfile(profile);
+    }
+    HwModuleCollection modules = config.getHwModules();
+    modules.add(usbModule);
+    config.setHwModules(modules);
+    if (!manager.initializeWithConfig(state)) return;
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        if (manager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                        AUDIO_POLICY_DEVICE_STATE_AVAILABLE, "", "usb",
+                        AUDIO_FORMAT_DEFAULT) != NO_ERROR) {
+            state.SkipWithError("cannot connect the device");
+            return;
+        }
+        if (manager->setDeviceConnectionState(AUDIO_DEVICE_OUT_USB_DEVICE,
+                        AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE, "", "usb",
+                        AUDIO_FORMAT_DEFAULT) != NO_ERROR) {
+            state.SkipWithError("cannot disconnect the device");
+            return;
+        }
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_DeviceConnection)->Arg(1)->Arg(4)->Arg(16);
+
+// Track creation and destruction, cycling through common usages.
+// Unless invalidated, the routing of each usage is found in the output routing cache.
+static void getOutputForAttr(benchmark::State& state, bool invalidateCache) {
+    BenchmarkManager manager;
+    if (!manager.initialize(state)) return;
+
+    const audio_usage_t usages[] = {
+        AUDIO_USAGE_MEDIA, AUDIO_USAGE_GAME, AUDIO_USAGE_NOTIFICATION,
+        AUDIO_USAGE_ASSISTANCE_SONIFICATION,
+    };
+    const audio_config_t config = pcmConfig();
+    size_t i = 0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        if (invalidateCache) manager->invalidateOutputRoutingCache();
+        audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+        attr.usage = usages[i++ % std::size(usages)];
+        audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
+        audio_stream_type_t stream = AUDIO_STREAM_DEFAULT;
+        audio_output_flags_t flags = AUDIO_OUTPUT_FLAG_NONE;
+        audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+        audio_port_handle_t portId = AUDIO_PORT_HANDLE_NONE;
+        std::vector<audio_io_handle_t> secondaryOutputs;
+        AudioPolicyInterface::output_type_t outputType;
+        if (manager->getOutputForAttr(&attr, &output, AUDIO_SESSION_NONE, &stream, 0 /*uid*/,
+                        &config, &flags, &selectedDeviceId, &portId, &secondaryOutputs,
+                        &outputType) != NO_ERROR) {
+            state.SkipWithError("getOutputForAttr failed");
+            return;
+        }
+        manager->releaseOutput(portId);
+    }
+    allocations.report(state);
+}
+
+static void BM_GetOutputForAttr(benchmark::State& state) {
+    getOutputForAttr(state, false /*invalidateCache*/);
+}
+BENCHMARK(BM_GetOutputForAttr);
+
+static void BM_GetOutputForAttrUncached(benchmark::State& state) {
+    getOutputForAttr(state, true /*invalidateCache*/);
+}
+BENCHMARK(BM_GetOutputForAttrUncached);
+
+// Record client creation and destruction
+static void BM_GetInputForAttr(benchmark::State& state) {
+    BenchmarkManager manager;
+    if (!manager.initialize(state)) return;
+
+    audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+    attr.source = AUDIO_SOURCE_MIC;
+    audio_unique_id_t riid = 1;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        audio_io_handle_t input = AUDIO_IO_HANDLE_NONE;
+        audio_config_base_t config = AUDIO_CONFIG_BASE_INITIALIZER;
+        config.sample_rate = 48000;
+        config.channel_mask = AUDIO_CHANNEL_IN_STEREO;
+        config.format = AUDIO_FORMAT_PCM_16_BIT;
+        audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+        audio_port_handle_t portId = AUDIO_PORT_HANDLE_NONE;
+        AudioPolicyInterface::input_type_t inputType;
+        if (manager->getInputForAttr(&attr, &input, riid++, AUDIO_SESSION_NONE, 0 /*uid*/,
+                        &config, AUDIO_INPUT_FLAG_NONE, &selectedDeviceId, &inputType,
+                        &portId) != NO_ERROR) {
+            state.SkipWithError("getInputForAttr failed");
+            return;
+        }
+        manager->releaseInput(portId);
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_GetInputForAttr);
+
+// One iteration changes the volume index of every stream, with a media track playing
+static void BM_SetStreamVolumeIndex(benchmark::State& state) {
+    constexpr int kMaxIndex = 15;
+    BenchmarkManager manager;
+    if (!manager.initialize(state)) return;
+    for (int stream = AUDIO_STREAM_MIN; stream < AUDIO_STREAM_PUBLIC_CNT; stream++) {
+        manager->initStreamVolume(static_cast<audio_stream_type_t>(stream), 0, kMaxIndex);
+    }
+
+    audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+    attr.usage = AUDIO_USAGE_MEDIA;
+    const audio_config_t config = pcmConfig();
+    audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
+    audio_stream_type_t stream = AUDIO_STREAM_DEFAULT;
+    audio_output_flags_t flags = AUDIO_OUTPUT_FLAG_NONE;
+    audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    audio_port_handle_t portId = AUDIO_PORT_HANDLE_NONE;
+    AudioPolicyInterface::output_type_t outputType;
+    if (manager->getOutputForAttr(&attr, &output, AUDIO_SESSION_NONE, &stream, 0 /*uid*/,
+                    &config, &flags, &selectedDeviceId, &portId, nullptr /*secondaryOutputs*/,
+                    &outputType) != NO_ERROR || manager->startOutput(portId) != NO_ERROR) {
+        state.SkipWithError("cannot start a media track");
+        return;
+    }
+
+    int index = 0;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        index = (index + 1) % (kMaxIndex + 1);
+        for (int s = AUDIO_STREAM_MIN; s < AUDIO_STREAM_PUBLIC_CNT; s++) {
+            manager->setStreamVolumeIndex(
+                    static_cast<audio_stream_type_t>(s), index, AUDIO_DEVICE_OUT_SPEAKER);
+        }
+    }
+    allocations.report(state);
+
+    manager->stopOutput(portId);
+    manager->releaseOutput(portId);
+}
+BENCHMARK(BM_SetStreamVolumeIndex);
+
+// Registration and unregistration of N loopback policy mixes at once
+static void BM_RegisterPolicyMixes(benchmark::State& state) {
+    const int mixCount = state.range(0);
+    BenchmarkManager manager;
+    if (!manager.initialize(state)) return;
+
+    const audio_config_t config = pcmConfig();
+    Vector<AudioMix> mixes;
+    for (int i = 0; i < mixCount; i++) {
+        Vector<AudioMixMatchCriterion> criteria;
+        criteria.add(AudioMixMatchCriterion(AUDIO_USAGE_MEDIA, AUDIO_SOURCE_DEFAULT,
+                        RULE_MATCH_ATTRIBUTE_USAGE));
+        AudioMixMatchCriterion uidCriterion;
+        uidCriterion.mRule = RULE_MATCH_UID;
+        uidCriterion.mValue.mUid = 10000 + i;
+        criteria.add(uidCriterion);
+        AudioMix mix(criteria, MIX_TYPE_PLAYERS, config, MIX_ROUTE_FLAG_LOOP_BACK,
+                String8(StringPrintf("benchmark_mix_%d", i).c_str()), 0);
+        mix.mDeviceType = AUDIO_DEVICE_OUT_REMOTE_SUBMIX;
+        mixes.add(mix);
+    }
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        if (manager->registerPolicyMixes(mixes) != NO_ERROR) {
+            state.SkipWithError("registerPolicyMixes failed");
+            return;
+        }
+        if (manager->unregisterPolicyMixes(mixes) != NO_ERROR) {
+            state.SkipWithError("unregisterPolicyMixes failed");
+            return;
+        }
+    }
+    allocations.report(state);
+}
+BENCHMARK(BM_RegisterPolicyMixes)->Arg(1)->Arg(16)->Arg(64);
+
+BENCHMARK_MAIN();
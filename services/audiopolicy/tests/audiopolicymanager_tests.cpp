@@ -18,6 +18,7 @@
 #include <string>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -1188,3 +1189,94 @@ TEST_F(AudioPolicyManagerDynamicHwModulesTest, ClientIsUpdated) {
     EXPECT_GT(mClient->getAudioPortListUpdateCount(), prevAudioPortListUpdateCount);
     EXPECT_GT(mManager->getAudioPortGeneration(), prevAudioPortGeneration);
 }
+
+class AudioPolicyManagerOutputRoutingCacheTest : public AudioPolicyManagerTestWithConfigurationFile {
+protected:
+    struct Routing {
+        audio_io_handle_t output = AUDIO_IO_HANDLE_NONE;
+        audio_port_handle_t selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+        audio_stream_type_t stream = AUDIO_STREAM_DEFAULT;
+        audio_output_flags_t flags = AUDIO_OUTPUT_FLAG_NONE;
+        bool operator==(const Routing &other) const {
+            return output == other.output && selectedDeviceId == other.selectedDeviceId &&
+                    stream == other.stream && flags == other.flags;
+        }
+    };
+
+    // Routes and releases a track, like a client creating and destroying an AudioTrack.
+    void routeTrack(audio_usage_t usage, audio_output_flags_t flags, Routing *routing);
+};
+
+void AudioPolicyManagerOutputRoutingCacheTest::routeTrack(
+        audio_usage_t usage, audio_output_flags_t flags, Routing *routing) {
+    audio_attributes_t attr = AUDIO_ATTRIBUTES_INITIALIZER;
+    attr.usage = usage;
+    audio_config_t config = AUDIO_CONFIG_INITIALIZER;
+    config.sample_rate = 48000;
+    config.channel_mask = AUDIO_CHANNEL_OUT_STEREO;
+    config.format = AUDIO_FORMAT_PCM_16_BIT;
+    routing->output = AUDIO_IO_HANDLE_NONE;
+    routing->selectedDeviceId = AUDIO_PORT_HANDLE_NONE;
+    routing->stream = AUDIO_STREAM_DEFAULT;
+    routing->flags = flags;
+    audio_port_handle_t portId = AUDIO_PORT_HANDLE_NONE;
+    std::vector<audio_io_handle_t> secondaryOutputs;
+    AudioPolicyInterface::output_type_t outputType;
+    ASSERT_EQ(OK, mManager->getOutputForAttr(&attr, &routing->output, AUDIO_SESSION_NONE,
+                    &routing->stream, 0 /*uid*/, &config, &routing->flags,
+                    &routing->selectedDeviceId, &portId, &secondaryOutputs, &outputType));
+    ASSERT_NE(AUDIO_PORT_HANDLE_NONE, portId);
+    ASSERT_NE(AUDIO_IO_HANDLE_NONE, routing->output);
+    ASSERT_EQ(AudioPolicyInterface::API_OUTPUT_LEGACY, outputType);
+    ASSERT_TRUE(secondaryOutputs.empty());
+    mManager->releaseOutput(portId);
+}
+
+TEST_F(AudioPolicyManagerOutputRoutingCacheTest, SameRoutingAsUncached) {
+    const audio_usage_t usages[] = {
+        AUDIO_USAGE_MEDIA, AUDIO_USAGE_GAME, AUDIO_USAGE_NOTIFICATION,
+        AUDIO_USAGE_ASSISTANCE_SONIFICATION, AUDIO_USAGE_ASSISTANT,
+    };
+    const audio_output_flags_t flags[] = {
+        AUDIO_OUTPUT_FLAG_NONE, AUDIO_OUTPUT_FLAG_FAST, AUDIO_OUTPUT_FLAG_DEEP_BUFFER,
+    };
+    for (audio_usage_t usage : usages) {
+        for (audio_output_flags_t flag : flags) {
+            SCOPED_TRACE(testing::Message() << "usage " << usage << " flags " << flag);
+            mManager->invalidateOutputRoutingCache();
+            Routing uncached;
+            ASSERT_NO_FATAL_FAILURE(routeTrack(usage, flag, &uncached));
+            const uint64_t hits = mManager->getOutputRoutingCacheHits();
+            Routing cached;
+            ASSERT_NO_FATAL_FAILURE(routeTrack(usage, flag, &cached));
+            EXPECT_LT(hits, mManager->getOutputRoutingCacheHits());
+            EXPECT_EQ(uncached, cached);
+        }
+    }
+}
+
+TEST_F(AudioPolicyManagerOutputRoutingCacheTest, InvalidatedOnDeviceConnection) {
+    Routing before;
+    ASSERT_NO_FATAL_FAILURE(routeTrack(AUDIO_USAGE_MEDIA, AUDIO_OUTPUT_FLAG_NONE, &before));
+
+    const uint32_t generation = mManager->getOutputRoutingCacheGeneration();
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_HDMI,
+                    AUDIO_POLICY_DEVICE_STATE_AVAILABLE, "", "", AUDIO_FORMAT_DEFAULT));
+    EXPECT_NE(generation, mManager->getOutputRoutingCacheGeneration());
+    audio_port hdmiPort;
+    ASSERT_TRUE(findDevicePort(AUDIO_PORT_ROLE_SINK, AUDIO_DEVICE_OUT_HDMI, "", &hdmiPort));
+
+    // Media now goes to HDMI, the decision taken for the speaker must not be reused
+    Routing connected;
+    ASSERT_NO_FATAL_FAILURE(routeTrack(AUDIO_USAGE_MEDIA, AUDIO_OUTPUT_FLAG_NONE, &connected));
+    EXPECT_EQ(hdmiPort.id, connected.selectedDeviceId);
+    Routing cached;
+    ASSERT_NO_FATAL_FAILURE(routeTrack(AUDIO_USAGE_MEDIA, AUDIO_OUTPUT_FLAG_NONE, &cached));
+    EXPECT_EQ(connected, cached);
+
+    ASSERT_EQ(NO_ERROR, mManager->setDeviceConnectionState(AUDIO_DEVICE_OUT_HDMI,
+                    AUDIO_POLICY_DEVICE_STATE_UNAVAILABLE, "", "", AUDIO_FORMAT_DEFAULT));
+    Routing after;
+    ASSERT_NO_FATAL_FAILURE(routeTrack(AUDIO_USAGE_MEDIA, AUDIO_OUTPUT_FLAG_NONE, &after));
+    EXPECT_EQ(before, after);
+}
@@ -695,8 +695,9 @@ Status CameraService::getCameraCharacteristics(const String16& cameraId,
 
     Status ret{};
 
-    status_t res = mCameraProviderManager->getCameraCharacteristics(
-            String8(cameraId).string(), cameraInfo);
+    std::shared_ptr<const CameraProviderManager::CharacteristicsSnapshot> snapshot;
+    status_t res = mCameraProviderManager->getCameraCharacteristicsSnapshot(
+            String8(cameraId).string(), &snapshot);
     if (res != OK) {
         return STATUS_ERROR_FMT(ERROR_INVALID_OPERATION, "Unable to retrieve camera "
                 "characteristics for device %s: %s (%d)", String8(cameraId).string(),
@@ -710,33 +711,24 @@ Status CameraService::getCameraCharacteristics(const String16& cameraId,
     }
     int callingPid = CameraThreadState::getCallingPid();
     int callingUid = CameraThreadState::getCallingUid();
-    std::vector<int32_t> tagsRemoved;
     // If it's not calling from cameraserver, check the permission only if
     // android.permission.CAMERA is required. If android.permission.SYSTEM_CAMERA was needed,
     // it would've already been checked in shouldRejectSystemCameraConnection.
+    // The filtered characteristics are precomputed in the snapshot, so only the final copy
+    // into the binder reply is done per call.
     if ((callingPid != getpid()) &&
             (deviceKind != SystemCameraKind::SYSTEM_ONLY_CAMERA) &&
             !checkPermission(sCameraPermission, callingPid, callingUid)) {
-        res = cameraInfo->removePermissionEntries(
-                mCameraProviderManager->getProviderTagIdLocked(String8(cameraId).string()),
-                &tagsRemoved);
+        res = snapshot->mPermissionFilterStatus;
         if (res != OK) {
             cameraInfo->clear();
             return STATUS_ERROR_FMT(ERROR_INVALID_OPERATION, "Failed to remove camera"
                     " characteristics needing camera permission for device %s: %s (%d)",
                     String8(cameraId).string(), strerror(-res), res);
         }
-    }
-
-    if (!tagsRemoved.empty()) {
-        res = cameraInfo->update(ANDROID_REQUEST_CHARACTERISTIC_KEYS_NEEDING_PERMISSION,
-                tagsRemoved.data(), tagsRemoved.size());
-        if (res != OK) {
-            cameraInfo->clear();
-            return STATUS_ERROR_FMT(ERROR_INVALID_OPERATION, "Failed to insert camera "
-                    "keys needing permission for device %s: %s (%d)", String8(cameraId).string(),
-                    strerror(-res), res);
-        }
+        *cameraInfo = snapshot->mPermissionFilteredCharacteristics;
+    } else {
+        *cameraInfo = snapshot->mCharacteristics;
     }
 
     return ret;
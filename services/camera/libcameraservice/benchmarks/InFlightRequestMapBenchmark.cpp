@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of the in-flight request bookkeeping done by Camera3Device for each capture result,
+// with the frame-number-indexed ring and with the sorted KeyedVector it replaced.
+//
+// adb shell /data/benchmarktest64/cameraservice_benchmark/cameraservice_benchmark
+
+#define LOG_TAG "InFlightRequestMapBenchmark"
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <utils/KeyedVector.h>
+
+#include "../device3/InFlightRequest.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+constexpr size_t kNumFrames = 1000;
+
+using InFlightRequestVector = KeyedVector<uint32_t, InFlightRequest>;
+
+InFlightRequest makeRequest(int numBuffers) {
+    return InFlightRequest(numBuffers, CaptureResultExtras(), /*hasInput*/false,
+            /*hasAppCallback*/true, InFlightRequest::kDefaultExpectedDuration,
+            std::set<String8>(), /*isStillCapture*/false, /*isZslCapture*/false,
+            /*rotateAndCropAuto*/false, std::set<std::string>());
+}
+
+void removeAt(InFlightRequestMap& map, ssize_t idx) {
+    map.removeItemAt(idx);
+}
+
+void removeAt(InFlightRequestVector& map, ssize_t idx) {
+    map.removeItemsAt(idx, 1);
+}
+
+// Replays a pipeline of the given depth where each frame gets a shutter, a partial result and a
+// buffer return, with results for neighbouring frames arriving slightly out of order. A request
+// is removed once its three results are delivered.
+// Returns false if a result is delivered for a frame missing from the map.
+template<typename MapT>
+bool replayPipeline(MapT& map, size_t numFrames, size_t depth) {
+    constexpr int kResultsPerFrame = 3;
+    std::mt19937 rng(1234);
+    std::vector<uint32_t> pending;
+    uint32_t nextFrame = 0;
+    while (nextFrame < numFrames || !pending.empty()) {
+        while (nextFrame < numFrames && pending.size() < depth * kResultsPerFrame) {
+            map.add(nextFrame, makeRequest(kResultsPerFrame));
+            pending.insert(pending.end(), kResultsPerFrame, nextFrame);
+            nextFrame++;
+        }
+        // Deliver one of the oldest few results, to emulate reordering across streams
+        size_t pick = std::min<size_t>(rng() % 4, pending.size() - 1);
+        uint32_t frameNumber = pending[pick];
+        pending.erase(pending.begin() + pick);
+        ssize_t idx = map.indexOfKey(frameNumber);
+        if (idx < 0) return false;
+        if (--map.editValueAt(idx).numBuffersLeft == 0) {
+            removeAt(map, idx);
+        }
+    }
+    return map.isEmpty();
+}
+
+template<typename MapT>
+void BM_NotifyResultReplay(benchmark::State& state) {
+    const size_t depth = state.range(0);
+    for (auto _ : state) {
+        MapT map;
+        if (!replayPipeline(map, kNumFrames, depth)) {
+            state.SkipWithError("result delivered for an unknown frame");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_NotifyResultReplay, InFlightRequestMap)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK_TEMPLATE(BM_NotifyResultReplay, InFlightRequestVector)->Arg(4)->Arg(8)->Arg(16)->Arg(32);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of TagMonitor::monitorMetadata() per capture result, with monitoring disabled and with
+// the 3A tags monitored.
+
+#define LOG_TAG "TagMonitorBenchmark"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../utils/TagMonitor.h"
+
+using namespace android;
+
+namespace {
+
+// A result with a realistic number of entries
+CameraMetadata makeResult(uint8_t aeState, int32_t afTrigger, int64_t exposure, float focus) {
+    CameraMetadata result;
+    result.update(ANDROID_CONTROL_AE_STATE, &aeState, 1);
+    result.update(ANDROID_CONTROL_AF_TRIGGER_ID, &afTrigger, 1);
+    result.update(ANDROID_SENSOR_EXPOSURE_TIME, &exposure, 1);
+    int32_t regions[] = {0, 0, 100, 100, 1};
+    result.update(ANDROID_CONTROL_AE_REGIONS, regions, 5);
+    result.update(ANDROID_LENS_FOCUS_DISTANCE, &focus, 1);
+    return result;
+}
+
+const std::unordered_map<std::string, CameraMetadata> kNoPhysicalMetadata;
+
+void BM_MonitorMetadata(benchmark::State& state, const char* tagNames) {
+    // The 3A tags change every few frames
+    std::vector<CameraMetadata> results;
+    for (int i = 0; i < 8; i++) {
+        results.push_back(makeResult(
+                (i < 4) ? ANDROID_CONTROL_AE_STATE_SEARCHING : ANDROID_CONTROL_AE_STATE_CONVERGED,
+                i / 2, 10000000 + i, 0.1f * i));
+    }
+
+    TagMonitor monitor;
+    if (tagNames != nullptr) {
+        monitor.parseTagsToMonitor(String8(tagNames));
+        if (!monitor.isMonitoringEnabled()) {
+            state.SkipWithError("cannot enable monitoring");
+            return;
+        }
+    }
+
+    int64_t frameNumber = 0;
+    for (auto _ : state) {
+        monitor.monitorMetadata(TagMonitor::RESULT, frameNumber, (frameNumber + 1) * 100,
+                results[(frameNumber / 4) % results.size()], kNoPhysicalMetadata);
+        frameNumber++;
+    }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_MonitorMetadata, disabled, nullptr);
+BENCHMARK_CAPTURE(BM_MonitorMetadata, 3a, "3a");
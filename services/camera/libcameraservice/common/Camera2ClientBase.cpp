@@ -171,6 +171,11 @@ status_t Camera2ClientBase<TClientBase>::dumpDevice(
         write(fd, result.string(), result.size());
     }
 
+    CaptureLatencySnapshot latencySnapshot;
+    device->getCaptureLatencySnapshot(&latencySnapshot);
+    CameraCaptureLatencyTracker::dumpSnapshot(fd, "    Capture stage latency histogram:",
+            latencySnapshot);
+
     return NO_ERROR;
 }
 
@@ -36,6 +36,7 @@
 #include "device3/StatusTracker.h"
 #include "binder/Status.h"
 #include "FrameProducer.h"
+#include "utils/CaptureLatencyTracker.h"
 
 #include "CameraOfflineSessionBase.h"
 
@@ -64,6 +65,11 @@ class CameraDeviceBase : public virtual FrameProducer {
 
     virtual status_t dump(int fd, const Vector<String16> &args) = 0;
 
+    /**
+     * Get a binary copy of the per-stage latency histograms of the completed captures
+     */
+    virtual void getCaptureLatencySnapshot(CaptureLatencySnapshot* snapshot) const = 0;
+
     /**
      * The physical camera device's static characteristics metadata buffer
      */
@@ -278,13 +278,100 @@ status_t CameraProviderManager::getCameraInfo(const std::string &id,
 status_t CameraProviderManager::isSessionConfigurationSupported(const std::string& id,
         const hardware::camera::device::V3_4::StreamConfiguration &configuration,
         bool *status /*out*/) const {
-    std::lock_guard<std::mutex> lock(mInterfaceMutex);
-    auto deviceInfo = findDeviceInfoLocked(id);
-    if (deviceInfo == nullptr) {
-        return NAME_NOT_FOUND;
+    if (status == nullptr) return BAD_VALUE;
+
+    std::string cacheKey = sessionConfigurationCacheKey(id, configuration);
+    uint64_t cacheGeneration;
+    {
+        std::lock_guard<std::mutex> cacheLock(mSessionConfigCacheLock);
+        auto cached = mSessionConfigCache.find(cacheKey);
+        if (cached != mSessionConfigCache.end()) {
+            mSessionConfigCacheHits++;
+            *status = cached->second;
+            return OK;
+        }
+        mSessionConfigCacheMisses++;
+        cacheGeneration = mSessionConfigCacheGeneration;
+    }
+
+    std::shared_ptr<ProviderInfo::DeviceInfo> deviceInfo;
+    sp<ProviderInfo> parentProvider;
+    sp<IBase> interface;
+    {
+        std::lock_guard<std::mutex> lock(mInterfaceMutex);
+        deviceInfo = findDeviceInfoLocked(id);
+        if (deviceInfo == nullptr) {
+            return NAME_NOT_FOUND;
+        }
+        if (deviceInfo->mVersion.get_major() < 3) {
+            // Only HALv3 devices can be queried, don't start the device for nothing.
+            return INVALID_OPERATION;
+        }
+        parentProvider = deviceInfo->mParentProvider.promote();
+        if (parentProvider == nullptr) {
+            return DEAD_OBJECT;
+        }
+        interface = deviceInfo->startInterfaceLocked();
+        if (interface == nullptr) {
+            return DEAD_OBJECT;
+        }
+    }
+
+    status_t res;
+    {
+        // The HAL query may take a while for logical cameras; don't block other devices on it.
+        std::lock_guard<std::mutex> deviceLock(deviceInfo->mDeviceLock);
+        res = deviceInfo->isSessionConfigurationSupported(interface, configuration, status);
+    }
+
+    if (res == OK) {
+        std::lock_guard<std::mutex> cacheLock(mSessionConfigCacheLock);
+        if (cacheGeneration == mSessionConfigCacheGeneration) {
+            if (mSessionConfigCache.size() >= kMaxSessionConfigCacheEntries) {
+                mSessionConfigCache.clear();
+            }
+            mSessionConfigCache.emplace(std::move(cacheKey), *status);
+        }
     }
+    return res;
+}
 
-    return deviceInfo->isSessionConfigurationSupported(configuration, status);
+std::string CameraProviderManager::sessionConfigurationCacheKey(const std::string& id,
+        const hardware::camera::device::V3_4::StreamConfiguration &configuration) {
+    std::string key;
+    auto append = [&key](const auto& value) {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto appendString = [&key, &append](const std::string& str) {
+        append(str.size());
+        key.append(str);
+    };
+
+    appendString(id);
+    append(configuration.operationMode);
+    append(configuration.sessionParams.size());
+    key.append(reinterpret_cast<const char*>(configuration.sessionParams.data()),
+            configuration.sessionParams.size());
+    append(configuration.streams.size());
+    for (const auto& stream : configuration.streams) {
+        append(stream.v3_2.id);
+        append(stream.v3_2.streamType);
+        append(stream.v3_2.width);
+        append(stream.v3_2.height);
+        append(stream.v3_2.format);
+        append(stream.v3_2.usage);
+        append(stream.v3_2.dataSpace);
+        append(stream.v3_2.rotation);
+        appendString(stream.physicalCameraId);
+        append(stream.bufferSize);
+    }
+    return key;
+}
+
+void CameraProviderManager::invalidateSessionConfigurationCache() {
+    std::lock_guard<std::mutex> cacheLock(mSessionConfigCacheLock);
+    mSessionConfigCache.clear();
+    mSessionConfigCacheGeneration++;
 }
 
 status_t CameraProviderManager::getCameraCharacteristics(const std::string &id,
@@ -293,6 +380,12 @@ status_t CameraProviderManager::getCameraCharacteristics(const std::string &id,
     return getCameraCharacteristicsLocked(id, characteristics);
 }
 
+status_t CameraProviderManager::getCameraCharacteristicsSnapshot(const std::string &id,
+        std::shared_ptr<const CharacteristicsSnapshot>* snapshot) const {
+    std::lock_guard<std::mutex> lock(mInterfaceMutex);
+    return getCameraCharacteristicsSnapshotLocked(id, snapshot);
+}
+
 status_t CameraProviderManager::getHighestSupportedVersion(const std::string &id,
         hardware::hidl_version *v) {
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
@@ -328,24 +421,35 @@ bool CameraProviderManager::supportSetTorchMode(const std::string &id) const {
 }
 
 status_t CameraProviderManager::setTorchMode(const std::string &id, bool enabled) {
-    std::lock_guard<std::mutex> lock(mInterfaceMutex);
+    std::shared_ptr<ProviderInfo::DeviceInfo> deviceInfo;
+    sp<ProviderInfo> parentProvider;
+    sp<IBase> deviceInterface;
+    {
+        std::lock_guard<std::mutex> lock(mInterfaceMutex);
 
-    auto deviceInfo = findDeviceInfoLocked(id);
-    if (deviceInfo == nullptr) return NAME_NOT_FOUND;
+        deviceInfo = findDeviceInfoLocked(id);
+        if (deviceInfo == nullptr) return NAME_NOT_FOUND;
 
-    // Pass the camera ID to start interface so that it will save it to the map of ICameraProviders
-    // that are currently in use.
-    sp<ProviderInfo> parentProvider = deviceInfo->mParentProvider.promote();
-    if (parentProvider == nullptr) {
-        return DEAD_OBJECT;
-    }
-    const sp<provider::V2_4::ICameraProvider> interface = parentProvider->startProviderInterface();
-    if (interface == nullptr) {
-        return DEAD_OBJECT;
+        // Pass the camera ID to start interface so that it will save it to the map of
+        // ICameraProviders that are currently in use.
+        parentProvider = deviceInfo->mParentProvider.promote();
+        if (parentProvider == nullptr) {
+            return DEAD_OBJECT;
+        }
+        const sp<provider::V2_4::ICameraProvider> interface =
+                parentProvider->startProviderInterface();
+        if (interface == nullptr) {
+            return DEAD_OBJECT;
+        }
+        saveRef(DeviceMode::TORCH, deviceInfo->mId, interface);
+        deviceInterface = deviceInfo->startInterfaceLocked();
+        if (deviceInterface == nullptr) {
+            return DEAD_OBJECT;
+        }
     }
-    saveRef(DeviceMode::TORCH, deviceInfo->mId, interface);
 
-    return deviceInfo->setTorchMode(enabled);
+    std::lock_guard<std::mutex> deviceLock(deviceInfo->mDeviceLock);
+    return deviceInfo->setTorchMode(deviceInterface, enabled);
 }
 
 status_t CameraProviderManager::setUpVendorTags() {
@@ -364,6 +468,8 @@ status_t CameraProviderManager::notifyDeviceStateChange(
         hardware::hidl_bitfield<provider::V2_5::DeviceState> newState) {
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
     mDeviceState = newState;
+    // Supported stream combinations may depend on the device state (e.g. folded)
+    invalidateSessionConfigurationCache();
     status_t res = OK;
     for (auto& provider : mProviders) {
         ALOGV("%s: Notifying %s for new state 0x%" PRIx64,
@@ -385,31 +491,39 @@ status_t CameraProviderManager::openSession(const std::string &id,
         /*out*/
         sp<device::V3_2::ICameraDeviceSession> *session) {
 
-    std::lock_guard<std::mutex> lock(mInterfaceMutex);
+    std::shared_ptr<ProviderInfo::DeviceInfo> deviceInfo;
+    sp<ProviderInfo> parentProvider;
+    sp<ProviderInfo::DeviceInfo3::InterfaceT> interface;
+    {
+        std::lock_guard<std::mutex> lock(mInterfaceMutex);
 
-    auto deviceInfo = findDeviceInfoLocked(id,
-            /*minVersion*/ {3,0}, /*maxVersion*/ {4,0});
-    if (deviceInfo == nullptr) return NAME_NOT_FOUND;
+        deviceInfo = findDeviceInfoLocked(id,
+                /*minVersion*/ {3,0}, /*maxVersion*/ {4,0});
+        if (deviceInfo == nullptr) return NAME_NOT_FOUND;
 
-    auto *deviceInfo3 = static_cast<ProviderInfo::DeviceInfo3*>(deviceInfo);
-    sp<ProviderInfo> parentProvider = deviceInfo->mParentProvider.promote();
-    if (parentProvider == nullptr) {
-        return DEAD_OBJECT;
-    }
-    const sp<provider::V2_4::ICameraProvider> provider = parentProvider->startProviderInterface();
-    if (provider == nullptr) {
-        return DEAD_OBJECT;
+        parentProvider = deviceInfo->mParentProvider.promote();
+        if (parentProvider == nullptr) {
+            return DEAD_OBJECT;
+        }
+        const sp<provider::V2_4::ICameraProvider> provider =
+                parentProvider->startProviderInterface();
+        if (provider == nullptr) {
+            return DEAD_OBJECT;
+        }
+        saveRef(DeviceMode::CAMERA, id, provider);
+
+        auto *deviceInfo3 = static_cast<ProviderInfo::DeviceInfo3*>(deviceInfo.get());
+        interface = deviceInfo3->startDeviceInterface<
+                CameraProviderManager::ProviderInfo::DeviceInfo3::InterfaceT>();
+        if (interface == nullptr) {
+            return DEAD_OBJECT;
+        }
     }
-    saveRef(DeviceMode::CAMERA, id, provider);
 
+    // Opening powers up the device and can be slow; only this device is blocked meanwhile.
+    std::lock_guard<std::mutex> deviceLock(deviceInfo->mDeviceLock);
     Status status;
     hardware::Return<void> ret;
-    auto interface = deviceInfo3->startDeviceInterface<
-            CameraProviderManager::ProviderInfo::DeviceInfo3::InterfaceT>();
-    if (interface == nullptr) {
-        return DEAD_OBJECT;
-    }
-
     ret = interface->open(callback, [&status, &session]
             (Status s, const sp<device::V3_2::ICameraDeviceSession>& cameraSession) {
                 status = s;
@@ -431,28 +545,36 @@ status_t CameraProviderManager::openSession(const std::string &id,
         /*out*/
         sp<device::V1_0::ICameraDevice> *session) {
 
-    std::lock_guard<std::mutex> lock(mInterfaceMutex);
+    std::shared_ptr<ProviderInfo::DeviceInfo> deviceInfo;
+    sp<ProviderInfo> parentProvider;
+    sp<ProviderInfo::DeviceInfo1::InterfaceT> interface;
+    {
+        std::lock_guard<std::mutex> lock(mInterfaceMutex);
 
-    auto deviceInfo = findDeviceInfoLocked(id,
-            /*minVersion*/ {1,0}, /*maxVersion*/ {2,0});
-    if (deviceInfo == nullptr) return NAME_NOT_FOUND;
+        deviceInfo = findDeviceInfoLocked(id,
+                /*minVersion*/ {1,0}, /*maxVersion*/ {2,0});
+        if (deviceInfo == nullptr) return NAME_NOT_FOUND;
 
-    auto *deviceInfo1 = static_cast<ProviderInfo::DeviceInfo1*>(deviceInfo);
-    sp<ProviderInfo> parentProvider = deviceInfo->mParentProvider.promote();
-    if (parentProvider == nullptr) {
-        return DEAD_OBJECT;
-    }
-    const sp<provider::V2_4::ICameraProvider> provider = parentProvider->startProviderInterface();
-    if (provider == nullptr) {
-        return DEAD_OBJECT;
-    }
-    saveRef(DeviceMode::CAMERA, id, provider);
+        parentProvider = deviceInfo->mParentProvider.promote();
+        if (parentProvider == nullptr) {
+            return DEAD_OBJECT;
+        }
+        const sp<provider::V2_4::ICameraProvider> provider =
+                parentProvider->startProviderInterface();
+        if (provider == nullptr) {
+            return DEAD_OBJECT;
+        }
+        saveRef(DeviceMode::CAMERA, id, provider);
 
-    auto interface = deviceInfo1->startDeviceInterface<
-            CameraProviderManager::ProviderInfo::DeviceInfo1::InterfaceT>();
-    if (interface == nullptr) {
-        return DEAD_OBJECT;
+        auto *deviceInfo1 = static_cast<ProviderInfo::DeviceInfo1*>(deviceInfo.get());
+        interface = deviceInfo1->startDeviceInterface<
+                CameraProviderManager::ProviderInfo::DeviceInfo1::InterfaceT>();
+        if (interface == nullptr) {
+            return DEAD_OBJECT;
+        }
     }
+
+    std::lock_guard<std::mutex> deviceLock(deviceInfo->mDeviceLock);
     hardware::Return<Status> status = interface->open(callback);
     if (!status.isOk()) {
         removeRef(DeviceMode::CAMERA, id);
@@ -545,20 +667,29 @@ hardware::Return<void> CameraProviderManager::onRegistration(
 status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
     std::lock_guard<std::mutex> lock(mInterfaceMutex);
 
+    {
+        std::lock_guard<std::mutex> cacheLock(mSessionConfigCacheLock);
+        uint64_t queries = mSessionConfigCacheHits + mSessionConfigCacheMisses;
+        dprintf(fd, "== Session configuration query cache: %zu entries, %" PRIu64 " hits, "
+                "%" PRIu64 " misses (%.1f%% hit rate) ==\n", mSessionConfigCache.size(),
+                mSessionConfigCacheHits, mSessionConfigCacheMisses,
+                queries > 0 ? 100.0 * mSessionConfigCacheHits / queries : 0.0);
+    }
+
     for (auto& provider : mProviders) {
         provider->dump(fd, args);
     }
     return OK;
 }
 
-CameraProviderManager::ProviderInfo::DeviceInfo* CameraProviderManager::findDeviceInfoLocked(
-        const std::string& id,
+std::shared_ptr<CameraProviderManager::ProviderInfo::DeviceInfo>
+CameraProviderManager::findDeviceInfoLocked(const std::string& id,
         hardware::hidl_version minVersion, hardware::hidl_version maxVersion) const {
     for (auto& provider : mProviders) {
         for (auto& deviceInfo : provider->mDevices) {
             if (deviceInfo->mId == id &&
                     minVersion <= deviceInfo->mVersion && maxVersion >= deviceInfo->mVersion) {
-                return deviceInfo.get();
+                return deviceInfo;
             }
         }
     }
@@ -1210,8 +1341,10 @@ CameraProviderManager::isHiddenPhysicalCameraInternal(const std::string& cameraI
 
     for (auto& provider : mProviders) {
         for (auto& deviceInfo : provider->mDevices) {
-            CameraMetadata info;
-            status_t res = deviceInfo->getCameraCharacteristics(&info);
+            // Only the availability of API2 characteristics matters here, so use the shared
+            // snapshot instead of copying the metadata.
+            std::shared_ptr<const CharacteristicsSnapshot> snapshot;
+            status_t res = deviceInfo->getCharacteristicsSnapshot(&snapshot);
             if (res != OK) {
                 ALOGE("%s: Failed to getCameraCharacteristics for id %s", __FUNCTION__,
                         deviceInfo->mId.c_str());
@@ -1264,6 +1397,7 @@ status_t CameraProviderManager::addProviderLocked(const std::string& newProvider
     }
 
     mProviders.push_back(providerInfo);
+    invalidateSessionConfigurationCache();
 
     return OK;
 }
@@ -1280,6 +1414,7 @@ status_t CameraProviderManager::removeProvider(const std::string& provider) {
                 removedDeviceIds.push_back(String8(deviceInfo->mId.c_str()));
             }
             mProviders.erase(it);
+            invalidateSessionConfigurationCache();
             res = OK;
             break;
         }
@@ -1658,8 +1793,8 @@ status_t CameraProviderManager::ProviderInfo::dump(int fd, const Vector<String16
                     info.facing == hardware::CAMERA_FACING_BACK ? "Back" : "Front");
             dprintf(fd, "    Orientation: %d\n", info.orientation);
         }
-        CameraMetadata info2;
-        res = device->getCameraCharacteristics(&info2);
+        std::shared_ptr<const CharacteristicsSnapshot> snapshot;
+        res = device->getCharacteristicsSnapshot(&snapshot);
         if (res == INVALID_OPERATION) {
             dprintf(fd, "  API2 not directly supported\n");
         } else if (res != OK) {
@@ -1667,7 +1802,7 @@ status_t CameraProviderManager::ProviderInfo::dump(int fd, const Vector<String16
                     strerror(-res), res);
         } else {
             dprintf(fd, "  API2 camera characteristics:\n");
-            info2.dump(fd, /*verbosity*/ 2, /*indentation*/ 4);
+            snapshot->mCharacteristics.dump(fd, /*verbosity*/ 2, /*indentation*/ 4);
         }
 
         // Dump characteristics of non-standalone physical camera
@@ -1679,11 +1814,13 @@ status_t CameraProviderManager::ProviderInfo::dump(int fd, const Vector<String16
                     continue;
                 }
 
-                CameraMetadata physicalInfo;
-                status_t status = device->getPhysicalCameraCharacteristics(id, &physicalInfo);
+                std::shared_ptr<const CharacteristicsSnapshot> physicalSnapshot;
+                status_t status = device->getPhysicalCharacteristicsSnapshot(id,
+                        &physicalSnapshot);
                 if (status == OK) {
                     dprintf(fd, "  Physical camera %s characteristics:\n", id.c_str());
-                    physicalInfo.dump(fd, /*verbosity*/ 2, /*indentation*/ 4);
+                    physicalSnapshot->mCharacteristics.dump(fd, /*verbosity*/ 2,
+                            /*indentation*/ 4);
                 }
             }
         }
@@ -1824,6 +1961,7 @@ status_t CameraProviderManager::ProviderInfo::cameraDeviceStatusChangeLocked(
     } else if (newStatus == CameraDeviceStatus::NOT_PRESENT) {
         removeDevice(cameraId);
     }
+    mManager->invalidateSessionConfigurationCache();
     if (reCacheConcurrentStreamingCameraIdsLocked() != OK) {
         ALOGE("%s: CameraProvider %s could not re-cache concurrent streaming camera id list ",
                   __FUNCTION__, mProviderName.c_str());
@@ -1900,6 +2038,7 @@ status_t CameraProviderManager::ProviderInfo::physicalCameraDeviceStatusChangeLo
                 physicalCameraDeviceName.c_str());
         return BAD_VALUE;
     }
+    mManager->invalidateSessionConfigurationCache();
 
     *id = cameraId;
     *physicalId = physicalCameraDeviceName.c_str();
@@ -2271,8 +2410,14 @@ CameraProviderManager::ProviderInfo::DeviceInfo1::DeviceInfo1(const std::string&
 
 CameraProviderManager::ProviderInfo::DeviceInfo1::~DeviceInfo1() {}
 
-status_t CameraProviderManager::ProviderInfo::DeviceInfo1::setTorchMode(bool enabled) {
-    return setTorchModeForDevice<InterfaceT>(enabled);
+sp<hidl::base::V1_0::IBase>
+CameraProviderManager::ProviderInfo::DeviceInfo1::startInterfaceLocked() {
+    return startDeviceInterface<InterfaceT>();
+}
+
+status_t CameraProviderManager::ProviderInfo::DeviceInfo1::setTorchMode(
+        const sp<IBase>& interface, bool enabled) {
+    return setTorchModeForDevice<InterfaceT>(interface, enabled);
 }
 
 status_t CameraProviderManager::ProviderInfo::DeviceInfo1::getCameraInfo(
@@ -2488,8 +2633,14 @@ CameraProviderManager::ProviderInfo::DeviceInfo3::DeviceInfo3(const std::string&
 
 CameraProviderManager::ProviderInfo::DeviceInfo3::~DeviceInfo3() {}
 
-status_t CameraProviderManager::ProviderInfo::DeviceInfo3::setTorchMode(bool enabled) {
-    return setTorchModeForDevice<InterfaceT>(enabled);
+sp<hidl::base::V1_0::IBase>
+CameraProviderManager::ProviderInfo::DeviceInfo3::startInterfaceLocked() {
+    return startDeviceInterface<InterfaceT>();
+}
+
+status_t CameraProviderManager::ProviderInfo::DeviceInfo3::setTorchMode(
+        const sp<IBase>& interface, bool enabled) {
+    return setTorchModeForDevice<InterfaceT>(interface, enabled);
 }
 
 status_t CameraProviderManager::ProviderInfo::DeviceInfo3::getCameraInfo(
@@ -2582,16 +2733,67 @@ status_t CameraProviderManager::ProviderInfo::DeviceInfo3::getPhysicalCameraChar
     return OK;
 }
 
+std::shared_ptr<const CameraProviderManager::CharacteristicsSnapshot>
+CameraProviderManager::ProviderInfo::DeviceInfo3::createCharacteristicsSnapshot(
+        const CameraMetadata& characteristics) const {
+    auto snapshot = std::make_shared<CharacteristicsSnapshot>();
+    snapshot->mCharacteristics = characteristics;
+
+    CameraMetadata& filtered = snapshot->mPermissionFilteredCharacteristics;
+    filtered = characteristics;
+    std::vector<int32_t> tagsRemoved;
+    status_t res = filtered.removePermissionEntries(mProviderTagid, &tagsRemoved);
+    if (res == OK && !tagsRemoved.empty()) {
+        res = filtered.update(ANDROID_REQUEST_CHARACTERISTIC_KEYS_NEEDING_PERMISSION,
+                tagsRemoved.data(), tagsRemoved.size());
+    }
+    if (res != OK) {
+        ALOGE("%s: Failed to build permission-filtered characteristics for camera %s: %s (%d)",
+                __FUNCTION__, mId.c_str(), strerror(-res), res);
+        filtered.clear();
+    }
+    snapshot->mPermissionFilterStatus = res;
+
+    return snapshot;
+}
+
+status_t CameraProviderManager::ProviderInfo::DeviceInfo3::getCharacteristicsSnapshot(
+        std::shared_ptr<const CharacteristicsSnapshot> *snapshot) const {
+    if (snapshot == nullptr) return BAD_VALUE;
+
+    std::lock_guard<std::mutex> lock(mSnapshotLock);
+    if (mCharacteristicsSnapshot == nullptr) {
+        mCharacteristicsSnapshot = createCharacteristicsSnapshot(mCameraCharacteristics);
+    }
+    *snapshot = mCharacteristicsSnapshot;
+    return OK;
+}
+
+status_t CameraProviderManager::ProviderInfo::DeviceInfo3::getPhysicalCharacteristicsSnapshot(
+        const std::string& physicalCameraId,
+        std::shared_ptr<const CharacteristicsSnapshot> *snapshot) const {
+    if (snapshot == nullptr) return BAD_VALUE;
+    auto physicalChars = mPhysicalCameraCharacteristics.find(physicalCameraId);
+    if (physicalChars == mPhysicalCameraCharacteristics.end()) {
+        return NAME_NOT_FOUND;
+    }
+
+    std::lock_guard<std::mutex> lock(mSnapshotLock);
+    auto& physicalSnapshot = mPhysicalCharacteristicsSnapshots[physicalCameraId];
+    if (physicalSnapshot == nullptr) {
+        physicalSnapshot = createCharacteristicsSnapshot(physicalChars->second);
+    }
+    *snapshot = physicalSnapshot;
+    return OK;
+}
+
 status_t CameraProviderManager::ProviderInfo::DeviceInfo3::isSessionConfigurationSupported(
+        const sp<IBase>& interface,
         const hardware::camera::device::V3_4::StreamConfiguration &configuration,
         bool *status /*out*/) {
 
-    const sp<CameraProviderManager::ProviderInfo::DeviceInfo3::InterfaceT> interface =
-            this->startDeviceInterface<CameraProviderManager::ProviderInfo::DeviceInfo3::InterfaceT>();
-    if (interface == nullptr) {
-        return DEAD_OBJECT;
-    }
-    auto castResult = device::V3_5::ICameraDevice::castFrom(interface);
+    const sp<InterfaceT> deviceInterface = static_cast<InterfaceT *>(interface.get());
+    auto castResult = device::V3_5::ICameraDevice::castFrom(deviceInterface);
     sp<hardware::camera::device::V3_5::ICameraDevice> interface_3_5 = castResult;
     if (interface_3_5 == nullptr) {
         return INVALID_OPERATION;
@@ -2979,11 +3181,13 @@ status_t CameraProviderManager::convertToHALStreamCombinationAndCameraIdsLocked(
     status_t res = OK;
     for (auto &cameraIdAndSessionConfig : cameraIdsAndSessionConfigs) {
         hardware::camera::device::V3_4::StreamConfiguration streamConfiguration;
-        CameraMetadata deviceInfo;
-        res = getCameraCharacteristicsLocked(cameraIdAndSessionConfig.mCameraId, &deviceInfo);
+        std::shared_ptr<const CharacteristicsSnapshot> snapshot;
+        res = getCameraCharacteristicsSnapshotLocked(cameraIdAndSessionConfig.mCameraId,
+                &snapshot);
         if (res != OK) {
             return res;
         }
+        const CameraMetadata &deviceInfo = snapshot->mCharacteristics;
         metadataGetter getMetadata =
                 [this](const String8 &id) {
                     CameraMetadata physicalDeviceInfo;
@@ -3093,6 +3297,24 @@ status_t CameraProviderManager::getCameraCharacteristicsLocked(const std::string
     return NAME_NOT_FOUND;
 }
 
+status_t CameraProviderManager::getCameraCharacteristicsSnapshotLocked(const std::string &id,
+        std::shared_ptr<const CharacteristicsSnapshot>* snapshot) const {
+    auto deviceInfo = findDeviceInfoLocked(id, /*minVersion*/ {3,0}, /*maxVersion*/ {5,0});
+    if (deviceInfo != nullptr) {
+        return deviceInfo->getCharacteristicsSnapshot(snapshot);
+    }
+
+    // Find hidden physical camera characteristics
+    for (auto& provider : mProviders) {
+        for (auto& deviceInfo : provider->mDevices) {
+            status_t res = deviceInfo->getPhysicalCharacteristicsSnapshot(id, snapshot);
+            if (res != NAME_NOT_FOUND && res != INVALID_OPERATION) return res;
+        }
+    }
+
+    return NAME_NOT_FOUND;
+}
+
 void CameraProviderManager::filterLogicalCameraIdsLocked(
         std::vector<std::string>& deviceIds) const
 {
@@ -18,6 +18,7 @@
 #define ANDROID_SERVERS_CAMERA_CAMERAPROVIDER_H
 
 #include <vector>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
@@ -220,6 +221,28 @@ public:
     status_t getCameraCharacteristics(const std::string &id,
             CameraMetadata* characteristics) const;
 
+    /**
+     * Immutable view of a camera device's static characteristics, shared between all callers.
+     * The permission-filtered variant has every entry requiring android.permission.CAMERA
+     * removed, with ANDROID_REQUEST_CHARACTERISTIC_KEYS_NEEDING_PERMISSION listing them.
+     */
+    struct CharacteristicsSnapshot {
+        CameraMetadata mCharacteristics;
+        CameraMetadata mPermissionFilteredCharacteristics;
+        // Result of building mPermissionFilteredCharacteristics; the filtered variant is
+        // empty unless this is OK.
+        status_t mPermissionFilterStatus = OK;
+    };
+
+    /**
+     * Return a reference-counted snapshot of the API2 camera characteristics. Unlike
+     * getCameraCharacteristics(), this does not copy the metadata; the snapshot is built once
+     * per device and stays valid after the device is removed. Returns NAME_NOT_FOUND if a
+     * device ID does not have a v3 or newer HAL version.
+     */
+    status_t getCameraCharacteristicsSnapshot(const std::string &id,
+            std::shared_ptr<const CharacteristicsSnapshot>* snapshot) const;
+
     status_t isConcurrentSessionConfigurationSupported(
             const std::vector<hardware::camera2::utils::CameraIdAndSessionConfiguration>
                     &cameraIdsAndSessionConfigs,
@@ -227,7 +250,8 @@ public:
 
     std::vector<std::unordered_set<std::string>> getConcurrentCameraIds() const;
     /**
-     * Check for device support of specific stream combination.
+     * Check for device support of specific stream combination. Definitive answers from the HAL
+     * are memoized until the device state or the set of camera devices changes.
      */
     status_t isSessionConfigurationSupported(const std::string& id,
             const hardware::camera::device::V3_4::StreamConfiguration &configuration,
@@ -326,7 +350,10 @@ public:
 
     static const float kDepthARTolerance;
 private:
-    // All private members, unless otherwise noted, expect mInterfaceMutex to be locked before use
+    // All private members, unless otherwise noted, expect mInterfaceMutex to be locked before use.
+    // Potentially slow per-device HAL calls (opening sessions, torch control and stream
+    // combination queries) only hold mInterfaceMutex for the device lookup, and then run under
+    // the device's own DeviceInfo::mDeviceLock so that independent devices proceed in parallel.
     mutable std::mutex mInterfaceMutex;
 
     wp<StatusListener> mListener;
@@ -340,6 +367,22 @@ private:
 
     static HardwareServiceInteractionProxy sHardwareServiceInteractionProxy;
 
+    // Memoized isSessionConfigurationSupported() answers, keyed by camera id and the
+    // canonical serialization of the HAL stream configuration. Guarded by
+    // mSessionConfigCacheLock, not mInterfaceMutex, since queries run without the latter.
+    static constexpr size_t kMaxSessionConfigCacheEntries = 256;
+    mutable std::mutex mSessionConfigCacheLock;
+    mutable std::unordered_map<std::string, bool> mSessionConfigCache;
+    // Bumped on every invalidation, so that answers racing with a device or provider change
+    // are not inserted after the fact.
+    mutable uint64_t mSessionConfigCacheGeneration = 0;
+    mutable uint64_t mSessionConfigCacheHits = 0;
+    mutable uint64_t mSessionConfigCacheMisses = 0;
+
+    static std::string sessionConfigurationCacheKey(const std::string& id,
+            const hardware::camera::device::V3_4::StreamConfiguration &configuration);
+    void invalidateSessionConfigurationCache();
+
     // Mapping from CameraDevice IDs to CameraProviders. This map is used to keep the
     // ICameraProvider alive while it is in use by the camera with the given ID for camera
     // capabilities
@@ -456,11 +499,17 @@ private:
 
             hardware::camera::common::V1_0::CameraDeviceStatus mStatus;
 
+            // Serializes HAL calls to this device that are made without mInterfaceMutex held
+            std::mutex mDeviceLock;
+
             wp<ProviderInfo> mParentProvider;
 
             bool hasFlashUnit() const { return mHasFlashUnit; }
             bool supportNativeZoomRatio() const { return mSupportNativeZoomRatio; }
-            virtual status_t setTorchMode(bool enabled) = 0;
+            // Starts the device interface for the HAL calls below. Expects the parent
+            // mInterfaceMutex to be locked, since it may start the provider interface.
+            virtual sp<IBase> startInterfaceLocked() = 0;
+            virtual status_t setTorchMode(const sp<IBase>& interface, bool enabled) = 0;
             virtual status_t getCameraInfo(hardware::CameraInfo *info) const = 0;
             virtual bool isAPI1Compatible() const = 0;
             virtual status_t dumpState(int fd) = 0;
@@ -474,13 +523,26 @@ private:
                 (void) characteristics;
                 return INVALID_OPERATION;
             }
+            virtual status_t getCharacteristicsSnapshot(
+                    std::shared_ptr<const CharacteristicsSnapshot> *snapshot) const {
+                (void) snapshot;
+                return INVALID_OPERATION;
+            }
+            virtual status_t getPhysicalCharacteristicsSnapshot(
+                    const std::string& physicalCameraId,
+                    std::shared_ptr<const CharacteristicsSnapshot> *snapshot) const {
+                (void) physicalCameraId;
+                (void) snapshot;
+                return INVALID_OPERATION;
+            }
 
-            virtual status_t isSessionConfigurationSupported(
+            virtual status_t isSessionConfigurationSupported(const sp<IBase>& /*interface*/,
                     const hardware::camera::device::V3_4::StreamConfiguration &/*configuration*/,
                     bool * /*status*/) {
                 return INVALID_OPERATION;
             }
 
+            // Expects the parent mInterfaceMutex to be locked, see startInterfaceLocked().
             template<class InterfaceT>
             sp<InterfaceT> startDeviceInterface();
 
@@ -504,14 +566,16 @@ private:
             static status_t setTorchMode(InterfaceT& interface, bool enabled);
 
             template<class InterfaceT>
-            status_t setTorchModeForDevice(bool enabled) {
+            status_t setTorchModeForDevice(const sp<IBase>& interface, bool enabled) {
                 // Don't save the ICameraProvider interface here because we assume that this was
                 // called from CameraProviderManager::setTorchMode(), which does save it.
-                const sp<InterfaceT> interface = startDeviceInterface<InterfaceT>();
-                return DeviceInfo::setTorchMode(interface, enabled);
+                const sp<InterfaceT> device = (InterfaceT *) interface.get();
+                return DeviceInfo::setTorchMode(device, enabled);
             }
         };
-        std::vector<std::unique_ptr<DeviceInfo>> mDevices;
+        // Devices are shared so that a HAL call in progress can keep its DeviceInfo alive
+        // after mInterfaceMutex is released, even if the device is removed meanwhile.
+        std::vector<std::shared_ptr<DeviceInfo>> mDevices;
         std::unordered_set<std::string> mUniqueCameraIds;
         int mUniqueDeviceCount;
         std::vector<std::string> mUniqueAPI1CompatibleCameraIds;
@@ -526,7 +590,8 @@ private:
         struct DeviceInfo1 : public DeviceInfo {
             typedef hardware::camera::device::V1_0::ICameraDevice InterfaceT;
 
-            virtual status_t setTorchMode(bool enabled) override;
+            virtual sp<IBase> startInterfaceLocked() override;
+            virtual status_t setTorchMode(const sp<IBase>& interface, bool enabled) override;
             virtual status_t getCameraInfo(hardware::CameraInfo *info) const override;
             //In case of Device1Info assume that we are always API1 compatible
             virtual bool isAPI1Compatible() const override { return true; }
@@ -547,7 +612,8 @@ private:
         struct DeviceInfo3 : public DeviceInfo {
             typedef hardware::camera::device::V3_2::ICameraDevice InterfaceT;
 
-            virtual status_t setTorchMode(bool enabled) override;
+            virtual sp<IBase> startInterfaceLocked() override;
+            virtual status_t setTorchMode(const sp<IBase>& interface, bool enabled) override;
             virtual status_t getCameraInfo(hardware::CameraInfo *info) const override;
             virtual bool isAPI1Compatible() const override;
             virtual status_t dumpState(int fd) override;
@@ -555,7 +621,12 @@ private:
                     CameraMetadata *characteristics) const override;
             virtual status_t getPhysicalCameraCharacteristics(const std::string& physicalCameraId,
                     CameraMetadata *characteristics) const override;
-            virtual status_t isSessionConfigurationSupported(
+            virtual status_t getCharacteristicsSnapshot(
+                    std::shared_ptr<const CharacteristicsSnapshot> *snapshot) const override;
+            virtual status_t getPhysicalCharacteristicsSnapshot(
+                    const std::string& physicalCameraId,
+                    std::shared_ptr<const CharacteristicsSnapshot> *snapshot) const override;
+            virtual status_t isSessionConfigurationSupported(const sp<IBase>& interface,
                     const hardware::camera::device::V3_4::StreamConfiguration &configuration,
                     bool *status /*out*/)
                     override;
@@ -569,6 +640,16 @@ private:
         private:
             CameraMetadata mCameraCharacteristics;
             std::unordered_map<std::string, CameraMetadata> mPhysicalCameraCharacteristics;
+
+            // Snapshots are built lazily on first use, since permission filtering needs the
+            // provider's vendor tags to have been set up. Guarded by mSnapshotLock.
+            mutable std::mutex mSnapshotLock;
+            mutable std::shared_ptr<const CharacteristicsSnapshot> mCharacteristicsSnapshot;
+            mutable std::unordered_map<std::string, std::shared_ptr<const CharacteristicsSnapshot>>
+                    mPhysicalCharacteristicsSnapshots;
+            std::shared_ptr<const CharacteristicsSnapshot> createCharacteristicsSnapshot(
+                    const CameraMetadata& characteristics) const;
+
             void queryPhysicalCameraIds();
             SystemCameraKind getSystemCameraKind();
             status_t fixupMonochromeTags();
@@ -664,12 +745,13 @@ private:
                 sp<hardware::camera::provider::V2_6::ICameraProvider> &interface2_6);
     };
 
-    // Utility to find a DeviceInfo by ID; pointer is only valid while mInterfaceMutex is held
-    // and the calling code doesn't mutate the list of providers or their lists of devices.
+    // Utility to find a DeviceInfo by ID. Must be called with mInterfaceMutex held; the returned
+    // reference keeps the DeviceInfo alive after mInterfaceMutex is released, but callers using
+    // it past that point must also hold a strong reference to the parent ProviderInfo.
     // Finds the first device of the given ID that falls within the requested version range
     //   minVersion <= deviceVersion < maxVersion
     // No guarantees on the order of traversal
-    ProviderInfo::DeviceInfo* findDeviceInfoLocked(const std::string& id,
+    std::shared_ptr<ProviderInfo::DeviceInfo> findDeviceInfoLocked(const std::string& id,
             hardware::hidl_version minVersion = hardware::hidl_version{0,0},
             hardware::hidl_version maxVersion = hardware::hidl_version{1000,0}) const;
 
@@ -699,6 +781,8 @@ private:
 
     status_t getCameraCharacteristicsLocked(const std::string &id,
             CameraMetadata* characteristics) const;
+    status_t getCameraCharacteristicsSnapshotLocked(const std::string &id,
+            std::shared_ptr<const CharacteristicsSnapshot>* snapshot) const;
     void filterLogicalCameraIdsLocked(std::vector<std::string>& deviceIds) const;
 
     status_t getSystemCameraKindLocked(const std::string& id, SystemCameraKind *kind) const;
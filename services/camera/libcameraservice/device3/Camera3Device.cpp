@@ -759,13 +759,12 @@ status_t Camera3Device::dump(int fd, const Vector<String16> &args) {
     if (mInFlightMap.size() == 0) {
         lines.append("      None\n");
     } else {
-        for (size_t i = 0; i < mInFlightMap.size(); i++) {
-            InFlightRequest r = mInFlightMap.valueAt(i);
+        mInFlightMap.forEach([&lines](uint32_t frameNumber, const InFlightRequest &r) {
             lines.appendFormat("      Frame %d |  Timestamp: %" PRId64 ", metadata"
-                    " arrived: %s, buffers left: %d\n", mInFlightMap.keyAt(i),
+                    " arrived: %s, buffers left: %d\n", frameNumber,
                     r.shutterTimestamp, r.haveResultMetadata ? "true" : "false",
                     r.numBuffersLeft);
-        }
+        });
     }
     write(fd, lines.string(), lines.size());
 
@@ -849,6 +848,10 @@ const CameraMetadata& Camera3Device::info() const {
     return infoPhysical(emptyId);
 }
 
+void Camera3Device::getCaptureLatencySnapshot(CaptureLatencySnapshot* snapshot) const {
+    mCaptureLatencyTracker.getSnapshot(snapshot);
+}
+
 status_t Camera3Device::checkStatusOkToCaptureLocked() {
     switch (mStatus) {
         case STATUS_ERROR:
@@ -891,6 +894,7 @@ status_t Camera3Device::convertMetadataListToRequestListLocked(
         }
 
         newRequest->mRepeating = repeating;
+        newRequest->mSubmitTimestamp = systemTime();
 
         // Setup burst Id and request Id
         newRequest->mResultExtras.burstId = burstId++;
@@ -1059,7 +1063,8 @@ hardware::Return<void> Camera3Device::processCaptureResult_3_4(
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
         mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
         mResultMetadataQueue, mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
-        mTagMonitor, mInputStream, mOutputStreams, listener, *this, *this, *mInterface
+        mTagMonitor, mCaptureLatencyTracker, mInputStream, mOutputStreams, listener, *this,
+        *this, *mInterface
     };
 
     for (const auto& result : results) {
@@ -1117,7 +1122,8 @@ hardware::Return<void> Camera3Device::processCaptureResult(
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
         mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
         mResultMetadataQueue, mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
-        mTagMonitor, mInputStream, mOutputStreams, listener, *this, *this, *mInterface
+        mTagMonitor, mCaptureLatencyTracker, mInputStream, mOutputStreams, listener, *this,
+        *this, *mInterface
     };
 
     for (const auto& result : results) {
@@ -1157,7 +1163,8 @@ hardware::Return<void> Camera3Device::notify(
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
         mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
         mResultMetadataQueue, mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
-        mTagMonitor, mInputStream, mOutputStreams, listener, *this, *this, *mInterface
+        mTagMonitor, mCaptureLatencyTracker, mInputStream, mOutputStreams, listener, *this,
+        *this, *mInterface
     };
     for (const auto& msg : msgs) {
         camera3::notify(states, msg);
@@ -2796,7 +2803,7 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
         bool hasAppCallback, nsecs_t maxExpectedDuration,
         std::set<String8>& physicalCameraIds, bool isStillCapture,
         bool isZslCapture, bool rotateAndCropAuto, const std::set<std::string>& cameraIdsWithZoom,
-        const SurfaceMap& outputSurfaces) {
+        const SurfaceMap& outputSurfaces, const CaptureLatencyRecord& latencyRecord) {
     ATRACE_CALL();
     std::lock_guard<std::mutex> l(mInFlightLock);
 
@@ -2805,6 +2812,7 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
             hasAppCallback, maxExpectedDuration, physicalCameraIds, isStillCapture, isZslCapture,
             rotateAndCropAuto, cameraIdsWithZoom, outputSurfaces));
     if (res < 0) return res;
+    mInFlightMap.editValueAt(res).latencyRecord = latencyRecord;
 
     if (mInFlightMap.size() == 1) {
         // Hold a separate dedicated tracker lock to prevent race with disconnect and also
@@ -2857,7 +2865,7 @@ void Camera3Device::onInflightMapFlushedLocked() {
 void Camera3Device::removeInFlightMapEntryLocked(int idx) {
     ATRACE_HFR_CALL();
     nsecs_t duration = mInFlightMap.valueAt(idx).maxExpectedDuration;
-    mInFlightMap.removeItemsAt(idx, 1);
+    mInFlightMap.removeItemAt(idx);
 
     onInflightEntryRemovedLocked(duration);
 }
@@ -4693,6 +4701,12 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
                 isZslCapture = true;
             }
         }
+        CaptureLatencyRecord latencyRecord;
+        if (!captureRequest->mRepeating) {
+            latencyRecord.mark(CAPTURE_STAGE_SUBMITTED, captureRequest->mSubmitTimestamp);
+        }
+        latencyRecord.mark(CAPTURE_STAGE_DEQUEUED, nextRequest.dequeueTimestamp);
+        latencyRecord.mark(CAPTURE_STAGE_HAL_SUBMITTED);
         res = parent->registerInFlight(halRequest->frame_number,
                 totalNumBuffers, captureRequest->mResultExtras,
                 /*hasInput*/halRequest->input_buffer != NULL,
@@ -4701,7 +4715,7 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
                 requestedPhysicalCameras, isStillCapture, isZslCapture,
                 captureRequest->mRotateAndCropAuto, mPrevCameraIdsWithZoom,
                 (mUseHalBufManager) ? uniqueSurfaceIdMap :
-                                      SurfaceMap{});
+                                      SurfaceMap{}, latencyRecord);
         ALOGVV("%s: registered in flight requestId = %" PRId32 ", frameNumber = %" PRId64
                ", burstId = %" PRId32 ".",
                 __FUNCTION__,
@@ -4986,6 +5000,7 @@ void Camera3Device::RequestThread::waitForNextRequestBatch() {
 
     nextRequest.halRequest = camera3_capture_request_t();
     nextRequest.submitted = false;
+    nextRequest.dequeueTimestamp = systemTime();
     mNextRequests.add(nextRequest);
 
     // Wait for additional requests
@@ -5000,6 +5015,7 @@ void Camera3Device::RequestThread::waitForNextRequestBatch() {
 
         additionalRequest.halRequest = camera3_capture_request_t();
         additionalRequest.submitted = false;
+        additionalRequest.dequeueTimestamp = systemTime();
         mNextRequests.add(additionalRequest);
     }
 
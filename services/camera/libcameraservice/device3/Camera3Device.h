@@ -54,6 +54,7 @@
 #include "device3/Camera3OfflineSession.h"
 #include "utils/TagMonitor.h"
 #include "utils/LatencyHistogram.h"
+#include "utils/CaptureLatencyTracker.h"
 #include <camera_metadata_hidden.h>
 
 using android::camera3::OutputStreamInfo;
@@ -98,6 +99,7 @@ class Camera3Device :
     status_t disconnect() override;
     status_t dump(int fd, const Vector<String16> &args) override;
     const CameraMetadata& info() const override;
+    void getCaptureLatencySnapshot(CaptureLatencySnapshot* snapshot) const override;
     const CameraMetadata& infoPhysical(const String8& physicalId) const override;
 
     // Capture and setStreamingRequest will configure streams if currently in
@@ -530,6 +532,9 @@ class Camera3Device :
         bool                                mRotationAndCropUpdated = false;
         // Whether this capture request's zoom ratio update has been done.
         bool                                mZoomRatioUpdated = false;
+        // When the client submitted this request. Repeating requests are
+        // resubmitted by the request thread, so this isn't meaningful for them.
+        nsecs_t                             mSubmitTimestamp = 0;
     };
     typedef List<sp<CaptureRequest> > RequestList;
 
@@ -890,6 +895,8 @@ class Camera3Device :
             camera3_capture_request_t       halRequest;
             Vector<camera3_stream_buffer_t> outputBuffers;
             bool                            submitted;
+            // When the request was taken off the request queue
+            nsecs_t                         dequeueTimestamp;
         };
 
         // Wait for the next batch of requests and put them in mNextRequests. mNextRequests will
@@ -1035,7 +1042,8 @@ class Camera3Device :
             int32_t numBuffers, CaptureResultExtras resultExtras, bool hasInput,
             bool callback, nsecs_t maxExpectedDuration, std::set<String8>& physicalCameraIds,
             bool isStillCapture, bool isZslCapture, bool rotateAndCropAuto,
-            const std::set<std::string>& cameraIdsWithZoom, const SurfaceMap& outputSurfaces);
+            const std::set<std::string>& cameraIdsWithZoom, const SurfaceMap& outputSurfaces,
+            const CaptureLatencyRecord& latencyRecord);
 
     /**
      * Tracking for idle detection
@@ -1166,6 +1174,9 @@ class Camera3Device :
     // - dumpsys -m 3a is a shortcut for ae/af/awbMode, State, and Triggers
     TagMonitor mTagMonitor;
 
+    // Per-stage latency of completed captures, from client submission to result delivery
+    CameraCaptureLatencyTracker mCaptureLatencyTracker;
+
     void monitorMetadata(TagMonitor::eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const CameraMetadata& metadata,
             const std::unordered_map<std::string, CameraMetadata>& physicalMetadata);
@@ -127,9 +127,10 @@ status_t Camera3OfflineSession::initialize(wp<NotificationListener> listener) {
     return OK;
 }
 
-status_t Camera3OfflineSession::dump(int /*fd*/) {
+status_t Camera3OfflineSession::dump(int fd) {
     ATRACE_CALL();
     std::lock_guard<std::mutex> il(mInterfaceLock);
+    mCaptureLatencyTracker.dump(fd, "    Offline capture stage latency histogram:");
     return OK;
 }
 
@@ -260,7 +261,8 @@ hardware::Return<void> Camera3OfflineSession::processCaptureResult_3_4(
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
         mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
         mResultMetadataQueue, mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
-        mTagMonitor, mInputStream, mOutputStreams, listener, *this, *this, mBufferRecords
+        mTagMonitor, mCaptureLatencyTracker, mInputStream, mOutputStreams, listener, *this,
+        *this, mBufferRecords
     };
 
     std::lock_guard<std::mutex> lock(mProcessCaptureResultLock);
@@ -299,7 +301,8 @@ hardware::Return<void> Camera3OfflineSession::processCaptureResult(
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
         mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
         mResultMetadataQueue, mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
-        mTagMonitor, mInputStream, mOutputStreams, listener, *this, *this, mBufferRecords
+        mTagMonitor, mCaptureLatencyTracker, mInputStream, mOutputStreams, listener, *this,
+        *this, mBufferRecords
     };
 
     std::lock_guard<std::mutex> lock(mProcessCaptureResultLock);
@@ -333,7 +336,8 @@ hardware::Return<void> Camera3OfflineSession::notify(
         mUseHalBufManager, mUsePartialResult, mNeedFixupMonochromeTags,
         mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
         mResultMetadataQueue, mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
-        mTagMonitor, mInputStream, mOutputStreams, listener, *this, *this, mBufferRecords
+        mTagMonitor, mCaptureLatencyTracker, mInputStream, mOutputStreams, listener, *this,
+        *this, mBufferRecords
     };
     for (const auto& msg : msgs) {
         camera3::notify(states, msg);
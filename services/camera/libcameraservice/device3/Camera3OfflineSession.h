@@ -216,6 +216,8 @@ class Camera3OfflineSession :
     sp<hardware::camera::device::V3_6::ICameraOfflineSession> mSession;
 
     TagMonitor mTagMonitor;
+    // Stage latencies of the requests completing after the switch to offline
+    CameraCaptureLatencyTracker mCaptureLatencyTracker;
     const metadata_vendor_id_t mVendorTagId;
 
     const bool mUseHalBufManager;
@@ -335,14 +335,9 @@ void sendCaptureResult(
         }
     }
 
-    std::unordered_map<std::string, CameraMetadata> monitoredPhysicalMetadata;
-    for (auto& m : physicalMetadatas) {
-        monitoredPhysicalMetadata.emplace(String8(m.mPhysicalCameraId).string(),
-                CameraMetadata(m.mPhysicalCameraMetadata));
-    }
     states.tagMonitor.monitorMetadata(TagMonitor::RESULT,
             frameNumber, sensorTimestamp, captureResult.mMetadata,
-            monitoredPhysicalMetadata);
+            captureResult.mPhysicalMetadatas);
 
     insertResultLocked(states, &captureResult, frameNumber);
 }
@@ -388,7 +383,7 @@ void removeInFlightMapEntryLocked(CaptureOutputStates& states, int idx) {
     ATRACE_CALL();
     InFlightRequestMap& inflightMap = states.inflightMap;
     nsecs_t duration = inflightMap.valueAt(idx).maxExpectedDuration;
-    inflightMap.removeItemsAt(idx, 1);
+    inflightMap.removeItemAt(idx);
 
     states.inflightIntf.onInflightEntryRemovedLocked(duration);
 }
@@ -437,6 +432,13 @@ void removeInFlightRequestIfReadyLocked(CaptureOutputStates& states, int idx) {
             request.outputSurfaces, request.resultExtras,
             request.errorBufStrategy);
 
+        // Only successful captures are representative of the pipeline latency
+        if (request.requestStatus == OK && !request.skipResultMetadata) {
+            CaptureLatencyRecord latencyRecord = request.latencyRecord;
+            latencyRecord.mark(CAPTURE_STAGE_DELIVERED);
+            states.latencyTracker.add(latencyRecord);
+        }
+
         // Note down the just completed frame number
         if (request.hasInputBuffer) {
             states.lastCompletedReprocessFrameNumber = frameNumber;
@@ -526,6 +528,7 @@ void processCaptureResult(CaptureOutputStates& states, const camera3_capture_res
             }
             if (isPartialResult) {
                 request.collectedPartialResult.append(result->result);
+                request.latencyRecord.markOnce(CAPTURE_STAGE_PARTIAL_RESULT);
             }
 
             if (isPartialResult && request.hasCallback) {
@@ -587,6 +590,9 @@ void processCaptureResult(CaptureOutputStates& states, const camera3_capture_res
                     frameNumber);
             return;
         }
+        if (numBuffersReturned > 0 && request.numBuffersLeft == 0) {
+            request.latencyRecord.mark(CAPTURE_STAGE_BUFFERS_RETURNED);
+        }
 
         camera_metadata_ro_entry_t entry;
         res = find_camera_metadata_ro_entry(result->result,
@@ -944,6 +950,7 @@ void notifyShutter(CaptureOutputStates& states, const camera3_shutter_msg_t &msg
             }
 
             r.shutterTimestamp = msg.timestamp;
+            r.latencyRecord.mark(CAPTURE_STAGE_SHUTTER);
             if (r.hasCallback) {
                 ALOGVV("Camera %s: %s: Shutter fired for frame %d (id %d) at %" PRId64,
                     states.cameraId.string(), __FUNCTION__,
@@ -1385,8 +1392,9 @@ void flushInflightRequests(FlushInflightReqStates& states) {
     ATRACE_CALL();
     { // First return buffers cached in mInFlightMap
         std::lock_guard<std::mutex> l(states.inflightLock);
-        for (size_t idx = 0; idx < states.inflightMap.size(); idx++) {
-            const InFlightRequest &request = states.inflightMap.valueAt(idx);
+        const char *functionName = __FUNCTION__;
+        states.inflightMap.forEach([&states, functionName](uint32_t frameNumber,
+                const InFlightRequest &request) {
             returnOutputBuffers(
                 states.useHalBufManager, states.listener,
                 request.pendingOutputBuffers.array(),
@@ -1394,11 +1402,11 @@ void flushInflightRequests(FlushInflightReqStates& states) {
                 /*timestampIncreasing*/true, request.outputSurfaces,
                 request.resultExtras, request.errorBufStrategy);
             ALOGW("%s: Frame %d |  Timestamp: %" PRId64 ", metadata"
-                    " arrived: %s, buffers left: %d.\n", __FUNCTION__,
-                    states.inflightMap.keyAt(idx), request.shutterTimestamp,
+                    " arrived: %s, buffers left: %d.\n", functionName,
+                    frameNumber, request.shutterTimestamp,
                     request.haveResultMetadata ? "true" : "false",
                     request.numBuffersLeft);
-        }
+        });
 
         states.inflightMap.clear();
         states.inflightIntf.onInflightMapFlushedLocked();
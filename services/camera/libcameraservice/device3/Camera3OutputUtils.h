@@ -33,6 +33,7 @@
 #include "device3/InFlightRequest.h"
 #include "device3/Camera3Stream.h"
 #include "device3/Camera3OutputStreamInterface.h"
+#include "utils/CaptureLatencyTracker.h"
 #include "utils/TagMonitor.h"
 
 namespace android {
@@ -96,6 +97,7 @@ namespace camera3 {
         std::unordered_map<std::string, camera3::ZoomRatioMapper>& zoomRatioMappers;
         std::unordered_map<std::string, camera3::RotateAndCropMapper>& rotateAndCropMappers;
         TagMonitor& tagMonitor;
+        CameraCaptureLatencyTracker& latencyTracker;
         sp<Camera3Stream> inputStream;
         StreamSet& outputStreams;
         sp<NotificationListener> listener;
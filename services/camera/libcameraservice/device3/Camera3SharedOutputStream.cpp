@@ -113,6 +113,14 @@ status_t Camera3SharedOutputStream::notifyBufferReleased(ANativeWindowBuffer *an
     return res;
 }
 
+void Camera3SharedOutputStream::dump(int fd, const Vector<String16> &args) const {
+    Camera3OutputStream::dump(fd, args);
+
+    if (mStreamSplitter != nullptr) {
+        mStreamSplitter->dump(fd);
+    }
+}
+
 bool Camera3SharedOutputStream::isConsumerConfigurationDeferred(size_t surface_id) const {
     Mutex::Autolock l(mLock);
     if (surface_id >= kMaxOutputs) {
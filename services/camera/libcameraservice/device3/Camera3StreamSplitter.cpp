@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <inttypes.h>
 
 #define LOG_TAG "Camera3StreamSplitter"
@@ -121,7 +122,41 @@ status_t Camera3StreamSplitter::getOnFrameAvailableResult() {
 
 void Camera3StreamSplitter::disconnect() {
     ATRACE_CALL();
-    Mutex::Autolock lock(mMutex);
+    std::vector<sp<OutputDeliveryThread>> deliveryThreads;
+    {
+        Mutex::Autolock lock(mMutex);
+        disconnectLocked(&deliveryThreads);
+    }
+
+    // The delivery threads need mMutex to finish an in-progress delivery, so they
+    // must be joined with the lock released.
+    for (auto& thread : deliveryThreads) {
+        thread->join();
+    }
+}
+
+void Camera3StreamSplitter::disconnectLocked(
+        std::vector<sp<OutputDeliveryThread>>* deliveryThreads) {
+    std::vector<std::pair<uint64_t, size_t>> pendingBuffers;
+    for (auto& it : mDeliveryThreads) {
+        std::vector<BufferItem> pendingFrames;
+        it.second->requestExit(&pendingFrames);
+        for (const auto& item : pendingFrames) {
+            pendingBuffers.emplace_back(item.mGraphicBuffer->getId(), it.first);
+        }
+        deliveryThreads->push_back(it.second);
+    }
+    mDeliveryThreads.clear();
+    for (auto& thread : mRetiredDeliveryThreads) {
+        deliveryThreads->push_back(thread);
+    }
+    mRetiredDeliveryThreads.clear();
+
+    // Return the buffers that were still waiting for delivery to the input, while the
+    // consumer is connected.
+    for (const auto& it : pendingBuffers) {
+        decrementBufRefCountLocked(it.first, it.second);
+    }
 
     for (auto& notifier : mNotifiers) {
         sp<IGraphicBufferProducer> producer = notifier.first;
@@ -266,6 +301,23 @@ status_t Camera3StreamSplitter::addOutputLocked(size_t surfaceId, const sp<Surfa
     mNotifiers[gbp] = listener;
     mOutputSlots[gbp] = std::make_unique<OutputSlots>(totalBufferCount);
 
+    sp<OutputDeliveryThread> deliveryThread = new OutputDeliveryThread(this, gbp, surfaceId,
+            ++mOutputGeneration);
+    res = deliveryThread->run(String8::format("%s-%zu", mConsumerName.string(),
+            surfaceId).string());
+    if (res != OK) {
+        SP_LOGE("%s: Unable to start delivery thread for surface %zu: %s (%d)",
+                __FUNCTION__, surfaceId, strerror(-res), res);
+        mOutputs[surfaceId] = nullptr;
+        mConsumerBufferCount[surfaceId] = 0;
+        mNotifiers[gbp] = nullptr;
+        mOutputSlots[gbp] = nullptr;
+        IInterface::asBinder(gbp)->unlinkToDeath(listener);
+        gbp->disconnect(NATIVE_WINDOW_API_CAMERA);
+        return res;
+    }
+    mDeliveryThreads[surfaceId] = deliveryThread;
+
     mMaxConsumerBuffers += maxConsumerBuffers;
     return NO_ERROR;
 }
@@ -298,9 +350,28 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     }
 
     sp<IGraphicBufferProducer> gbp = mOutputs[surfaceId];
+
+    // Stop accepting new frames for this output. A delivery that is already blocked in
+    // queueBuffer will notice the removal once it re-acquires mMutex, so the thread is
+    // only joined on disconnect.
+    std::vector<BufferItem> pendingFrames;
+    auto deliveryThread = mDeliveryThreads.find(surfaceId);
+    if (deliveryThread != mDeliveryThreads.end()) {
+        deliveryThread->second->requestExit(&pendingFrames);
+        mRetiredDeliveryThreads.erase(std::remove_if(mRetiredDeliveryThreads.begin(),
+                mRetiredDeliveryThreads.end(),
+                [](const sp<OutputDeliveryThread>& t) { return !t->isRunning(); }),
+                mRetiredDeliveryThreads.end());
+        mRetiredDeliveryThreads.push_back(deliveryThread->second);
+        mDeliveryThreads.erase(deliveryThread);
+    }
+
     //Search and decrement the ref. count of any buffers that are
-    //still attached to the removed surface.
+    //still attached to the removed surface, or waiting to be queued to it.
     std::vector<uint64_t> pendingBufferIds;
+    for (const auto& item : pendingFrames) {
+        pendingBufferIds.push_back(item.mGraphicBuffer->getId());
+    }
     auto& outputSlots = *mOutputSlots[gbp];
     for (size_t i = 0; i < outputSlots.size(); i++) {
         if (outputSlots[i] != nullptr) {
@@ -340,8 +411,8 @@ status_t Camera3StreamSplitter::removeOutputLocked(size_t surfaceId) {
     return res;
 }
 
-status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProducer>& output,
-        const BufferItem& bufferItem, size_t surfaceId) {
+status_t Camera3StreamSplitter::deliverBufferToOutput(const sp<IGraphicBufferProducer>& output,
+        const BufferItem& bufferItem, int slot, size_t surfaceId, uint64_t generation) {
     ATRACE_CALL();
     status_t res;
     IGraphicBufferProducer::QueueBufferInput queueInput(
@@ -352,29 +423,29 @@ status_t Camera3StreamSplitter::outputBufferLocked(const sp<IGraphicBufferProduc
 
     IGraphicBufferProducer::QueueBufferOutput queueOutput;
 
-    uint64_t bufferId = bufferItem.mGraphicBuffer->getId();
-    const BufferTracker& tracker = *(mBuffers[bufferId]);
-    int slot = getSlotForOutputLocked(output, tracker.getBuffer());
-
     // In case the output BufferQueue has its own lock, if we hold splitter lock while calling
     // queueBuffer (which will try to acquire the output lock), the output could be holding its
     // own lock calling releaseBuffer (which  will try to acquire the splitter lock), running into
     // circular lock situation.
-    mMutex.unlock();
     res = output->queueBuffer(slot, queueInput, &queueOutput);
-    mMutex.lock();
+    Mutex::Autolock lock(mMutex);
 
     SP_LOGV("%s: Queuing buffer to buffer queue %p slot %d returns %d",
             __FUNCTION__, output.get(), slot, res);
     //During buffer queue 'mMutex' is not held which makes the removal of
-    //"output" possible. Check whether this is the case and return.
-    if (mOutputSlots[output] == nullptr) {
+    //"output" possible. Check whether this is the case and return. The buffer
+    //references were dropped by the removal, and the same output may since have
+    //been added back with a new generation.
+    auto deliveryThread = mDeliveryThreads.find(surfaceId);
+    if (deliveryThread == mDeliveryThreads.end() ||
+            deliveryThread->second->getGeneration() != generation) {
         return res;
     }
     if (res != OK) {
         if (res != NO_INIT && res != DEAD_OBJECT) {
             SP_LOGE("Queuing buffer to output failed (%d)", res);
         }
+        mOnFrameAvailableRes.store(res);
         // If we just discovered that this output has been abandoned, note
         // that, increment the release count so that we still release this
         // buffer eventually, and move on to the next output
@@ -518,26 +589,38 @@ void Camera3StreamSplitter::onFrameAvailable(const BufferItem& /*item*/) {
         bufferItem.mTransform |= NATIVE_WINDOW_TRANSFORM_INVERSE_DISPLAY;
     }
 
-    // Attach and queue the buffer to each of the outputs
+    // Hand the buffer to the delivery queue of each of the outputs. The actual
+    // queueBuffer calls happen on the per-output delivery threads, so a slow
+    // consumer doesn't hold up the others.
     BufferTracker& tracker = *(mBuffers[bufferId]);
 
     SP_LOGV("%s: BufferTracker for buffer %" PRId64 ", number of requests %zu",
            __FUNCTION__, bufferItem.mGraphicBuffer->getId(), tracker.requestedSurfaces().size());
-    for (const auto id : tracker.requestedSurfaces()) {
+    // Copy what we need from the tracker, since decrementBufRefCountLocked below
+    // may release it.
+    const sp<GraphicBuffer> buffer = tracker.getBuffer();
+    const std::vector<size_t> requestedSurfaces = tracker.requestedSurfaces();
+    for (const auto id : requestedSurfaces) {
 
         if (mOutputs[id] == nullptr) {
             //Output surface got likely removed by client.
             continue;
         }
 
-        res = outputBufferLocked(mOutputs[id], bufferItem, id);
-        if (res != OK) {
-            SP_LOGE("%s: outputBufferLocked failed %d", __FUNCTION__, res);
-            mOnFrameAvailableRes.store(res);
+        int slot = getSlotForOutputLocked(mOutputs[id], buffer);
+        auto deliveryThread = mDeliveryThreads.find(id);
+        if (slot == BufferItem::INVALID_BUFFER_SLOT ||
+                deliveryThread == mDeliveryThreads.end()) {
+            SP_LOGE("%s: Unable to deliver buffer %" PRId64 " to surface %zu", __FUNCTION__,
+                    bufferId, id);
+            res = INVALID_OPERATION;
             // If we fail to send buffer to certain output, keep sending to
             // other outputs.
+            decrementBufRefCountLocked(bufferId, id);
             continue;
         }
+
+        deliveryThread->second->enqueue(bufferItem, slot);
     }
 
     mOnFrameAvailableRes.store(res);
@@ -756,6 +839,88 @@ int Camera3StreamSplitter::getSlotForOutputLocked(const sp<IGraphicBufferProduce
     return BufferItem::INVALID_BUFFER_SLOT;
 }
 
+void Camera3StreamSplitter::dump(int fd) {
+    Mutex::Autolock lock(mMutex);
+    String8 lines;
+    lines.appendFormat("      Stream splitter %s: %zu outputs, %zu acquired input buffers\n",
+            mConsumerName.string(), mDeliveryThreads.size(), mAcquiredInputBuffers);
+    write(fd, lines.string(), lines.size());
+
+    for (const auto& it : mDeliveryThreads) {
+        it.second->dump(fd);
+    }
+}
+
+Camera3StreamSplitter::OutputDeliveryThread::OutputDeliveryThread(
+        wp<Camera3StreamSplitter> splitter,
+        const sp<IGraphicBufferProducer>& output, size_t surfaceId, uint64_t generation)
+      : Thread(/*canCallJava*/false), mSplitter(splitter), mOutput(output),
+        mSurfaceId(surfaceId), mGeneration(generation) {}
+
+void Camera3StreamSplitter::OutputDeliveryThread::enqueue(const BufferItem& bufferItem,
+        int slot) {
+    Mutex::Autolock l(mQueueLock);
+    mPendingFrames.push_back({bufferItem, slot, systemTime()});
+    mMaxQueueDepth = std::max(mMaxQueueDepth, mPendingFrames.size());
+    mQueueSignal.signal();
+}
+
+void Camera3StreamSplitter::OutputDeliveryThread::requestExit(
+        std::vector<BufferItem>* pendingFrames) {
+    Thread::requestExit();
+    Mutex::Autolock l(mQueueLock);
+    mDroppedCount += mPendingFrames.size();
+    if (pendingFrames != nullptr) {
+        for (auto& frame : mPendingFrames) {
+            pendingFrames->push_back(frame.bufferItem);
+        }
+    }
+    mPendingFrames.clear();
+    mQueueSignal.signal();
+}
+
+bool Camera3StreamSplitter::OutputDeliveryThread::threadLoop() {
+    PendingFrame frame;
+    {
+        Mutex::Autolock l(mQueueLock);
+        while (mPendingFrames.empty()) {
+            if (exitPending()) {
+                return false;
+            }
+            mQueueSignal.wait(mQueueLock);
+        }
+        frame = std::move(mPendingFrames.front());
+        mPendingFrames.pop_front();
+    }
+
+    status_t res = DEAD_OBJECT;
+    sp<Camera3StreamSplitter> splitter = mSplitter.promote();
+    if (splitter != nullptr) {
+        res = splitter->deliverBufferToOutput(mOutput, frame.bufferItem, frame.slot,
+                mSurfaceId, mGeneration);
+    }
+    nsecs_t doneTime = systemTime();
+
+    Mutex::Autolock l(mQueueLock);
+    if (res == OK) {
+        mDeliveredCount++;
+        mQueueLatency.add(frame.enqueueTime, doneTime);
+    } else {
+        mDroppedCount++;
+    }
+    return true;
+}
+
+void Camera3StreamSplitter::OutputDeliveryThread::dump(int fd) const {
+    Mutex::Autolock l(mQueueLock);
+    String8 lines;
+    lines.appendFormat("        Surface %zu: delivered %" PRIu64 ", dropped %" PRIu64
+            ", pending %zu, max pending %zu\n", mSurfaceId, mDeliveredCount, mDroppedCount,
+            mPendingFrames.size(), mMaxQueueDepth);
+    write(fd, lines.string(), lines.size());
+    mQueueLatency.dump(fd, "        Output queue latency histogram:");
+}
+
 Camera3StreamSplitter::OutputListener::OutputListener(
         wp<Camera3StreamSplitter> splitter,
         wp<IGraphicBufferProducer> output)
@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_STREAMSPLITTER_H
 #define ANDROID_SERVERS_STREAMSPLITTER_H
 
+#include <deque>
 #include <unordered_set>
 
 #include <gui/IConsumerListener.h>
@@ -26,8 +27,11 @@
 #include <utils/Condition.h>
 #include <utils/Mutex.h>
 #include <utils/StrongPointer.h>
+#include <utils/Thread.h>
 #include <utils/Timers.h>
 
+#include "utils/LatencyHistogram.h"
+
 #define SP_LOGV(x, ...) ALOGV("[%s] " x, mConsumerName.string(), ##__VA_ARGS__)
 #define SP_LOGI(x, ...) ALOGI("[%s] " x, mConsumerName.string(), ##__VA_ARGS__)
 #define SP_LOGW(x, ...) ALOGW("[%s] " x, mConsumerName.string(), ##__VA_ARGS__)
@@ -91,6 +95,9 @@ public:
     // Disconnect the buffer queue from output surfaces.
     void disconnect();
 
+    // Dump per-output delivery queue depth, latency and drop counters.
+    void dump(int fd);
+
 private:
     // From IConsumerListener
     //
@@ -129,7 +136,7 @@ private:
     // onFrameAvailable call to proceed.
     void onBufferReleasedByOutput(const sp<IGraphicBufferProducer>& from);
 
-    // Called by outputBufferLocked when a buffer in the async buffer queue got replaced.
+    // Called by deliverBufferToOutput when a buffer in the async buffer queue got replaced.
     void onBufferReplacedLocked(const sp<IGraphicBufferProducer>& from, size_t surfaceId);
 
     // When this is called, the splitter disconnects from (i.e., abandons) its
@@ -172,6 +179,56 @@ private:
         wp<IGraphicBufferProducer> mOutput;
     };
 
+    // Queues buffers to a single output on a dedicated thread. Each output has its own
+    // delivery queue and lock, so a consumer that is slow to accept queueBuffer only delays
+    // its own frames instead of stalling onFrameAvailable and every other output.
+    class OutputDeliveryThread : public Thread {
+    public:
+        OutputDeliveryThread(wp<Camera3StreamSplitter> splitter,
+                const sp<IGraphicBufferProducer>& output, size_t surfaceId,
+                uint64_t generation);
+        virtual ~OutputDeliveryThread() = default;
+
+        uint64_t getGeneration() const { return mGeneration; }
+
+        // Add a buffer to the delivery queue. Never blocks on the consumer.
+        void enqueue(const BufferItem& bufferItem, int slot);
+
+        // Wake up the delivery thread so that it can exit. Frames still pending in the
+        // queue are moved to 'pendingFrames', so that their buffers can be returned to the
+        // input, or dropped if 'pendingFrames' is null.
+        void requestExit(std::vector<BufferItem>* pendingFrames);
+        void requestExit() override { requestExit(nullptr); }
+
+        void dump(int fd) const;
+
+    private:
+        bool threadLoop() override;
+
+        struct PendingFrame {
+            BufferItem bufferItem;
+            int slot;
+            nsecs_t enqueueTime;
+        };
+
+        wp<Camera3StreamSplitter> mSplitter;
+        const sp<IGraphicBufferProducer> mOutput;
+        const size_t mSurfaceId;
+        // Output generation the thread delivers to, see mOutputGeneration
+        const uint64_t mGeneration;
+
+        mutable Mutex mQueueLock;
+        Condition mQueueSignal;
+        std::deque<PendingFrame> mPendingFrames;
+
+        // Delivery statistics, guarded by mQueueLock
+        static const int32_t kQueueLatencyBinSizeMs = 5;
+        CameraLatencyHistogram mQueueLatency{kQueueLatencyBinSizeMs};
+        uint64_t mDeliveredCount = 0;
+        uint64_t mDroppedCount = 0;
+        size_t mMaxQueueDepth = 0;
+    };
+
     class BufferTracker {
     public:
         BufferTracker(const sp<GraphicBuffer>& buffer,
@@ -212,11 +269,16 @@ private:
 
     status_t removeOutputLocked(size_t surfaceId);
 
-    // Send a buffer to particular output, and increment the reference count
-    // of the buffer. If this output is abandoned, the buffer's reference count
-    // won't be incremented.
-    status_t outputBufferLocked(const sp<IGraphicBufferProducer>& output,
-            const BufferItem& bufferItem, size_t surfaceId);
+    // Disconnect all outputs and the input queue. The delivery threads are asked to exit
+    // and returned, so that the caller can join them after releasing mMutex.
+    void disconnectLocked(std::vector<sp<OutputDeliveryThread>>* deliveryThreads);
+
+    // Send a buffer to particular output. If this output is abandoned, the buffer's
+    // reference count is decremented. Called from the output's delivery thread
+    // without mMutex held. Nothing is done after queueBuffer if the output was removed
+    // since 'generation' was current, even if the same producer was added back.
+    status_t deliverBufferToOutput(const sp<IGraphicBufferProducer>& output,
+            const BufferItem& bufferItem, int slot, size_t surfaceId, uint64_t generation);
 
     // Get unique name for the buffer queue consumer
     String8 getUniqueConsumerName();
@@ -251,6 +313,16 @@ private:
     //Map surface ids -> gbp outputs
     std::unordered_map<int, sp<IGraphicBufferProducer> > mOutputs;
 
+    //Map surface ids -> delivery threads
+    std::unordered_map<int, sp<OutputDeliveryThread> > mDeliveryThreads;
+
+    //Delivery threads of removed outputs that may still be finishing a queueBuffer call.
+    //They are joined on disconnect.
+    std::vector<sp<OutputDeliveryThread> > mRetiredDeliveryThreads;
+
+    //Incremented for every added output, each delivery thread delivers to one generation.
+    uint64_t mOutputGeneration = 0;
+
     //Map surface ids -> consumer buffer count
     std::unordered_map<int, size_t > mConsumerBufferCount;
 
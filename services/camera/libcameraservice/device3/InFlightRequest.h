@@ -17,7 +17,11 @@
 #ifndef ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 #define ANDROID_SERVERS_CAMERA3_INFLIGHT_REQUEST_H
 
+#include <algorithm>
+#include <optional>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 #include <camera/CaptureResult.h>
 #include <camera/CameraMetadata.h>
@@ -27,6 +31,7 @@
 #include "hardware/camera3.h"
 
 #include "common/CameraDeviceBase.h"
+#include "utils/CaptureLatencyTracker.h"
 
 namespace android {
 
@@ -118,6 +123,9 @@ struct InFlightRequest {
     // What shared surfaces an output should go to
     SurfaceMap outputSurfaces;
 
+    // Time at which this request passed each pipeline stage
+    CaptureLatencyRecord latencyRecord;
+
     // TODO: dedupe
     static const nsecs_t kDefaultExpectedDuration = 100000000; // 100 ms
 
@@ -163,8 +171,166 @@ struct InFlightRequest {
     }
 };
 
-// Map from frame number to the in-flight request state
-typedef KeyedVector<uint32_t, InFlightRequest> InFlightRequestMap;
+/**
+ * Map from frame number to the in-flight request state.
+ *
+ * Frame numbers are handed out sequentially, so the requests in flight occupy a sliding window
+ * of keys. Requests are stored in a power-of-two ring indexed by frame number modulo the ring
+ * capacity, which makes insertion, lookup and removal O(1) and avoids the element shifting of a
+ * sorted vector. A request whose slot is still held by a much older frame (e.g. a reprocess or
+ * long exposure request lagging behind the pipeline) is kept in a small overflow table instead.
+ *
+ * The accessors mirror KeyedVector, but an index returned by indexOfKey() or add() is an opaque
+ * handle rather than a position: it stays valid until that entry is removed or another request
+ * is added, and must not be used for iteration. Use forEach() to visit all entries.
+ */
+class InFlightRequestMap {
+  public:
+    InFlightRequestMap() : mRing(kInitialCapacity) {}
+
+    // Inserts or replaces the request for the given frame number, returning its index
+    ssize_t add(uint32_t frameNumber, InFlightRequest request) {
+        ssize_t idx = indexOfKey(frameNumber);
+        if (idx >= 0) {
+            editValueAt(idx) = std::move(request);
+            return idx;
+        }
+
+        size_t slot = frameNumber & (mRing.size() - 1);
+        if (mRing[slot].request.has_value() && mSize >= mRing.size() / 2 &&
+                mRing.size() < kMaxCapacity) {
+            grow();
+            slot = frameNumber & (mRing.size() - 1);
+        }
+        mSize++;
+        if (!mRing[slot].request.has_value()) {
+            mRing[slot].frameNumber = frameNumber;
+            mRing[slot].request.emplace(std::move(request));
+            return slot;
+        }
+        return addOverflow(frameNumber, std::move(request));
+    }
+
+    ssize_t indexOfKey(uint32_t frameNumber) const {
+        size_t slot = frameNumber & (mRing.size() - 1);
+        if (mRing[slot].request.has_value() && mRing[slot].frameNumber == frameNumber) {
+            return slot;
+        }
+        if (!mOverflowIndex.empty()) {
+            auto it = mOverflowIndex.find(frameNumber);
+            if (it != mOverflowIndex.end()) {
+                return mRing.size() + it->second;
+            }
+        }
+        return NAME_NOT_FOUND;
+    }
+
+    const InFlightRequest& valueAt(ssize_t idx) const { return *entryAt(idx).request; }
+    InFlightRequest& editValueAt(ssize_t idx) {
+        return *const_cast<Entry&>(entryAt(idx)).request;
+    }
+    uint32_t keyAt(ssize_t idx) const { return entryAt(idx).frameNumber; }
+
+    void removeItemAt(ssize_t idx) {
+        if (static_cast<size_t>(idx) >= mRing.size()) {
+            size_t pos = idx - mRing.size();
+            mOverflowIndex.erase(mOverflow[pos].frameNumber);
+            mOverflow[pos].request.reset();
+            mOverflowFree.push_back(pos);
+        } else {
+            mRing[idx].request.reset();
+        }
+        mSize--;
+    }
+
+    size_t size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+
+    void clear() {
+        for (auto& entry : mRing) entry.request.reset();
+        mOverflow.clear();
+        mOverflowFree.clear();
+        mOverflowIndex.clear();
+        mSize = 0;
+    }
+
+    // Visits every in-flight request in increasing frame number order. Only meant for
+    // infrequent operations such as dumps and flushes.
+    template<typename Func>
+    void forEach(Func func) const {
+        std::vector<const Entry*> entries;
+        entries.reserve(mSize);
+        for (const auto& entry : mRing) {
+            if (entry.request.has_value()) entries.push_back(&entry);
+        }
+        for (const auto& entry : mOverflow) {
+            if (entry.request.has_value()) entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) {
+            return a->frameNumber < b->frameNumber;
+        });
+        for (const Entry* entry : entries) {
+            func(entry->frameNumber, *entry->request);
+        }
+    }
+
+  private:
+    static constexpr size_t kInitialCapacity = 64;
+    static constexpr size_t kMaxCapacity = 1024;
+
+    struct Entry {
+        uint32_t frameNumber = 0;
+        std::optional<InFlightRequest> request;
+    };
+
+    const Entry& entryAt(ssize_t idx) const {
+        return static_cast<size_t>(idx) < mRing.size() ?
+                mRing[idx] : mOverflow[idx - mRing.size()];
+    }
+
+    ssize_t addOverflow(uint32_t frameNumber, InFlightRequest&& request) {
+        size_t pos;
+        if (!mOverflowFree.empty()) {
+            pos = mOverflowFree.back();
+            mOverflowFree.pop_back();
+        } else {
+            pos = mOverflow.size();
+            mOverflow.emplace_back();
+        }
+        mOverflow[pos].frameNumber = frameNumber;
+        mOverflow[pos].request.emplace(std::move(request));
+        mOverflowIndex[frameNumber] = pos;
+        return mRing.size() + pos;
+    }
+
+    // Doubles the ring and re-homes every entry, including overflowed ones that now fit.
+    void grow() {
+        std::vector<Entry> oldRing(mRing.size() * 2);
+        oldRing.swap(mRing);
+        std::vector<Entry> oldOverflow;
+        oldOverflow.swap(mOverflow);
+        mOverflowFree.clear();
+        mOverflowIndex.clear();
+
+        auto rehome = [this](Entry& entry) {
+            if (!entry.request.has_value()) return;
+            size_t slot = entry.frameNumber & (mRing.size() - 1);
+            if (!mRing[slot].request.has_value()) {
+                mRing[slot] = std::move(entry);
+            } else {
+                addOverflow(entry.frameNumber, std::move(*entry.request));
+            }
+        };
+        for (auto& entry : oldRing) rehome(entry);
+        for (auto& entry : oldOverflow) rehome(entry);
+    }
+
+    std::vector<Entry> mRing;
+    std::vector<Entry> mOverflow;
+    std::vector<size_t> mOverflowFree;
+    std::unordered_map<uint32_t, size_t> mOverflowIndex;
+    size_t mSize = 0;
+};
 
 } // namespace camera3
 
@@ -25,6 +25,7 @@ LOCAL_SHARED_LIBRARIES := \
     liblog \
     libcamera_client \
     libcamera_metadata \
+    libgui \
     libui \
     libutils \
     libjpeg \
@@ -36,6 +37,7 @@ LOCAL_SHARED_LIBRARIES := \
     android.hardware.camera.device@1.0 \
     android.hardware.camera.device@3.2 \
     android.hardware.camera.device@3.4 \
+    android.hardware.camera.device@3.5 \
     android.hidl.token@1.0-utils
 
 LOCAL_STATIC_LIBRARIES := \
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3StreamSplitterTest"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+#include <gui/BufferItemConsumer.h>
+#include <gui/BufferQueue.h>
+#include <gui/Surface.h>
+#include <system/window.h>
+
+#include "../device3/Camera3StreamSplitter.h"
+
+using namespace android;
+
+namespace {
+
+const uint32_t kWidth = 64;
+const uint32_t kHeight = 48;
+const size_t kHalMaxBuffers = 2;
+const uint64_t kUsage = GRALLOC_USAGE_SW_READ_OFTEN | GRALLOC_USAGE_SW_WRITE_OFTEN;
+
+/**
+ * Consumer frame listener that signals the first frame, and optionally blocks inside
+ * onFrameAvailable until released, to emulate a consumer that is slow to accept buffers.
+ * An in-process queueBuffer doesn't return before this listener does.
+ */
+struct TestFrameListener : public ConsumerBase::FrameAvailableListener {
+    std::promise<void> mFirstFrame;
+    std::shared_future<void> mRelease;
+    std::atomic<int> mFrameCount{0};
+
+    TestFrameListener() {}
+    TestFrameListener(std::shared_future<void> release) : mRelease(release) {}
+
+    void onFrameAvailable(const BufferItem&) override {
+        if (mFrameCount++ == 0) {
+            mFirstFrame.set_value();
+        }
+        if (mRelease.valid()) {
+            mRelease.wait();
+        }
+    }
+};
+
+struct TestOutput {
+    sp<BufferItemConsumer> mConsumer;
+    sp<Surface> mSurface;
+
+    TestOutput(const sp<TestFrameListener>& listener) {
+        sp<IGraphicBufferProducer> producer;
+        sp<IGraphicBufferConsumer> consumer;
+        BufferQueue::createBufferQueue(&producer, &consumer);
+        mConsumer = new BufferItemConsumer(consumer, kUsage);
+        mConsumer->setFrameAvailableListener(listener);
+        mSurface = new Surface(producer);
+    }
+};
+
+} // namespace
+
+// Test that an output whose consumer blocks in queueBuffer doesn't hold up the other outputs
+TEST(Camera3StreamSplitterTest, SlowOutputDoesNotBlockOthers) {
+    std::promise<void> releaseSlowOutput;
+    sp<TestFrameListener> slowListener =
+            new TestFrameListener(releaseSlowOutput.get_future().share());
+    sp<TestFrameListener> fastListener = new TestFrameListener();
+    std::future<void> slowFrame = slowListener->mFirstFrame.get_future();
+    std::future<void> fastFrame = fastListener->mFirstFrame.get_future();
+    TestOutput slowOutput(slowListener);
+    TestOutput fastOutput(fastListener);
+
+    sp<Camera3StreamSplitter> splitter = new Camera3StreamSplitter();
+    std::unordered_map<size_t, sp<Surface>> surfaces {
+        {0, slowOutput.mSurface},
+        {1, fastOutput.mSurface}};
+    sp<Surface> input;
+    ASSERT_EQ(splitter->connect(surfaces, kUsage, kUsage, kHalMaxBuffers, kWidth, kHeight,
+            PIXEL_FORMAT_RGBA_8888, &input), OK);
+
+    ANativeWindow* window = input.get();
+    ASSERT_EQ(native_window_api_connect(window, NATIVE_WINDOW_API_CAMERA), OK);
+    ASSERT_EQ(native_window_set_usage(window, kUsage), OK);
+    ASSERT_EQ(native_window_set_buffers_dimensions(window, kWidth, kHeight), OK);
+    ASSERT_EQ(native_window_set_buffers_format(window, PIXEL_FORMAT_RGBA_8888), OK);
+
+    // Same sequence as Camera3SharedOutputStream: attach to the outputs, then queue the input
+    ANativeWindowBuffer* anb = nullptr;
+    ASSERT_EQ(native_window_dequeue_buffer_and_wait(window, &anb), OK);
+    ASSERT_EQ(splitter->attachBufferToOutputs(anb, {0, 1}), OK);
+
+    auto inputQueue = std::async(std::launch::async, [window, anb]() {
+        return window->queueBuffer(window, anb, /*fenceFd*/-1);
+    });
+
+    ASSERT_EQ(slowFrame.wait_for(std::chrono::seconds(5)), std::future_status::ready)
+            << "Frame never reached the slow output";
+    bool inputQueued =
+            inputQueue.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+    bool fastDelivered =
+            fastFrame.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+
+    // The slow output is still blocked in queueBuffer at this point
+    releaseSlowOutput.set_value();
+    EXPECT_TRUE(inputQueued) << "Input queueBuffer blocked behind the slow output";
+    EXPECT_TRUE(fastDelivered) << "Fast output blocked behind the slow output";
+    EXPECT_EQ(inputQueue.get(), OK);
+    EXPECT_EQ(splitter->getOnFrameAvailableResult(), OK);
+    EXPECT_EQ(fastListener->mFrameCount, 1);
+
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_CAMERA);
+    splitter->disconnect();
+    EXPECT_EQ(slowListener->mFrameCount, 1);
+}
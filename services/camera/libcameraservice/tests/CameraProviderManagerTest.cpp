@@ -22,9 +22,14 @@
 #include <android/hidl/manager/1.0/IServiceNotification.h>
 #include <android/hardware/camera/device/3.2/ICameraDeviceCallback.h>
 #include <android/hardware/camera/device/3.2/ICameraDeviceSession.h>
+#include <android/hardware/camera/device/3.5/ICameraDevice.h>
 #include <camera_metadata_hidden.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <future>
+#include <thread>
+
 using namespace android;
 using namespace android::hardware::camera;
 using android::hardware::camera::common::V1_0::Status;
@@ -91,6 +96,58 @@ struct TestDeviceInterface : public device::V3_2::ICameraDevice {
     }
 };
 
+/**
+ * Test implementation of a camera ver. 3.5 device interface, counting stream combination queries
+ */
+struct StreamCombinationTestDeviceInterface : public device::V3_5::ICameraDevice {
+    std::vector<hardware::hidl_string> mDeviceNames;
+    int mStreamCombinationQueries = 0;
+
+    StreamCombinationTestDeviceInterface(std::vector<hardware::hidl_string> deviceNames) :
+        mDeviceNames(deviceNames) {}
+
+    hardware::Return<void> getResourceCost(getResourceCost_cb _hidl_cb) override {
+        hardware::camera::common::V1_0::CameraResourceCost resourceCost = {100,
+                mDeviceNames};
+        _hidl_cb(Status::OK, resourceCost);
+        return hardware::Void();
+    }
+
+    hardware::Return<void> getCameraCharacteristics(
+            getCameraCharacteristics_cb _hidl_cb) override {
+        _hidl_cb(Status::OK, hardware::hidl_vec<uint8_t>());
+        return hardware::Void();
+    }
+
+    hardware::Return<Status> setTorchMode(common::V1_0::TorchMode) override {
+        return Status::OK;
+    }
+
+    hardware::Return<void> open(const sp<ICameraDeviceCallback>&, open_cb _hidl_cb) override {
+        _hidl_cb(Status::OK, nullptr);
+        return hardware::Void();
+    }
+
+    hardware::Return<void> dumpState(const hardware::hidl_handle&) override {
+        return hardware::Void();
+    }
+
+    hardware::Return<void> getPhysicalCameraCharacteristics(const hardware::hidl_string&,
+            getPhysicalCameraCharacteristics_cb _hidl_cb) override {
+        _hidl_cb(Status::ILLEGAL_ARGUMENT, hardware::hidl_vec<uint8_t>());
+        return hardware::Void();
+    }
+
+    hardware::Return<void> isStreamCombinationSupported(
+            const device::V3_4::StreamConfiguration& configuration,
+            isStreamCombinationSupported_cb _hidl_cb) override {
+        mStreamCombinationQueries++;
+        // Only single stream configurations are supported
+        _hidl_cb(Status::OK, configuration.streams.size() == 1);
+        return hardware::Void();
+    }
+};
+
 /**
  * Basic test implementation of a camera provider
  */
@@ -187,6 +244,52 @@ struct TestICameraProvider : virtual public provider::V2_5::ICameraProvider {
     hardware::hidl_bitfield<DeviceState> mCurrentState = 0xFFFFFFFF; // Unlikely to be a real state
 };
 
+/**
+ * Test device whose open() blocks until released, to emulate a slow HAL
+ */
+struct SlowOpenTestDeviceInterface : public TestDeviceInterface {
+    std::promise<void> mOpenEntered;
+    std::shared_future<void> mOpenReleased;
+
+    SlowOpenTestDeviceInterface(std::vector<hardware::hidl_string> deviceNames,
+            std::shared_future<void> openReleased) :
+        TestDeviceInterface(deviceNames), mOpenReleased(openReleased) {}
+
+    hardware::Return<void> open(
+            const ::android::sp<ICameraDeviceCallback>& callback,
+            open_cb _hidl_cb) override {
+        mOpenEntered.set_value();
+        mOpenReleased.wait();
+        return TestDeviceInterface::open(callback, _hidl_cb);
+    }
+};
+
+/**
+ * Test provider that hands out a slow device interface for one of its devices
+ */
+struct SlowDeviceTestICameraProvider : public TestICameraProvider {
+    hardware::hidl_string mSlowDeviceName;
+    sp<SlowOpenTestDeviceInterface> mSlowDeviceInterface;
+
+    SlowDeviceTestICameraProvider(const std::vector<hardware::hidl_string> &devices,
+            const hardware::hidl_vec<common::V1_0::VendorTagSection> &vendorSection,
+            const hardware::hidl_string &slowDeviceName,
+            std::shared_future<void> openReleased) :
+        TestICameraProvider(devices, vendorSection),
+        mSlowDeviceName(slowDeviceName),
+        mSlowDeviceInterface(new SlowOpenTestDeviceInterface(devices, openReleased)) {}
+
+    virtual hardware::Return<void> getCameraDeviceInterface_V3_x(
+            const hardware::hidl_string& cameraDeviceName,
+            getCameraDeviceInterface_V3_x_cb _hidl_cb) override {
+        if (cameraDeviceName == mSlowDeviceName) {
+            _hidl_cb(Status::OK, mSlowDeviceInterface);
+            return hardware::Void();
+        }
+        return TestICameraProvider::getCameraDeviceInterface_V3_x(cameraDeviceName, _hidl_cb);
+    }
+};
+
 /**
  * Simple test version of the interaction proxy, to use to inject onRegistered calls to the
  * CameraProviderManager
@@ -304,6 +407,71 @@ TEST(CameraProviderManagerTest, InitializeDynamicDepthTest) {
     ASSERT_EQ(res, OK) << "Unable to initialize provider manager";
 }
 
+TEST(CameraProviderManagerTest, CharacteristicsSnapshotTest) {
+    std::vector<hardware::hidl_string> deviceNames;
+    deviceNames.push_back("device@3.2/test/0");
+    hardware::hidl_vec<common::V1_0::VendorTagSection> vendorSection;
+    status_t res;
+    sp<CameraProviderManager> providerManager = new CameraProviderManager();
+    sp<TestStatusListener> statusListener = new TestStatusListener();
+    TestInteractionProxy serviceProxy;
+
+    android::hardware::hidl_vec<uint8_t> chars;
+    CameraMetadata meta;
+    int32_t charKeys[] = { ANDROID_LENS_FACING, ANDROID_LENS_INTRINSIC_CALIBRATION };
+    meta.update(ANDROID_REQUEST_AVAILABLE_CHARACTERISTICS_KEYS, charKeys,
+            sizeof(charKeys) / sizeof(charKeys[0]));
+    uint8_t facing = ANDROID_LENS_FACING_BACK;
+    meta.update(ANDROID_LENS_FACING, &facing, 1);
+    float calibration[] = { 1.f, 1.f, 0.5f, 0.5f, 0.f };
+    meta.update(ANDROID_LENS_INTRINSIC_CALIBRATION, calibration,
+            sizeof(calibration) / sizeof(calibration[0]));
+    camera_metadata_t* metaBuffer = const_cast<camera_metadata_t*>(meta.getAndLock());
+    chars.setToExternal(reinterpret_cast<uint8_t*>(metaBuffer),
+            get_camera_metadata_size(metaBuffer));
+
+    sp<TestICameraProvider> provider =  new TestICameraProvider(deviceNames,
+            vendorSection, chars);
+    serviceProxy.setProvider(provider);
+
+    res = providerManager->initialize(statusListener, &serviceProxy);
+    ASSERT_EQ(res, OK) << "Unable to initialize provider manager";
+
+    std::shared_ptr<const CameraProviderManager::CharacteristicsSnapshot> snapshot;
+    res = providerManager->getCameraCharacteristicsSnapshot("0", &snapshot);
+    ASSERT_EQ(res, OK) << "Unable to get characteristics snapshot";
+    ASSERT_NE(snapshot, nullptr);
+
+    // Repeated queries must share the same immutable snapshot instead of copying
+    std::shared_ptr<const CameraProviderManager::CharacteristicsSnapshot> secondSnapshot;
+    ASSERT_EQ(providerManager->getCameraCharacteristicsSnapshot("0", &secondSnapshot), OK);
+    EXPECT_EQ(snapshot.get(), secondSnapshot.get());
+
+    // The full characteristics match the copying accessor
+    CameraMetadata copied;
+    ASSERT_EQ(providerManager->getCameraCharacteristics("0", &copied), OK);
+    EXPECT_EQ(copied.entryCount(), snapshot->mCharacteristics.entryCount());
+    EXPECT_TRUE(snapshot->mCharacteristics.exists(ANDROID_LENS_INTRINSIC_CALIBRATION));
+
+    // The filtered variant drops permission-protected entries and lists them
+    ASSERT_EQ(snapshot->mPermissionFilterStatus, OK);
+    const CameraMetadata& filtered = snapshot->mPermissionFilteredCharacteristics;
+    EXPECT_FALSE(filtered.exists(ANDROID_LENS_INTRINSIC_CALIBRATION));
+    EXPECT_TRUE(filtered.exists(ANDROID_LENS_FACING));
+    camera_metadata_ro_entry entry =
+            filtered.find(ANDROID_REQUEST_CHARACTERISTIC_KEYS_NEEDING_PERMISSION);
+    ASSERT_GT(entry.count, 0u);
+    bool listed = false;
+    for (size_t i = 0; i < entry.count; i++) {
+        listed |= (entry.data.i32[i] == ANDROID_LENS_INTRINSIC_CALIBRATION);
+    }
+    EXPECT_TRUE(listed);
+
+    std::shared_ptr<const CameraProviderManager::CharacteristicsSnapshot> missing;
+    EXPECT_EQ(providerManager->getCameraCharacteristicsSnapshot("unknown", &missing),
+            NAME_NOT_FOUND);
+}
+
 TEST(CameraProviderManagerTest, InitializeTest) {
     std::vector<hardware::hidl_string> deviceNames;
     deviceNames.push_back("device@3.2/test/0");
@@ -569,3 +737,116 @@ TEST(CameraProviderManagerTest, BadHalStartupTest) {
     ASSERT_EQ(serviceProxy.mLastRequestedServiceNames.back(), testProviderInstanceName) <<
             "Incorrect instance requested from service manager";
 }
+
+// Test that a slow HAL call on one camera device doesn't block operations on other devices
+TEST(CameraProviderManagerTest, ConcurrentDeviceAccessTest) {
+    std::vector<hardware::hidl_string> deviceNames {
+        "device@3.2/test/0",
+        "device@3.2/test/1"};
+    hardware::hidl_vec<common::V1_0::VendorTagSection> vendorSection;
+    status_t res;
+
+    sp<CameraProviderManager> providerManager = new CameraProviderManager();
+    sp<TestStatusListener> statusListener = new TestStatusListener();
+    TestInteractionProxy serviceProxy;
+    std::promise<void> releaseSlowOpen;
+    sp<SlowDeviceTestICameraProvider> provider = new SlowDeviceTestICameraProvider(deviceNames,
+            vendorSection, deviceNames[0], releaseSlowOpen.get_future().share());
+    std::future<void> slowOpenEntered = provider->mSlowDeviceInterface->mOpenEntered.get_future();
+    serviceProxy.setProvider(provider);
+
+    res = providerManager->initialize(statusListener, &serviceProxy);
+    ASSERT_EQ(res, OK) << "Unable to initialize provider manager";
+
+    sp<ICameraDeviceCallback> callback;
+    auto slowOpen = std::async(std::launch::async, [&]() {
+        sp<ICameraDeviceSession> session;
+        return providerManager->openSession("0", callback, &session);
+    });
+    ASSERT_EQ(slowOpenEntered.wait_for(std::chrono::seconds(5)), std::future_status::ready)
+            << "Slow device open never reached the HAL";
+
+    // Device 0 is now stuck inside the HAL; device 1 must still be usable.
+    auto fastOpen = std::async(std::launch::async, [&]() {
+        sp<ICameraDeviceSession> session;
+        status_t openRes = providerManager->openSession("1", callback, &session);
+        hardware::camera::common::V1_0::CameraResourceCost cost;
+        if (openRes == OK) openRes = providerManager->getResourceCost("0", &cost);
+        if (openRes == OK) openRes = providerManager->setTorchMode("1", true);
+        return openRes;
+    });
+    bool fastOpenDone =
+            fastOpen.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+
+    releaseSlowOpen.set_value();
+    EXPECT_TRUE(fastOpenDone) << "Operations on device 1 blocked behind slow open of device 0";
+    EXPECT_EQ(fastOpen.get(), OK);
+    EXPECT_EQ(slowOpen.get(), OK);
+}
+
+// Test that stream combination answers are served from the cache until the device state changes
+TEST(CameraProviderManagerTest, SessionConfigurationCacheTest) {
+    std::vector<hardware::hidl_string> deviceNames {
+        "device@3.5/test/0"};
+    hardware::hidl_vec<common::V1_0::VendorTagSection> vendorSection;
+    status_t res;
+
+    sp<CameraProviderManager> providerManager = new CameraProviderManager();
+    sp<TestStatusListener> statusListener = new TestStatusListener();
+    TestInteractionProxy serviceProxy;
+    sp<TestICameraProvider> provider = new TestICameraProvider(deviceNames, vendorSection);
+    sp<StreamCombinationTestDeviceInterface> deviceInterface =
+            new StreamCombinationTestDeviceInterface(deviceNames);
+    provider->mDeviceInterface = deviceInterface;
+    serviceProxy.setProvider(provider);
+
+    res = providerManager->initialize(statusListener, &serviceProxy);
+    ASSERT_EQ(res, OK) << "Unable to initialize provider manager";
+
+    device::V3_4::StreamConfiguration configuration;
+    configuration.streams.resize(1);
+    configuration.streams[0].v3_2.width = 640;
+    configuration.streams[0].v3_2.height = 480;
+    configuration.operationMode = device::V3_2::StreamConfigurationMode::NORMAL_MODE;
+
+    bool supported = false;
+    ASSERT_EQ(providerManager->isSessionConfigurationSupported("0", configuration, &supported),
+            OK);
+    EXPECT_TRUE(supported);
+    EXPECT_EQ(deviceInterface->mStreamCombinationQueries, 1);
+
+    // An identical query is answered without another HAL call
+    supported = false;
+    ASSERT_EQ(providerManager->isSessionConfigurationSupported("0", configuration, &supported),
+            OK);
+    EXPECT_TRUE(supported);
+    EXPECT_EQ(deviceInterface->mStreamCombinationQueries, 1) << "Repeated query not served from cache";
+
+    // A different configuration is a separate entry
+    device::V3_4::StreamConfiguration twoStreams = configuration;
+    twoStreams.streams.resize(2);
+    twoStreams.streams[1] = configuration.streams[0];
+    twoStreams.streams[1].v3_2.id = 1;
+    ASSERT_EQ(providerManager->isSessionConfigurationSupported("0", twoStreams, &supported),
+            OK);
+    EXPECT_FALSE(supported);
+    EXPECT_EQ(deviceInterface->mStreamCombinationQueries, 2);
+    ASSERT_EQ(providerManager->isSessionConfigurationSupported("0", twoStreams, &supported),
+            OK);
+    EXPECT_FALSE(supported);
+    EXPECT_EQ(deviceInterface->mStreamCombinationQueries, 2);
+
+    // A device state change drops all cached answers
+    res = providerManager->notifyDeviceStateChange(
+        static_cast<hardware::hidl_bitfield<DeviceState>>(DeviceState::FOLDED));
+    ASSERT_EQ(res, OK) << "Unable to call notifyDeviceStateChange";
+    ASSERT_EQ(providerManager->isSessionConfigurationSupported("0", configuration, &supported),
+            OK);
+    EXPECT_TRUE(supported);
+    EXPECT_EQ(deviceInterface->mStreamCombinationQueries, 3) << "Cache not invalidated on state change";
+
+    // Unknown cameras are never cached
+    EXPECT_EQ(providerManager->isSessionConfigurationSupported("unknown", configuration,
+            &supported), NAME_NOT_FOUND);
+    EXPECT_EQ(deviceInterface->mStreamCombinationQueries, 3);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "CaptureLatencyTrackerTest"
+
+#include <thread>
+#include <vector>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include "../utils/CaptureLatencyTracker.h"
+
+using namespace android;
+
+namespace {
+
+uint64_t histogramCount(const CaptureLatencySnapshot& snapshot, size_t histogram) {
+    uint64_t count = 0;
+    for (size_t bin = 0; bin < CaptureLatencySnapshot::kBinCount; bin++) {
+        count += snapshot.bins[histogram][bin];
+    }
+    return count;
+}
+
+constexpr size_t histogramFor(CaptureLatencyStage stage) {
+    return CaptureLatencySnapshot::histogramFor(stage);
+}
+
+} // namespace
+
+TEST(CaptureLatencyTrackerTest, StageIntervals) {
+    CameraCaptureLatencyTracker tracker;
+
+    CaptureLatencyRecord record;
+    record.mark(CAPTURE_STAGE_SUBMITTED, us2ns(1000));
+    record.mark(CAPTURE_STAGE_DEQUEUED, us2ns(1100));      // 100us
+    record.mark(CAPTURE_STAGE_HAL_SUBMITTED, us2ns(3100)); // 2000us
+    record.mark(CAPTURE_STAGE_SHUTTER, us2ns(33100));      // 30000us
+    // No partial result
+    record.mark(CAPTURE_STAGE_BUFFERS_RETURNED, us2ns(50100));
+    record.mark(CAPTURE_STAGE_DELIVERED, us2ns(50200));
+    tracker.add(record);
+
+    CaptureLatencySnapshot snapshot;
+    tracker.getSnapshot(&snapshot);
+    EXPECT_EQ(snapshot.version, CaptureLatencySnapshot::kVersion);
+    EXPECT_EQ(snapshot.stageCount, static_cast<uint32_t>(CAPTURE_STAGE_COUNT));
+    EXPECT_EQ(snapshot.captureCount, 1u);
+
+    // Every interval, including submit to dequeue, ends up in exactly one histogram
+    EXPECT_EQ(histogramCount(snapshot, histogramFor(CAPTURE_STAGE_PARTIAL_RESULT)), 0u);
+    uint64_t total = 0;
+    for (size_t i = 0; i < CaptureLatencySnapshot::kTotal; i++) {
+        total += histogramCount(snapshot, i);
+    }
+    EXPECT_EQ(total, 5u);
+
+    // 100us lands in [64, 128)
+    EXPECT_EQ(snapshot.bins[histogramFor(CAPTURE_STAGE_DEQUEUED)][6], 1u);
+    // 2000us lands in [1024, 2048)
+    EXPECT_EQ(snapshot.bins[histogramFor(CAPTURE_STAGE_HAL_SUBMITTED)][10], 1u);
+    EXPECT_EQ(snapshot.sumUs[histogramFor(CAPTURE_STAGE_SHUTTER)], 30000u);
+    EXPECT_EQ(snapshot.maxUs[CaptureLatencySnapshot::kTotal], 49200u);
+}
+
+TEST(CaptureLatencyTrackerTest, OutOfOrderStagesAndReset) {
+    CameraCaptureLatencyTracker tracker;
+
+    // Repeating request without a submit time, with buffers returned before the shutter
+    CaptureLatencyRecord record;
+    record.mark(CAPTURE_STAGE_DEQUEUED, us2ns(100));
+    record.mark(CAPTURE_STAGE_SHUTTER, us2ns(500));
+    record.mark(CAPTURE_STAGE_PARTIAL_RESULT, us2ns(400));
+    record.markOnce(CAPTURE_STAGE_PARTIAL_RESULT, us2ns(900));
+    record.mark(CAPTURE_STAGE_DELIVERED, us2ns(1000));
+    tracker.add(record);
+
+    CaptureLatencySnapshot snapshot;
+    tracker.getSnapshot(&snapshot);
+    EXPECT_EQ(snapshot.captureCount, 1u);
+    EXPECT_EQ(snapshot.sumUs[histogramFor(CAPTURE_STAGE_PARTIAL_RESULT)], 0u);
+    EXPECT_EQ(snapshot.sumUs[histogramFor(CAPTURE_STAGE_DELIVERED)], 500u);
+    EXPECT_EQ(snapshot.sumUs[CaptureLatencySnapshot::kTotal], 900u);
+
+    // A record with no stages is ignored
+    tracker.add(CaptureLatencyRecord());
+    tracker.getSnapshot(&snapshot);
+    EXPECT_EQ(snapshot.captureCount, 1u);
+
+    tracker.reset();
+    tracker.getSnapshot(&snapshot);
+    EXPECT_EQ(snapshot.captureCount, 0u);
+    EXPECT_EQ(histogramCount(snapshot, CaptureLatencySnapshot::kTotal), 0u);
+}
+
+TEST(CaptureLatencyTrackerTest, ConcurrentAdd) {
+    const size_t kThreads = 4;
+    const size_t kCapturesPerThread = 10000;
+    CameraCaptureLatencyTracker tracker;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; t++) {
+        threads.emplace_back([&tracker, t]() {
+            for (size_t i = 0; i < kCapturesPerThread; i++) {
+                CaptureLatencyRecord record;
+                record.mark(CAPTURE_STAGE_DEQUEUED, us2ns(10));
+                record.mark(CAPTURE_STAGE_DELIVERED, us2ns(10 + (t + 1) * 1000));
+                tracker.add(record);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CaptureLatencySnapshot snapshot;
+    tracker.getSnapshot(&snapshot);
+    EXPECT_EQ(snapshot.captureCount, kThreads * kCapturesPerThread);
+    EXPECT_EQ(histogramCount(snapshot, histogramFor(CAPTURE_STAGE_DELIVERED)),
+            kThreads * kCapturesPerThread);
+    EXPECT_EQ(snapshot.maxUs[histogramFor(CAPTURE_STAGE_DELIVERED)], kThreads * 1000);
+}
+
+TEST(CaptureLatencyTrackerTest, DumpSnapshot) {
+    CameraCaptureLatencyTracker tracker;
+    CaptureLatencyRecord record;
+    record.mark(CAPTURE_STAGE_SUBMITTED, us2ns(1000));
+    record.mark(CAPTURE_STAGE_DEQUEUED, us2ns(1100));
+    record.mark(CAPTURE_STAGE_DELIVERED, us2ns(2100));
+    tracker.add(record);
+
+    CaptureLatencySnapshot snapshot;
+    tracker.getSnapshot(&snapshot);
+    TemporaryFile tf;
+    CameraCaptureLatencyTracker::dumpSnapshot(tf.fd, "Latency:", snapshot);
+    std::string dump;
+    ASSERT_TRUE(android::base::ReadFileToString(tf.path, &dump));
+
+    // The submit to dequeue interval is printed as Dequeued; Submitted has no line
+    EXPECT_NE(dump.find("Dequeued"), std::string::npos) << dump;
+    EXPECT_NE(dump.find("Delivered"), std::string::npos) << dump;
+    EXPECT_NE(dump.find("Total"), std::string::npos) << dump;
+    EXPECT_EQ(dump.find("Submitted"), std::string::npos) << dump;
+    EXPECT_EQ(dump.find("Unknown"), std::string::npos) << dump;
+}
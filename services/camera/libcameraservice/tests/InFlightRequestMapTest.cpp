@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "InFlightRequestMapTest"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+
+#include "../device3/InFlightRequest.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+InFlightRequest makeRequest(int numBuffers) {
+    return InFlightRequest(numBuffers, CaptureResultExtras(), /*hasInput*/false,
+            /*hasAppCallback*/true, InFlightRequest::kDefaultExpectedDuration,
+            std::set<String8>(), /*isStillCapture*/false, /*isZslCapture*/false,
+            /*rotateAndCropAuto*/false, std::set<std::string>());
+}
+
+} // namespace
+
+TEST(InFlightRequestMapTest, BasicOperations) {
+    InFlightRequestMap map;
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(map.indexOfKey(5), NAME_NOT_FOUND);
+
+    for (uint32_t frame = 0; frame < 10; frame++) {
+        ASSERT_GE(map.add(frame, makeRequest(frame)), 0);
+    }
+    EXPECT_EQ(map.size(), 10u);
+
+    ssize_t idx = map.indexOfKey(7);
+    ASSERT_GE(idx, 0);
+    EXPECT_EQ(map.keyAt(idx), 7u);
+    EXPECT_EQ(map.valueAt(idx).numBuffersLeft, 7);
+    map.editValueAt(idx).numBuffersLeft = 42;
+    EXPECT_EQ(map.valueAt(map.indexOfKey(7)).numBuffersLeft, 42);
+
+    map.removeItemAt(idx);
+    EXPECT_EQ(map.indexOfKey(7), NAME_NOT_FOUND);
+    EXPECT_EQ(map.size(), 9u);
+
+    // Re-adding an existing key replaces its value
+    map.add(3, makeRequest(99));
+    EXPECT_EQ(map.size(), 9u);
+    EXPECT_EQ(map.valueAt(map.indexOfKey(3)).numBuffersLeft, 99);
+
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_EQ(map.indexOfKey(3), NAME_NOT_FOUND);
+}
+
+TEST(InFlightRequestMapTest, OutlierFramesAndOrderedIteration) {
+    InFlightRequestMap map;
+
+    // A long-lived request stays in flight while many newer frames wrap around the ring.
+    map.add(0, makeRequest(1));
+    for (uint32_t frame = 1; frame < 5000; frame++) {
+        map.add(frame, makeRequest(1));
+        if (frame > 8) {
+            ssize_t idx = map.indexOfKey(frame - 8);
+            ASSERT_GE(idx, 0) << "frame " << frame - 8;
+            map.removeItemAt(idx);
+        }
+    }
+    ASSERT_GE(map.indexOfKey(0), 0);
+    EXPECT_EQ(map.size(), 9u);
+
+    // Force growth, so that entries get re-homed between the ring and the overflow table
+    for (uint32_t frame = 5000; frame < 7000; frame++) {
+        map.add(frame, makeRequest(frame));
+    }
+    EXPECT_EQ(map.size(), 2009u);
+    for (uint32_t frame = 5000; frame < 7000; frame++) {
+        ssize_t idx = map.indexOfKey(frame);
+        ASSERT_GE(idx, 0) << "frame " << frame;
+        EXPECT_EQ(map.valueAt(idx).numBuffersLeft, static_cast<int>(frame));
+    }
+
+    std::vector<uint32_t> visited;
+    map.forEach([&visited](uint32_t frameNumber, const InFlightRequest&) {
+        visited.push_back(frameNumber);
+    });
+    ASSERT_EQ(visited.size(), map.size());
+    EXPECT_TRUE(std::is_sorted(visited.begin(), visited.end()));
+    EXPECT_EQ(visited.front(), 0u);
+    EXPECT_EQ(visited.back(), 6999u);
+}
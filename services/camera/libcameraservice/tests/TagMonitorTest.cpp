@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "TagMonitorTest"
+
+#include <stdio.h>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <utils/Log.h>
+
+#include "../utils/TagMonitor.h"
+
+using namespace android;
+
+namespace {
+
+// Returns the dump output of the monitor
+std::string dumpMonitor(TagMonitor& monitor) {
+    FILE* f = tmpfile();
+    monitor.dumpMonitoredMetadata(fileno(f));
+    fflush(f);
+    rewind(f);
+    std::string out;
+    char buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        out.append(buf, n);
+    }
+    fclose(f);
+    return out;
+}
+
+size_t countOccurrences(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+            pos = haystack.find(needle, pos + needle.size())) {
+        count++;
+    }
+    return count;
+}
+
+CameraMetadata makeResult(uint8_t aeState, int32_t afTrigger) {
+    CameraMetadata result;
+    result.update(ANDROID_CONTROL_AE_STATE, &aeState, 1);
+    result.update(ANDROID_CONTROL_AF_TRIGGER_ID, &afTrigger, 1);
+    return result;
+}
+
+const std::unordered_map<std::string, CameraMetadata> kNoPhysicalMetadata;
+
+} // namespace
+
+TEST(TagMonitorTest, RecordsOnlyChanges) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor(String8("android.control.aeState"));
+    ASSERT_TRUE(monitor.isMonitoringEnabled());
+
+    CameraMetadata converged = makeResult(ANDROID_CONTROL_AE_STATE_CONVERGED, 0);
+    CameraMetadata searching = makeResult(ANDROID_CONTROL_AE_STATE_SEARCHING, 0);
+    CameraMetadata empty;
+
+    monitor.monitorMetadata(TagMonitor::RESULT, 0, 100, searching, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 1, 200, searching, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 2, 300, converged, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 3, 400, converged, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 4, 500, empty, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 5, 600, empty, kNoPhysicalMetadata);
+
+    std::string out = dumpMonitor(monitor);
+    EXPECT_EQ(countOccurrences(out, "RES:"), 3u) << out;
+    EXPECT_EQ(countOccurrences(out, "(Removed)"), 1u) << out;
+    EXPECT_EQ(countOccurrences(out, "f1:"), 0u) << out;
+    EXPECT_EQ(countOccurrences(out, "f3:"), 0u) << out;
+
+    // Newest event is listed first
+    EXPECT_LT(out.find("f4:"), out.find("f2:"));
+    EXPECT_LT(out.find("f2:"), out.find("f0:"));
+}
+
+TEST(TagMonitorTest, PhysicalCamerasTrackedSeparately) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor(String8("android.control.aeState"));
+
+    CameraMetadata converged = makeResult(ANDROID_CONTROL_AE_STATE_CONVERGED, 0);
+    CameraMetadata searching = makeResult(ANDROID_CONTROL_AE_STATE_SEARCHING, 0);
+
+    std::vector<PhysicalCaptureResultInfo> physical;
+    physical.emplace_back(String16("2"), searching);
+
+    monitor.monitorMetadata(TagMonitor::RESULT, 0, 100, converged, physical);
+    monitor.monitorMetadata(TagMonitor::RESULT, 1, 200, converged, physical);
+    physical[0].mPhysicalCameraMetadata = converged;
+    monitor.monitorMetadata(TagMonitor::RESULT, 2, 300, converged, physical);
+
+    std::string out = dumpMonitor(monitor);
+    // Logical at f0, physical at f0 and f2
+    EXPECT_EQ(countOccurrences(out, "RES:"), 3u) << out;
+    EXPECT_EQ(countOccurrences(out, "f1:"), 0u) << out;
+}
+
+TEST(TagMonitorTest, EventLogIsBounded) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor(String8("android.control.afTriggerId"));
+
+    for (int32_t i = 0; i < 1000; i++) {
+        monitor.monitorMetadata(TagMonitor::REQUEST, i, (i + 1) * 100,
+                makeResult(ANDROID_CONTROL_AE_STATE_CONVERGED, i), kNoPhysicalMetadata);
+    }
+
+    std::string out = dumpMonitor(monitor);
+    EXPECT_EQ(countOccurrences(out, "REQ:"), 100u);
+    EXPECT_NE(out.find("f999:"), std::string::npos);
+    EXPECT_EQ(out.find("f899:"), std::string::npos);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "CameraCaptureLatencyTracker"
+#include <algorithm>
+#include <inttypes.h>
+#include <utils/Log.h>
+#include <utils/String8.h>
+
+#include "CaptureLatencyTracker.h"
+
+namespace android {
+
+namespace {
+
+size_t binForDurationUs(uint64_t durationUs) {
+    if (durationUs < 2) return 0;
+    size_t bin = 63 - __builtin_clzll(durationUs);
+    return std::min(bin, CaptureLatencySnapshot::kBinCount - 1);
+}
+
+// Upper bound of the bin containing the given percentile
+uint64_t percentileUs(const uint64_t (&bins)[CaptureLatencySnapshot::kBinCount], uint64_t count,
+        uint32_t percentile) {
+    uint64_t target = (count * percentile + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < CaptureLatencySnapshot::kBinCount; i++) {
+        seen += bins[i];
+        if (seen >= target) {
+            return 2ULL << i;
+        }
+    }
+    return 2ULL << (CaptureLatencySnapshot::kBinCount - 1);
+}
+
+} // anonymous namespace
+
+CameraCaptureLatencyTracker::CameraCaptureLatencyTracker() {
+    reset();
+}
+
+void CameraCaptureLatencyTracker::add(const CaptureLatencyRecord& record) {
+    nsecs_t first = 0;
+    nsecs_t previous = 0;
+    for (size_t stage = 0; stage < CAPTURE_STAGE_COUNT; stage++) {
+        nsecs_t timestamp = record.timestamps[stage];
+        if (timestamp == 0) continue;
+        if (previous != 0) {
+            // Stages such as partial results may race with each other; count an
+            // out-of-order stage as taking no time.
+            addSample(CaptureLatencySnapshot::histogramFor(
+                    static_cast<CaptureLatencyStage>(stage)),
+                    std::max<nsecs_t>(timestamp - previous, 0));
+        } else {
+            first = timestamp;
+        }
+        previous = std::max(previous, timestamp);
+    }
+    if (first == 0) return;
+
+    addSample(CaptureLatencySnapshot::kTotal, previous - first);
+    mCaptureCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CameraCaptureLatencyTracker::addSample(size_t histogram, nsecs_t duration) {
+    uint64_t durationUs = static_cast<uint64_t>(ns2us(duration));
+    Histogram& h = mHistograms[histogram];
+    h.bins[binForDurationUs(durationUs)].fetch_add(1, std::memory_order_relaxed);
+    h.sumUs.fetch_add(durationUs, std::memory_order_relaxed);
+    uint64_t currentMax = h.maxUs.load(std::memory_order_relaxed);
+    while (durationUs > currentMax &&
+            !h.maxUs.compare_exchange_weak(currentMax, durationUs, std::memory_order_relaxed)) {
+    }
+}
+
+void CameraCaptureLatencyTracker::reset() {
+    mCaptureCount.store(0, std::memory_order_relaxed);
+    for (auto& h : mHistograms) {
+        for (auto& bin : h.bins) {
+            bin.store(0, std::memory_order_relaxed);
+        }
+        h.sumUs.store(0, std::memory_order_relaxed);
+        h.maxUs.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CameraCaptureLatencyTracker::getSnapshot(CaptureLatencySnapshot* snapshot) const {
+    if (snapshot == nullptr) return;
+
+    snapshot->version = CaptureLatencySnapshot::kVersion;
+    snapshot->stageCount = CAPTURE_STAGE_COUNT;
+    snapshot->binCount = CaptureLatencySnapshot::kBinCount;
+    snapshot->reserved = 0;
+    snapshot->captureCount = mCaptureCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kHistogramCount; i++) {
+        const Histogram& h = mHistograms[i];
+        for (size_t bin = 0; bin < CaptureLatencySnapshot::kBinCount; bin++) {
+            snapshot->bins[i][bin] = h.bins[bin].load(std::memory_order_relaxed);
+        }
+        snapshot->sumUs[i] = h.sumUs.load(std::memory_order_relaxed);
+        snapshot->maxUs[i] = h.maxUs.load(std::memory_order_relaxed);
+    }
+}
+
+void CameraCaptureLatencyTracker::dump(int fd, const char* name) const {
+    CaptureLatencySnapshot snapshot;
+    getSnapshot(&snapshot);
+    dumpSnapshot(fd, name, snapshot);
+}
+
+void CameraCaptureLatencyTracker::dumpSnapshot(int fd, const char* name,
+        const CaptureLatencySnapshot& snapshot) {
+    if (snapshot.captureCount == 0) {
+        return;
+    }
+
+    String8 lines;
+    lines.appendFormat("%s (%" PRIu64 ") captures, in us\n", name, snapshot.captureCount);
+    for (size_t i = 0; i < kHistogramCount; i++) {
+        uint64_t count = 0;
+        for (auto bin : snapshot.bins[i]) {
+            count += bin;
+        }
+        if (count == 0) continue;
+        lines.appendFormat("      %-18s n=%-8" PRIu64 " mean=%-8" PRIu64 " p50<%-8" PRIu64
+                " p90<%-8" PRIu64 " p99<%-8" PRIu64 " max=%" PRIu64 "\n",
+                i == CaptureLatencySnapshot::kTotal ? "Total" : stageName(i + 1),
+                count, snapshot.sumUs[i] / count,
+                percentileUs(snapshot.bins[i], count, 50),
+                percentileUs(snapshot.bins[i], count, 90),
+                percentileUs(snapshot.bins[i], count, 99), snapshot.maxUs[i]);
+    }
+
+    write(fd, lines.string(), lines.size());
+}
+
+const char* CameraCaptureLatencyTracker::stageName(size_t stage) {
+    switch (stage) {
+        case CAPTURE_STAGE_SUBMITTED:
+            return "Submitted";
+        case CAPTURE_STAGE_DEQUEUED:
+            return "Dequeued";
+        case CAPTURE_STAGE_HAL_SUBMITTED:
+            return "HalSubmitted";
+        case CAPTURE_STAGE_SHUTTER:
+            return "Shutter";
+        case CAPTURE_STAGE_PARTIAL_RESULT:
+            return "PartialResult";
+        case CAPTURE_STAGE_BUFFERS_RETURNED:
+            return "BuffersReturned";
+        case CAPTURE_STAGE_DELIVERED:
+            return "Delivered";
+        default:
+            return "Unknown";
+    }
+}
+
+}; // namespace android
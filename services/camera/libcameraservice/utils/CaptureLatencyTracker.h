@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_CAPTURE_LATENCY_TRACKER_H_
+#define ANDROID_SERVERS_CAMERA_CAPTURE_LATENCY_TRACKER_H_
+
+#include <array>
+#include <atomic>
+
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+namespace android {
+
+/**
+ * Pipeline stages of a single capture, in the order they normally happen.
+ */
+enum CaptureLatencyStage {
+    // Request submitted by the client. Not recorded for repeating requests. Always the first
+    // recorded stage, so it only starts the Dequeued interval and has no histogram of its own.
+    CAPTURE_STAGE_SUBMITTED = 0,
+    // Request taken off the request queue by the request thread
+    CAPTURE_STAGE_DEQUEUED,
+    // Output buffers acquired and request handed to processCaptureRequest
+    CAPTURE_STAGE_HAL_SUBMITTED,
+    // Shutter notification received from the HAL
+    CAPTURE_STAGE_SHUTTER,
+    // First partial result received from the HAL
+    CAPTURE_STAGE_PARTIAL_RESULT,
+    // All output and input buffers returned by the HAL
+    CAPTURE_STAGE_BUFFERS_RETURNED,
+    // Final result and all buffers delivered to the client
+    CAPTURE_STAGE_DELIVERED,
+    CAPTURE_STAGE_COUNT
+};
+
+/**
+ * Timestamps of one capture at each of the pipeline stages. A timestamp of 0 means that the
+ * stage was not reached or not recorded. Owned by the in-flight request and only accessed
+ * under the same lock, so no synchronization of its own.
+ */
+struct CaptureLatencyRecord {
+    std::array<nsecs_t, CAPTURE_STAGE_COUNT> timestamps{};
+
+    void mark(CaptureLatencyStage stage, nsecs_t now = systemTime()) {
+        timestamps[stage] = now;
+    }
+
+    // Only records the first time a stage is reached, e.g. for the first of several partial
+    // results.
+    void markOnce(CaptureLatencyStage stage, nsecs_t now = systemTime()) {
+        if (timestamps[stage] == 0) timestamps[stage] = now;
+    }
+};
+
+/**
+ * Aggregated capture latency histograms, as returned by
+ * CameraCaptureLatencyTracker::getSnapshot. Plain data with fixed layout, so that it can be
+ * copied out as a binary blob.
+ */
+struct CaptureLatencySnapshot {
+    static constexpr uint32_t kVersion = 1;
+    // Bin i counts latencies in [2^i, 2^(i+1)) microseconds; bin 0 also counts anything
+    // shorter, and the last bin anything longer.
+    static constexpr size_t kBinCount = 24;
+    // Index of the end-to-end histogram, after the per-stage ones.
+    static constexpr size_t kTotal = CAPTURE_STAGE_COUNT - 1;
+    static constexpr size_t kHistogramCount = kTotal + 1;
+
+    // Index of the histogram of the interval ending at the given stage. There is none for
+    // CAPTURE_STAGE_SUBMITTED.
+    static constexpr size_t histogramFor(CaptureLatencyStage stage) { return stage - 1; }
+
+    uint32_t version;
+    // CAPTURE_STAGE_COUNT, which is also the number of histograms
+    uint32_t stageCount;
+    uint32_t binCount;
+    uint32_t reserved;
+    // Number of captures aggregated
+    uint64_t captureCount;
+    // For each stage after CAPTURE_STAGE_SUBMITTED, the time since the previous recorded
+    // stage, see histogramFor(). Entry kTotal is the time from the first to the last recorded
+    // stage.
+    uint64_t bins[kHistogramCount][kBinCount];
+    uint64_t sumUs[kHistogramCount];
+    uint64_t maxUs[kHistogramCount];
+};
+
+/**
+ * Per-stage capture latency histograms with logarithmic bins.
+ *
+ * Completed captures are added from the result paths without any locking; all counters are
+ * relaxed atomics, so a concurrent snapshot may be off by the capture being added.
+ */
+class CameraCaptureLatencyTracker {
+public:
+    CameraCaptureLatencyTracker();
+
+    // Aggregate the stage timestamps of a completed capture
+    void add(const CaptureLatencyRecord& record);
+    void reset();
+
+    void getSnapshot(CaptureLatencySnapshot* snapshot) const;
+    void dump(int fd, const char* name) const;
+
+    // Print a snapshot as returned by getSnapshot(); prints nothing if no capture was added
+    static void dumpSnapshot(int fd, const char* name, const CaptureLatencySnapshot& snapshot);
+
+    static const char* stageName(size_t stage);
+
+private:
+    static constexpr size_t kHistogramCount = CaptureLatencySnapshot::kHistogramCount;
+
+    struct Histogram {
+        std::atomic<uint64_t> bins[CaptureLatencySnapshot::kBinCount];
+        std::atomic<uint64_t> sumUs;
+        std::atomic<uint64_t> maxUs;
+    };
+
+    void addSample(size_t histogram, nsecs_t duration);
+
+    std::atomic<uint64_t> mCaptureCount;
+    Histogram mHistograms[kHistogramCount];
+}; // class CameraCaptureLatencyTracker
+
+}; // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAPTURE_LATENCY_TRACKER_H_
@@ -20,6 +20,7 @@
 
 #include "TagMonitor.h"
 
+#include <algorithm>
 #include <inttypes.h>
 #include <utils/Log.h>
 #include <camera/VendorTagDescriptor.h>
@@ -30,6 +31,9 @@ namespace android {
 TagMonitor::TagMonitor():
         mMonitoringEnabled(false),
         mMonitoringEvents(kMaxMonitorEvents),
+        mNextEventIndex(0),
+        mEventCount(0),
+        mEventCameraIds(1),
         mVendorTagId(CAMERA_METADATA_INVALID_VENDOR_ID)
 {}
 
@@ -41,6 +45,9 @@ TagMonitor::TagMonitor(const TagMonitor& other):
         mLastMonitoredPhysicalRequestKeys(other.mLastMonitoredPhysicalRequestKeys),
         mLastMonitoredPhysicalResultKeys(other.mLastMonitoredPhysicalResultKeys),
         mMonitoringEvents(other.mMonitoringEvents),
+        mNextEventIndex(other.mNextEventIndex),
+        mEventCount(other.mEventCount),
+        mEventCameraIds(other.mEventCameraIds),
         mVendorTagId(other.mVendorTagId) {}
 
 const String16 TagMonitor::kMonitorOption = String16("-m");
@@ -91,6 +98,8 @@ void TagMonitor::parseTagsToMonitor(String8 tagNames) {
         } else {
             if (!gotTag) {
                 mMonitoredTagList.clear();
+                // Last-seen values are stored by position in the tag list
+                clearLastValuesLocked();
                 gotTag = true;
             }
             mMonitoredTagList.push_back(tag);
@@ -108,6 +117,11 @@ void TagMonitor::parseTagsToMonitor(String8 tagNames) {
 
 void TagMonitor::disableMonitoring() {
     mMonitoringEnabled = false;
+    std::lock_guard<std::mutex> lock(mMonitorMutex);
+    clearLastValuesLocked();
+}
+
+void TagMonitor::clearLastValuesLocked() {
     mLastMonitoredRequestValues.clear();
     mLastMonitoredResultValues.clear();
     mLastMonitoredPhysicalRequestKeys.clear();
@@ -126,76 +140,115 @@ void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_
     }
 
     std::string emptyId;
-    for (auto tag : mMonitoredTagList) {
-        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata);
+    monitorSingleMetadata(source, frameNumber, timestamp, emptyId, metadata);
+    for (auto& m : physicalMetadata) {
+        monitorSingleMetadata(source, frameNumber, timestamp, m.first, m.second);
+    }
+}
 
-        for (auto& m : physicalMetadata) {
-            monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second);
-        }
+void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
+        const CameraMetadata& metadata,
+        const std::vector<PhysicalCaptureResultInfo>& physicalMetadata) {
+    if (!mMonitoringEnabled) return;
+
+    std::lock_guard<std::mutex> lock(mMonitorMutex);
+
+    if (timestamp == 0) {
+        timestamp = systemTime(SYSTEM_TIME_BOOTTIME);
+    }
+
+    std::string emptyId;
+    monitorSingleMetadata(source, frameNumber, timestamp, emptyId, metadata);
+    for (auto& m : physicalMetadata) {
+        std::string cameraId(String8(m.mPhysicalCameraId).string());
+        monitorSingleMetadata(source, frameNumber, timestamp, cameraId,
+                m.mPhysicalCameraMetadata);
     }
 }
 
+uint64_t TagMonitor::hashEntry(const camera_metadata_ro_entry& entry) {
+    // 64-bit FNV-1a over the type, count and value bytes
+    const uint64_t kPrime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= kPrime;
+        }
+    };
+    mix(&entry.type, sizeof(entry.type));
+    mix(reinterpret_cast<const uint8_t*>(&entry.count), sizeof(entry.count));
+    mix(entry.data.u8, camera_metadata_type_size[entry.type] * entry.count);
+
+    // Keep the absent marker unambiguous
+    return (hash == kValueAbsent) ? 1 : hash;
+}
+
 void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
-        const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata) {
+        const std::string& cameraId, const CameraMetadata& metadata) {
 
-    CameraMetadata &lastValues = (source == REQUEST) ?
+    TagValueHashes &lastValues = (source == REQUEST) ?
             (cameraId.empty() ? mLastMonitoredRequestValues :
                     mLastMonitoredPhysicalRequestKeys[cameraId]) :
             (cameraId.empty() ? mLastMonitoredResultValues :
                     mLastMonitoredPhysicalResultKeys[cameraId]);
 
-    camera_metadata_ro_entry entry = metadata.find(tag);
-    if (lastValues.isEmpty()) {
-        lastValues = CameraMetadata(mMonitoredTagList.size());
-        const camera_metadata_t *metaBuffer =
-                lastValues.getAndLock();
-        set_camera_metadata_vendor_id(
-                const_cast<camera_metadata_t *> (metaBuffer), mVendorTagId);
-        lastValues.unlock(metaBuffer);
+    if (lastValues.size() != mMonitoredTagList.size()) {
+        lastValues.assign(mMonitoredTagList.size(), kValueAbsent);
     }
 
-    camera_metadata_entry lastEntry = lastValues.find(tag);
-
-    if (entry.count > 0) {
-        bool isDifferent = false;
-        if (lastEntry.count > 0) {
-            // Have a last value, compare to see if changed
-            if (lastEntry.type == entry.type &&
-                    lastEntry.count == entry.count) {
-                // Same type and count, compare values
-                size_t bytesPerValue = camera_metadata_type_size[lastEntry.type];
-                size_t entryBytes = bytesPerValue * lastEntry.count;
-                int cmp = memcmp(entry.data.u8, lastEntry.data.u8, entryBytes);
-                if (cmp != 0) {
-                    isDifferent = true;
-                }
-            } else {
-                // Count or type has changed
-                isDifferent = true;
-            }
-        } else {
-            // No last entry, so always consider to be different
-            isDifferent = true;
+    for (size_t i = 0; i < mMonitoredTagList.size(); i++) {
+        uint32_t tag = mMonitoredTagList[i];
+        camera_metadata_ro_entry entry = metadata.find(tag);
+        uint64_t hash = (entry.count > 0) ? hashEntry(entry) : kValueAbsent;
+        if (hash == lastValues[i]) {
+            continue;
         }
 
-        if (isDifferent) {
+        if (entry.count > 0) {
             ALOGV("%s: Tag %s changed", __FUNCTION__,
                   get_local_camera_metadata_tag_name_vendor_id(
                           tag, mVendorTagId));
-            lastValues.update(entry);
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId);
+        } else {
+            // Value has been removed
+            ALOGV("%s: Tag %s removed", __FUNCTION__,
+                  get_local_camera_metadata_tag_name_vendor_id(
+                          tag, mVendorTagId));
+            entry.tag = tag;
+            entry.type = get_local_camera_metadata_tag_type_vendor_id(tag,
+                    mVendorTagId);
+        }
+        lastValues[i] = hash;
+        recordEventLocked(source, frameNumber, timestamp, cameraId, entry);
+    }
+}
+
+void TagMonitor::recordEventLocked(eventSource source, int64_t frameNumber, nsecs_t timestamp,
+        const std::string& cameraId, const camera_metadata_ro_entry& entry) {
+    uint16_t cameraIdIndex = 0;
+    if (!cameraId.empty()) {
+        auto it = std::find(mEventCameraIds.begin(), mEventCameraIds.end(), cameraId);
+        cameraIdIndex = it - mEventCameraIds.begin();
+        if (it == mEventCameraIds.end()) {
+            mEventCameraIds.push_back(cameraId);
         }
-    } else if (lastEntry.count > 0) {
-        // Value has been removed
-        ALOGV("%s: Tag %s removed", __FUNCTION__,
-              get_local_camera_metadata_tag_name_vendor_id(
-                      tag, mVendorTagId));
-        lastValues.erase(tag);
-        entry.tag = tag;
-        entry.type = get_local_camera_metadata_tag_type_vendor_id(tag,
-                mVendorTagId);
-        entry.count = 0;
-        mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId);
+    }
+
+    MonitorEvent& event = mMonitoringEvents[mNextEventIndex];
+    mNextEventIndex = (mNextEventIndex + 1) % kMaxMonitorEvents;
+    mEventCount = std::min(mEventCount + 1, kMaxMonitorEvents);
+
+    size_t typeSize = camera_metadata_type_size[entry.type];
+    event.source = source;
+    event.frameNumber = frameNumber;
+    event.timestamp = timestamp;
+    event.tag = entry.tag;
+    event.type = entry.type;
+    event.cameraIdIndex = cameraIdIndex;
+    event.count = entry.count;
+    event.storedCount = std::min(entry.count, kMaxEventDataSize / typeSize);
+    if (event.storedCount > 0) {
+        memcpy(event.data, entry.data.u8, event.storedCount * typeSize);
     }
 }
 
@@ -214,25 +267,32 @@ void TagMonitor::dumpMonitoredMetadata(int fd) {
     } else {
         dprintf(fd, "     Tag monitoring disabled (enable with -m <name1,..,nameN>)\n");
     }
-    if (mMonitoringEvents.size() > 0) {
+    if (mEventCount > 0) {
         dprintf(fd, "     Monitored tag event log:\n");
-        for (const auto& event : mMonitoringEvents) {
+        // Newest event first
+        for (size_t i = 1; i <= mEventCount; i++) {
+            const MonitorEvent& event = mMonitoringEvents[
+                    (mNextEventIndex + kMaxMonitorEvents - i) % kMaxMonitorEvents];
             int indentation = (event.source == REQUEST) ? 15 : 30;
             dprintf(fd, "        f%d:%" PRId64 "ns:%*s%*s%s.%s: ",
                     event.frameNumber, event.timestamp,
-                    2, event.cameraId.c_str(),
+                    2, mEventCameraIds[event.cameraIdIndex].c_str(),
                     indentation,
                     event.source == REQUEST ? "REQ:" : "RES:",
                     get_local_camera_metadata_section_name_vendor_id(event.tag,
                             mVendorTagId),
                     get_local_camera_metadata_tag_name_vendor_id(event.tag,
                             mVendorTagId));
-            if (event.newData.size() == 0) {
+            if (event.count == 0) {
                 dprintf(fd, " (Removed)\n");
             } else {
-                printData(fd, event.newData.data(), event.tag,
-                        event.type, event.newData.size() / camera_metadata_type_size[event.type],
+                printData(fd, event.data, event.tag,
+                        event.type, event.storedCount,
                         indentation + 18);
+                if (event.storedCount < event.count) {
+                    dprintf(fd, "%*s(%u of %u values logged)\n", indentation + 22, "",
+                            event.storedCount, event.count);
+                }
             }
         }
     }
@@ -323,19 +383,4 @@ void TagMonitor::printData(int fd, const uint8_t *data_ptr, uint32_t tag,
     }
 }
 
-template<typename T>
-TagMonitor::MonitorEvent::MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-        const T &value, const std::string& cameraId) :
-        source(src),
-        frameNumber(frameNumber),
-        timestamp(timestamp),
-        tag(value.tag),
-        type(value.type),
-        newData(value.data.u8, value.data.u8 + camera_metadata_type_size[value.type] * value.count),
-        cameraId(cameraId) {
-}
-
-TagMonitor::MonitorEvent::~MonitorEvent() {
-}
-
 } // namespace android
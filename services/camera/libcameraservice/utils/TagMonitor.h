@@ -26,17 +26,21 @@
 #include <utils/String8.h>
 #include <utils/Timers.h>
 
-#include <media/RingBuffer.h>
 #include <system/camera_metadata.h>
 #include <system/camera_vendor_tags.h>
 #include <camera/CameraMetadata.h>
+#include <camera/CaptureResult.h>
 
 namespace android {
 
 /**
  * A monitor for camera metadata values.
  * Tracks changes to specified metadata values over time, keeping a circular
- * buffer log that can be dumped at will. */
+ * buffer log that can be dumped at will.
+ *
+ * Changes are detected by comparing a hash of each monitored value against the
+ * hash of its last-seen value, and the event log is preallocated, so that
+ * monitoring doesn't allocate or copy metadata on the request and result paths. */
 class TagMonitor {
   public:
 
@@ -63,11 +67,19 @@ class TagMonitor {
     // Disable monitoring; does not clear the event log
     void disableMonitoring();
 
+    bool isMonitoringEnabled() const { return mMonitoringEnabled; }
+
     // Scan through the metadata and update the monitoring information
     void monitorMetadata(eventSource source, int64_t frameNumber,
             nsecs_t timestamp, const CameraMetadata& metadata,
             const std::unordered_map<std::string, CameraMetadata>& physicalMetadata);
 
+    // Same as above, taking the physical camera metadata in the form it is
+    // delivered to the client, to avoid building a copy just for monitoring.
+    void monitorMetadata(eventSource source, int64_t frameNumber,
+            nsecs_t timestamp, const CameraMetadata& metadata,
+            const std::vector<PhysicalCaptureResultInfo>& physicalMetadata);
+
     // Dump current event log to the provided fd
     void dumpMonitoredMetadata(int fd);
 
@@ -76,9 +88,21 @@ class TagMonitor {
     static void printData(int fd, const uint8_t *data_ptr, uint32_t tag,
             int type, int count, int indentation);
 
+    // Hashes of the last-seen values of the monitored tags, in mMonitoredTagList order
+    typedef std::vector<uint64_t> TagValueHashes;
+
+    // Hash value of a tag that is not present
+    static constexpr uint64_t kValueAbsent = 0;
+
+    static uint64_t hashEntry(const camera_metadata_ro_entry& entry);
+
     void monitorSingleMetadata(TagMonitor::eventSource source, int64_t frameNumber,
-            nsecs_t timestamp, const std::string& cameraId, uint32_t tag,
-            const CameraMetadata& metadata);
+            nsecs_t timestamp, const std::string& cameraId, const CameraMetadata& metadata);
+
+    void recordEventLocked(eventSource source, int64_t frameNumber, nsecs_t timestamp,
+            const std::string& cameraId, const camera_metadata_ro_entry& entry);
+
+    void clearLastValuesLocked();
 
     std::atomic<bool> mMonitoringEnabled;
     std::mutex mMonitorMutex;
@@ -87,35 +111,45 @@ class TagMonitor {
     std::vector<uint32_t> mMonitoredTagList;
 
     // Latest-seen values of tracked tags
-    CameraMetadata mLastMonitoredRequestValues;
-    CameraMetadata mLastMonitoredResultValues;
+    TagValueHashes mLastMonitoredRequestValues;
+    TagValueHashes mLastMonitoredResultValues;
 
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalRequestKeys;
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalResultKeys;
+    std::unordered_map<std::string, TagValueHashes> mLastMonitoredPhysicalRequestKeys;
+    std::unordered_map<std::string, TagValueHashes> mLastMonitoredPhysicalResultKeys;
+
+    // Values larger than this are truncated in the event log
+    static constexpr size_t kMaxEventDataSize = 128;
 
     /**
      * A monitoring event
      * Stores a new metadata field value and the timestamp at which it changed.
-     * Copies the source metadata value array and frees it on destruct.
+     * The value is copied into inline storage, so events can be reused in place.
      */
     struct MonitorEvent {
-        template<typename T>
-        MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-                const T &newValue, const std::string& cameraId);
-        ~MonitorEvent();
-
         eventSource source;
         uint32_t frameNumber;
         nsecs_t timestamp;
         uint32_t tag;
         uint8_t type;
-        std::vector<uint8_t> newData;
-        std::string cameraId;
+        // Index into mEventCameraIds; 0 for the logical camera
+        uint16_t cameraIdIndex;
+        // Number of values of the tag, 0 if it was removed
+        uint32_t count;
+        // Number of values kept in data
+        uint32_t storedCount;
+        uint8_t data[kMaxEventDataSize];
     };
 
-    // A ring buffer for tracking the last kMaxMonitorEvents metadata changes
-    static const int kMaxMonitorEvents = 100;
-    RingBuffer<MonitorEvent> mMonitoringEvents;
+    // A ring buffer for tracking the last kMaxMonitorEvents metadata changes,
+    // allocated up front
+    static constexpr size_t kMaxMonitorEvents = 100;
+    std::vector<MonitorEvent> mMonitoringEvents;
+    // Slot the next event is written to, and number of valid events
+    size_t mNextEventIndex;
+    size_t mEventCount;
+
+    // Camera ids referenced by the events. Entry 0 is the logical camera.
+    std::vector<std::string> mEventCameraIds;
 
     // 3A fields to use with the "3a" option
     static const char *k3aTags;
@@ -102,7 +102,9 @@ public:
             ll -= l;
         }
         if (ll > 0) {
-            ss << "TimeMachine: gc(" << mTimeMachine.getGarbageCollectionCount() << ")\n";
+            ss << "TimeMachine: gc(" << mTimeMachine.getGarbageCollectionCount()
+                    << ") keys(" << mTimeMachine.size()
+                    << ") bytes(" << mTimeMachine.getMemoryBytes() << ")\n";
             --ll;
         }
         if (ll > 0) {
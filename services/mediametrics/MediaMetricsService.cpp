@@ -111,6 +111,30 @@ MediaMetricsService::~MediaMetricsService()
     mItems.clear();
 }
 
+status_t MediaMetricsService::submitBatch(const char *buffer, size_t length)
+{
+    status_t status = NO_ERROR;
+    while (length > 0) {
+        // every item starts with its total size
+        uint32_t size;
+        if (length < sizeof(size)) {
+            return BAD_VALUE;
+        }
+        memcpy(&size, buffer, sizeof(size));
+        if (size < sizeof(size) || size > length) {
+            ALOGW("%s: bad item size %u, %zu bytes left", __func__, size, length);
+            return BAD_VALUE;
+        }
+        const status_t itemStatus = submitBuffer(buffer, size);
+        if (itemStatus != NO_ERROR) {
+            status = itemStatus; // keep going, items are independent
+        }
+        buffer += size;
+        length -= size;
+    }
+    return status;
+}
+
 status_t MediaMetricsService::submitInternal(mediametrics::Item *item, bool release)
 {
     // calling PID is 0 for one-way calls.
@@ -55,6 +55,9 @@ public:
                 ?: submitInternal(item, true /* release */);
     }
 
+    // Submits each item of a batch as submitBuffer() would.
+    status_t submitBatch(const char *buffer, size_t length) override;
+
     status_t dump(int fd, const Vector<String16>& args) override;
 
     static constexpr const char * const kServiceName = "media.metrics";
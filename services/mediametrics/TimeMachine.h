@@ -16,11 +16,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <any>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -60,27 +62,251 @@ std::ostream & operator<< (std::ostream& s,
  *
  * Any URL that ends with '#' (AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED)
  * will have a time sequence that keeps duplicates.
+ * Storage is columnar: each key keeps, per property, the times and values of
+ * its last kTimeSequenceMaxElements changes in two parallel rings, and refers
+ * to the property by an id interned once per TimeMachine.
  *
  * The TimeMachine is NOT thread safe.
  */
 class TimeMachine final { // made final as we have copy constructor instead of dup() override.
 public:
     using Elem = Item::Prop::Elem;  // use the Item property element.
-    using PropertyHistory = std::multimap<int64_t /* time */, Elem>;
 
 private:
 
+    static inline constexpr size_t kTimeSequenceMaxElements = 50;
+    static inline constexpr size_t kKeyMaxProperties = 50;
+    static inline constexpr size_t kKeyLowWaterMark = 400;
+    static inline constexpr size_t kKeyHighWaterMark = 500;
+
+    // Estimated max data space usage is 3KB * kKeyHighWaterMark.
+
+    // Heap bytes owned by a std::string beyond its inline (small string) storage.
+    static size_t stringHeapBytes(const std::string& s) {
+        static const size_t inlineCapacity = std::string().capacity();
+        return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+    }
+
+    // PropertyNames interns property names for all the keys of a TimeMachine
+    // (and of its copies, which share it) so a KeyHistory identifies a property
+    // by a small integer instead of storing its name again.
+    //
+    // Every column holds a reference on its name. A name is removed with its
+    // last column, when the keys using it are garbage collected, and its id is
+    // then reused. So the table holds at most the names of the live columns,
+    // which kKeyMaxProperties and the key water marks bound.
+    // The ids of AMEDIAMETRICS_PROP_ALLOWUID and "_expire" are never removed.
+    // mLock is a leaf lock: no other lock is acquired while holding it.
+    class PropertyNames {
+    public:
+        static inline constexpr int32_t kAllowUidId = 0;
+        static inline constexpr int32_t kExpireId = 1;
+
+        PropertyNames() {
+            acquire(AMEDIAMETRICS_PROP_ALLOWUID);
+            acquire("_expire");
+        }
+
+        // Returns the id of name, or -1 if name is not interned.
+        // The name of an id only stays the same while a column refers to it,
+        // so the id must only be used to look up the columns of a locked key.
+        int32_t find(const std::string& name) const {
+            std::lock_guard lock(mLock);
+            return find_l(name);
+        }
+
+        // Looks up all names with a single lock acquisition.
+        void find(const std::vector<const std::string *>& names,
+                std::vector<int32_t>* ids) const {
+            std::lock_guard lock(mLock);
+            ids->clear();
+            for (const std::string *name : names) {
+                ids->push_back(find_l(*name));
+            }
+        }
+
+        // Interns name if needed, and returns its id with a reference for a new column.
+        int32_t acquire(const std::string& name) {
+            std::lock_guard lock(mLock);
+            auto it = mIds.find(name);
+            if (it == mIds.end()) {
+                int32_t id;
+                if (mFreeIds.empty()) {
+                    id = (int32_t)mEntries.size();
+                    mEntries.emplace_back();
+                } else {
+                    id = mFreeIds.back();
+                    mFreeIds.pop_back();
+                }
+                it = mIds.emplace(name, id).first;
+                mEntries[id].name = &it->first; // node keys are stable
+            }
+            ++mEntries[it->second].refs;
+            return it->second;
+        }
+
+        // Adds a reference to an id for a copy of its column.
+        void acquire(int32_t id) {
+            std::lock_guard lock(mLock);
+            ++mEntries[id].refs;
+        }
+
+        // Drops the reference of a column, removing the name with its last reference.
+        void release(int32_t id) {
+            std::lock_guard lock(mLock);
+            Entry& entry = mEntries[id];
+            if (--entry.refs > 0) return;
+            mIds.erase(mIds.find(*entry.name));
+            entry.name = nullptr;
+            mFreeIds.push_back(id);
+        }
+
+        std::string getName(int32_t id) const {
+            std::lock_guard lock(mLock);
+            return *mEntries[id].name;
+        }
+
+        size_t size() const {
+            std::lock_guard lock(mLock);
+            return mIds.size();
+        }
+
+        size_t getMemoryBytes() const {
+            std::lock_guard lock(mLock);
+            size_t bytes = sizeof(*this)
+                    + mEntries.capacity() * sizeof(mEntries[0])
+                    + mFreeIds.capacity() * sizeof(mFreeIds[0])
+                    + mIds.bucket_count() * sizeof(void *);
+            for (const auto& [name, id] : mIds) {
+                // node: next pointer, cached hash and value.
+                bytes += 2 * sizeof(void *) + sizeof(std::pair<const std::string, int32_t>)
+                        + stringHeapBytes(name);
+            }
+            return bytes;
+        }
+
+    private:
+        struct Entry {
+            const std::string *name = nullptr;  // nullptr if the id is free.
+            size_t refs = 0;
+        };
+
+        int32_t find_l(const std::string& name) const REQUIRES(mLock) {
+            const auto it = mIds.find(name);
+            return it == mIds.end() ? -1 : it->second;
+        }
+
+        mutable std::mutex mLock;
+        std::unordered_map<std::string, int32_t> mIds GUARDED_BY(mLock);
+        std::vector<Entry> mEntries GUARDED_BY(mLock);  // indexed by id
+        std::vector<int32_t> mFreeIds GUARDED_BY(mLock);
+    };
+
+    // Column contains the time sequence of one property of a key, sorted by time.
+    // Times and values are held in two rings of at most kTimeSequenceMaxElements
+    // which share their indexing, so searching by time only touches the times.
+    class Column {
+    public:
+        Column(int32_t nameId, bool keepDuplicates)
+            : mNameId(nameId)
+            , mKeepDuplicates(keepDuplicates) {}
+
+        int32_t getNameId() const { return mNameId; }
+        size_t size() const { return mCount; }
+        int64_t timeAt(size_t i) const { return mTimes[physical(i)]; }
+        const Elem& valueAt(size_t i) const { return mValues[physical(i)]; }
+
+        // Returns the index of the first element with a time greater than time.
+        size_t upperBound(int64_t time) const {
+            size_t lo = 0;
+            for (size_t hi = mCount; lo < hi;) {
+                const size_t mid = (lo + hi) / 2;
+                if (timeAt(mid) <= time) lo = mid + 1; else hi = mid;
+            }
+            return lo;
+        }
+
+        // Returns the index of the first element with a time not less than time.
+        size_t lowerBound(int64_t time) const {
+            size_t lo = 0;
+            for (size_t hi = mCount; lo < hi;) {
+                const size_t mid = (lo + hi) / 2;
+                if (timeAt(mid) < time) lo = mid + 1; else hi = mid;
+            }
+            return lo;
+        }
+
+        void put(int64_t time, Elem&& value) {
+            if (mCount > 0 && !mKeepDuplicates && valueAt(mCount - 1) == value) {
+                return; // value unchanged.
+            }
+            if (mCount == kTimeSequenceMaxElements) {
+                if (time < timeAt(0)) return; // would be discarded as the oldest.
+                ALOGV("%s: restricting maximum elements (discarding oldest)", __func__);
+                // the oldest slot becomes the one after the newest.
+                mHead = (uint8_t)physical(1);
+                --mCount;
+            } else {
+                // not full, so mHead is 0 and the new slot is at the end.
+                if (mTimes.size() == mTimes.capacity()) {
+                    const size_t capacity =
+                            std::min(std::max(mTimes.capacity() * 2, (size_t)4),
+                                    kTimeSequenceMaxElements);
+                    mTimes.reserve(capacity);
+                    mValues.reserve(capacity);
+                }
+                mTimes.emplace_back();
+                mValues.emplace_back();
+            }
+            // Items are mostly put in time order, otherwise shift the newer elements.
+            size_t pos = mCount;
+            for (; pos > 0 && timeAt(pos - 1) > time; --pos) {
+                mTimes[physical(pos)] = mTimes[physical(pos - 1)];
+                mValues[physical(pos)] = std::move(mValues[physical(pos - 1)]);
+            }
+            mTimes[physical(pos)] = time;
+            mValues[physical(pos)] = std::move(value);
+            ++mCount;
+        }
+
+        size_t getMemoryBytes() const {
+            size_t bytes = mTimes.capacity() * sizeof(mTimes[0])
+                    + mValues.capacity() * sizeof(mValues[0]);
+            for (const auto& value : mValues) {
+                if (const auto s = std::get_if<std::string>(&value); s != nullptr) {
+                    bytes += stringHeapBytes(*s);
+                }
+            }
+            return bytes;
+        }
+
+    private:
+        size_t physical(size_t i) const {
+            i += mHead;
+            return i < mTimes.size() ? i : i - mTimes.size();
+        }
+
+        int32_t mNameId;
+        bool mKeepDuplicates;           // property name ends with '#'.
+        uint8_t mHead = 0;              // physical index of the oldest element.
+        uint8_t mCount = 0;
+        std::vector<int64_t> mTimes;
+        std::vector<Elem> mValues;
+    };
+    static_assert(kTimeSequenceMaxElements <= UINT8_MAX);
+
     // KeyHistory contains no lock.
     // Access is through the TimeMachine, and a hash-striped lock is used
     // before calling into KeyHistory.
     class KeyHistory  {
     public:
         template <typename T>
-        KeyHistory(T key, uid_t allowUid, int64_t time)
+        KeyHistory(T key, uid_t allowUid, std::shared_ptr<PropertyNames> names, int64_t time)
             : mKey(key)
             , mAllowUid(allowUid)
             , mCreationTime(time)
             , mLastModificationTime(time)
+            , mNames(std::move(names))
         {
             (void)mCreationTime; // suppress unused warning.
 
@@ -89,11 +315,34 @@ private:
             // If allowUid == (uid_t)-1, no untrusted client may set properties in the key.
             if (allowUid != (uid_t)-1) {
                 // Set ALLOWUID property here; does not change after key creation.
-                putValue(AMEDIAMETRICS_PROP_ALLOWUID, (int32_t)allowUid, time);
+                putValue(AMEDIAMETRICS_PROP_ALLOWUID, PropertyNames::kAllowUidId,
+                        (int32_t)allowUid, time);
+            }
+        }
+
+        KeyHistory(const KeyHistory &other)
+            : mKey(other.mKey)
+            , mAllowUid(other.mAllowUid)
+            , mCreationTime(other.mCreationTime)
+            , mLastModificationTime(other.mLastModificationTime)
+            , mNames(other.mNames)
+            , mColumns(other.mColumns)
+        {
+            for (const auto& column : mColumns) {
+                mNames->acquire(column.getNameId());
+            }
+        }
+
+        KeyHistory& operator=(const KeyHistory &other) = delete;
+
+        ~KeyHistory() {
+            for (const auto& column : mColumns) {
+                mNames->release(column.getNameId());
             }
         }
 
-        KeyHistory(const KeyHistory &other) = default;
+        // The names of the columns, to look up ids under the key lock.
+        const PropertyNames& getNames() const { return *mNames; }
 
         // Return NO_ERROR only if the passed in uidCheck is -1 or matches
         // the internal mAllowUid.
@@ -105,68 +354,71 @@ private:
         }
 
         template <typename T>
-        status_t getValue(const std::string &property, T* value, int64_t time = 0) const
+        status_t getValue(int32_t nameId, T* value, int64_t time = 0) const
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
-            const auto tsptr = mPropertyMap.find(property);
-            if (tsptr == mPropertyMap.end()) return BAD_VALUE;
-            const auto& timeSequence = tsptr->second;
-            auto eptr = timeSequence.upper_bound(time);
-            if (eptr == timeSequence.begin()) return BAD_VALUE;
-            --eptr;
-            if (eptr == timeSequence.end()) return BAD_VALUE;
-            const T* vptr = std::get_if<T>(&eptr->second);
+            const size_t c = findColumn(nameId);
+            if (c == mColumns.size()) return BAD_VALUE;
+            const Column& column = mColumns[c];
+            const size_t i = column.upperBound(time);
+            if (i == 0) return BAD_VALUE;
+            const T* vptr = std::get_if<T>(&column.valueAt(i - 1));
             if (vptr == nullptr) return BAD_VALUE;
             *value = *vptr;
             return NO_ERROR;
         }
 
         template <typename T>
-        status_t getValue(const std::string &property, T defaultValue, int64_t time = 0) const
+        status_t getValue(int32_t nameId, T defaultValue, int64_t time = 0) const
                 REQUIRES(mPseudoKeyHistoryLock){
             T value;
-            return getValue(property, &value, time) != NO_ERROR ? defaultValue : value;
+            return getValue(nameId, &value, time) != NO_ERROR ? defaultValue : value;
         }
 
-        void putProp(
-                const std::string &name, const mediametrics::Item::Prop &prop, int64_t time = 0)
+        // nameId is the id found for name, or -1 if it was not interned.
+        void putProp(const std::string &name, int32_t nameId,
+                const mediametrics::Item::Prop &prop, int64_t time = 0)
                 REQUIRES(mPseudoKeyHistoryLock) {
             //alternatively: prop.visit([&](auto value) { putValue(name, value, time); });
-            putValue(name, prop.get(), time);
+            putValue(name, nameId, prop.get(), time);
         }
 
         template <typename T>
-        void putValue(const std::string &property, T&& e, int64_t time = 0)
+        void putValue(const std::string &name, int32_t nameId, T&& e, int64_t time = 0)
                 REQUIRES(mPseudoKeyHistoryLock) {
             if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
             mLastModificationTime = time;
-            if (mPropertyMap.size() >= kKeyMaxProperties &&
-                    !mPropertyMap.count(property)) {
-                ALOGV("%s: too many properties, rejecting %s", __func__, property.c_str());
-                return;
-            }
-            auto& timeSequence = mPropertyMap[property];
-            Elem el{std::forward<T>(e)};
-            if (timeSequence.empty()           // no elements
-                    || property.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED
-                    || timeSequence.rbegin()->second != el) { // value changed
-                timeSequence.emplace_hint(timeSequence.end(), time, std::move(el));
-
-                if (timeSequence.size() > kTimeSequenceMaxElements) {
-                    ALOGV("%s: restricting maximum elements (discarding oldest) for %s",
-                            __func__, property.c_str());
-                    timeSequence.erase(timeSequence.begin());
+            size_t c = findColumn(nameId);
+            if (c == mColumns.size()) {
+                if (mColumns.size() >= kKeyMaxProperties) {
+                    ALOGV("%s: too many properties, rejecting %s", __func__, name.c_str());
+                    return;
                 }
+                // Only interned once accepted, so a rejected name takes no table entry.
+                nameId = mNames->acquire(name);
+                const auto it = std::upper_bound(mColumns.begin(), mColumns.end(), nameId,
+                        [](int32_t id, const Column& column) { return id < column.getNameId(); });
+                c = it - mColumns.begin();
+                mColumns.emplace(it, nameId, isDuplicatesAllowed(name));
             }
+            mColumns[c].put(time, Elem{std::forward<T>(e)});
         }
 
-        std::pair<std::string, int32_t> dump(int32_t lines, int64_t time) const
-                REQUIRES(mPseudoKeyHistoryLock) {
+        std::pair<std::string, int32_t> dump(int32_t lines, int64_t time,
+                const PropertyNames& names) const REQUIRES(mPseudoKeyHistoryLock) {
+            // dump in property name order.
+            std::vector<std::pair<std::string, const Column *>> sorted;
+            sorted.reserve(mColumns.size());
+            for (const auto& column : mColumns) {
+                sorted.emplace_back(names.getName(column.getNameId()), &column);
+            }
+            std::sort(sorted.begin(), sorted.end());
+
             std::stringstream ss;
             int32_t ll = lines;
-            for (auto& tsPair : mPropertyMap) {
+            for (const auto& [name, column] : sorted) {
                 if (ll <= 0) break;
-                std::string s = dump(mKey, tsPair, time);
+                std::string s = dump(mKey, name, *column, time);
                 if (s.size() > 0) {
                     --ll;
                     ss << s;
@@ -179,29 +431,44 @@ private:
             return mLastModificationTime;
         }
 
+        size_t getMemoryBytes() const REQUIRES(mPseudoKeyHistoryLock) {
+            size_t bytes = sizeof(*this) + stringHeapBytes(mKey)
+                    + mColumns.capacity() * sizeof(Column);
+            for (const auto& column : mColumns) {
+                bytes += column.getMemoryBytes();
+            }
+            return bytes;
+        }
+
     private:
+        // Returns the index of the column of nameId, or mColumns.size() if there is none.
+        size_t findColumn(int32_t nameId) const {
+            const auto it = std::lower_bound(mColumns.begin(), mColumns.end(), nameId,
+                    [](const Column& column, int32_t id) { return column.getNameId() < id; });
+            return it != mColumns.end() && it->getNameId() == nameId
+                    ? it - mColumns.begin() : mColumns.size();
+        }
+
         static std::string dump(
-                const std::string &key,
-                const std::pair<std::string /* prop */, PropertyHistory>& tsPair,
+                const std::string &key, const std::string &name, const Column &column,
                 int64_t time) {
-            const auto timeSequence = tsPair.second;
-            auto eptr = timeSequence.lower_bound(time);
-            if (eptr == timeSequence.end()) {
-                return {}; // don't dump anything. tsPair.first + "={};\n";
+            size_t i = column.lowerBound(time);
+            if (i == column.size()) {
+                return {}; // don't dump anything. name + "={};\n";
             }
             std::stringstream ss;
-            ss << key << "." << tsPair.first << "={";
+            ss << key << "." << name << "={";
 
             time_string_t last_timestring{}; // last timestring used.
             while (true) {
-                const time_string_t timestring = mediametrics::timeStringFromNs(eptr->first);
+                const time_string_t timestring = mediametrics::timeStringFromNs(column.timeAt(i));
                 // find common prefix offset.
                 const size_t offset = commonTimePrefixPosition(timestring.time,
                         last_timestring.time);
                 last_timestring = timestring;
                 ss << "(" << (offset == 0 ? "" : "~") << &timestring.time[offset]
-                    << ") " << eptr->second;
-                if (++eptr == timeSequence.end()) {
+                    << ") " << column.valueAt(i);
+                if (++i == column.size()) {
                     break;
                 }
                 ss << ", ";
@@ -215,18 +482,12 @@ private:
         const int64_t mCreationTime;
 
         int64_t mLastModificationTime;
-        std::map<std::string /* property */, PropertyHistory> mPropertyMap;
+        const std::shared_ptr<PropertyNames> mNames;  // holds a reference for each column.
+        std::vector<Column> mColumns;   // sorted by name id.
     };
 
     using History = std::map<std::string /* key */, std::shared_ptr<KeyHistory>>;
 
-    static inline constexpr size_t kTimeSequenceMaxElements = 50;
-    static inline constexpr size_t kKeyMaxProperties = 50;
-    static inline constexpr size_t kKeyLowWaterMark = 400;
-    static inline constexpr size_t kKeyHighWaterMark = 500;
-
-    // Estimated max data space usage is 3KB * kKeyHighWaterMark.
-
 public:
 
     TimeMachine() = default;
@@ -256,6 +517,7 @@ public:
             std::lock_guard lock2(other.mLock);
             mHistory = other.mHistory;
             mGarbageCollectionCount = other.mGarbageCollectionCount.load();
+            mNames = other.mNames; // ids in the copied KeyHistory refer to these names.
         }
 
         // Now that we safely have our own shared pointers, let's dup them
@@ -293,8 +555,7 @@ public:
                 (void)item->get(AMEDIAMETRICS_PROP_ALLOWUID, &allowUid);
                 // no keylock needed here as we are sole owner
                 // until placed on mHistory.
-                keyHistory = std::make_shared<KeyHistory>(
-                    key, allowUid, time);
+                keyHistory = std::make_shared<KeyHistory>(key, allowUid, mNames, time);
                 mHistory[key] = keyHistory;
             } else {
                 keyHistory = it->second;
@@ -311,6 +572,10 @@ public:
                 if (status != NO_ERROR) return status;
             }
 
+            std::vector<const std::string *> names;
+            std::vector<const mediametrics::Item::Prop *> props;
+            names.reserve(item->count());
+            props.reserve(item->count());
             for (const auto &prop : *item) {
                 const std::string &name = prop.getName();
                 if (name.size() == 0 || name[0] == '_') continue;
@@ -320,9 +585,15 @@ public:
                     if (!isTrusted) continue;
                     deferred.push_back(&prop);
                 } else {
-                    keyHistory->putProp(name, prop, time);
+                    names.push_back(&name);
+                    props.push_back(&prop);
                 }
             }
+            std::vector<int32_t> ids;
+            keyHistory->getNames().find(names, &ids);
+            for (size_t i = 0; i < ids.size(); ++i) {
+                keyHistory->putProp(*names[i], ids[i], *props[i], time);
+            }
         }
 
         // handle remote properties, if any
@@ -342,7 +613,8 @@ public:
                 remoteKeyHistory = it->second;
             }
             std::lock_guard lock(getLockForKey(remoteKey));
-            remoteKeyHistory->putProp(remoteName, prop, time);
+            remoteKeyHistory->putProp(
+                    remoteName, remoteKeyHistory->getNames().find(remoteName), prop, time);
         }
         return NO_ERROR;
     }
@@ -359,7 +631,7 @@ public:
         }
         std::lock_guard lock(getLockForKey(key));
         return keyHistory->checkPermission(uidCheck)
-                ?: keyHistory->getValue(property, value, time);
+                ?: keyHistory->getValue(keyHistory->getNames().find(property), value, time);
     }
 
     /**
@@ -376,7 +648,8 @@ public:
         if (keyHistory == nullptr) return BAD_VALUE;
         if (time == 0) time = systemTime(SYSTEM_TIME_REALTIME);
         std::lock_guard lock(getLockForKey(key));
-        keyHistory->putValue(prop, std::forward<T>(e), time);
+        keyHistory->putValue(
+                prop, keyHistory->getNames().find(prop), std::forward<T>(e), time);
         return NO_ERROR;
     }
 
@@ -393,7 +666,7 @@ public:
 
         std::lock_guard lock(getLockForKey(key));
         return keyHistory->checkPermission(uidCheck)
-               ?: keyHistory->getValue(prop, value, time);
+               ?: keyHistory->getValue(keyHistory->getNames().find(prop), value, time);
     }
 
     /**
@@ -448,7 +721,7 @@ public:
             if (ll <= 0) break;
             if (prefix != nullptr && !startsWith(it->first, prefix)) break;
             std::lock_guard lock2(getLockForKey(it->first));
-            auto [s, l] = it->second->dump(ll, sinceNs);
+            auto [s, l] = it->second->dump(ll, sinceNs, *mNames);
             ss << s;
             ll -= l;
         }
@@ -459,8 +732,40 @@ public:
         return mGarbageCollectionCount;
     }
 
+    /**
+     * Returns the number of property names interned for the keys
+     * of the Time Machine and its copies.
+     */
+    size_t getPropertyNameCount() const {
+        std::lock_guard lock(mLock);
+        return mNames->size();
+    }
+
+    /**
+     * Returns an estimate of the bytes used by the Time Machine,
+     * including the property names shared with its copies.
+     */
+    size_t getMemoryBytes() const {
+        std::lock_guard lock(mLock);
+        size_t bytes = sizeof(*this) + mNames->getMemoryBytes();
+        for (const auto &[key, keyHistory] : mHistory) {
+            // map node (3 pointers and color) and shared_ptr control block.
+            bytes += 4 * sizeof(void *) + sizeof(History::value_type) + stringHeapBytes(key)
+                    + 2 * sizeof(void *);
+            std::lock_guard lock2(getLockForKey(key));
+            bytes += keyHistory->getMemoryBytes();
+        }
+        return bytes;
+    }
+
 private:
 
+    // Whether the time sequence of a property keeps consecutive duplicate values,
+    // i.e. its name ends with AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED.
+    static bool isDuplicatesAllowed(const std::string &name) {
+        return !name.empty() && name.back() == AMEDIAMETRICS_PROP_SUFFIX_CHAR_DUPLICATES_ALLOWED;
+    }
+
     // Obtains the lock for a KeyHistory.
     std::mutex &getLockForKey(const std::string &key) const
             RETURN_CAPABILITY(mPseudoKeyHistoryLock) {
@@ -512,7 +817,7 @@ private:
             std::shared_ptr<KeyHistory> &keyHist = it->second;
 
             std::lock_guard lock(getLockForKey(it->first));
-            int64_t expireTime = keyHist->getValue("_expire", -1 /* default */);
+            int64_t expireTime = keyHist->getValue(PropertyNames::kExpireId, -1 /* default */);
             if (expireTime != -1) {
                 stale.emplace_back(std::move(it->second));
                 it = mHistory.erase(it);
@@ -571,6 +876,9 @@ private:
     mutable std::mutex mLock;           // Lock for mHistory
     History mHistory GUARDED_BY(mLock);
 
+    // Set on construction and copy, the names themselves have their own lock.
+    std::shared_ptr<PropertyNames> mNames = std::make_shared<PropertyNames>();
+
     // KEY_LOCKS is the number of mutexes for keys.
     // It need not be a power of 2, but faster that way.
     static inline constexpr size_t KEY_LOCKS = 256;
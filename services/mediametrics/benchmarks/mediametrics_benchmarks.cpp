@@ -17,12 +17,28 @@
 #include <media/MediaMetricsItem.h>
 #include <benchmark/benchmark.h>
 
+#include "TimeMachine.h"
+
 class MyItem : public android::mediametrics::BaseItem {
 public:
     static bool mySubmitBuffer() {
         // Deliberately lame so that we're measuring just the cost to deliver things to the service.
         return submitBuffer("", 0);
     }
+
+    // A small item, as logged by AudioTrack or AudioRecord.
+    template <bool batched>
+    static bool mySubmitItem() {
+        android::mediametrics::LogItem<> item("benchmark.item");
+        item.set("value", (int32_t)1).set("frames", (int64_t)480);
+        if (!item.updateHeader()) return false;
+        return batched ? submitBufferBatched(item.getBuffer(), item.getLength())
+                : submitBuffer(item.getBuffer(), item.getLength());
+    }
+
+    static void myFlushBatch() {
+        flushBatch();
+    }
 };
 
 static void BM_SubmitBuffer(benchmark::State& state)
@@ -44,4 +60,88 @@ static void BM_SubmitBuffer(benchmark::State& state)
 
 BENCHMARK(BM_SubmitBuffer)->Iterations(4000);   // Adjust magic number until test runs
 
+// One binder transaction per item.
+static void BM_SubmitItem(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        if (!MyItem::mySubmitItem<false /* batched */>()) {
+            state.SkipWithError("failed"); // see BM_SubmitBuffer
+            return;
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(BM_SubmitItem)->Iterations(4000);
+
+// Items are queued and sent kBatchMaxBytes at a time.
+static void BM_SubmitItemBatched(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        if (!MyItem::mySubmitItem<true /* batched */>()) {
+            state.SkipWithError("failed");
+            return;
+        }
+        benchmark::ClobberMemory();
+    }
+    MyItem::myFlushBatch();
+}
+
+BENCHMARK(BM_SubmitItemBatched)->Iterations(4000);
+BENCHMARK(BM_SubmitItemBatched)->Iterations(4000)->Threads(4);
+
+// Puts one audio track like item for each of the keys.
+static void fillTimeMachine(android::mediametrics::TimeMachine& timeMachine, int64_t keys)
+{
+    for (int64_t i = 0; i < keys; ++i) {
+        auto item = std::make_shared<android::mediametrics::Item>(
+                "audio.track." + std::to_string(i));
+        (*item).set("sampleRate", (int32_t)48000)
+               .set("channelMask", (int32_t)3)
+               .set("encoding", "AUDIO_FORMAT_PCM_16_BIT")
+               .set("frameCount", (int32_t)960)
+               .set("state", "ACTIVE")
+               .setTimestamp(1);
+        timeMachine.put(item, true /* isTrusted */);
+    }
+}
+
+static void BM_TimeMachinePut(benchmark::State& state)
+{
+    const int64_t keys = state.range(0);
+    android::mediametrics::TimeMachine timeMachine(keys, keys * 2);
+    fillTimeMachine(timeMachine, keys);
+
+    int64_t i = 0;
+    while (state.KeepRunning()) {
+        auto item = std::make_shared<android::mediametrics::Item>(
+                "audio.track." + std::to_string(i % keys));
+        (*item).set("underrunFrames", (int32_t)i)
+               .set("state", i & 1 ? "ACTIVE" : "STOPPED")
+               .setTimestamp(2 + i);
+        timeMachine.put(item, true /* isTrusted */);
+        ++i;
+    }
+    state.counters["bytes"] = timeMachine.getMemoryBytes();
+}
+
+BENCHMARK(BM_TimeMachinePut)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_TimeMachineGet(benchmark::State& state)
+{
+    const int64_t keys = state.range(0);
+    android::mediametrics::TimeMachine timeMachine(keys, keys * 2);
+    fillTimeMachine(timeMachine, keys);
+
+    int64_t i = 0;
+    while (state.KeepRunning()) {
+        int32_t sampleRate;
+        benchmark::DoNotOptimize(timeMachine.get(
+                "audio.track." + std::to_string(i++ % keys), "sampleRate", &sampleRate));
+    }
+    state.counters["bytes"] = timeMachine.getMemoryBytes();
+}
+
+BENCHMARK(BM_TimeMachineGet)->Arg(100)->Arg(1000)->Arg(10000);
+
 BENCHMARK_MAIN();
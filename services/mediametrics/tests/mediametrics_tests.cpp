@@ -237,6 +237,26 @@ TEST(mediametrics_tests, instantiate) {
   mediaMetrics->dump(fileno(stdout), {} /* args */);
 }
 
+TEST(mediametrics_tests, submit_batch) {
+  sp mediaMetrics = new MediaMetricsService();
+
+  std::string batch;
+  for (int32_t i = 0; i < 3; ++i) {
+    mediametrics::Item item("audiotrack");
+    item.setInt32("value", i);
+    char *data;
+    size_t length;
+    ASSERT_EQ(0, item.writeToByteString(&data, &length));
+    batch.append(data, length);
+    free(data);
+  }
+  ASSERT_EQ(NO_ERROR, mediaMetrics->submitBatch(batch.data(), batch.size()));
+
+  // a truncated item invalidates the rest of the batch
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBatch(batch.data(), batch.size() - 1));
+  ASSERT_EQ(BAD_VALUE, mediaMetrics->submitBatch(batch.data(), 2));
+}
+
 TEST(mediametrics_tests, package_installer_check) {
   ASSERT_EQ(false, MediaMetricsService::useUidForPackage(
       "abcd", "installer"));  // ok, package name has no dot.
@@ -710,6 +730,88 @@ TEST(mediametrics_tests, time_machine_gc) {
   printf("After\n%s\n", timeMachine.dump().first.c_str());
 }
 
+TEST(mediametrics_tests, time_machine_property_name_flood) {
+  constexpr uid_t kUntrustedUid = 10123;
+  constexpr size_t kKeyMaxProperties = 50;  // TimeMachine::kKeyMaxProperties
+
+  android::mediametrics::TimeMachine timeMachine(1, 2); // keep at most 2 keys.
+
+  // a trusted client creates a key that an untrusted app may write.
+  auto item = std::make_shared<mediametrics::Item>("Flood");
+  (*item).set(AMEDIAMETRICS_PROP_ALLOWUID, (int32_t)kUntrustedUid)
+         .setTimestamp(10);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+  const size_t names = timeMachine.getPropertyNameCount();
+
+  // the app floods the key with distinct property names.
+  for (int32_t i = 0; i < 100; ++i) {
+    auto flood = std::make_shared<mediametrics::Item>("Flood");
+    for (int32_t j = 0; j < 100; ++j) {
+      flood->set(("name" + std::to_string(i * 100 + j)).c_str(), j);
+    }
+    flood->setUid(kUntrustedUid).setTimestamp(11 + i);
+    ASSERT_EQ(NO_ERROR, timeMachine.put(flood, false));
+  }
+
+  // only the properties accepted for the key are interned.
+  ASSERT_LE(timeMachine.getPropertyNameCount(), names + kKeyMaxProperties);
+  int32_t i32;
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Flood.name0", &i32, -1));
+  ASSERT_EQ(0, i32);
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Flood.name9999", &i32, -1));
+
+  // other keys can still record new properties.
+  auto other = std::make_shared<mediametrics::Item>("Other");
+  (*other).set("fresh", (int32_t)1)
+          .setTimestamp(200);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(other, true));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Other.fresh", &i32, -1));
+  ASSERT_EQ(1, i32);
+
+  // the names go away with the flooded key when it is garbage collected.
+  auto last = std::make_shared<mediametrics::Item>("Last");
+  (*last).set("fresh", (int32_t)2)
+         .setTimestamp(300);
+  ASSERT_EQ(NO_ERROR, timeMachine.put(last, true));
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Flood.name0", &i32, -1));
+  ASSERT_EQ(names + 1, timeMachine.getPropertyNameCount());
+}
+
+TEST(mediametrics_tests, time_machine_columns) {
+  auto item = std::make_shared<mediametrics::Item>("Key");
+  (*item).set("value", (int32_t)0)
+         .setTimestamp(10);
+
+  android::mediametrics::TimeMachine timeMachine;
+  ASSERT_EQ(NO_ERROR, timeMachine.put(item, true));
+  const size_t bytes = timeMachine.getMemoryBytes();
+
+  // out of order changes are kept in time order.
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", (int32_t)2, 30));
+  ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", (int32_t)1, 20));
+
+  int32_t i32;
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.value", &i32, -1, 5));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 15));
+  ASSERT_EQ(0, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 25));
+  ASSERT_EQ(1, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 35));
+  ASSERT_EQ(2, i32);
+
+  // only the most recent changes are kept.
+  for (int32_t i = 0; i < 100; ++i) {
+    ASSERT_EQ(NO_ERROR, timeMachine.put("Key.value", i, 100 + i));
+  }
+  ASSERT_EQ(BAD_VALUE, timeMachine.get("Key.value", &i32, -1, 120));
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 160));
+  ASSERT_EQ(60, i32);
+  ASSERT_EQ(NO_ERROR, timeMachine.get("Key.value", &i32, -1, 1000));
+  ASSERT_EQ(99, i32);
+
+  ASSERT_LT(bytes, timeMachine.getMemoryBytes());
+}
+
 TEST(mediametrics_tests, transaction_log_gc) {
   auto item = std::make_shared<mediametrics::Item>("Key1");
   (*item).set("one", (int32_t)1)